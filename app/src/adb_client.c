@@ -0,0 +1,467 @@
+#include "adb_client.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <SDL2/SDL_rwops.h>
+#include <SDL2/SDL_stdinc.h>
+
+#include "config.h"
+#include "util/buffer_util.h"
+#include "util/log.h"
+#include "util/str_util.h"
+
+#define IPV4_LOCALHOST 0x7F000001
+
+// a request is prefixed by its length, as 4 hexadecimal digits
+#define REQUEST_MAX_LENGTH 0xFFFF
+// large enough for any command executed by scrcpy
+#define SHELL_REQUEST_MAX_LENGTH 4096
+
+// the sync protocol limits the size of DATA chunks
+#define SYNC_DATA_MAX (64 * 1024)
+// regular file, rw-r--r--
+#define SYNC_FILE_MODE 0100644
+
+uint16_t
+adb_client_get_server_port(void) {
+    const char *env = SDL_getenv("ANDROID_ADB_SERVER_PORT");
+    if (env) {
+        long value;
+        if (parse_integer(env, &value) && value > 0 && value <= 0xFFFF) {
+            return (uint16_t) value;
+        }
+        LOGW("Invalid ANDROID_ADB_SERVER_PORT: %s", env);
+    }
+    return ADB_CLIENT_DEFAULT_SERVER_PORT;
+}
+
+// like the adb executable, target the device given by ANDROID_SERIAL if no
+// serial is given (if none, the adb server selects the only device)
+static const char *
+get_serial(const char *serial) {
+    if (serial) {
+        return serial;
+    }
+    const char *env = SDL_getenv("ANDROID_SERIAL");
+    return env && *env ? env : NULL;
+}
+
+static socket_t
+connect_to_adb_server(void) {
+    uint16_t port = adb_client_get_server_port();
+    socket_t socket = net_connect(IPV4_LOCALHOST, port);
+    if (socket == INVALID_SOCKET) {
+        LOGD("adb server not reachable on port %" PRIu16, port);
+    }
+    return socket;
+}
+
+static void
+close_adb_socket(socket_t socket) {
+    net_shutdown(socket, SHUT_RDWR);
+    net_close(socket);
+}
+
+static bool
+send_all(socket_t socket, const void *buf, size_t len) {
+    return !len || net_send_all(socket, buf, len) == (ssize_t) len;
+}
+
+static bool
+send_request(socket_t socket, const char *request) {
+    size_t len = strlen(request);
+    if (len > REQUEST_MAX_LENGTH) {
+        LOGE("adb request too long");
+        return false;
+    }
+    char header[5];
+    sprintf(header, "%04x", (unsigned) len);
+    return send_all(socket, header, 4) && send_all(socket, request, len);
+}
+
+static bool
+read_hex_length(socket_t socket, size_t *len) {
+    char hex[5];
+    if (net_recv_all(socket, hex, 4) != 4) {
+        return false;
+    }
+    hex[4] = '\0';
+    char *endptr;
+    unsigned long value = strtoul(hex, &endptr, 16);
+    if (*endptr != '\0') {
+        return false;
+    }
+    *len = value;
+    return true;
+}
+
+// read a FAIL message (length-prefixed in hex) and log it
+static void
+log_failure(socket_t socket, const char *request) {
+    size_t len;
+    char msg[256];
+    if (!read_hex_length(socket, &len)) {
+        LOGW("adb server: \"%s\" failed", request);
+        return;
+    }
+    size_t to_read = len < sizeof(msg) - 1 ? len : sizeof(msg) - 1;
+    if (net_recv_all(socket, msg, to_read) != (ssize_t) to_read) {
+        LOGW("adb server: \"%s\" failed", request);
+        return;
+    }
+    msg[to_read] = '\0';
+    LOGW("adb server: \"%s\" failed: %s", request, msg);
+}
+
+// read the status of a request: "OKAY", or "FAIL" followed by a message
+// if eof_is_okay, the connection closed by the server counts as "OKAY"
+static bool
+read_status(socket_t socket, const char *request, bool eof_is_okay) {
+    char status[4];
+    ssize_t r = net_recv_all(socket, status, 4);
+    if (r == 0 && eof_is_okay) {
+        return true;
+    }
+    if (r != 4) {
+        LOGW("adb server: could not read the status of \"%s\"", request);
+        return false;
+    }
+    if (!memcmp(status, "OKAY", 4)) {
+        return true;
+    }
+    if (!memcmp(status, "FAIL", 4)) {
+        log_failure(socket, request);
+    } else {
+        LOGW("adb server: unexpected status for \"%s\"", request);
+    }
+    return false;
+}
+
+static enum adb_client_result
+execute_request(socket_t socket, const char *request) {
+    if (!send_request(socket, request) || !read_status(socket, request, false)) {
+        return ADB_CLIENT_ERROR;
+    }
+    return ADB_CLIENT_SUCCESS;
+}
+
+// connect to the adb server and select the device transport, so that the next
+// request on the returned socket is forwarded to the device
+static enum adb_client_result
+connect_to_transport(const char *serial, socket_t *socket) {
+    serial = get_serial(serial);
+    char request[256];
+    if (serial) {
+        int len = snprintf(request, sizeof(request), "host:transport:%s",
+                           serial);
+        if (len < 0 || (size_t) len >= sizeof(request)) {
+            LOGE("Serial too long: %s", serial);
+            return ADB_CLIENT_ERROR;
+        }
+    } else {
+        strcpy(request, "host:transport-any");
+    }
+
+    socket_t s = connect_to_adb_server();
+    if (s == INVALID_SOCKET) {
+        return ADB_CLIENT_ERROR_UNAVAILABLE;
+    }
+
+    enum adb_client_result result = execute_request(s, request);
+    if (result != ADB_CLIENT_SUCCESS) {
+        close_adb_socket(s);
+        return result;
+    }
+
+    *socket = s;
+    return ADB_CLIENT_SUCCESS;
+}
+
+// execute a request on the device which replies with two statuses (the first
+// for the service, the second for the operation), like "reverse:..."
+static enum adb_client_result
+execute_device_command(const char *serial, const char *request) {
+    socket_t socket;
+    enum adb_client_result result = connect_to_transport(serial, &socket);
+    if (result != ADB_CLIENT_SUCCESS) {
+        return result;
+    }
+
+    result = execute_request(socket, request);
+    if (result == ADB_CLIENT_SUCCESS && !read_status(socket, request, true)) {
+        result = ADB_CLIENT_ERROR;
+    }
+
+    close_adb_socket(socket);
+    return result;
+}
+
+// execute a request on the adb server itself, which replies with two
+// statuses (like "host:forward:...")
+static enum adb_client_result
+execute_host_command(const char *request) {
+    socket_t socket = connect_to_adb_server();
+    if (socket == INVALID_SOCKET) {
+        return ADB_CLIENT_ERROR_UNAVAILABLE;
+    }
+
+    enum adb_client_result result = execute_request(socket, request);
+    if (result == ADB_CLIENT_SUCCESS && !read_status(socket, request, true)) {
+        result = ADB_CLIENT_ERROR;
+    }
+
+    close_adb_socket(socket);
+    return result;
+}
+
+// a host request targets a specific device with the prefix "host-serial:"
+static bool
+format_host_request(char *buf, size_t size, const char *serial,
+                    const char *command) {
+    serial = get_serial(serial);
+    int len = serial ? snprintf(buf, size, "host-serial:%s:%s", serial, command)
+                     : snprintf(buf, size, "host:%s", command);
+    return len >= 0 && (size_t) len < size;
+}
+
+enum adb_client_result
+adb_client_reverse(const char *serial, const char *device_socket_name,
+                   uint16_t local_port) {
+    char request[256];
+    int len = snprintf(request, sizeof(request),
+                       "reverse:forward:localabstract:%s;tcp:%" PRIu16,
+                       device_socket_name, local_port);
+    if (len < 0 || (size_t) len >= sizeof(request)) {
+        return ADB_CLIENT_ERROR;
+    }
+    return execute_device_command(serial, request);
+}
+
+enum adb_client_result
+adb_client_reverse_remove(const char *serial, const char *device_socket_name) {
+    char request[256];
+    int len = snprintf(request, sizeof(request),
+                       "reverse:killforward:localabstract:%s",
+                       device_socket_name);
+    if (len < 0 || (size_t) len >= sizeof(request)) {
+        return ADB_CLIENT_ERROR;
+    }
+    return execute_device_command(serial, request);
+}
+
+enum adb_client_result
+adb_client_forward(const char *serial, uint16_t local_port,
+                   const char *device_socket_name) {
+    char command[256];
+    char request[512];
+    int len = snprintf(command, sizeof(command),
+                       "forward:tcp:%" PRIu16 ";localabstract:%s", local_port,
+                       device_socket_name);
+    if (len < 0 || (size_t) len >= sizeof(command)
+            || !format_host_request(request, sizeof(request), serial,
+                                    command)) {
+        return ADB_CLIENT_ERROR;
+    }
+    return execute_host_command(request);
+}
+
+enum adb_client_result
+adb_client_forward_remove(const char *serial, uint16_t local_port) {
+    char command[32];
+    char request[512];
+    sprintf(command, "killforward:tcp:%" PRIu16, local_port);
+    if (!format_host_request(request, sizeof(request), serial, command)) {
+        return ADB_CLIENT_ERROR;
+    }
+    return execute_host_command(request);
+}
+
+enum adb_client_result
+adb_client_shell(const char *serial, const char *const cmd[], size_t len,
+                 socket_t *socket) {
+    char request[SHELL_REQUEST_MAX_LENGTH];
+    // like "adb shell", the arguments are joined by spaces
+    size_t pos = xstrncpy(request, "shell:", sizeof(request));
+    for (size_t i = 0; i < len; ++i) {
+        if (i && pos < sizeof(request) - 1) {
+            request[pos++] = ' ';
+        }
+        size_t remaining = sizeof(request) - pos;
+        size_t w = xstrncpy(&request[pos], cmd[i], remaining);
+        if (w >= remaining) {
+            LOGE("Shell command too long");
+            return ADB_CLIENT_ERROR;
+        }
+        pos += w;
+    }
+
+    socket_t s;
+    enum adb_client_result result = connect_to_transport(serial, &s);
+    if (result != ADB_CLIENT_SUCCESS) {
+        return result;
+    }
+
+    result = execute_request(s, request);
+    if (result != ADB_CLIENT_SUCCESS) {
+        close_adb_socket(s);
+        return result;
+    }
+
+    *socket = s;
+    return ADB_CLIENT_SUCCESS;
+}
+
+// a sync packet header: 4-byte id followed by a 32-bit little-endian value
+static bool
+sync_send_header(socket_t socket, const char *id, uint32_t value) {
+    uint8_t header[8];
+    memcpy(header, id, 4);
+    buffer_write32le(&header[4], value);
+    return send_all(socket, header, sizeof(header));
+}
+
+static bool
+sync_read_status(socket_t socket, const char *remote) {
+    uint8_t header[8];
+    if (net_recv_all(socket, header, sizeof(header)) != sizeof(header)) {
+        LOGW("adb sync: could not read the status of %s", remote);
+        return false;
+    }
+    if (!memcmp(header, "OKAY", 4)) {
+        return true;
+    }
+    if (!memcmp(header, "FAIL", 4)) {
+        char msg[256];
+        uint32_t len = buffer_read32le(&header[4]);
+        size_t to_read = len < sizeof(msg) - 1 ? len : sizeof(msg) - 1;
+        if (net_recv_all(socket, msg, to_read) == (ssize_t) to_read) {
+            msg[to_read] = '\0';
+            LOGW("adb sync: could not push %s: %s", remote, msg);
+            return false;
+        }
+    }
+    LOGW("adb sync: could not push %s", remote);
+    return false;
+}
+
+static bool
+sync_send_file(socket_t socket, SDL_RWops *file, const char *remote) {
+    char path_and_mode[1024];
+    int len = snprintf(path_and_mode, sizeof(path_and_mode), "%s,%d", remote,
+                       SYNC_FILE_MODE);
+    if (len < 0 || (size_t) len >= sizeof(path_and_mode)) {
+        LOGE("Remote path too long: %s", remote);
+        return false;
+    }
+    if (!sync_send_header(socket, "SEND", len)
+            || !send_all(socket, path_and_mode, len)) {
+        return false;
+    }
+
+    uint8_t *data = SDL_malloc(SYNC_DATA_MAX);
+    if (!data) {
+        LOGE("Could not allocate sync buffer");
+        return false;
+    }
+
+    bool ok = true;
+    size_t r;
+    while ((r = SDL_RWread(file, data, 1, SYNC_DATA_MAX)) > 0) {
+        if (!sync_send_header(socket, "DATA", r)
+                || !send_all(socket, data, r)) {
+            ok = false;
+            break;
+        }
+    }
+    SDL_free(data);
+
+    if (!ok) {
+        return false;
+    }
+
+    uint32_t mtime = (uint32_t) time(NULL);
+    return sync_send_header(socket, "DONE", mtime)
+        && sync_read_status(socket, remote);
+}
+
+static bool
+sync_stat(socket_t socket, const char *remote, bool *exists, uint32_t *size) {
+    size_t len = strlen(remote);
+    if (len > 1024) {
+        LOGE("Remote path too long: %s", remote);
+        return false;
+    }
+    if (!sync_send_header(socket, "STAT", len)
+            || !send_all(socket, remote, len)) {
+        return false;
+    }
+
+    // "STAT" followed by the mode, the size and the mtime (little-endian)
+    uint8_t reply[16];
+    if (net_recv_all(socket, reply, sizeof(reply)) != sizeof(reply)
+            || memcmp(reply, "STAT", 4)) {
+        LOGW("adb sync: could not stat %s", remote);
+        return false;
+    }
+
+    uint32_t mode = buffer_read32le(&reply[4]);
+    // a mode of 0 means that the file does not exist
+    *exists = mode != 0;
+    *size = buffer_read32le(&reply[8]);
+    return true;
+}
+
+enum adb_client_result
+adb_client_stat(const char *serial, const char *remote, bool *exists,
+                uint32_t *size) {
+    socket_t socket;
+    enum adb_client_result result = connect_to_transport(serial, &socket);
+    if (result != ADB_CLIENT_SUCCESS) {
+        return result;
+    }
+
+    result = execute_request(socket, "sync:");
+    if (result == ADB_CLIENT_SUCCESS) {
+        if (sync_stat(socket, remote, exists, size)) {
+            sync_send_header(socket, "QUIT", 0); // ignore failure
+        } else {
+            result = ADB_CLIENT_ERROR;
+        }
+    }
+
+    close_adb_socket(socket);
+    return result;
+}
+
+enum adb_client_result
+adb_client_push(const char *serial, const char *local, const char *remote) {
+    SDL_RWops *file = SDL_RWFromFile(local, "rb");
+    if (!file) {
+        LOGE("Could not open %s", local);
+        return ADB_CLIENT_ERROR;
+    }
+
+    socket_t socket;
+    enum adb_client_result result = connect_to_transport(serial, &socket);
+    if (result != ADB_CLIENT_SUCCESS) {
+        SDL_RWclose(file);
+        return result;
+    }
+
+    result = execute_request(socket, "sync:");
+    if (result == ADB_CLIENT_SUCCESS) {
+        if (sync_send_file(socket, file, remote)) {
+            // ignore failure, the file has been pushed
+            sync_send_header(socket, "QUIT", 0);
+        } else {
+            result = ADB_CLIENT_ERROR;
+        }
+    }
+
+    close_adb_socket(socket);
+    SDL_RWclose(file);
+    return result;
+}
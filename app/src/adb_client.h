@@ -0,0 +1,74 @@
+#ifndef ADB_CLIENT_H
+#define ADB_CLIENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "util/net.h"
+
+// Native client for the adb server (host) protocol, so that no "adb" process
+// needs to be spawned for each command.
+//
+// The adb server listens on localhost, on the port given by the environment
+// variable ANDROID_ADB_SERVER_PORT (5037 by default). It is not started by
+// this client: if it is not running, ADB_CLIENT_ERROR_UNAVAILABLE is returned,
+// and the caller is expected to fallback to the "adb" executable (which starts
+// the server on demand). It must also fallback on ADB_CLIENT_ERROR, since the
+// adb executable may succeed where this client fails (e.g. a feature or a
+// transport not supported by this client).
+//
+// If no serial is given, the device is selected by the environment variable
+// ANDROID_SERIAL, like the adb executable.
+
+#define ADB_CLIENT_DEFAULT_SERVER_PORT 5037
+
+enum adb_client_result {
+    ADB_CLIENT_SUCCESS,
+    // the adb server refused the request or the communication failed
+    ADB_CLIENT_ERROR,
+    // the adb server is not reachable
+    ADB_CLIENT_ERROR_UNAVAILABLE,
+};
+
+// the port of the adb server (ANDROID_ADB_SERVER_PORT or the default)
+uint16_t
+adb_client_get_server_port(void);
+
+// equivalent to "adb push <local> <remote>"
+enum adb_client_result
+adb_client_push(const char *serial, const char *local, const char *remote);
+
+// retrieve the size of a remote file through the sync protocol (like "adb
+// shell stat"); *exists is set to false if the file does not exist
+enum adb_client_result
+adb_client_stat(const char *serial, const char *remote, bool *exists,
+                uint32_t *size);
+
+// equivalent to "adb reverse localabstract:<name> tcp:<port>"
+enum adb_client_result
+adb_client_reverse(const char *serial, const char *device_socket_name,
+                   uint16_t local_port);
+
+// equivalent to "adb reverse --remove localabstract:<name>"
+enum adb_client_result
+adb_client_reverse_remove(const char *serial, const char *device_socket_name);
+
+// equivalent to "adb forward tcp:<port> localabstract:<name>"
+enum adb_client_result
+adb_client_forward(const char *serial, uint16_t local_port,
+                   const char *device_socket_name);
+
+// equivalent to "adb forward --remove tcp:<port>"
+enum adb_client_result
+adb_client_forward_remove(const char *serial, uint16_t local_port);
+
+// equivalent to "adb shell <cmd...>"
+// on success, *socket receives the output of the command; closing it
+// terminates the command on the device
+enum adb_client_result
+adb_client_shell(const char *serial, const char *const cmd[], size_t len,
+                 socket_t *socket);
+
+#endif
@@ -0,0 +1,250 @@
+#include "async_log.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL_log.h>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_timer.h>
+
+#include "config.h"
+
+static_assert(!(ASYNC_LOG_CAPACITY & (ASYNC_LOG_CAPACITY - 1)),
+              "ASYNC_LOG_CAPACITY must be a power of 2");
+
+struct log_message {
+    int category;
+    SDL_LogPriority priority;
+    char text[ASYNC_LOG_MESSAGE_SIZE];
+};
+
+// A slot of the bounded multi-producer queue: seq is the position which may
+// be written next (when equal to the enqueue position) or read next (when
+// equal to the dequeue position + 1).
+struct log_record {
+    atomic_size_t seq;
+    struct log_message msg;
+};
+
+static struct log_record records[ASYNC_LOG_CAPACITY];
+static atomic_size_t enqueue_pos;
+static size_t dequeue_pos; // accessed only by the writer
+static atomic_uint dropped;
+static atomic_bool stopped;
+static SDL_sem *sem;
+static SDL_Thread *thread;
+
+// the initial output function, called from the writer thread
+static SDL_LogOutputFunction output;
+static void *output_userdata;
+
+// accessed only by the writer
+static struct log_message last;
+static bool has_last;
+static unsigned repeats; // number of messages identical to last
+static unsigned written; // during the current period
+static unsigned suppressed; // during the current period
+static uint32_t period_start;
+
+// the SDL log output function, called from any thread
+static void
+push_message(void *userdata, int category, SDL_LogPriority priority,
+             const char *message) {
+    (void) userdata;
+
+    size_t pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+    struct log_record *record;
+    for (;;) {
+        record = &records[pos % ASYNC_LOG_CAPACITY];
+        size_t seq = atomic_load_explicit(&record->seq, memory_order_acquire);
+        if (seq == pos) {
+            // the slot is free, claim it (on failure, pos is reloaded)
+            if (atomic_compare_exchange_weak_explicit(&enqueue_pos, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (seq < pos) {
+            // the queue is full, never block the caller
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            // another thread claimed the slot meanwhile
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    struct log_message *msg = &record->msg;
+    msg->category = category;
+    msg->priority = priority;
+    size_t len = strlen(message);
+    if (len >= ASYNC_LOG_MESSAGE_SIZE) {
+        len = ASYNC_LOG_MESSAGE_SIZE - 1;
+    }
+    memcpy(msg->text, message, len);
+    msg->text[len] = '\0';
+
+    atomic_store_explicit(&record->seq, pos + 1, memory_order_release);
+    SDL_SemPost(sem);
+}
+
+static bool
+pop_message(struct log_message *msg) {
+    struct log_record *record = &records[dequeue_pos % ASYNC_LOG_CAPACITY];
+    size_t seq = atomic_load_explicit(&record->seq, memory_order_acquire);
+    if (seq != dequeue_pos + 1) {
+        // empty (or the next record is not completely written yet)
+        return false;
+    }
+
+    *msg = record->msg;
+    // the slot may be written again on the next round
+    atomic_store_explicit(&record->seq, dequeue_pos + ASYNC_LOG_CAPACITY,
+                          memory_order_release);
+    ++dequeue_pos;
+    return true;
+}
+
+static void
+write_message(int category, SDL_LogPriority priority, const char *fmt, ...) {
+    char text[ASYNC_LOG_MESSAGE_SIZE];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    output(output_userdata, category, priority, text);
+}
+
+static void
+flush_repeats(void) {
+    if (repeats) {
+        write_message(last.category, last.priority,
+                      "Last message repeated %u times", repeats);
+        repeats = 0;
+    }
+}
+
+static void
+process_message(const struct log_message *msg) {
+    if (has_last && msg->category == last.category
+            && msg->priority == last.priority
+            && !strcmp(msg->text, last.text)) {
+        ++repeats;
+        return;
+    }
+
+    flush_repeats();
+
+    if (written >= ASYNC_LOG_RATE_LIMIT) {
+        ++suppressed;
+        return;
+    }
+
+    output(output_userdata, msg->category, msg->priority, msg->text);
+    ++written;
+    last = *msg;
+    has_last = true;
+}
+
+static void
+end_period(uint32_t now) {
+    // report the repeats at least once per period
+    flush_repeats();
+
+    if (suppressed) {
+        write_message(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_WARN,
+                      "%u log messages suppressed (more than %d per second)",
+                      suppressed, ASYNC_LOG_RATE_LIMIT);
+        suppressed = 0;
+    }
+
+    unsigned d = atomic_exchange_explicit(&dropped, 0, memory_order_relaxed);
+    if (d) {
+        write_message(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_WARN,
+                      "%u log messages dropped (queue full)", d);
+    }
+
+    written = 0;
+    period_start = now;
+}
+
+static int
+run_writer(void *data) {
+    (void) data;
+
+    for (;;) {
+        // wake up at least once per period, to report the repeats
+        SDL_SemWaitTimeout(sem, ASYNC_LOG_PERIOD_MS);
+        // read before draining, so that no message is left once stopped
+        bool stop = atomic_load_explicit(&stopped, memory_order_acquire);
+
+        struct log_message msg;
+        while (pop_message(&msg)) {
+            process_message(&msg);
+        }
+
+        uint32_t now = SDL_GetTicks();
+        if (stop || now - period_start >= ASYNC_LOG_PERIOD_MS) {
+            end_period(now);
+        }
+        if (stop) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+bool
+async_log_init(void) {
+    for (size_t i = 0; i < ASYNC_LOG_CAPACITY; ++i) {
+        atomic_init(&records[i].seq, i);
+    }
+    atomic_init(&enqueue_pos, 0);
+    dequeue_pos = 0;
+    atomic_init(&dropped, 0);
+    atomic_init(&stopped, false);
+    has_last = false;
+    repeats = 0;
+    written = 0;
+    suppressed = 0;
+    period_start = SDL_GetTicks();
+
+    sem = SDL_CreateSemaphore(0);
+    if (!sem) {
+        return false;
+    }
+
+    SDL_LogGetOutputFunction(&output, &output_userdata);
+
+    thread = SDL_CreateThread(run_writer, "log", NULL);
+    if (!thread) {
+        SDL_DestroySemaphore(sem);
+        return false;
+    }
+
+    SDL_LogSetOutputFunction(push_message, NULL);
+    return true;
+}
+
+void
+async_log_destroy(void) {
+    atomic_store_explicit(&stopped, true, memory_order_release);
+    SDL_SemPost(sem);
+    SDL_WaitThread(thread, NULL);
+
+    SDL_LogSetOutputFunction(output, output_userdata);
+
+    // a message may have been pushed after the writer stopped
+    struct log_message msg;
+    while (pop_message(&msg)) {
+        output(output_userdata, msg.category, msg.priority, msg.text);
+    }
+
+    SDL_DestroySemaphore(sem);
+}
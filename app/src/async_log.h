@@ -0,0 +1,40 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <stdbool.h>
+
+#include "config.h"
+
+// number of records in the queue (must be a power of 2)
+#define ASYNC_LOG_CAPACITY 256
+// longer messages are truncated
+#define ASYNC_LOG_MESSAGE_SIZE 512
+// max number of messages written per period (the others are counted)
+#define ASYNC_LOG_RATE_LIMIT 100
+#define ASYNC_LOG_PERIOD_MS 1000
+
+// Move the writing of the logs (SDL_Log(), so the LOGx() macros) off the
+// calling threads.
+//
+// The SDL log output function is replaced by one which copies the formatted
+// message into a lock-free queue of fixed-size records, and a single writer
+// thread forwards the messages to the initial output function. If the queue
+// is full, the message is dropped (and counted) rather than blocking the
+// caller.
+//
+// The writer deduplicates consecutive identical messages ("Last message
+// repeated N times"), and writes at most ASYNC_LOG_RATE_LIMIT messages per
+// period.
+//
+// Like the SDL log output function, the logger is process-wide.
+
+// must be called before the threads which log are started
+bool
+async_log_init(void);
+
+// write the pending messages, then restore the initial output function (must
+// be called once the threads which log are joined)
+void
+async_log_destroy(void);
+
+#endif
@@ -0,0 +1,280 @@
+#include "automation.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL_stdinc.h>
+
+#include "config.h"
+#include "automation_cmd.h"
+#include "util/lock.h"
+#include "util/log.h"
+
+static void
+serve_client(socket_t socket, void *userdata);
+
+static socket_t
+connect_to_server(void *userdata) {
+    struct automation *automation = userdata;
+    return net_connect_unix(automation->path);
+}
+
+static const struct accept_loop_cbs accept_loop_cbs = {
+    .serve = serve_client,
+    .connect = connect_to_server,
+};
+
+bool
+automation_init(struct automation *automation, const char *path,
+                struct video_buffer *video_buffer,
+                struct rtt_stats *rtt_stats) {
+    if (!(automation->path = SDL_strdup(path))) {
+        return false;
+    }
+
+    if (!(automation->mutex = SDL_CreateMutex())) {
+        SDL_free(automation->path);
+        return false;
+    }
+
+    socket_t server_socket = net_listen_unix(path, 1);
+    if (server_socket == INVALID_SOCKET) {
+        LOGE("Could not listen on automation socket \"%s\"", path);
+        SDL_DestroyMutex(automation->mutex);
+        SDL_free(automation->path);
+        return false;
+    }
+
+    if (!accept_loop_init(&automation->loop, "automation", server_socket,
+                          &accept_loop_cbs, automation)) {
+        net_close(server_socket);
+        SDL_DestroyMutex(automation->mutex);
+        SDL_free(automation->path);
+        return false;
+    }
+
+    automation->controller = NULL;
+    automation->video_buffer = video_buffer;
+    automation->rtt_stats = rtt_stats;
+    return true;
+}
+
+void
+automation_destroy(struct automation *automation) {
+    accept_loop_destroy(&automation->loop);
+    if (remove(automation->path)) {
+        LOGW("Could not remove automation socket \"%s\"", automation->path);
+    }
+    SDL_DestroyMutex(automation->mutex);
+    SDL_free(automation->path);
+}
+
+static bool
+send_str(socket_t socket, const char *s) {
+    size_t len = strlen(s);
+    return net_send_all(socket, s, len) == (ssize_t) len;
+}
+
+static bool
+send_error(socket_t socket, const char *error) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "error %s\n", error);
+    return send_str(socket, buf);
+}
+
+static bool
+push_input(struct automation *automation, socket_t socket,
+           struct automation_cmd *cmd) {
+    mutex_lock(automation->mutex);
+    struct controller *controller = automation->controller;
+    unsigned pushed = 0;
+    if (controller) {
+        while (pushed < cmd->msg_count
+                && controller_push_msg_reliable(controller,
+                                                &cmd->msgs[pushed])) {
+            ++pushed;
+        }
+    }
+    mutex_unlock(automation->mutex);
+
+    if (pushed == cmd->msg_count) {
+        return true;
+    }
+
+    // the remaining messages are still owned here
+    for (unsigned i = pushed; i < cmd->msg_count; ++i) {
+        control_msg_destroy(&cmd->msgs[i]);
+    }
+    return send_error(socket, controller ? "could not push event"
+                                         : "device disconnected");
+}
+
+static bool
+send_stats(struct automation *automation, socket_t socket) {
+    char buf[512];
+    int len = snprintf(buf, sizeof(buf), "stats");
+
+    struct rtt_percentiles rtt;
+    if (automation->rtt_stats
+            && rtt_stats_get_percentiles(automation->rtt_stats, &rtt)) {
+        // in microseconds
+        len += snprintf(&buf[len], sizeof(buf) - len,
+                        " rtt_p50=%" PRIu32 " rtt_p90=%" PRIu32
+                        " rtt_p99=%" PRIu32 " rtt_max=%" PRIu32,
+                        rtt.p50, rtt.p90, rtt.p99, rtt.max);
+    }
+
+    mutex_lock(automation->mutex);
+    struct controller *controller = automation->controller;
+    struct control_lane_stats reliable;
+    struct control_lane_stats lossy;
+    if (controller) {
+        controller_get_lane_stats(controller, &reliable, &lossy);
+    }
+    mutex_unlock(automation->mutex);
+
+    if (controller) {
+        len += snprintf(&buf[len], sizeof(buf) - len,
+                        " reliable_pushed=%" PRIu64 " lossy_pushed=%" PRIu64
+                        " lossy_merged=%" PRIu64 " lossy_dropped=%" PRIu64,
+                        reliable.pushed, lossy.pushed, lossy.merged,
+                        lossy.dropped);
+    }
+
+    snprintf(&buf[len], sizeof(buf) - len, "\n");
+    return send_str(socket, buf);
+}
+
+static bool
+send_frame(struct automation *automation, socket_t socket) {
+    uint8_t *data;
+    size_t len;
+    struct size size;
+    if (!video_buffer_copy_frame(automation->video_buffer, &data, &len,
+                                 &size)) {
+        return send_error(socket, "no frame available");
+    }
+
+    char header[64];
+    snprintf(header, sizeof(header), "frame %" PRIu16 " %" PRIu16 " %zu\n",
+             size.width, size.height, len);
+    bool ok = send_str(socket, header)
+           && net_send_all(socket, data, len) == (ssize_t) len;
+    SDL_free(data);
+    return ok;
+}
+
+// return false if the client must be disconnected
+static bool
+process_line(struct automation *automation, socket_t socket, char *line) {
+    struct size frame_size =
+        video_buffer_get_frame_size(automation->video_buffer);
+
+    struct automation_cmd cmd;
+    const char *error;
+    if (!automation_cmd_parse(line, frame_size, &cmd, &error)) {
+        return send_error(socket, error);
+    }
+
+    switch (cmd.type) {
+        case AUTOMATION_CMD_INPUT:
+            return push_input(automation, socket, &cmd);
+        case AUTOMATION_CMD_GET_SIZE: {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "size %" PRIu16 " %" PRIu16 "\n",
+                     frame_size.width, frame_size.height);
+            return send_str(socket, buf);
+        }
+        case AUTOMATION_CMD_GET_STATS:
+            return send_stats(automation, socket);
+        case AUTOMATION_CMD_GET_FRAME:
+            return send_frame(automation, socket);
+        case AUTOMATION_CMD_SYNC:
+            return send_str(socket, "sync\n");
+    }
+    assert(!"unexpected command type");
+    return false;
+}
+
+static void
+read_lines(struct automation *automation, socket_t socket) {
+    char buf[AUTOMATION_LINE_MAX];
+    size_t len = 0;
+    // the current line is too long, discard it until its end
+    bool discard = false;
+    for (;;) {
+        ssize_t r = net_recv(socket, &buf[len], sizeof(buf) - len);
+        if (r <= 0) {
+            return;
+        }
+        len += r;
+
+        size_t head = 0;
+        char *eol;
+        while ((eol = memchr(&buf[head], '\n', len - head))) {
+            *eol = '\0';
+            char *line = &buf[head];
+            head = eol - buf + 1;
+            if (discard) {
+                discard = false;
+                continue;
+            }
+            size_t line_len = eol - line;
+            if (line_len && line[line_len - 1] == '\r') {
+                line[line_len - 1] = '\0';
+            }
+            if (!process_line(automation, socket, line)) {
+                return;
+            }
+        }
+
+        memmove(buf, &buf[head], len - head);
+        len -= head;
+        if (len == sizeof(buf)) {
+            if (!discard && !send_error(socket, "line too long")) {
+                return;
+            }
+            discard = true;
+            len = 0;
+        }
+    }
+}
+
+static void
+serve_client(socket_t socket, void *userdata) {
+    struct automation *automation = userdata;
+    LOGI("Automation client connected");
+    read_lines(automation, socket);
+    LOGI("Automation client disconnected");
+}
+
+bool
+automation_start(struct automation *automation) {
+    LOGD("Starting automation thread");
+
+    if (!accept_loop_start(&automation->loop, "automation")) {
+        return false;
+    }
+
+    LOGI("Automation socket listening on \"%s\"", automation->path);
+    return true;
+}
+
+void
+automation_stop(struct automation *automation) {
+    accept_loop_stop(&automation->loop);
+}
+
+void
+automation_join(struct automation *automation) {
+    accept_loop_join(&automation->loop);
+}
+
+void
+automation_set_controller(struct automation *automation,
+                          struct controller *controller) {
+    mutex_lock(automation->mutex);
+    automation->controller = controller;
+    mutex_unlock(automation->mutex);
+}
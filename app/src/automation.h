@@ -0,0 +1,59 @@
+#ifndef AUTOMATION_H
+#define AUTOMATION_H
+
+#include <stdbool.h>
+#include <SDL2/SDL_mutex.h>
+
+#include "config.h"
+#include "controller.h"
+#include "rtt_stats.h"
+#include "video_buffer.h"
+#include "util/accept_loop.h"
+
+// max length of a command line (longer lines are rejected)
+#define AUTOMATION_LINE_MAX 4096
+
+// Serve the automation API (see automation_cmd.h) on a Unix domain socket, so
+// that scripts can inject input events and read the frames without the
+// overhead of spawning "adb shell input" for each event.
+//
+// The commands are pipelined: input commands are not acknowledged (only
+// errors are reported, as "error <message>"), "sync" replies "sync" once all
+// the previous commands have been pushed to the controller.
+//
+// A single client is served at a time.
+struct automation {
+    char *path;
+    struct accept_loop loop;
+    SDL_mutex *mutex;
+    // NULL while the device is disconnected (protected by the mutex)
+    struct controller *controller;
+    struct video_buffer *video_buffer;
+    struct rtt_stats *rtt_stats; // may be NULL
+};
+
+bool
+automation_init(struct automation *automation, const char *path,
+                struct video_buffer *video_buffer,
+                struct rtt_stats *rtt_stats);
+
+void
+automation_destroy(struct automation *automation);
+
+bool
+automation_start(struct automation *automation);
+
+void
+automation_stop(struct automation *automation);
+
+void
+automation_join(struct automation *automation);
+
+// set the controller to which the input events are pushed, or NULL (the
+// input commands then fail)
+// once it returns, the previous controller is not accessed anymore
+void
+automation_set_controller(struct automation *automation,
+                          struct controller *controller);
+
+#endif
@@ -0,0 +1,272 @@
+#include "automation_cmd.h"
+
+#include <string.h>
+#include <SDL2/SDL_stdinc.h>
+
+#include "config.h"
+#include "util/str_util.h"
+
+// return the next space-separated token, or NULL if there is none
+static char *
+next_token(char **s) {
+    char *p = *s;
+    while (*p == ' ') {
+        ++p;
+    }
+    if (!*p) {
+        *s = p;
+        return NULL;
+    }
+    char *token = p;
+    while (*p && *p != ' ') {
+        ++p;
+    }
+    if (*p) {
+        *p++ = '\0';
+    }
+    *s = p;
+    return token;
+}
+
+static bool
+next_integer(char **s, long min, long max, long *value) {
+    char *token = next_token(s);
+    return token && parse_integer(token, value)
+                 && *value >= min && *value <= max;
+}
+
+static bool
+is_end(char **s) {
+    return !next_token(s);
+}
+
+static bool
+parse_position(char **s, struct size frame_size, struct position *position,
+               const char **error) {
+    if (!frame_size.width || !frame_size.height) {
+        *error = "no frame received yet";
+        return false;
+    }
+    long x;
+    long y;
+    if (!next_integer(s, 0, frame_size.width - 1, &x)
+            || !next_integer(s, 0, frame_size.height - 1, &y)) {
+        *error = "invalid position";
+        return false;
+    }
+    position->screen_size = frame_size;
+    position->point.x = x;
+    position->point.y = y;
+    return true;
+}
+
+static void
+init_touch(struct control_msg *msg, enum android_motionevent_action action,
+           uint64_t pointer_id, const struct position *position) {
+    msg->type = CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT;
+    msg->inject_touch_event.action = action;
+    msg->inject_touch_event.pointer_id = pointer_id;
+    msg->inject_touch_event.position = *position;
+    msg->inject_touch_event.pressure =
+        action == AMOTION_EVENT_ACTION_UP ? 0.f : 1.f;
+    msg->inject_touch_event.buttons = 0;
+}
+
+static bool
+parse_key(char **s, struct automation_cmd *cmd, const char **error) {
+    const char *action = next_token(s);
+    bool down = action && (!strcmp(action, "down") || !strcmp(action, "press"));
+    bool up = action && (!strcmp(action, "up") || !strcmp(action, "press"));
+    if (!down && !up) {
+        *error = "invalid key action";
+        return false;
+    }
+
+    long keycode;
+    if (!next_integer(s, 0, 0xFFFF, &keycode)) {
+        *error = "invalid keycode";
+        return false;
+    }
+
+    long metastate = 0;
+    char *token = next_token(s);
+    if (token && (!parse_integer(token, &metastate) || metastate < 0
+                                                    || !is_end(s))) {
+        *error = "invalid metastate";
+        return false;
+    }
+
+    cmd->msg_count = 0;
+    if (down) {
+        struct control_msg *msg = &cmd->msgs[cmd->msg_count++];
+        msg->type = CONTROL_MSG_TYPE_INJECT_KEYCODE;
+        msg->inject_keycode.action = AKEY_EVENT_ACTION_DOWN;
+        msg->inject_keycode.keycode = keycode;
+        msg->inject_keycode.repeat = 0;
+        msg->inject_keycode.metastate = metastate;
+    }
+    if (up) {
+        struct control_msg *msg = &cmd->msgs[cmd->msg_count++];
+        msg->type = CONTROL_MSG_TYPE_INJECT_KEYCODE;
+        msg->inject_keycode.action = AKEY_EVENT_ACTION_UP;
+        msg->inject_keycode.keycode = keycode;
+        msg->inject_keycode.repeat = 0;
+        msg->inject_keycode.metastate = metastate;
+    }
+    return true;
+}
+
+static bool
+parse_text(char **s, struct automation_cmd *cmd, const char **error) {
+    // the text is the remaining of the line, spaces included
+    const char *text = *s;
+    if (!*text) {
+        *error = "empty text";
+        return false;
+    }
+
+    char *copy = SDL_strdup(text);
+    if (!copy) {
+        *error = "could not allocate text";
+        return false;
+    }
+
+    struct control_msg *msg = &cmd->msgs[0];
+    msg->type = CONTROL_MSG_TYPE_INJECT_TEXT;
+    msg->inject_text.text = copy;
+    cmd->msg_count = 1;
+    return true;
+}
+
+static bool
+parse_touch(char **s, struct size frame_size, struct automation_cmd *cmd,
+            const char **error) {
+    const char *name = next_token(s);
+    enum android_motionevent_action action;
+    if (name && !strcmp(name, "down")) {
+        action = AMOTION_EVENT_ACTION_DOWN;
+    } else if (name && !strcmp(name, "up")) {
+        action = AMOTION_EVENT_ACTION_UP;
+    } else if (name && !strcmp(name, "move")) {
+        action = AMOTION_EVENT_ACTION_MOVE;
+    } else {
+        *error = "invalid touch action";
+        return false;
+    }
+
+    long pointer_id;
+    if (!next_integer(s, 0, 0xFFFF, &pointer_id)) {
+        *error = "invalid pointer id";
+        return false;
+    }
+
+    struct position position;
+    if (!parse_position(s, frame_size, &position, error)) {
+        return false;
+    }
+
+    init_touch(&cmd->msgs[0], action, pointer_id, &position);
+    cmd->msg_count = 1;
+    return true;
+}
+
+static bool
+parse_tap(char **s, struct size frame_size, struct automation_cmd *cmd,
+          const char **error) {
+    struct position position;
+    if (!parse_position(s, frame_size, &position, error)) {
+        return false;
+    }
+
+    // pointer 0
+    init_touch(&cmd->msgs[0], AMOTION_EVENT_ACTION_DOWN, 0, &position);
+    init_touch(&cmd->msgs[1], AMOTION_EVENT_ACTION_UP, 0, &position);
+    cmd->msg_count = 2;
+    return true;
+}
+
+static bool
+parse_scroll(char **s, struct size frame_size, struct automation_cmd *cmd,
+             const char **error) {
+    struct position position;
+    if (!parse_position(s, frame_size, &position, error)) {
+        return false;
+    }
+
+    long hscroll;
+    long vscroll;
+    if (!next_integer(s, INT32_MIN, INT32_MAX, &hscroll)
+            || !next_integer(s, INT32_MIN, INT32_MAX, &vscroll)) {
+        *error = "invalid scroll amount";
+        return false;
+    }
+
+    struct control_msg *msg = &cmd->msgs[0];
+    msg->type = CONTROL_MSG_TYPE_INJECT_SCROLL_EVENT;
+    msg->inject_scroll_event.position = position;
+    msg->inject_scroll_event.hscroll = hscroll;
+    msg->inject_scroll_event.vscroll = vscroll;
+    cmd->msg_count = 1;
+    return true;
+}
+
+static bool
+parse_get(char **s, struct automation_cmd *cmd, const char **error) {
+    const char *what = next_token(s);
+    if (what && !strcmp(what, "size")) {
+        cmd->type = AUTOMATION_CMD_GET_SIZE;
+    } else if (what && !strcmp(what, "stats")) {
+        cmd->type = AUTOMATION_CMD_GET_STATS;
+    } else if (what && !strcmp(what, "frame")) {
+        cmd->type = AUTOMATION_CMD_GET_FRAME;
+    } else {
+        *error = "invalid query";
+        return false;
+    }
+    return true;
+}
+
+bool
+automation_cmd_parse(char *line, struct size frame_size,
+                     struct automation_cmd *cmd, const char **error) {
+    char *s = line;
+    const char *name = next_token(&s);
+    if (!name) {
+        *error = "empty command";
+        return false;
+    }
+
+    cmd->type = AUTOMATION_CMD_INPUT;
+    cmd->msg_count = 0;
+
+    bool ok;
+    if (!strcmp(name, "key")) {
+        ok = parse_key(&s, cmd, error);
+    } else if (!strcmp(name, "text")) {
+        return parse_text(&s, cmd, error);
+    } else if (!strcmp(name, "touch")) {
+        ok = parse_touch(&s, frame_size, cmd, error);
+    } else if (!strcmp(name, "tap")) {
+        ok = parse_tap(&s, frame_size, cmd, error);
+    } else if (!strcmp(name, "scroll")) {
+        ok = parse_scroll(&s, frame_size, cmd, error);
+    } else if (!strcmp(name, "back")) {
+        cmd->msgs[0].type = CONTROL_MSG_TYPE_BACK_OR_SCREEN_ON;
+        cmd->msg_count = 1;
+        ok = true;
+    } else if (!strcmp(name, "get")) {
+        ok = parse_get(&s, cmd, error);
+    } else if (!strcmp(name, "sync")) {
+        cmd->type = AUTOMATION_CMD_SYNC;
+        ok = true;
+    } else {
+        *error = "unknown command";
+        return false;
+    }
+
+    if (ok && !is_end(&s)) {
+        *error = "too many arguments";
+        return false;
+    }
+    return ok;
+}
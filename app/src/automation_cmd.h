@@ -0,0 +1,50 @@
+#ifndef AUTOMATION_CMD_H
+#define AUTOMATION_CMD_H
+
+#include <stdbool.h>
+
+#include "config.h"
+#include "common.h"
+#include "control_msg.h"
+
+// Commands of the automation socket, one per line (see README.md):
+//
+//     key <down|up|press> <keycode> [<metastate>]
+//     text <text>
+//     touch <down|up|move> <pointer_id> <x> <y>
+//     tap <x> <y>
+//     scroll <x> <y> <hscroll> <vscroll>
+//     back
+//     get <size|stats|frame>
+//     sync
+//
+// Keycodes and metastates are the Android values (AKEYCODE_*, AMETA_*).
+// Positions are in pixels of the current frame.
+
+// a "press" or a "tap" generates 2 messages
+#define AUTOMATION_CMD_MAX_MSGS 2
+
+enum automation_cmd_type {
+    AUTOMATION_CMD_INPUT,
+    AUTOMATION_CMD_GET_SIZE,
+    AUTOMATION_CMD_GET_STATS,
+    AUTOMATION_CMD_GET_FRAME,
+    AUTOMATION_CMD_SYNC,
+};
+
+struct automation_cmd {
+    enum automation_cmd_type type;
+    // for AUTOMATION_CMD_INPUT, to be pushed to the controller
+    struct control_msg msgs[AUTOMATION_CMD_MAX_MSGS];
+    unsigned msg_count;
+};
+
+// parse a command line (without the end of line), modifying it in place
+// frame_size is the size of the current frame (0x0 if none), to which the
+// positions apply
+// on error, return false and set *error to a static message
+bool
+automation_cmd_parse(char *line, struct size frame_size,
+                     struct automation_cmd *cmd, const char **error);
+
+#endif
@@ -4,11 +4,13 @@
 #include <getopt.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "config.h"
 #include "scrcpy.h"
 #include "util/log.h"
+#include "util/net.h"
 #include "util/str_util.h"
 
 void
@@ -21,11 +23,22 @@ scrcpy_print_usage(const char *arg0) {
         "    --always-on-top\n"
         "        Make scrcpy window always on top (above other windows).\n"
         "\n"
+        "    --automation-socket path\n"
+        "        Listen on a Unix domain socket at the given path, to inject\n"
+        "        input events and read frames from a script, one command per\n"
+        "        line (see the README). It requires display and control.\n"
+        "        Not supported on Windows.\n"
+        "\n"
         "    -b, --bit-rate value\n"
         "        Encode the video at the given bit-rate, expressed in bits/s.\n"
         "        Unit suffixes are supported: 'K' (x1000) and 'M' (x1000000).\n"
         "        Default is %d.\n"
         "\n"
+        "    --busy-poll usec\n"
+        "        Busy poll the sockets for up to usec microseconds on receive\n"
+        "        instead of waiting for an interrupt (Linux only). This may\n"
+        "        reduce latency at the cost of CPU usage.\n"
+        "\n"
         "    --codec-options key[:type]=value[,...]\n"
         "        Set a list of comma-separated key:type=value options for the\n"
         "        device encoder.\n"
@@ -44,6 +57,23 @@ scrcpy_print_usage(const char *arg0) {
         "    --disable-screensaver\n"
         "        Disable screensaver while scrcpy is running.\n"
         "\n"
+        "    --direct-tcp ip[:port]\n"
+        "        Connect directly to the device over TCP/IP, without any adb\n"
+        "        tunnel (the device must be reachable at the given address).\n"
+        "        The server still is started via adb, and listens on the\n"
+        "        given port on the device loopback interface only (typically\n"
+        "        reached through \"adb forward tcp:port tcp:port\"), unless\n"
+        "        --direct-tcp-all-interfaces is set.\n"
+        "        Default port is %d.\n"
+        "\n"
+        "    --direct-tcp-all-interfaces\n"
+        "        With --direct-tcp, listen on all the device network\n"
+        "        interfaces, so that the client may connect over the network.\n"
+        "        The connection is not authenticated nor encrypted: anyone\n"
+        "        able to reach the device may view its screen and control it\n"
+        "        until the client is connected. Use only on a trusted\n"
+        "        network.\n"
+        "\n"
         "    --display id\n"
         "        Specify the display id to mirror.\n"
         "\n"
@@ -53,6 +83,12 @@ scrcpy_print_usage(const char *arg0) {
         "\n"
         "        Default is 0.\n"
         "\n"
+        "    --follow-window-size\n"
+        "        Request the device to adapt the video size to the window\n"
+        "        size when it is resized (within the --max-size limit), to\n"
+        "        avoid encoding and transmitting pixels which are not\n"
+        "        displayed.\n"
+        "\n"
         "    --force-adb-forward\n"
         "        Do not attempt to use \"adb reverse\" to connect to the\n"
         "        the device.\n"
@@ -63,6 +99,10 @@ scrcpy_print_usage(const char *arg0) {
         "    -h, --help\n"
         "        Print this help.\n"
         "\n"
+        "    --legacy-control\n"
+        "        Encode the control messages with fixed-width fields, as\n"
+        "        before the compact encoding (mainly for comparison).\n"
+        "\n"
         "    --lock-video-orientation value\n"
         "        Lock video orientation to value.\n"
         "        Possible values are -1 (unlocked), 0, 1, 2 and 3.\n"
@@ -80,6 +120,17 @@ scrcpy_print_usage(const char *arg0) {
         "        is preserved.\n"
         "        Default is %d%s.\n"
         "\n"
+        "    --metrics-all-interfaces\n"
+        "        With --metrics-port, serve the metrics on all the network\n"
+        "        interfaces, so that a remote server can scrape them. The\n"
+        "        endpoint is not authenticated.\n"
+        "\n"
+        "    --metrics-port port\n"
+        "        Serve the metrics (frames, drops, latencies, control\n"
+        "        messages...) over HTTP on this port, on localhost only\n"
+        "        (unless --metrics-all-interfaces is set), in the Prometheus\n"
+        "        text format (GET /metrics).\n"
+        "\n"
         "    -n, --no-control\n"
         "        Disable device control (mirror the device in read-only).\n"
         "\n"
@@ -99,6 +150,14 @@ scrcpy_print_usage(const char *arg0) {
         "        Set the TCP port (range) used by the client to listen.\n"
         "        Default is %d:%d.\n"
         "\n"
+        "    --persistent-server seconds\n"
+        "        Keep the server running on the device after scrcpy exits, so\n"
+        "        that the next launch attaches to it immediately, without\n"
+        "        pushing and starting it again. The server exits if no client\n"
+        "        attaches for the given duration.\n"
+        "        This implies --force-adb-forward (unless --direct-tcp is\n"
+        "        used).\n"
+        "\n"
         "    --prefer-text\n"
         "        Inject alpha characters and space as text events instead of\n"
         "        key events.\n"
@@ -111,6 +170,20 @@ scrcpy_print_usage(const char *arg0) {
         "        drag & drop. It is passed as-is to \"adb push\".\n"
         "        Default is \"/sdcard/\".\n"
         "\n"
+        "    --push-workers n\n"
+        "        Set the number of files pushed or APKs installed in parallel\n"
+        "        by drag & drop (between 1 and 8). Several files dropped at\n"
+        "        once are pushed by a single \"adb push\" command if the push\n"
+        "        target is a directory (ending with '/').\n"
+        "        Default is 2.\n"
+        "\n"
+        "    --reconnect retries\n"
+        "        On disconnection (e.g. USB unplugged, adb restarted), restart\n"
+        "        the server and reconnect, keeping the window, up to the\n"
+        "        given number of attempts (one per second). The recording\n"
+        "        continues in a new file, named after the initial one with a\n"
+        "        segment number (file-1.mp4, file-2.mp4...).\n"
+        "\n"
         "    -r, --record file.mp4\n"
         "        Record screen to file.\n"
         "        The format is determined by the --record-format option if\n"
@@ -137,6 +210,11 @@ scrcpy_print_usage(const char *arg0) {
         "        Possibles values are 0, 1, 2 and 3. Each increment adds a 90\n"
         "        degrees rotation counterclockwise.\n"
         "\n"
+        "    --rtt-warning ms\n"
+        "        Log a warning when the round-trip time of the control\n"
+        "        channel exceeds the given value (in milliseconds).\n"
+        "        Default is 0 (disabled).\n"
+        "\n"
         "    -s, --serial serial\n"
         "        The device serial number. Mandatory only if several devices\n"
         "        are connected to adb.\n"
@@ -154,6 +232,17 @@ scrcpy_print_usage(const char *arg0) {
         "\n"
         "        Default is \"lalt,lsuper\" (left-Alt or left-Super).\n"
         "\n"
+        "    --startup-timeline file.json\n"
+        "        Write the duration of each startup phase, up to the first\n"
+        "        frame, as a JSON line in the given file.\n"
+        "\n"
+        "    --trace file.json\n"
+        "        Record the timeline of the hot operations of each thread\n"
+        "        (receiving, parsing, decoding, uploading and presenting the\n"
+        "        frames, muxing, sending control messages), and write it in\n"
+        "        the Chrome trace format on exit (and on SIGUSR1, except on\n"
+        "        Windows).\n"
+        "\n"
         "    -S, --turn-screen-off\n"
         "        Turn the device screen off immediately.\n"
         "\n"
@@ -279,6 +368,9 @@ scrcpy_print_usage(const char *arg0) {
         "    MOD+i\n"
         "        Enable/disable FPS counter (print frames/second in logs)\n"
         "\n"
+        "    MOD+Shift+i\n"
+        "        Show/hide the performance HUD (overlay over the video)\n"
+        "\n"
         "    Ctrl+click-and-move\n"
         "        Pinch-to-zoom from the center of the screen\n"
         "\n"
@@ -287,6 +379,7 @@ scrcpy_print_usage(const char *arg0) {
         "\n",
         arg0,
         DEFAULT_BIT_RATE,
+        DEFAULT_LOCAL_PORT_RANGE_FIRST,
         DEFAULT_LOCK_VIDEO_ORIENTATION, DEFAULT_LOCK_VIDEO_ORIENTATION >= 0 ? "" : " (unlocked)",
         DEFAULT_MAX_SIZE, DEFAULT_MAX_SIZE ? "" : " (unlimited)",
         DEFAULT_LOCAL_PORT_RANGE_FIRST, DEFAULT_LOCAL_PORT_RANGE_LAST);
@@ -475,6 +568,111 @@ parse_display_id(const char *s, uint16_t *display_id) {
     return true;
 }
 
+static bool
+parse_direct_tcp(const char *s, uint32_t *addr, uint16_t *port) {
+    // format: "ip[:port]"
+    const char *colon = strchr(s, ':');
+    size_t addr_len = colon ? (size_t) (colon - s) : strlen(s);
+    char addr_str[16]; // "255.255.255.255" + '\0'
+    if (addr_len >= sizeof(addr_str)) {
+        LOGE("Invalid IPv4 address: %s", s);
+        return false;
+    }
+    memcpy(addr_str, s, addr_len);
+    addr_str[addr_len] = '\0';
+
+    if (!net_parse_ipv4(addr_str, addr)) {
+        LOGE("Invalid IPv4 address: %s", addr_str);
+        return false;
+    }
+
+    if (colon) {
+        long value;
+        bool ok = parse_integer_arg(colon + 1, &value, false, 1, 0xFFFF,
+                                    "port");
+        if (!ok) {
+            return false;
+        }
+        *port = (uint16_t) value;
+    }
+
+    return true;
+}
+
+static bool
+parse_busy_poll(const char *s, uint32_t *busy_poll_us) {
+    long value;
+    bool ok = parse_integer_arg(s, &value, false, 0, 1000000, "busy poll");
+    if (!ok) {
+        return false;
+    }
+
+    *busy_poll_us = (uint32_t) value;
+    return true;
+}
+
+static bool
+parse_persistent_server(const char *s, uint32_t *timeout) {
+    long value;
+    bool ok = parse_integer_arg(s, &value, false, 1, 86400,
+                                "persistent server timeout");
+    if (!ok) {
+        return false;
+    }
+
+    *timeout = (uint32_t) value;
+    return true;
+}
+
+static bool
+parse_reconnect(const char *s, uint16_t *retries) {
+    long value;
+    bool ok = parse_integer_arg(s, &value, false, 0, 0xFFFF,
+                                "reconnect retries");
+    if (!ok) {
+        return false;
+    }
+
+    *retries = (uint16_t) value;
+    return true;
+}
+
+static bool
+parse_rtt_warning(const char *s, uint32_t *rtt_warning) {
+    long value;
+    bool ok = parse_integer_arg(s, &value, false, 0, 60000, "RTT warning");
+    if (!ok) {
+        return false;
+    }
+
+    *rtt_warning = (uint32_t) value;
+    return true;
+}
+
+static bool
+parse_metrics_port(const char *s, uint16_t *port) {
+    long value;
+    bool ok = parse_integer_arg(s, &value, false, 1, 0xFFFF, "metrics port");
+    if (!ok) {
+        return false;
+    }
+
+    *port = (uint16_t) value;
+    return true;
+}
+
+static bool
+parse_push_workers(const char *s, uint8_t *workers) {
+    long value;
+    bool ok = parse_integer_arg(s, &value, false, 1, 8, "push workers");
+    if (!ok) {
+        return false;
+    }
+
+    *workers = (uint8_t) value;
+    return true;
+}
+
 static bool
 parse_log_level(const char *s, enum sc_log_level *log_level) {
     if (!strcmp(s, "debug")) {
@@ -651,42 +849,77 @@ guess_record_format(const char *filename) {
 #define OPT_DISABLE_SCREENSAVER    1020
 #define OPT_SHORTCUT_MOD           1021
 #define OPT_NO_KEY_REPEAT          1022
+#define OPT_FOLLOW_WINDOW_SIZE     1023
+#define OPT_DIRECT_TCP             1024
+#define OPT_BUSY_POLL              1025
+#define OPT_STARTUP_TIMELINE       1026
+#define OPT_PERSISTENT_SERVER      1027
+#define OPT_RECONNECT              1028
+#define OPT_RTT_WARNING            1029
+#define OPT_AUTOMATION_SOCKET      1030
+#define OPT_LEGACY_CONTROL         1031
+#define OPT_METRICS_PORT           1032
+#define OPT_TRACE                  1033
+#define OPT_PUSH_WORKERS           1034
+#define OPT_DIRECT_TCP_ALL_INTERFACES 1035
+#define OPT_METRICS_ALL_INTERFACES 1036
 
 bool
 scrcpy_parse_args(struct scrcpy_cli_args *args, int argc, char *argv[]) {
     static const struct option long_options[] = {
         {"always-on-top",          no_argument,       NULL, OPT_ALWAYS_ON_TOP},
+        {"automation-socket",      required_argument, NULL,
+                                                  OPT_AUTOMATION_SOCKET},
         {"bit-rate",               required_argument, NULL, 'b'},
+        {"busy-poll",              required_argument, NULL, OPT_BUSY_POLL},
         {"codec-options",          required_argument, NULL, OPT_CODEC_OPTIONS},
         {"crop",                   required_argument, NULL, OPT_CROP},
         {"disable-screensaver",    no_argument,       NULL,
                                                   OPT_DISABLE_SCREENSAVER},
+        {"direct-tcp",             required_argument, NULL, OPT_DIRECT_TCP},
+        {"direct-tcp-all-interfaces", no_argument, NULL,
+            OPT_DIRECT_TCP_ALL_INTERFACES},
         {"display",                required_argument, NULL, OPT_DISPLAY_ID},
+        {"follow-window-size",     no_argument,       NULL,
+                                                  OPT_FOLLOW_WINDOW_SIZE},
         {"force-adb-forward",      no_argument,       NULL,
                                                   OPT_FORCE_ADB_FORWARD},
         {"fullscreen",             no_argument,       NULL, 'f'},
         {"help",                   no_argument,       NULL, 'h'},
+        {"legacy-control",         no_argument,       NULL,
+                                                  OPT_LEGACY_CONTROL},
         {"lock-video-orientation", required_argument, NULL,
                                                   OPT_LOCK_VIDEO_ORIENTATION},
         {"max-fps",                required_argument, NULL, OPT_MAX_FPS},
         {"max-size",               required_argument, NULL, 'm'},
+        {"metrics-all-interfaces", no_argument,       NULL,
+                                                  OPT_METRICS_ALL_INTERFACES},
+        {"metrics-port",           required_argument, NULL, OPT_METRICS_PORT},
         {"no-control",             no_argument,       NULL, 'n'},
         {"no-display",             no_argument,       NULL, 'N'},
         {"no-mipmaps",             no_argument,       NULL, OPT_NO_MIPMAPS},
         {"no-key-repeat",          no_argument,       NULL, OPT_NO_KEY_REPEAT},
         {"port",                   required_argument, NULL, 'p'},
+        {"persistent-server",      required_argument, NULL,
+                                                  OPT_PERSISTENT_SERVER},
         {"prefer-text",            no_argument,       NULL, OPT_PREFER_TEXT},
         {"push-target",            required_argument, NULL, OPT_PUSH_TARGET},
+        {"push-workers",           required_argument, NULL, OPT_PUSH_WORKERS},
+        {"reconnect",              required_argument, NULL, OPT_RECONNECT},
         {"record",                 required_argument, NULL, 'r'},
         {"record-format",          required_argument, NULL, OPT_RECORD_FORMAT},
         {"render-driver",          required_argument, NULL, OPT_RENDER_DRIVER},
         {"render-expired-frames",  no_argument,       NULL,
                                                   OPT_RENDER_EXPIRED_FRAMES},
         {"rotation",               required_argument, NULL, OPT_ROTATION},
+        {"rtt-warning",            required_argument, NULL, OPT_RTT_WARNING},
         {"serial",                 required_argument, NULL, 's'},
         {"shortcut-mod",           required_argument, NULL, OPT_SHORTCUT_MOD},
         {"show-touches",           no_argument,       NULL, 't'},
+        {"startup-timeline",       required_argument, NULL,
+                                                  OPT_STARTUP_TIMELINE},
         {"stay-awake",             no_argument,       NULL, 'w'},
+        {"trace",                  required_argument, NULL, OPT_TRACE},
         {"turn-screen-off",        no_argument,       NULL, 'S'},
         {"verbosity",              required_argument, NULL, 'V'},
         {"version",                no_argument,       NULL, 'v'},
@@ -782,6 +1015,9 @@ scrcpy_parse_args(struct scrcpy_cli_args *args, int argc, char *argv[]) {
             case OPT_ALWAYS_ON_TOP:
                 opts->always_on_top = true;
                 break;
+            case OPT_AUTOMATION_SOCKET:
+                opts->automation_socket = optarg;
+                break;
             case 'v':
                 args->version = true;
                 break;
@@ -825,6 +1061,14 @@ scrcpy_parse_args(struct scrcpy_cli_args *args, int argc, char *argv[]) {
             case OPT_PUSH_TARGET:
                 opts->push_target = optarg;
                 break;
+            case OPT_DIRECT_TCP_ALL_INTERFACES:
+                opts->direct_tcp_all_interfaces = true;
+                break;
+            case OPT_PUSH_WORKERS:
+                if (!parse_push_workers(optarg, &opts->push_workers)) {
+                    return false;
+                }
+                break;
             case OPT_PREFER_TEXT:
                 opts->prefer_text = true;
                 break;
@@ -833,6 +1077,19 @@ scrcpy_parse_args(struct scrcpy_cli_args *args, int argc, char *argv[]) {
                     return false;
                 }
                 break;
+            case OPT_RTT_WARNING:
+                if (!parse_rtt_warning(optarg, &opts->rtt_warning)) {
+                    return false;
+                }
+                break;
+            case OPT_METRICS_PORT:
+                if (!parse_metrics_port(optarg, &opts->metrics_port)) {
+                    return false;
+                }
+                break;
+            case OPT_METRICS_ALL_INTERFACES:
+                opts->metrics_all_interfaces = true;
+                break;
             case OPT_RENDER_DRIVER:
                 opts->render_driver = optarg;
                 break;
@@ -851,6 +1108,41 @@ scrcpy_parse_args(struct scrcpy_cli_args *args, int argc, char *argv[]) {
             case OPT_DISABLE_SCREENSAVER:
                 opts->disable_screensaver = true;
                 break;
+            case OPT_FOLLOW_WINDOW_SIZE:
+                opts->follow_window_size = true;
+                break;
+            case OPT_DIRECT_TCP:
+                if (!parse_direct_tcp(optarg, &opts->direct_tcp_addr,
+                                      &opts->direct_tcp_port)) {
+                    return false;
+                }
+                opts->direct_tcp = true;
+                break;
+            case OPT_BUSY_POLL:
+                if (!parse_busy_poll(optarg, &opts->busy_poll_us)) {
+                    return false;
+                }
+                break;
+            case OPT_STARTUP_TIMELINE:
+                opts->startup_timeline_filename = optarg;
+                break;
+            case OPT_TRACE:
+                opts->trace_filename = optarg;
+                break;
+            case OPT_LEGACY_CONTROL:
+                opts->legacy_control = true;
+                break;
+            case OPT_RECONNECT:
+                if (!parse_reconnect(optarg, &opts->reconnect_retries)) {
+                    return false;
+                }
+                break;
+            case OPT_PERSISTENT_SERVER:
+                if (!parse_persistent_server(
+                        optarg, &opts->persistent_server_timeout)) {
+                    return false;
+                }
+                break;
             case OPT_SHORTCUT_MOD:
                 if (!parse_shortcut_mods(optarg, &opts->shortcut_mods)) {
                     return false;
@@ -897,5 +1189,50 @@ scrcpy_parse_args(struct scrcpy_cli_args *args, int argc, char *argv[]) {
         return false;
     }
 
+    if (!opts->control && opts->follow_window_size) {
+        LOGE("Could not follow the window size if control is disabled");
+        return false;
+    }
+
+    if ((!opts->display || !opts->control) && opts->automation_socket) {
+        LOGE("The automation socket requires display and control");
+        return false;
+    }
+
+    if (opts->metrics_all_interfaces && !opts->metrics_port) {
+        LOGE("--metrics-all-interfaces requires --metrics-port");
+        return false;
+    }
+
+    if (opts->direct_tcp_all_interfaces && !opts->direct_tcp) {
+        LOGE("--direct-tcp-all-interfaces requires --direct-tcp");
+        return false;
+    }
+
+    // 127.0.0.0/8
+    bool loopback = (opts->direct_tcp_addr >> 24) == 127;
+    if (opts->direct_tcp && !loopback && !opts->direct_tcp_all_interfaces) {
+        LOGE("The device listens on its loopback interface only: to connect "
+             "over the network, pass --direct-tcp-all-interfaces (the "
+             "connection is not authenticated)");
+        return false;
+    }
+
+    if (opts->direct_tcp && opts->force_adb_forward) {
+        LOGE("Could not force adb forward with a direct TCP connection");
+        return false;
+    }
+
+    if (!opts->display && opts->follow_window_size) {
+        LOGE("Could not follow the window size if display is disabled");
+        return false;
+    }
+
+    if (!opts->display && opts->startup_timeline_filename) {
+        LOGE("The startup timeline requires display (it ends on the first "
+             "frame)");
+        return false;
+    }
+
     return true;
 }
@@ -0,0 +1,79 @@
+#include "clock_sync.h"
+
+#include <inttypes.h>
+
+#include "config.h"
+#include "util/lock.h"
+#include "util/log.h"
+
+bool
+clock_sync_init(struct clock_sync *sync) {
+    if (!(sync->mutex = SDL_CreateMutex())) {
+        return false;
+    }
+    sync->head = 0;
+    sync->count = 0;
+    return true;
+}
+
+void
+clock_sync_destroy(struct clock_sync *sync) {
+    SDL_DestroyMutex(sync->mutex);
+}
+
+// must be called with mutex locked
+static void
+select_best(struct clock_sync *sync) {
+    const struct clock_sync_sample *best = &sync->samples[0];
+    for (unsigned i = 1; i < sync->count; ++i) {
+        if (sync->samples[i].delay < best->delay) {
+            best = &sync->samples[i];
+        }
+    }
+    sync->best = *best;
+}
+
+void
+clock_sync_add_exchange(struct clock_sync *sync, uint64_t t0, uint64_t t1,
+                        uint64_t t2, uint64_t t3) {
+    if (t3 < t0 || t2 < t1 || t3 - t0 < t2 - t1) {
+        LOGW("Invalid clock synchronization timestamps");
+        return;
+    }
+
+    struct clock_sync_sample sample = {
+        .offset = ((int64_t) (t1 - t0) + (int64_t) (t2 - t3)) / 2,
+        .delay = (t3 - t0) - (t2 - t1),
+    };
+
+    mutex_lock(sync->mutex);
+    bool first = !sync->count;
+    sync->samples[sync->head] = sample;
+    sync->head = (sync->head + 1) % CLOCK_SYNC_WINDOW;
+    if (sync->count < CLOCK_SYNC_WINDOW) {
+        ++sync->count;
+    }
+    select_best(sync);
+    mutex_unlock(sync->mutex);
+
+    if (first) {
+        LOGD("Clocks synchronized: offset %" PRId64 " µs (delay %" PRIu64
+             " µs)", sample.offset, sample.delay);
+    }
+}
+
+bool
+clock_sync_to_client_time(struct clock_sync *sync, uint64_t device_time,
+                          uint64_t *client_time) {
+    mutex_lock(sync->mutex);
+    bool synchronized = sync->count;
+    int64_t offset = sync->best.offset;
+    mutex_unlock(sync->mutex);
+
+    if (!synchronized) {
+        return false;
+    }
+
+    *client_time = device_time - offset;
+    return true;
+}
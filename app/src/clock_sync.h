@@ -0,0 +1,58 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL2/SDL_mutex.h>
+
+#include "config.h"
+
+// number of recent exchanges the offset is selected from
+#define CLOCK_SYNC_WINDOW 8
+
+// Estimate the offset between the device clock and the client clock (both in
+// µs), NTP-style, from the ping/pong exchanges:
+//  - t0: the client sends the ping (client clock)
+//  - t1: the device receives the ping (device clock)
+//  - t2: the device sends the pong (device clock)
+//  - t3: the client receives the pong (client clock)
+//
+//     offset = ((t1 - t0) + (t2 - t3)) / 2
+//     delay = (t3 - t0) - (t2 - t1)
+//
+// The error of an offset is at most half the delay, so the offset of the
+// exchange having the smallest delay among the recent ones is kept. Since the
+// pings are periodic, the window slides and the drift between the clocks is
+// tracked.
+
+struct clock_sync_sample {
+    int64_t offset; // device time - client time
+    uint64_t delay;
+};
+
+struct clock_sync {
+    SDL_mutex *mutex;
+    struct clock_sync_sample samples[CLOCK_SYNC_WINDOW];
+    unsigned head;
+    unsigned count;
+    // the selected sample, valid if count > 0
+    struct clock_sync_sample best;
+};
+
+bool
+clock_sync_init(struct clock_sync *sync);
+
+void
+clock_sync_destroy(struct clock_sync *sync);
+
+void
+clock_sync_add_exchange(struct clock_sync *sync, uint64_t t0, uint64_t t1,
+                        uint64_t t2, uint64_t t3);
+
+// convert a device time to the client clock
+// return false if the clocks are not synchronized yet
+bool
+clock_sync_to_client_time(struct clock_sync *sync, uint64_t device_time,
+                          uint64_t *client_time);
+
+#endif
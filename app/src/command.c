@@ -165,27 +165,33 @@ adb_reverse_remove(const char *serial, const char *device_socket_name) {
 }
 
 process_t
-adb_push(const char *serial, const char *local, const char *remote) {
+adb_push(const char *serial, const char *const local[], size_t count,
+         const char *remote) {
+    const char *adb_cmd[count + 2];
+    adb_cmd[0] = "push";
+    memcpy(&adb_cmd[1], local, count * sizeof(*local));
+    adb_cmd[count + 1] = remote;
+
 #ifdef __WINDOWS__
     // Windows will parse the string, so the paths must be quoted
     // (see sys/win/command.c)
-    local = strquote(local);
-    if (!local) {
-        return PROCESS_NONE;
-    }
-    remote = strquote(remote);
-    if (!remote) {
-        SDL_free((void *) local);
-        return PROCESS_NONE;
+    for (size_t i = 1; i < count + 2; ++i) {
+        adb_cmd[i] = strquote(adb_cmd[i]);
+        if (!adb_cmd[i]) {
+            while (--i) {
+                SDL_free((void *) adb_cmd[i]);
+            }
+            return PROCESS_NONE;
+        }
     }
 #endif
 
-    const char *const adb_cmd[] = {"push", local, remote};
-    process_t proc = adb_execute(serial, adb_cmd, ARRAY_LEN(adb_cmd));
+    process_t proc = adb_execute(serial, adb_cmd, count + 2);
 
 #ifdef __WINDOWS__
-    SDL_free((void *) remote);
-    SDL_free((void *) local);
+    for (size_t i = 1; i < count + 2; ++i) {
+        SDL_free((void *) adb_cmd[i]);
+    }
 #endif
 
     return proc;
@@ -74,8 +74,11 @@ adb_reverse(const char *serial, const char *device_socket_name,
 process_t
 adb_reverse_remove(const char *serial, const char *device_socket_name);
 
+// push several local files by a single command (remote must then be a
+// directory)
 process_t
-adb_push(const char *serial, const char *local, const char *remote);
+adb_push(const char *serial, const char *const local[], size_t count,
+         const char *remote);
 
 process_t
 adb_install(const char *serial, const char *local);
@@ -77,6 +77,24 @@ control_msg_serialize(const struct control_msg *msg, unsigned char *buf) {
         case CONTROL_MSG_TYPE_SET_SCREEN_POWER_MODE:
             buf[1] = msg->set_screen_power_mode.mode;
             return 2;
+        case CONTROL_MSG_TYPE_SET_VIDEO_SIZE:
+            buffer_write16be(&buf[1], msg->set_video_size.max_size);
+            buf[3] = !!msg->set_video_size.set_crop;
+            buffer_write16be(&buf[4], msg->set_video_size.crop.size.width);
+            buffer_write16be(&buf[6], msg->set_video_size.crop.size.height);
+            buffer_write16be(&buf[8], msg->set_video_size.crop.x);
+            buffer_write16be(&buf[10], msg->set_video_size.crop.y);
+            return 12;
+        case CONTROL_MSG_TYPE_SET_VIDEO_PAUSED:
+            buf[1] = !!msg->set_video_paused.paused;
+            return 2;
+        case CONTROL_MSG_TYPE_ACK_FRAME:
+            buffer_write64be(&buf[1], msg->ack_frame.pts);
+            buffer_write16be(&buf[9], msg->ack_frame.skipped_frames);
+            return 11;
+        case CONTROL_MSG_TYPE_PING:
+            buffer_write64be(&buf[1], msg->ping.timestamp);
+            return 9;
         case CONTROL_MSG_TYPE_BACK_OR_SCREEN_ON:
         case CONTROL_MSG_TYPE_EXPAND_NOTIFICATION_PANEL:
         case CONTROL_MSG_TYPE_COLLAPSE_NOTIFICATION_PANEL:
@@ -90,6 +108,104 @@ control_msg_serialize(const struct control_msg *msg, unsigned char *buf) {
     }
 }
 
+void
+control_msg_encoder_init(struct control_msg_encoder *encoder,
+                         enum control_msg_encoding encoding) {
+    encoder->encoding = encoding;
+    // the first position always carries the screen size
+    encoder->screen_size.width = 0;
+    encoder->screen_size.height = 0;
+    encoder->point.x = 0;
+    encoder->point.y = 0;
+}
+
+// write the flags byte, and return the number of bytes written after it
+static size_t
+write_compact_position(struct control_msg_encoder *encoder, uint8_t *flags,
+                       unsigned char *buf, const struct position *position) {
+    size_t len = 0;
+    const struct size *size = &position->screen_size;
+    if (size->width != encoder->screen_size.width
+            || size->height != encoder->screen_size.height) {
+        *flags |= CONTROL_MSG_COMPACT_FLAG_SIZE;
+        len += buffer_write_varint(&buf[len], size->width);
+        len += buffer_write_varint(&buf[len], size->height);
+        encoder->screen_size = *size;
+    }
+
+    const struct point *point = &position->point;
+    len += buffer_write_svarint(&buf[len],
+                                (int64_t) point->x - encoder->point.x);
+    len += buffer_write_svarint(&buf[len],
+                                (int64_t) point->y - encoder->point.y);
+    encoder->point = *point;
+    return len;
+}
+
+static size_t
+encode_compact(struct control_msg_encoder *encoder,
+               const struct control_msg *msg, unsigned char *buf) {
+    buf[0] = msg->type;
+    switch (msg->type) {
+        case CONTROL_MSG_TYPE_INJECT_KEYCODE: {
+            buf[1] = msg->inject_keycode.action;
+            size_t len = 2;
+            len += buffer_write_varint(&buf[len],
+                                       msg->inject_keycode.keycode);
+            len += buffer_write_varint(&buf[len], msg->inject_keycode.repeat);
+            len += buffer_write_varint(&buf[len],
+                                       msg->inject_keycode.metastate);
+            return len;
+        }
+        case CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT: {
+            assert(!(msg->inject_touch_event.action
+                        & ~CONTROL_MSG_COMPACT_ACTION_MASK));
+            uint8_t flags = msg->inject_touch_event.action;
+            size_t len = 2;
+            // the pointer ids are small, or negative (mouse, virtual finger)
+            len += buffer_write_svarint(&buf[len],
+                    (int64_t) msg->inject_touch_event.pointer_id);
+            len += write_compact_position(encoder, &flags, &buf[len],
+                                          &msg->inject_touch_event.position);
+            float pressure = msg->inject_touch_event.pressure;
+            if (pressure == 0.f) {
+                flags |= CONTROL_MSG_COMPACT_FLAG_NO_PRESSURE;
+            } else if (pressure != 1.f) {
+                flags |= CONTROL_MSG_COMPACT_FLAG_PRESSURE;
+                buffer_write16be(&buf[len], to_fixed_point_16(pressure));
+                len += 2;
+            }
+            len += buffer_write_varint(&buf[len],
+                                       msg->inject_touch_event.buttons);
+            buf[1] = flags;
+            return len;
+        }
+        case CONTROL_MSG_TYPE_INJECT_SCROLL_EVENT: {
+            uint8_t flags = 0;
+            size_t len = 2;
+            len += write_compact_position(encoder, &flags, &buf[len],
+                                          &msg->inject_scroll_event.position);
+            len += buffer_write_svarint(&buf[len],
+                                        msg->inject_scroll_event.hscroll);
+            len += buffer_write_svarint(&buf[len],
+                                        msg->inject_scroll_event.vscroll);
+            buf[1] = flags;
+            return len;
+        }
+        default:
+            return control_msg_serialize(msg, buf);
+    }
+}
+
+size_t
+control_msg_encode(struct control_msg_encoder *encoder,
+                   const struct control_msg *msg, unsigned char *buf) {
+    if (encoder->encoding == CONTROL_MSG_ENCODING_COMPACT) {
+        return encode_compact(encoder, msg, buf);
+    }
+    return control_msg_serialize(msg, buf);
+}
+
 void
 control_msg_destroy(struct control_msg *msg) {
     switch (msg->type) {
@@ -31,6 +31,10 @@ enum control_msg_type {
     CONTROL_MSG_TYPE_SET_CLIPBOARD,
     CONTROL_MSG_TYPE_SET_SCREEN_POWER_MODE,
     CONTROL_MSG_TYPE_ROTATE_DEVICE,
+    CONTROL_MSG_TYPE_SET_VIDEO_SIZE,
+    CONTROL_MSG_TYPE_SET_VIDEO_PAUSED,
+    CONTROL_MSG_TYPE_ACK_FRAME,
+    CONTROL_MSG_TYPE_PING,
 };
 
 enum screen_power_mode {
@@ -70,14 +74,89 @@ struct control_msg {
         struct {
             enum screen_power_mode mode;
         } set_screen_power_mode;
+        struct {
+            uint16_t max_size; // 0 for unlimited
+            bool set_crop; // if false, the current crop is kept
+            // crop.size.width == 0 disables cropping
+            struct {
+                struct size size;
+                uint16_t x;
+                uint16_t y;
+            } crop;
+        } set_video_size;
+        struct {
+            bool paused;
+        } set_video_paused;
+        struct {
+            uint64_t pts; // PTS of the last displayed frame
+            // number of frames skipped since the previous acknowledgement
+            uint16_t skipped_frames;
+        } ack_frame;
+        struct {
+            // opaque for the device, echoed back in a pong device message
+            uint64_t timestamp;
+        } ping;
     };
 };
 
+// The control messages may be serialized in two encodings, selected for the
+// whole session by a server argument (the client and the server versions
+// always match):
+//  - the legacy encoding writes fixed-width big-endian fields;
+//  - the compact encoding writes the input events (keys, touches and scrolls)
+//    with varints (see buffer_write_varint()): the positions are delta-coded
+//    from the previous position sent, the screen size is sent only when it
+//    changes, and the pointer ids are zigzag-encoded (the mouse is -1). The
+//    other messages are written as in the legacy encoding.
+//
+// Compact input events:
+//  - keycode: type, action (u8), keycode, repeat, metastate (varints)
+//  - touch: type, action | flags (u8), pointer id (svarint), [screen width
+//    and height (varints)], dx, dy (svarints), [pressure (u16)], buttons
+//    (varint)
+//  - scroll: type, flags (u8), [screen width and height (varints)], dx, dy,
+//    hscroll, vscroll (svarints)
+enum control_msg_encoding {
+    CONTROL_MSG_ENCODING_LEGACY,
+    CONTROL_MSG_ENCODING_COMPACT,
+};
+
+// flags of the compact touch and scroll events
+// the screen size follows
+#define CONTROL_MSG_COMPACT_FLAG_SIZE 0x80
+// the pressure (16-bit fixed-point) follows, otherwise it is 1
+#define CONTROL_MSG_COMPACT_FLAG_PRESSURE 0x40
+// the pressure is 0 (no pressure follows)
+#define CONTROL_MSG_COMPACT_FLAG_NO_PRESSURE 0x20
+// the action of a compact touch event is in the other bits
+#define CONTROL_MSG_COMPACT_ACTION_MASK 0x1f
+
+// the state of the session (the compact encoding is stateful)
+struct control_msg_encoder {
+    enum control_msg_encoding encoding;
+    // the last screen size and position sent
+    struct size screen_size;
+    struct point point;
+};
+
+void
+control_msg_encoder_init(struct control_msg_encoder *encoder,
+                         enum control_msg_encoding encoding);
+
+// serialize in the legacy encoding
 // buf size must be at least CONTROL_MSG_MAX_SIZE
 // return the number of bytes written
 size_t
 control_msg_serialize(const struct control_msg *msg, unsigned char *buf);
 
+// serialize in the encoding of the session, in the order the messages are
+// sent
+// buf size must be at least CONTROL_MSG_MAX_SIZE
+// return the number of bytes written
+size_t
+control_msg_encode(struct control_msg_encoder *encoder,
+                   const struct control_msg *msg, unsigned char *buf);
+
 void
 control_msg_destroy(struct control_msg *msg);
 
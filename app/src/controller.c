@@ -1,16 +1,32 @@
 #include "controller.h"
 
 #include <assert.h>
+#include <inttypes.h>
+#include <SDL2/SDL_timer.h>
 
 #include "config.h"
+#include "common.h"
+#include "metrics.h"
+#include "trace.h"
 #include "util/lock.h"
 #include "util/log.h"
+#include "util/tick.h"
 
 bool
-controller_init(struct controller *controller, socket_t control_socket) {
-    cbuf_init(&controller->queue);
+controller_init(struct controller *controller, socket_t control_socket,
+                enum control_msg_encoding encoding,
+                struct rtt_stats *rtt_stats, struct clock_sync *clock_sync,
+                struct encoder_stats *encoder_stats) {
+    controller->next_seq = 0;
+    control_msg_encoder_init(&controller->encoder, encoding);
+    queue_init(&controller->reliable);
+    controller->queued_ack = NULL;
+    cbuf_init(&controller->lossy);
+    controller->reliable_stats = (struct control_lane_stats) {0, 0, 0};
+    controller->lossy_stats = (struct control_lane_stats) {0, 0, 0};
 
-    if (!receiver_init(&controller->receiver, control_socket)) {
+    if (!receiver_init(&controller->receiver, control_socket, rtt_stats,
+                       clock_sync, encoder_stats)) {
         return false;
     }
 
@@ -27,29 +43,154 @@ controller_init(struct controller *controller, socket_t control_socket) {
 
     controller->control_socket = control_socket;
     controller->stopped = false;
+    controller->ping = rtt_stats || clock_sync;
+    controller->next_ping = SDL_GetTicks();
+    controller->sent_msgs = 0;
+    controller->send_calls = 0;
 
     return true;
 }
 
+static void
+log_lane_stats(const char *name, const struct control_lane_stats *stats) {
+    LOGD("Controller %s lane: %" PRIu64 " pushed, %" PRIu64 " merged, "
+         "%" PRIu64 " dropped", name, stats->pushed, stats->merged,
+         stats->dropped);
+}
+
 void
 controller_destroy(struct controller *controller) {
     SDL_DestroyCond(controller->msg_cond);
     SDL_DestroyMutex(controller->mutex);
 
-    struct control_msg msg;
-    while (cbuf_take(&controller->queue, &msg)) {
-        control_msg_destroy(&msg);
+    struct control_msg msgs[CONTROL_MSG_BATCH_SIZE];
+    size_t count;
+    while ((count = controller_take_msgs(controller, msgs,
+                                         CONTROL_MSG_BATCH_SIZE))) {
+        for (size_t i = 0; i < count; ++i) {
+            control_msg_destroy(&msgs[i]);
+        }
     }
 
+    log_lane_stats("reliable", &controller->reliable_stats);
+    log_lane_stats("lossy", &controller->lossy_stats);
+
     receiver_destroy(&controller->receiver);
 }
 
-bool
-controller_push_msg(struct controller *controller,
-                      const struct control_msg *msg) {
+static bool
+is_touch_move(const struct control_msg *msg) {
+    return msg->type == CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT
+        && msg->inject_touch_event.action == AMOTION_EVENT_ACTION_MOVE;
+}
+
+// lossy messages own no data, they may be overwritten or dropped without
+// calling control_msg_destroy()
+static bool
+is_lossy(const struct control_msg *msg) {
+    return is_touch_move(msg)
+        || msg->type == CONTROL_MSG_TYPE_INJECT_SCROLL_EVENT;
+}
+
+// a move event may replace the previous one if it is still queued (the
+// intermediate position is not needed), so that a backlog does not increase
+// the latency of a gesture
+static bool
+can_coalesce(const struct control_msg *queued,
+             const struct control_msg *msg) {
+    return is_touch_move(queued) && is_touch_move(msg)
+        && queued->inject_touch_event.pointer_id
+                == msg->inject_touch_event.pointer_id
+        && queued->inject_touch_event.buttons
+                == msg->inject_touch_event.buttons;
+}
+
+static bool
+is_queue_empty(const struct controller *controller) {
+    return queue_is_empty(&controller->reliable)
+        && cbuf_is_empty(&controller->lossy);
+}
+
+static void
+push_lossy(struct controller *controller, const struct control_msg *msg) {
+    struct control_lane_stats *stats = &controller->lossy_stats;
+    if (!cbuf_is_empty(&controller->lossy)) {
+        struct control_msg_entry *last = cbuf_last(&controller->lossy);
+        // only if no other message has been pushed since, to keep the order
+        if (last->seq == controller->next_seq - 1
+                && can_coalesce(&last->msg, msg)) {
+            last->msg = *msg;
+            ++stats->merged;
+            metrics_inc(METRIC_CONTROL_MSGS_MERGED);
+            return;
+        }
+    }
+
+    struct control_msg_entry entry = {
+        .msg = *msg,
+        .seq = controller->next_seq,
+    };
+    if (!cbuf_push(&controller->lossy, entry)) {
+        ++stats->dropped;
+        metrics_inc(METRIC_CONTROL_MSGS_DROPPED);
+        return;
+    }
+    ++controller->next_seq;
+    ++stats->pushed;
+}
+
+// a frame ack acknowledges all the previous frames, so it may replace the
+// queued one, if any: the device always receives the latest ack, but the acks
+// never accumulate in the queue
+static bool
+merge_ack(struct controller *controller, const struct control_msg *msg) {
+    struct control_msg_node *queued = controller->queued_ack;
+    if (!queued) {
+        return false;
+    }
+    uint32_t skipped_frames = (uint32_t) queued->msg.ack_frame.skipped_frames
+                            + msg->ack_frame.skipped_frames;
+    queued->msg.ack_frame.pts = msg->ack_frame.pts;
+    queued->msg.ack_frame.skipped_frames = MIN(skipped_frames, UINT16_MAX);
+    ++controller->reliable_stats.merged;
+    metrics_inc(METRIC_CONTROL_MSGS_MERGED);
+    return true;
+}
+
+static bool
+push_reliable(struct controller *controller, const struct control_msg *msg) {
+    if (msg->type == CONTROL_MSG_TYPE_ACK_FRAME
+            && merge_ack(controller, msg)) {
+        return true;
+    }
+
+    struct control_msg_node *node = SDL_malloc(sizeof(*node));
+    if (!node) {
+        LOGC("Could not allocate control message");
+        return false;
+    }
+    node->msg = *msg;
+    node->seq = controller->next_seq++;
+    queue_push(&controller->reliable, next, node);
+    if (msg->type == CONTROL_MSG_TYPE_ACK_FRAME) {
+        controller->queued_ack = node;
+    }
+    ++controller->reliable_stats.pushed;
+    return true;
+}
+
+static bool
+push_msg(struct controller *controller, const struct control_msg *msg,
+         bool reliable) {
     mutex_lock(controller->mutex);
-    bool was_empty = cbuf_is_empty(&controller->queue);
-    bool res = cbuf_push(&controller->queue, *msg);
+    bool was_empty = is_queue_empty(controller);
+    bool res;
+    if (!reliable && is_lossy(msg)) {
+        push_lossy(controller, msg);
+        res = true;
+    } else {
+        res = push_reliable(controller, msg);
+    }
     if (was_empty) {
         cond_signal(controller->msg_cond);
     }
@@ -57,40 +198,174 @@ controller_push_msg(struct controller *controller,
     return res;
 }
 
+bool
+controller_push_msg(struct controller *controller,
+                      const struct control_msg *msg) {
+    return push_msg(controller, msg, false);
+}
+
+bool
+controller_push_msg_reliable(struct controller *controller,
+                             const struct control_msg *msg) {
+    return push_msg(controller, msg, true);
+}
+
+void
+controller_get_lane_stats(struct controller *controller,
+                          struct control_lane_stats *reliable,
+                          struct control_lane_stats *lossy) {
+    mutex_lock(controller->mutex);
+    *reliable = controller->reliable_stats;
+    *lossy = controller->lossy_stats;
+    mutex_unlock(controller->mutex);
+}
+
+size_t
+controller_take_msgs(struct controller *controller, struct control_msg *msgs,
+                     size_t max) {
+    size_t count = 0;
+    while (count < max) {
+        bool has_reliable = !queue_is_empty(&controller->reliable);
+        bool has_lossy = !cbuf_is_empty(&controller->lossy);
+        if (!has_reliable && !has_lossy) {
+            break;
+        }
+
+        // take the oldest message of both lanes
+        bool take_reliable = !has_lossy;
+        if (has_reliable && has_lossy) {
+            uint64_t reliable_seq = controller->reliable.first->seq;
+            uint64_t lossy_seq = cbuf_first(&controller->lossy)->seq;
+            take_reliable = reliable_seq < lossy_seq;
+        }
+
+        if (take_reliable) {
+            struct control_msg_node *node;
+            queue_take(&controller->reliable, next, &node);
+            if (node == controller->queued_ack) {
+                controller->queued_ack = NULL;
+            }
+            msgs[count++] = node->msg;
+            SDL_free(node);
+        } else {
+            struct control_msg_entry entry;
+            cbuf_take(&controller->lossy, &entry);
+            msgs[count++] = entry.msg;
+        }
+    }
+    return count;
+}
+
+// send the buffer containing msg_count serialized messages
 static bool
-process_msg(struct controller *controller,
-              const struct control_msg *msg) {
-    static unsigned char serialized_msg[CONTROL_MSG_MAX_SIZE];
-    int length = control_msg_serialize(msg, serialized_msg);
-    if (!length) {
+send_buffer(struct controller *controller, const unsigned char *buf,
+            size_t len, size_t msg_count) {
+    ++controller->send_calls;
+    uint64_t trace_start = trace_begin();
+    ssize_t w = net_send_all(controller->control_socket, buf, len);
+    trace_end("control_send", trace_start);
+    if (w > 0) {
+        metrics_add(METRIC_CONTROL_BYTES_SENT, w);
+    }
+    if (w != (ssize_t) len) {
         return false;
     }
-    int w = net_send_all(controller->control_socket, serialized_msg, length);
-    return w == length;
+    // only count the messages actually sent
+    controller->sent_msgs += msg_count;
+    metrics_add(METRIC_CONTROL_MSGS_SENT, msg_count);
+    return true;
+}
+
+// serialize the messages into a single buffer, to send them in a single call
+// (mouse drags and multi-touch gestures generate many small messages)
+static bool
+process_msgs(struct controller *controller, const struct control_msg *msgs,
+             size_t count) {
+    // as long as the buffer is filled by less than CONTROL_MSG_MAX_SIZE, any
+    // message fits
+    static unsigned char buf[2 * CONTROL_MSG_MAX_SIZE];
+    size_t len = 0;
+    size_t buffered = 0; // the number of messages serialized into buf
+    for (size_t i = 0; i < count; ++i) {
+        if (len >= CONTROL_MSG_MAX_SIZE) {
+            if (!send_buffer(controller, buf, len, buffered)) {
+                return false;
+            }
+            len = 0;
+            buffered = 0;
+        }
+        size_t r = control_msg_encode(&controller->encoder, &msgs[i],
+                                      &buf[len]);
+        if (!r) {
+            return false;
+        }
+        len += r;
+        ++buffered;
+    }
+    return send_buffer(controller, buf, len, buffered);
+}
+
+// push a ping if it is time to (must be called with mutex locked)
+// return the delay until the next ping, in ms (0 if pings are disabled)
+static uint32_t
+ping_if_needed(struct controller *controller) {
+    if (!controller->ping) {
+        return 0;
+    }
+
+    uint32_t now = SDL_GetTicks();
+    int32_t remaining = (int32_t) (controller->next_ping - now);
+    if (remaining > 0) {
+        return remaining;
+    }
+
+    struct control_msg msg;
+    msg.type = CONTROL_MSG_TYPE_PING;
+    // the timestamp is as late as possible, but the ping is queued behind the
+    // pending messages: their latency is part of the measure
+    msg.ping.timestamp = tick_now_us();
+    if (!push_reliable(controller, &msg)) {
+        LOGW("Could not push ping");
+    }
+    controller->next_ping = now + CONTROLLER_PING_INTERVAL_MS;
+    return CONTROLLER_PING_INTERVAL_MS;
 }
 
 static int
 run_controller(void *data) {
     struct controller *controller = data;
+    trace_set_thread_name("controller");
 
     for (;;) {
         mutex_lock(controller->mutex);
-        while (!controller->stopped && cbuf_is_empty(&controller->queue)) {
-            cond_wait(controller->msg_cond, controller->mutex);
+        for (;;) {
+            uint32_t ping_delay = ping_if_needed(controller);
+            if (controller->stopped || !is_queue_empty(controller)) {
+                break;
+            }
+            if (ping_delay) {
+                cond_wait_timeout(controller->msg_cond, controller->mutex,
+                                  ping_delay);
+            } else {
+                cond_wait(controller->msg_cond, controller->mutex);
+            }
         }
         if (controller->stopped) {
             // stop immediately, do not process further msgs
             mutex_unlock(controller->mutex);
             break;
         }
-        struct control_msg msg;
-        bool non_empty = cbuf_take(&controller->queue, &msg);
-        assert(non_empty);
-        (void) non_empty;
+        // take all the pending messages
+        struct control_msg msgs[CONTROL_MSG_BATCH_SIZE];
+        size_t count = controller_take_msgs(controller, msgs,
+                                            CONTROL_MSG_BATCH_SIZE);
+        assert(count);
         mutex_unlock(controller->mutex);
 
-        bool ok = process_msg(controller, &msg);
-        control_msg_destroy(&msg);
+        bool ok = process_msgs(controller, msgs, count);
+        for (size_t i = 0; i < count; ++i) {
+            control_msg_destroy(&msgs[i]);
+        }
         if (!ok) {
             LOGD("Could not write msg to socket");
             break;
@@ -2,16 +2,55 @@
 #define CONTROLLER_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <SDL2/SDL_mutex.h>
 #include <SDL2/SDL_thread.h>
 
 #include "config.h"
+#include "clock_sync.h"
 #include "control_msg.h"
+#include "encoder_stats.h"
 #include "receiver.h"
+#include "rtt_stats.h"
 #include "util/cbuf.h"
 #include "util/net.h"
+#include "util/queue.h"
 
-struct control_msg_queue CBUF(struct control_msg, 64);
+// capacity of the lossy lane
+#define CONTROL_MSG_LOSSY_QUEUE_SIZE 64
+// max number of messages taken at once by the controller thread
+#define CONTROL_MSG_BATCH_SIZE 64
+// interval between two pings, to measure the round-trip time
+#define CONTROLLER_PING_INTERVAL_MS 500
+
+// Messages are queued in two lanes:
+//  - the reliable lane (keys, buttons, text, clipboard, frame acks...) is
+//    unbounded, its messages are never dropped, so that a key is never stuck
+//    on the device (a frame ack is merged into the queued one, if any);
+//  - the lossy lane (touch moves, scroll) is bounded, its messages may be
+//    merged (consecutive moves) or dropped when it is full.
+// The messages are sent in the order they were pushed, whatever their lane.
+
+struct control_msg_entry {
+    struct control_msg msg;
+    uint64_t seq;
+};
+
+struct control_msg_node {
+    struct control_msg msg;
+    uint64_t seq;
+    struct control_msg_node *next;
+};
+
+struct control_msg_lossy_queue CBUF(struct control_msg_entry,
+                                    CONTROL_MSG_LOSSY_QUEUE_SIZE);
+struct control_msg_reliable_queue QUEUE(struct control_msg_node);
+
+struct control_lane_stats {
+    uint64_t pushed;
+    uint64_t merged; // replaced the previous queued message
+    uint64_t dropped; // the lane was full
+};
 
 struct controller {
     socket_t control_socket;
@@ -19,12 +58,32 @@ struct controller {
     SDL_mutex *mutex;
     SDL_cond *msg_cond;
     bool stopped;
-    struct control_msg_queue queue;
+    uint64_t next_seq;
+    struct control_msg_reliable_queue reliable;
+    // the frame ack in the reliable lane, if any (to merge the next one)
+    struct control_msg_node *queued_ack;
+    struct control_msg_lossy_queue lossy;
+    struct control_lane_stats reliable_stats;
+    struct control_lane_stats lossy_stats;
     struct receiver receiver;
+    // only accessed by the controller thread
+    struct control_msg_encoder encoder;
+    bool ping; // ping the device periodically
+    uint32_t next_ping; // SDL_GetTicks() of the next ping
+    // statistics, only written by the controller thread (read them once it
+    // is joined)
+    uint64_t sent_msgs;
+    uint64_t send_calls;
 };
 
+// if rtt_stats or clock_sync is not NULL, the controller pings the device
+// periodically, to record the round-trip times or synchronize the clocks
+// if encoder_stats is not NULL, it receives the reports of the device encoder
 bool
-controller_init(struct controller *controller, socket_t control_socket);
+controller_init(struct controller *controller, socket_t control_socket,
+                enum control_msg_encoding encoding,
+                struct rtt_stats *rtt_stats, struct clock_sync *clock_sync,
+                struct encoder_stats *encoder_stats);
 
 void
 controller_destroy(struct controller *controller);
@@ -38,8 +97,29 @@ controller_stop(struct controller *controller);
 void
 controller_join(struct controller *controller);
 
+// push a message to be sent to the device
+// a lossy message (see above) may be merged or dropped under load, which is
+// not an error
 bool
 controller_push_msg(struct controller *controller,
                     const struct control_msg *msg);
 
+// push a message on the reliable lane, whatever its type, so that it is never
+// merged or dropped (for scripted input, which must be replayed exactly)
+bool
+controller_push_msg_reliable(struct controller *controller,
+                             const struct control_msg *msg);
+
+// copy the statistics of both lanes
+void
+controller_get_lane_stats(struct controller *controller,
+                          struct control_lane_stats *reliable,
+                          struct control_lane_stats *lossy);
+
+// take up to max pending messages, in the order they were pushed
+// (used by the controller thread; the mutex must be held)
+size_t
+controller_take_msgs(struct controller *controller, struct control_msg *msgs,
+                     size_t max);
+
 #endif
@@ -10,7 +10,9 @@
 #include "config.h"
 #include "compat.h"
 #include "events.h"
+#include "metrics.h"
 #include "recorder.h"
+#include "trace.h"
 #include "video_buffer.h"
 #include "util/buffer_util.h"
 #include "util/log.h"
@@ -18,9 +20,17 @@
 // set the decoded frame as ready for rendering, and notify
 static void
 push_frame(struct decoder *decoder) {
+    metrics_inc(METRIC_DECODER_FRAMES);
+    if (decoder->frame_latency) {
+        frame_latency_on_decoded(decoder->frame_latency,
+                                 decoder->video_buffer->decoding_frame->pts);
+    }
+
     bool previous_frame_skipped;
+    uint64_t trace_start = trace_begin();
     video_buffer_offer_decoded_frame(decoder->video_buffer,
                                      &previous_frame_skipped);
+    trace_end("offer", trace_start);
     if (previous_frame_skipped) {
         // the previous EVENT_NEW_FRAME will consume this frame
         return;
@@ -32,8 +42,10 @@ push_frame(struct decoder *decoder) {
 }
 
 void
-decoder_init(struct decoder *decoder, struct video_buffer *vb) {
+decoder_init(struct decoder *decoder, struct video_buffer *vb,
+             struct frame_latency *frame_latency) {
     decoder->video_buffer = vb;
+    decoder->frame_latency = frame_latency;
 }
 
 bool
@@ -67,6 +79,7 @@ decoder_push(struct decoder *decoder, const AVPacket *packet) {
     int ret;
     if ((ret = avcodec_send_packet(decoder->codec_ctx, packet)) < 0) {
         LOGE("Could not send video packet: %d", ret);
+        metrics_inc(METRIC_DECODER_ERRORS);
         return false;
     }
     ret = avcodec_receive_frame(decoder->codec_ctx,
@@ -76,6 +89,7 @@ decoder_push(struct decoder *decoder, const AVPacket *packet) {
         push_frame(decoder);
     } else if (ret != AVERROR(EAGAIN)) {
         LOGE("Could not receive video frame: %d", ret);
+        metrics_inc(METRIC_DECODER_ERRORS);
         return false;
     }
 #else
@@ -86,6 +100,7 @@ decoder_push(struct decoder *decoder, const AVPacket *packet) {
                                     packet);
     if (len < 0) {
         LOGE("Could not decode video packet: %d", len);
+        metrics_inc(METRIC_DECODER_ERRORS);
         return false;
     }
     if (got_picture) {
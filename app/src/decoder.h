@@ -5,16 +5,19 @@
 #include <libavformat/avformat.h>
 
 #include "config.h"
+#include "frame_latency.h"
 
 struct video_buffer;
 
 struct decoder {
     struct video_buffer *video_buffer;
+    struct frame_latency *frame_latency; // may be NULL
     AVCodecContext *codec_ctx;
 };
 
 void
-decoder_init(struct decoder *decoder, struct video_buffer *vb);
+decoder_init(struct decoder *decoder, struct video_buffer *vb,
+             struct frame_latency *frame_latency);
 
 bool
 decoder_open(struct decoder *decoder, const AVCodec *codec);
@@ -1,43 +1,145 @@
 #include "device_msg.h"
 
+#include <assert.h>
 #include <string.h>
 
 #include "config.h"
 #include "util/buffer_util.h"
 #include "util/log.h"
 
-ssize_t
-device_msg_deserialize(const unsigned char *buf, size_t len,
-                       struct device_msg *msg) {
-    if (len < 5) {
-        // at least type + empty string length
-        return 0; // not available
+// the size of the header (including the type), 0 if the type is unknown
+static size_t
+header_size(uint8_t type) {
+    switch (type) {
+        case DEVICE_MSG_TYPE_CLIPBOARD:
+            return 5; // type + text length
+        case DEVICE_MSG_TYPE_PONG:
+            return 25;
+        case DEVICE_MSG_TYPE_ENCODER_STATS:
+            return 33;
+        default:
+            return 0;
+    }
+}
+
+// the payload length announced by the header
+static size_t
+payload_len(const unsigned char *header) {
+    if (header[0] == DEVICE_MSG_TYPE_CLIPBOARD) {
+        return buffer_read32be(&header[1]);
     }
+    return 0;
+}
 
-    msg->type = buf[0];
+// parse the header, and allocate the payload (of payload_len(header) bytes)
+static bool
+parse_header(const unsigned char *header, struct device_msg *msg) {
+    msg->type = header[0];
     switch (msg->type) {
         case DEVICE_MSG_TYPE_CLIPBOARD: {
-            size_t clipboard_len = buffer_read32be(&buf[1]);
-            if (clipboard_len > len - 5) {
-                return 0; // not available
+            size_t len = payload_len(header);
+            if (len > DEVICE_MSG_TEXT_MAX_LENGTH) {
+                LOGW("Clipboard text too long: %zu bytes", len);
+                return false;
             }
-            char *text = SDL_malloc(clipboard_len + 1);
+            char *text = SDL_malloc(len + 1);
             if (!text) {
                 LOGW("Could not allocate text for clipboard");
-                return -1;
-            }
-            if (clipboard_len) {
-                memcpy(text, &buf[5], clipboard_len);
+                return false;
             }
-            text[clipboard_len] = '\0';
-
+            text[len] = '\0';
             msg->clipboard.text = text;
-            return 5 + clipboard_len;
+            return true;
+        }
+        case DEVICE_MSG_TYPE_PONG:
+            msg->pong.timestamp = buffer_read64be(&header[1]);
+            msg->pong.receive_time = buffer_read64be(&header[9]);
+            msg->pong.send_time = buffer_read64be(&header[17]);
+            return true;
+        case DEVICE_MSG_TYPE_ENCODER_STATS: {
+            struct device_encoder_stats *stats = &msg->encoder_stats;
+            stats->frames = buffer_read32be(&header[1]);
+            stats->bytes = buffer_read64be(&header[5]);
+            stats->dequeue_wait = buffer_read64be(&header[13]);
+            stats->restarts = buffer_read32be(&header[21]);
+            stats->bit_rate = buffer_read32be(&header[25]);
+            stats->max_fps = buffer_read32be(&header[29]);
+            return true;
         }
         default:
-            LOGW("Unknown device message type: %d", (int) msg->type);
+            assert(!"unexpected device message type");
+            return false;
+    }
+}
+
+static void
+write_payload(struct device_msg *msg, size_t offset,
+              const unsigned char *chunk, size_t len) {
+    // only clipboard messages have a payload
+    assert(msg->type == DEVICE_MSG_TYPE_CLIPBOARD);
+    memcpy(&msg->clipboard.text[offset], chunk, len);
+}
+
+void
+device_msg_reader_init(struct device_msg_reader *reader) {
+    reader->in_payload = false;
+}
+
+void
+device_msg_reader_destroy(struct device_msg_reader *reader) {
+    if (reader->in_payload) {
+        device_msg_destroy(&reader->msg);
+    }
+}
+
+int
+device_msg_reader_read(struct device_msg_reader *reader,
+                       struct byte_ring *ring, struct device_msg *msg) {
+    if (!reader->in_payload) {
+        if (!byte_ring_len(ring)) {
+            return 0;
+        }
+
+        unsigned char header[DEVICE_MSG_HEADER_MAX_SIZE];
+        byte_ring_peek(ring, header, 1);
+        size_t size = header_size(header[0]);
+        if (!size) {
+            LOGW("Unknown device message type: %d", (int) header[0]);
             return -1; // error, we cannot recover
+        }
+        if (byte_ring_len(ring) < size) {
+            return 0; // not available
+        }
+
+        // the header is small, copy it in case it wraps around
+        byte_ring_peek(ring, header, size);
+        if (!parse_header(header, &reader->msg)) {
+            return -1;
+        }
+        byte_ring_consume(ring, size);
+        reader->in_payload = true;
+        reader->payload_len = payload_len(header);
+        reader->payload_read = 0;
     }
+
+    while (reader->payload_read < reader->payload_len) {
+        size_t len;
+        const unsigned char *chunk = byte_ring_read_ptr(ring, &len);
+        if (!len) {
+            return 0; // the remaining of the payload is not available yet
+        }
+        size_t remaining = reader->payload_len - reader->payload_read;
+        if (len > remaining) {
+            len = remaining;
+        }
+        write_payload(&reader->msg, reader->payload_read, chunk, len);
+        byte_ring_consume(ring, len);
+        reader->payload_read += len;
+    }
+
+    *msg = reader->msg;
+    reader->in_payload = false;
+    return 1;
 }
 
 void
@@ -3,16 +3,31 @@
 
 #include <stdbool.h>
 #include <stdint.h>
-#include <unistd.h>
 
 #include "config.h"
+#include "util/byte_ring.h"
 
-#define DEVICE_MSG_MAX_SIZE (1 << 18) // 256k
-// type: 1 byte; length: 4 bytes
-#define DEVICE_MSG_TEXT_MAX_LENGTH (DEVICE_MSG_MAX_SIZE - 5)
+// the max size of the fixed part of a message (the encoder stats)
+#define DEVICE_MSG_HEADER_MAX_SIZE 33
+// the clipboard text is streamed (never buffered whole), this limit only
+// protects from a corrupted length
+#define DEVICE_MSG_TEXT_MAX_LENGTH (1 << 24) // 16M
 
 enum device_msg_type {
     DEVICE_MSG_TYPE_CLIPBOARD,
+    DEVICE_MSG_TYPE_PONG,
+    DEVICE_MSG_TYPE_ENCODER_STATS,
+};
+
+// statistics of the device encoder, sent periodically
+// the counters are cumulative since the start of the encoder
+struct device_encoder_stats {
+    uint32_t frames; // encoded frames produced
+    uint64_t bytes; // encoded bytes produced (including the codec config)
+    uint64_t dequeue_wait; // time spent waiting for output buffers, in µs
+    uint32_t restarts; // codec restarts (on rotation or size change)
+    uint32_t bit_rate; // current bit rate, in bits/s
+    uint32_t max_fps; // current fps cap, 0 if none
 };
 
 struct device_msg {
@@ -21,13 +36,41 @@ struct device_msg {
         struct {
             char *text; // owned, to be freed by SDL_free()
         } clipboard;
+        struct {
+            uint64_t timestamp; // the timestamp of the ping (client clock)
+            uint64_t receive_time; // device clock
+            uint64_t send_time; // device clock
+        } pong;
+        struct device_encoder_stats encoder_stats;
     };
 };
 
-// return the number of bytes consumed (0 for no msg available, -1 on error)
-ssize_t
-device_msg_deserialize(const unsigned char *buf, size_t len,
-                       struct device_msg *msg);
+// Streaming deserializer: the fixed-size header of a message is parsed in
+// place from the ring buffer, then its payload (the clipboard text) is copied
+// chunk by chunk into the message, so that the ring buffer may be small
+// whatever the message size.
+struct device_msg_reader {
+    struct device_msg msg; // the message being read
+    bool in_payload;
+    size_t payload_len;
+    size_t payload_read;
+};
+
+void
+device_msg_reader_init(struct device_msg_reader *reader);
+
+// release the message being read, if any
+void
+device_msg_reader_destroy(struct device_msg_reader *reader);
+
+// read from the ring buffer, consuming the bytes read
+// return 1 if a message is complete (moved to *msg, to be destroyed by the
+// caller), 0 if more bytes are needed, -1 on error
+// an incomplete header is left in the ring buffer (it is smaller than
+// DEVICE_MSG_HEADER_MAX_SIZE)
+int
+device_msg_reader_read(struct device_msg_reader *reader,
+                       struct byte_ring *ring, struct device_msg *msg);
 
 void
 device_msg_destroy(struct device_msg *msg);
@@ -0,0 +1,66 @@
+#include "encoder_stats.h"
+
+#include "config.h"
+#include "util/lock.h"
+
+bool
+encoder_stats_init(struct encoder_stats *stats) {
+    if (!(stats->mutex = SDL_CreateMutex())) {
+        return false;
+    }
+    stats->has_last = false;
+    stats->has_summary = false;
+    return true;
+}
+
+void
+encoder_stats_destroy(struct encoder_stats *stats) {
+    SDL_DestroyMutex(stats->mutex);
+}
+
+void
+encoder_stats_reset(struct encoder_stats *stats) {
+    mutex_lock(stats->mutex);
+    stats->has_last = false;
+    stats->has_summary = false;
+    mutex_unlock(stats->mutex);
+}
+
+void
+encoder_stats_add_report(struct encoder_stats *stats,
+                         const struct device_encoder_stats *report) {
+    mutex_lock(stats->mutex);
+    const struct device_encoder_stats *last = &stats->last;
+    struct encoder_stats_summary *summary = &stats->summary;
+    // the first report covers the activity since the start of the encoder
+    if (!stats->has_last) {
+        summary->frames = report->frames;
+        summary->bytes = report->bytes;
+        summary->dequeue_wait = report->dequeue_wait;
+    } else {
+        summary->frames = report->frames - last->frames;
+        summary->bytes = report->bytes - last->bytes;
+        summary->dequeue_wait = report->dequeue_wait - last->dequeue_wait;
+    }
+    summary->restarts = report->restarts;
+    summary->bit_rate = report->bit_rate;
+    summary->max_fps = report->max_fps;
+
+    stats->last = *report;
+    stats->has_last = true;
+    stats->has_summary = true;
+    mutex_unlock(stats->mutex);
+}
+
+bool
+encoder_stats_take_summary(struct encoder_stats *stats,
+                           struct encoder_stats_summary *summary) {
+    mutex_lock(stats->mutex);
+    bool ok = stats->has_summary;
+    if (ok) {
+        *summary = stats->summary;
+        stats->has_summary = false;
+    }
+    mutex_unlock(stats->mutex);
+    return ok;
+}
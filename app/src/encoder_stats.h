@@ -0,0 +1,54 @@
+#ifndef ENCODER_STATS_H
+#define ENCODER_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL2/SDL_mutex.h>
+
+#include "config.h"
+#include "device_msg.h"
+
+// the encoder activity between two consecutive reports
+struct encoder_stats_summary {
+    uint32_t frames;
+    uint64_t bytes;
+    uint64_t dequeue_wait; // in µs
+    uint32_t restarts; // since the start of the encoder
+    uint32_t bit_rate;
+    uint32_t max_fps;
+};
+
+// Statistics of the device encoder, reported periodically by the device, so
+// that they can be displayed along with the client statistics (to tell
+// whether a stall comes from the encoder, the link or the client).
+struct encoder_stats {
+    SDL_mutex *mutex;
+    bool has_last;
+    struct device_encoder_stats last; // the last report received
+    struct encoder_stats_summary summary; // computed from the last report
+    bool has_summary; // not taken yet
+};
+
+bool
+encoder_stats_init(struct encoder_stats *stats);
+
+void
+encoder_stats_destroy(struct encoder_stats *stats);
+
+// forget the last report, on the start of a new session (the counters of a
+// new device encoder restart from 0)
+void
+encoder_stats_reset(struct encoder_stats *stats);
+
+// record a report received from the device
+void
+encoder_stats_add_report(struct encoder_stats *stats,
+                         const struct device_encoder_stats *report);
+
+// get the activity between the last two reports
+// return false if no report has been received since the previous call
+bool
+encoder_stats_take_summary(struct encoder_stats *stats,
+                           struct encoder_stats_summary *summary);
+
+#endif
@@ -1,3 +1,8 @@
 #define EVENT_NEW_SESSION SDL_USEREVENT
 #define EVENT_NEW_FRAME (SDL_USEREVENT + 1)
 #define EVENT_STREAM_STOPPED (SDL_USEREVENT + 2)
+#define EVENT_RECONNECT_DONE (SDL_USEREVENT + 3)
+#define EVENT_WRITE_TRACE (SDL_USEREVENT + 4)
+#define EVENT_FILE_PROGRESS (SDL_USEREVENT + 5)
+#define EVENT_FOLLOW_WINDOW_SIZE (SDL_USEREVENT + 6)
+#define EVENT_HUD_REFRESH (SDL_USEREVENT + 7)
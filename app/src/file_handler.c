@@ -2,14 +2,22 @@
 
 #include <assert.h>
 #include <string.h>
+#include <SDL2/SDL_events.h>
+#include <SDL2/SDL_rwops.h>
+#include <SDL2/SDL_timer.h>
 
 #include "config.h"
 #include "command.h"
+#include "events.h"
+#include "metrics.h"
 #include "util/lock.h"
 #include "util/log.h"
 
 #define DEFAULT_PUSH_TARGET "/sdcard/"
 
+// min delay between two intermediate progress reports
+#define PROGRESS_REPORT_PERIOD_MS 1000
+
 static void
 file_handler_request_destroy(struct file_handler_request *req) {
     SDL_free(req->file);
@@ -17,7 +25,8 @@ file_handler_request_destroy(struct file_handler_request *req) {
 
 bool
 file_handler_init(struct file_handler *file_handler, const char *serial,
-                  const char *push_target) {
+                  const char *push_target, unsigned worker_count) {
+    assert(worker_count >= 1 && worker_count <= FILE_HANDLER_MAX_WORKERS);
 
     cbuf_init(&file_handler->queue);
 
@@ -46,7 +55,17 @@ file_handler_init(struct file_handler *file_handler, const char *serial,
     file_handler->initialized = false;
 
     file_handler->stopped = false;
-    file_handler->current_process = PROCESS_NONE;
+    file_handler->worker_count = worker_count;
+    for (unsigned i = 0; i < worker_count; ++i) {
+        struct file_handler_worker *worker = &file_handler->workers[i];
+        worker->file_handler = file_handler;
+        worker->thread = NULL;
+        worker->current_process = PROCESS_NONE;
+    }
+
+    file_handler->progress = (struct file_handler_progress) {0};
+    file_handler->progress_pending = false;
+    file_handler->last_report = 0;
 
     file_handler->push_target = push_target ? push_target : DEFAULT_PUSH_TARGET;
 
@@ -65,14 +84,82 @@ file_handler_destroy(struct file_handler *file_handler) {
     }
 }
 
+static size_t
+queue_size(struct file_handler *file_handler) {
+    struct file_handler_request_queue *queue = &file_handler->queue;
+    return (queue->head + cbuf_size_(queue) - queue->tail) % cbuf_size_(queue);
+}
+
+// several files may be pushed by a single command only to a directory
+static bool
+can_batch(struct file_handler *file_handler) {
+    size_t len = strlen(file_handler->push_target);
+    return len && file_handler->push_target[len - 1] == '/';
+}
+
+// take the next request, followed by the next push requests which may be
+// pushed by the same command
+// return the number of requests taken
+static unsigned
+take_batch(struct file_handler *file_handler,
+           struct file_handler_request *batch) {
+    // share the pending requests between the workers rather than letting a
+    // single one take all of them
+    size_t max = (queue_size(file_handler) + file_handler->worker_count - 1)
+               / file_handler->worker_count;
+    if (max > FILE_HANDLER_MAX_BATCH) {
+        max = FILE_HANDLER_MAX_BATCH;
+    }
+
+    bool non_empty = cbuf_take(&file_handler->queue, &batch[0]);
+    assert(non_empty);
+    (void) non_empty;
+
+    unsigned count = 1;
+    if (batch[0].action != ACTION_PUSH_FILE || !can_batch(file_handler)) {
+        return count;
+    }
+
+    size_t len = strlen(batch[0].file);
+    while (count < max && !cbuf_is_empty(&file_handler->queue)) {
+        struct file_handler_request *next = cbuf_first(&file_handler->queue);
+        if (next->action != ACTION_PUSH_FILE) {
+            break;
+        }
+        len += strlen(next->file);
+        if (len > FILE_HANDLER_MAX_BATCH_LENGTH) {
+            break;
+        }
+        cbuf_take(&file_handler->queue, &batch[count]);
+        ++count;
+    }
+    return count;
+}
+
 static process_t
 install_apk(const char *serial, const char *file) {
     return adb_install(serial, file);
 }
 
 static process_t
-push_file(const char *serial, const char *file, const char *push_target) {
-    return adb_push(serial, file, push_target);
+push_files(const char *serial, const struct file_handler_request *batch,
+           unsigned count, const char *push_target) {
+    const char *files[FILE_HANDLER_MAX_BATCH];
+    for (unsigned i = 0; i < count; ++i) {
+        files[i] = batch[i].file;
+    }
+    return adb_push(serial, files, count, push_target);
+}
+
+static uint64_t
+get_file_size(const char *file) {
+    SDL_RWops *rw = SDL_RWFromFile(file, "rb");
+    if (!rw) {
+        return 0;
+    }
+    Sint64 size = SDL_RWsize(rw);
+    SDL_RWclose(rw);
+    return size > 0 ? (uint64_t) size : 0;
 }
 
 bool
@@ -86,7 +173,7 @@ file_handler_request(struct file_handler *file_handler,
         file_handler->initialized = true;
     }
 
-    LOGI("Request to %s %s", action == ACTION_INSTALL_APK ? "install" : "push",
+    LOGD("Request to %s %s", action == ACTION_INSTALL_APK ? "install" : "push",
                              file);
     struct file_handler_request req = {
         .action = action,
@@ -94,22 +181,149 @@ file_handler_request(struct file_handler *file_handler,
     };
 
     mutex_lock(file_handler->mutex);
-    bool was_empty = cbuf_is_empty(&file_handler->queue);
     bool res = cbuf_push(&file_handler->queue, req);
-    if (was_empty) {
+    if (res) {
+        metrics_inc(METRIC_FILE_REQUESTS);
+        metrics_gauge_add(METRIC_FILE_QUEUE, 1);
+        if (!file_handler->progress.requested) {
+            file_handler->progress.start = SDL_GetTicks();
+        }
+        ++file_handler->progress.requested;
         cond_signal(file_handler->event_cond);
+    } else {
+        LOGE("Too many pending files, %s ignored", file);
     }
     mutex_unlock(file_handler->mutex);
     return res;
 }
 
+static process_t
+execute_batch(struct file_handler *file_handler,
+              const struct file_handler_request *batch, unsigned count) {
+    if (batch[0].action == ACTION_INSTALL_APK) {
+        assert(count == 1);
+        LOGI("Installing %s...", batch[0].file);
+        return install_apk(file_handler->serial, batch[0].file);
+    }
+
+    if (count == 1) {
+        LOGI("Pushing %s...", batch[0].file);
+    } else {
+        LOGI("Pushing %u files...", count);
+        for (unsigned i = 0; i < count; ++i) {
+            LOGD("Pushing %s...", batch[i].file);
+        }
+    }
+    return push_files(file_handler->serial, batch, count,
+                      file_handler->push_target);
+}
+
+// update the progress and notify the event loop
+static void
+file_handler_done(struct file_handler *file_handler, unsigned count,
+                  bool success, uint64_t bytes) {
+    mutex_lock(file_handler->mutex);
+    struct file_handler_progress *progress = &file_handler->progress;
+    progress->done += count;
+    if (!success) {
+        progress->failed += count;
+    }
+    progress->bytes += bytes;
+
+    // the event loop reads the latest progress when it handles the event, so
+    // it is useless to push an event if one is already pending
+    if (!file_handler->stopped && !file_handler->progress_pending) {
+        SDL_Event event;
+        event.type = EVENT_FILE_PROGRESS;
+        if (SDL_PushEvent(&event) > 0) {
+            file_handler->progress_pending = true;
+        }
+    }
+    mutex_unlock(file_handler->mutex);
+}
+
+// execute the command of the batch, and wait for its result
+// return false if the file handler has been stopped meanwhile
+static bool
+process_batch(struct file_handler_worker *worker,
+              const struct file_handler_request *batch, unsigned count,
+              bool *success) {
+    struct file_handler *file_handler = worker->file_handler;
+
+    // execute the command without holding the lock, so that the requests
+    // received meanwhile are queued (and batched) immediately
+    process_t process = execute_batch(file_handler, batch, count);
+
+    mutex_lock(file_handler->mutex);
+    bool stopped = file_handler->stopped;
+    if (!stopped) {
+        worker->current_process = process;
+    }
+    mutex_unlock(file_handler->mutex);
+
+    if (stopped) {
+        // stopped meanwhile, file_handler_stop() could not terminate it
+        if (process != PROCESS_NONE) {
+            cmd_terminate(process);
+            cmd_simple_wait(process, NULL);
+        }
+        return false;
+    }
+
+    *success = process_check_success(process,
+                                     batch[0].action == ACTION_INSTALL_APK
+                                         ? "adb install" : "adb push");
+
+    mutex_lock(file_handler->mutex);
+    worker->current_process = PROCESS_NONE;
+    // if stopped meanwhile, the process has been terminated: its failure
+    // must not be reported (nor retried)
+    stopped = file_handler->stopped;
+    mutex_unlock(file_handler->mutex);
+    return !stopped;
+}
+
+// log the result of a batch, and account for its files
+static void
+report_batch(struct file_handler *file_handler,
+             const struct file_handler_request *batch, unsigned count,
+             bool success) {
+    const char *push_target = file_handler->push_target;
+    if (batch[0].action == ACTION_INSTALL_APK) {
+        if (success) {
+            LOGI("%s successfully installed", batch[0].file);
+        } else {
+            LOGE("Failed to install %s", batch[0].file);
+        }
+    } else if (success && count == 1) {
+        LOGI("%s successfully pushed to %s", batch[0].file, push_target);
+    } else if (success) {
+        LOGI("%u files successfully pushed to %s", count, push_target);
+    } else {
+        assert(count == 1);
+        LOGE("Failed to push %s to %s", batch[0].file, push_target);
+    }
+
+    uint64_t bytes = 0;
+    if (success) {
+        for (unsigned i = 0; i < count; ++i) {
+            bytes += get_file_size(batch[i].file);
+        }
+        metrics_add(METRIC_FILE_BYTES, bytes);
+    } else {
+        metrics_add(METRIC_FILE_ERRORS, count);
+    }
+
+    file_handler_done(file_handler, count, success, bytes);
+}
+
 static int
 run_file_handler(void *data) {
-    struct file_handler *file_handler = data;
+    struct file_handler_worker *worker = data;
+    struct file_handler *file_handler = worker->file_handler;
 
     for (;;) {
         mutex_lock(file_handler->mutex);
-        file_handler->current_process = PROCESS_NONE;
         while (!file_handler->stopped && cbuf_is_empty(&file_handler->queue)) {
             cond_wait(file_handler->event_cond, file_handler->mutex);
         }
@@ -118,53 +332,56 @@ run_file_handler(void *data) {
             mutex_unlock(file_handler->mutex);
             break;
         }
-        struct file_handler_request req;
-        bool non_empty = cbuf_take(&file_handler->queue, &req);
-        assert(non_empty);
-        (void) non_empty;
+        struct file_handler_request batch[FILE_HANDLER_MAX_BATCH];
+        unsigned count = take_batch(file_handler, batch);
+        metrics_gauge_add(METRIC_FILE_QUEUE, -(int64_t) count);
 
-        process_t process;
-        if (req.action == ACTION_INSTALL_APK) {
-            LOGI("Installing %s...", req.file);
-            process = install_apk(file_handler->serial, req.file);
-        } else {
-            LOGI("Pushing %s...", req.file);
-            process = push_file(file_handler->serial, req.file,
-                                file_handler->push_target);
-        }
-        file_handler->current_process = process;
         mutex_unlock(file_handler->mutex);
 
-        if (req.action == ACTION_INSTALL_APK) {
-            if (process_check_success(process, "adb install")) {
-                LOGI("%s successfully installed", req.file);
-            } else {
-                LOGE("Failed to install %s", req.file);
-            }
-        } else {
-            if (process_check_success(process, "adb push")) {
-                LOGI("%s successfully pushed to %s", req.file,
-                                                     file_handler->push_target);
-            } else {
-                LOGE("Failed to push %s to %s", req.file,
-                                                file_handler->push_target);
+        bool success;
+        bool stopped = !process_batch(worker, batch, count, &success);
+        if (!stopped && !success && count > 1) {
+            // adb does not report which files of the batch failed: push them
+            // one by one (the files already pushed are overwritten), so that
+            // only the failed ones are reported and accounted as errors
+            LOGW("Failed to push %u files to %s, retrying one by one", count,
+                 file_handler->push_target);
+            for (unsigned i = 0; i < count; ++i) {
+                if (!process_batch(worker, &batch[i], 1, &success)) {
+                    stopped = true;
+                    break;
+                }
+                report_batch(file_handler, &batch[i], 1, success);
             }
+        } else if (!stopped) {
+            report_batch(file_handler, batch, count, success);
         }
 
-        file_handler_request_destroy(&req);
+        for (unsigned i = 0; i < count; ++i) {
+            file_handler_request_destroy(&batch[i]);
+        }
+
+        if (stopped) {
+            break;
+        }
     }
     return 0;
 }
 
 bool
 file_handler_start(struct file_handler *file_handler) {
-    LOGD("Starting file_handler thread");
+    LOGD("Starting %u file_handler threads", file_handler->worker_count);
 
-    file_handler->thread = SDL_CreateThread(run_file_handler, "file_handler",
-                                            file_handler);
-    if (!file_handler->thread) {
-        LOGC("Could not start file_handler thread");
-        return false;
+    for (unsigned i = 0; i < file_handler->worker_count; ++i) {
+        struct file_handler_worker *worker = &file_handler->workers[i];
+        worker->thread = SDL_CreateThread(run_file_handler, "file_handler",
+                                          worker);
+        if (!worker->thread) {
+            LOGC("Could not start file_handler thread");
+            file_handler_stop(file_handler);
+            file_handler_join(file_handler);
+            return false;
+        }
     }
 
     return true;
@@ -174,18 +391,75 @@ void
 file_handler_stop(struct file_handler *file_handler) {
     mutex_lock(file_handler->mutex);
     file_handler->stopped = true;
-    cond_signal(file_handler->event_cond);
-    if (file_handler->current_process != PROCESS_NONE) {
-        if (!cmd_terminate(file_handler->current_process)) {
-            LOGW("Could not terminate install process");
+    cond_broadcast(file_handler->event_cond);
+    for (unsigned i = 0; i < file_handler->worker_count; ++i) {
+        struct file_handler_worker *worker = &file_handler->workers[i];
+        if (worker->current_process != PROCESS_NONE) {
+            if (!cmd_terminate(worker->current_process)) {
+                LOGW("Could not terminate adb process");
+            }
+            cmd_simple_wait(worker->current_process, NULL);
+            worker->current_process = PROCESS_NONE;
         }
-        cmd_simple_wait(file_handler->current_process, NULL);
-        file_handler->current_process = PROCESS_NONE;
+    }
+    size_t pending = queue_size(file_handler);
+    if (pending) {
+        LOGW("%u pending file requests cancelled", (unsigned) pending);
+        // they are destroyed by file_handler_destroy()
+        metrics_gauge_add(METRIC_FILE_QUEUE, -(int64_t) pending);
     }
     mutex_unlock(file_handler->mutex);
 }
 
 void
 file_handler_join(struct file_handler *file_handler) {
-    SDL_WaitThread(file_handler->thread, NULL);
+    for (unsigned i = 0; i < file_handler->worker_count; ++i) {
+        SDL_WaitThread(file_handler->workers[i].thread, NULL);
+        file_handler->workers[i].thread = NULL;
+    }
+}
+
+void
+file_handler_get_progress(struct file_handler *file_handler,
+                          struct file_handler_progress *progress) {
+    mutex_lock(file_handler->mutex);
+    *progress = file_handler->progress;
+    if (progress->done == progress->requested) {
+        // all the requests are processed, the next ones start a new progress
+        file_handler->progress = (struct file_handler_progress) {0};
+    }
+    file_handler->progress_pending = false;
+    mutex_unlock(file_handler->mutex);
+}
+
+void
+file_handler_report_progress(struct file_handler *file_handler) {
+    struct file_handler_progress progress;
+    file_handler_get_progress(file_handler, &progress);
+    if (progress.requested <= 1) {
+        // a single file is already reported by its worker
+        return;
+    }
+
+    uint32_t now = SDL_GetTicks();
+    bool finished = progress.done == progress.requested;
+    if (!finished
+            && now - file_handler->last_report < PROGRESS_REPORT_PERIOD_MS) {
+        return;
+    }
+    file_handler->last_report = now;
+
+    float elapsed = (now - progress.start) / 1000.f;
+    float mib = progress.bytes / (1024.f * 1024.f);
+    float rate = elapsed > 0 ? mib / elapsed : 0;
+    if (finished) {
+        LOGI("%u files processed in %.1f s (%.1f MiB, %.1f MiB/s)",
+             progress.done, elapsed, mib, rate);
+        if (progress.failed) {
+            LOGW("%u of %u files failed", progress.failed, progress.done);
+        }
+    } else {
+        LOGI("%u/%u files processed (%.1f MiB, %.1f MiB/s)",
+             progress.done, progress.requested, mib, rate);
+    }
 }
@@ -2,6 +2,7 @@
 #define FILE_HANDLER_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <SDL2/SDL_mutex.h>
 #include <SDL2/SDL_thread.h>
 
@@ -9,6 +10,13 @@
 #include "command.h"
 #include "util/cbuf.h"
 
+#define FILE_HANDLER_MAX_WORKERS 8
+// max number of files pushed by a single "adb push" command
+#define FILE_HANDLER_MAX_BATCH 16
+// max total length of the file names pushed by a single command (the command
+// line length is limited on Windows)
+#define FILE_HANDLER_MAX_BATCH_LENGTH 4096
+
 typedef enum {
     ACTION_INSTALL_APK,
     ACTION_PUSH_FILE,
@@ -19,23 +27,43 @@ struct file_handler_request {
     char *file;
 };
 
-struct file_handler_request_queue CBUF(struct file_handler_request, 16);
+// large enough to accept many files dropped at once
+struct file_handler_request_queue CBUF(struct file_handler_request, 256);
+
+// the requests since the last time all of them were processed
+struct file_handler_progress {
+    unsigned requested;
+    unsigned done; // including the failed ones
+    unsigned failed;
+    uint64_t bytes; // total size of the files successfully processed
+    uint32_t start; // SDL_GetTicks() of the first request
+};
+
+struct file_handler_worker {
+    struct file_handler *file_handler;
+    SDL_Thread *thread;
+    process_t current_process;
+};
 
 struct file_handler {
     char *serial;
     const char *push_target;
-    SDL_Thread *thread;
+    unsigned worker_count;
+    struct file_handler_worker workers[FILE_HANDLER_MAX_WORKERS];
     SDL_mutex *mutex;
     SDL_cond *event_cond;
     bool stopped;
     bool initialized;
-    process_t current_process;
     struct file_handler_request_queue queue;
+    struct file_handler_progress progress;
+    // an EVENT_FILE_PROGRESS has been pushed, and not handled yet
+    bool progress_pending;
+    uint32_t last_report; // accessed only from the main thread
 };
 
 bool
 file_handler_init(struct file_handler *file_handler, const char *serial,
-                  const char *push_target);
+                  const char *push_target, unsigned worker_count);
 
 void
 file_handler_destroy(struct file_handler *file_handler);
@@ -43,6 +71,7 @@ file_handler_destroy(struct file_handler *file_handler);
 bool
 file_handler_start(struct file_handler *file_handler);
 
+// terminate the running adb processes and discard the pending requests
 void
 file_handler_stop(struct file_handler *file_handler);
 
@@ -55,4 +84,14 @@ file_handler_request(struct file_handler *file_handler,
                      file_handler_action_t action,
                      char *file);
 
+// get the current progress (once all the requests are processed, the progress
+// is reset for the next requests)
+void
+file_handler_get_progress(struct file_handler *file_handler,
+                          struct file_handler_progress *progress);
+
+// log the progress, on EVENT_FILE_PROGRESS (from the main thread)
+void
+file_handler_report_progress(struct file_handler *file_handler);
+
 #endif
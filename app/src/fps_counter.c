@@ -1,6 +1,7 @@
 #include "fps_counter.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <SDL2/SDL_timer.h>
 
 #include "config.h"
@@ -10,7 +11,9 @@
 #define FPS_COUNTER_INTERVAL_MS 1000
 
 bool
-fps_counter_init(struct fps_counter *counter) {
+fps_counter_init(struct fps_counter *counter, struct rtt_stats *rtt_stats,
+                 struct frame_latency *frame_latency,
+                 struct encoder_stats *encoder_stats) {
     counter->mutex = SDL_CreateMutex();
     if (!counter->mutex) {
         return false;
@@ -22,6 +25,9 @@ fps_counter_init(struct fps_counter *counter) {
         return false;
     }
 
+    counter->rtt_stats = rtt_stats;
+    counter->frame_latency = frame_latency;
+    counter->encoder_stats = encoder_stats;
     counter->thread = NULL;
     atomic_init(&counter->started, 0);
     // no need to initialize the other fields, they are unused until started
@@ -48,6 +54,17 @@ set_started(struct fps_counter *counter, bool started) {
 // must be called with mutex locked
 static void
 display_fps(struct fps_counter *counter) {
+    // from the device to the screen: encoder, link, then client
+    struct encoder_stats_summary encoder;
+    if (counter->encoder_stats
+            && encoder_stats_take_summary(counter->encoder_stats, &encoder)) {
+        LOGI("Encoder: %" PRIu32 " frames, %.1f kB, %.1f ms waiting for "
+             "output, %" PRIu32 " restarts (bit rate %.1f Mbps, max fps %"
+             PRIu32 ")", encoder.frames, encoder.bytes / 1000.0,
+             encoder.dequeue_wait / 1000.0, encoder.restarts,
+             encoder.bit_rate / 1000000.0, encoder.max_fps);
+    }
+
     unsigned rendered_per_second =
         counter->nr_rendered * 1000 / FPS_COUNTER_INTERVAL_MS;
     if (counter->nr_skipped) {
@@ -56,6 +73,24 @@ display_fps(struct fps_counter *counter) {
     } else {
         LOGI("%u fps", rendered_per_second);
     }
+
+    struct rtt_percentiles rtt;
+    if (counter->rtt_stats
+            && rtt_stats_get_percentiles(counter->rtt_stats, &rtt)) {
+        LOGI("RTT: p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms "
+             "(%u samples)", rtt.p50 / 1000.0, rtt.p90 / 1000.0,
+             rtt.p99 / 1000.0, rtt.max / 1000.0, rtt.count);
+    }
+
+    struct frame_latency_summary latency;
+    if (counter->frame_latency
+            && frame_latency_take_summary(counter->frame_latency, &latency)) {
+        LOGI("Latency from capture (avg/max): receive %.1f/%.1f ms, "
+             "decode %.1f/%.1f ms, present %.1f/%.1f ms",
+             latency.receive.avg / 1000.0, latency.receive.max / 1000.0,
+             latency.decode.avg / 1000.0, latency.decode.max / 1000.0,
+             latency.present.avg / 1000.0, latency.present.max / 1000.0);
+    }
 }
 
 // must be called with mutex locked
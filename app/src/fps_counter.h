@@ -8,11 +8,18 @@
 #include <SDL2/SDL_thread.h>
 
 #include "config.h"
+#include "encoder_stats.h"
+#include "frame_latency.h"
+#include "rtt_stats.h"
 
 struct fps_counter {
     SDL_Thread *thread;
     SDL_mutex *mutex;
     SDL_cond *state_cond;
+    // displayed along with the FPS, may be NULL
+    struct rtt_stats *rtt_stats;
+    struct frame_latency *frame_latency;
+    struct encoder_stats *encoder_stats;
 
     // atomic so that we can check without locking the mutex
     // if the FPS counter is disabled, we don't want to lock unnecessarily
@@ -25,8 +32,11 @@ struct fps_counter {
     uint32_t next_timestamp;
 };
 
+// rtt_stats, frame_latency and encoder_stats may be NULL
 bool
-fps_counter_init(struct fps_counter *counter);
+fps_counter_init(struct fps_counter *counter, struct rtt_stats *rtt_stats,
+                 struct frame_latency *frame_latency,
+                 struct encoder_stats *encoder_stats);
 
 void
 fps_counter_destroy(struct fps_counter *counter);
@@ -0,0 +1,154 @@
+#include "frame_latency.h"
+
+#include <inttypes.h>
+
+#include "config.h"
+#include "metrics.h"
+#include "util/lock.h"
+#include "util/log.h"
+#include "util/tick.h"
+
+static void
+reset(struct frame_latency *fl) {
+    fl->receive = (struct frame_latency_acc) {0, 0};
+    fl->decode = (struct frame_latency_acc) {0, 0};
+    fl->present = (struct frame_latency_acc) {0, 0};
+    fl->presented = 0;
+}
+
+bool
+frame_latency_init(struct frame_latency *fl, struct clock_sync *clock_sync) {
+    if (!(fl->mutex = SDL_CreateMutex())) {
+        return false;
+    }
+    fl->clock_sync = clock_sync;
+    fl->head = 0;
+    fl->count = 0;
+    reset(fl);
+    return true;
+}
+
+void
+frame_latency_destroy(struct frame_latency *fl) {
+    SDL_DestroyMutex(fl->mutex);
+}
+
+// must be called with mutex locked
+static struct frame_latency_entry *
+find_entry(struct frame_latency *fl, int64_t pts) {
+    for (unsigned i = 0; i < fl->count; ++i) {
+        struct frame_latency_entry *entry = &fl->entries[i];
+        if (entry->pts == pts) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+void
+frame_latency_on_received(struct frame_latency *fl, int64_t pts,
+                          uint64_t device_capture_time) {
+    uint64_t now = tick_now_us();
+    uint64_t captured;
+    if (!clock_sync_to_client_time(fl->clock_sync, device_capture_time,
+                                   &captured)) {
+        return;
+    }
+
+    mutex_lock(fl->mutex);
+    // overwrite the oldest entry (its frame has been skipped)
+    struct frame_latency_entry *entry = &fl->entries[fl->head];
+    entry->pts = pts;
+    entry->captured = captured;
+    entry->received = now;
+    entry->decoded = 0;
+    fl->head = (fl->head + 1) % FRAME_LATENCY_PENDING;
+    if (fl->count < FRAME_LATENCY_PENDING) {
+        ++fl->count;
+    }
+    mutex_unlock(fl->mutex);
+}
+
+void
+frame_latency_on_decoded(struct frame_latency *fl, int64_t pts) {
+    uint64_t now = tick_now_us();
+
+    mutex_lock(fl->mutex);
+    struct frame_latency_entry *entry = find_entry(fl, pts);
+    if (entry) {
+        entry->decoded = now;
+    }
+    mutex_unlock(fl->mutex);
+}
+
+// the clock offset is an estimation, a time may be (slightly) before the
+// capture time
+static uint64_t
+elapsed(uint64_t from, uint64_t to) {
+    return to > from ? to - from : 0;
+}
+
+static void
+accumulate(struct frame_latency_acc *acc, uint64_t latency) {
+    acc->sum += latency;
+    if (latency > acc->max) {
+        acc->max = latency;
+    }
+}
+
+void
+frame_latency_on_presented(struct frame_latency *fl, int64_t pts) {
+    uint64_t now = tick_now_us();
+
+    mutex_lock(fl->mutex);
+    struct frame_latency_entry *entry = find_entry(fl, pts);
+    if (!entry || !entry->decoded) {
+        mutex_unlock(fl->mutex);
+        return;
+    }
+
+    uint64_t receive = elapsed(entry->captured, entry->received);
+    uint64_t decode = elapsed(entry->captured, entry->decoded);
+    uint64_t present = elapsed(entry->captured, now);
+    accumulate(&fl->receive, receive);
+    accumulate(&fl->decode, decode);
+    accumulate(&fl->present, present);
+    ++fl->presented;
+    // a frame is presented only once
+    entry->pts = -1;
+    mutex_unlock(fl->mutex);
+
+    metrics_observe(METRIC_FRAME_RECEIVE_LATENCY, receive);
+    metrics_observe(METRIC_FRAME_DECODE_LATENCY, decode);
+    metrics_observe(METRIC_FRAME_LATENCY, present);
+
+    LOGV("Frame %" PRId64 ": capture->receive %" PRIu64 " µs, "
+         "capture->decode %" PRIu64 " µs, capture->present %" PRIu64 " µs",
+         pts, receive, decode, present);
+}
+
+static struct frame_latency_stage
+to_stage(const struct frame_latency_acc *acc, unsigned count) {
+    struct frame_latency_stage stage = {
+        .avg = acc->sum / count,
+        .max = acc->max,
+    };
+    return stage;
+}
+
+bool
+frame_latency_take_summary(struct frame_latency *fl,
+                           struct frame_latency_summary *summary) {
+    mutex_lock(fl->mutex);
+    unsigned count = fl->presented;
+    if (count) {
+        summary->receive = to_stage(&fl->receive, count);
+        summary->decode = to_stage(&fl->decode, count);
+        summary->present = to_stage(&fl->present, count);
+        summary->count = count;
+    }
+    reset(fl);
+    mutex_unlock(fl->mutex);
+
+    return count;
+}
@@ -0,0 +1,83 @@
+#ifndef FRAME_LATENCY_H
+#define FRAME_LATENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL2/SDL_mutex.h>
+
+#include "config.h"
+#include "clock_sync.h"
+
+// max number of frames between their reception and their presentation
+#define FRAME_LATENCY_PENDING 16
+
+// the times of a frame, on the client clock, in µs
+struct frame_latency_entry {
+    int64_t pts;
+    uint64_t captured; // converted from the device clock
+    uint64_t received;
+    uint64_t decoded; // 0 if not decoded yet
+};
+
+struct frame_latency_stage {
+    uint64_t avg;
+    uint64_t max;
+};
+
+struct frame_latency_acc {
+    uint64_t sum;
+    uint64_t max;
+};
+
+// average and max latencies from the capture, in µs
+struct frame_latency_summary {
+    struct frame_latency_stage receive;
+    struct frame_latency_stage decode;
+    struct frame_latency_stage present;
+    unsigned count; // number of presented frames
+};
+
+// Measure the latency of each frame, from its capture on the device to its
+// reception, decoding and presentation on the client.
+//
+// The capture time is sent by the device along with each frame, and converted
+// to the client clock through the clock synchronization. The frames are
+// identified by their PTS.
+struct frame_latency {
+    SDL_mutex *mutex;
+    struct clock_sync *clock_sync;
+    struct frame_latency_entry entries[FRAME_LATENCY_PENDING];
+    unsigned head;
+    unsigned count;
+    // accumulated since the last call to frame_latency_take_summary()
+    struct frame_latency_acc receive;
+    struct frame_latency_acc decode;
+    struct frame_latency_acc present;
+    unsigned presented;
+};
+
+bool
+frame_latency_init(struct frame_latency *fl, struct clock_sync *clock_sync);
+
+void
+frame_latency_destroy(struct frame_latency *fl);
+
+// the frame is ignored if the clocks are not synchronized yet
+void
+frame_latency_on_received(struct frame_latency *fl, int64_t pts,
+                          uint64_t device_capture_time);
+
+void
+frame_latency_on_decoded(struct frame_latency *fl, int64_t pts);
+
+// log the latencies of the frame (at verbose level)
+void
+frame_latency_on_presented(struct frame_latency *fl, int64_t pts);
+
+// reset the accumulated latencies
+// return false if no frame has been presented since the previous call
+bool
+frame_latency_take_summary(struct frame_latency *fl,
+                           struct frame_latency_summary *summary);
+
+#endif
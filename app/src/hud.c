@@ -0,0 +1,347 @@
+#include "hud.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "events.h"
+#include "util/log.h"
+
+#define GLYPH_WIDTH 3
+#define GLYPH_HEIGHT 5
+// the glyphs are separated by transparent pixels in the atlas, so that they
+// never bleed into each other
+#define CELL_WIDTH (GLYPH_WIDTH + 1)
+#define CELL_HEIGHT (GLYPH_HEIGHT + 1)
+// the atlas contains the characters from ' ' to '_' (lowercase letters are
+// drawn as uppercase)
+#define GLYPH_FIRST ' '
+#define GLYPH_COUNT 64
+
+#define ATLAS_WIDTH (GLYPH_COUNT * CELL_WIDTH)
+#define ATLAS_HEIGHT CELL_HEIGHT
+
+// the first line of the latencies (the other lines are white)
+#define LATENCY_LINE (HUD_LINES - HUD_STAGE_COUNT)
+// the column (in characters) of the latency sparklines
+#define SPARKLINE_COLUMN 18
+
+// 3x5 glyphs, row by row ('#' for a lit pixel), missing glyphs are blank
+#define G(c) [(c) - GLYPH_FIRST]
+static const char *const glyphs[GLYPH_COUNT] = {
+    G('%') = "#.#" "..#" ".#." "#.." "#.#",
+    G('(') = "..#" ".#." ".#." ".#." "..#",
+    G(')') = "#.." ".#." ".#." ".#." "#..",
+    G('+') = "..." ".#." "###" ".#." "...",
+    G('-') = "..." "..." "###" "..." "...",
+    G('.') = "..." "..." "..." "..." ".#.",
+    G('/') = "..#" "..#" ".#." "#.." "#..",
+    G('0') = "###" "#.#" "#.#" "#.#" "###",
+    G('1') = ".#." "##." ".#." ".#." "###",
+    G('2') = "###" "..#" "###" "#.." "###",
+    G('3') = "###" "..#" ".##" "..#" "###",
+    G('4') = "#.#" "#.#" "###" "..#" "..#",
+    G('5') = "###" "#.." "###" "..#" "###",
+    G('6') = "###" "#.." "###" "#.#" "###",
+    G('7') = "###" "..#" "..#" ".#." ".#.",
+    G('8') = "###" "#.#" "###" "#.#" "###",
+    G('9') = "###" "#.#" "###" "..#" "###",
+    G(':') = "..." ".#." "..." ".#." "...",
+    G('=') = "..." "###" "..." "###" "...",
+    G('A') = ".#." "#.#" "###" "#.#" "#.#",
+    G('B') = "##." "#.#" "##." "#.#" "##.",
+    G('C') = ".##" "#.." "#.." "#.." ".##",
+    G('D') = "##." "#.#" "#.#" "#.#" "##.",
+    G('E') = "###" "#.." "##." "#.." "###",
+    G('F') = "###" "#.." "##." "#.." "#..",
+    G('G') = ".##" "#.." "#.#" "#.#" ".##",
+    G('H') = "#.#" "#.#" "###" "#.#" "#.#",
+    G('I') = "###" ".#." ".#." ".#." "###",
+    G('J') = "..#" "..#" "..#" "#.#" ".#.",
+    G('K') = "#.#" "#.#" "##." "#.#" "#.#",
+    G('L') = "#.." "#.." "#.." "#.." "###",
+    G('M') = "#.#" "###" "###" "#.#" "#.#",
+    G('N') = "##." "#.#" "#.#" "#.#" "#.#",
+    G('O') = ".#." "#.#" "#.#" "#.#" ".#.",
+    G('P') = "##." "#.#" "##." "#.." "#..",
+    G('Q') = ".#." "#.#" "#.#" "##." ".##",
+    G('R') = "##." "#.#" "##." "#.#" "#.#",
+    G('S') = ".##" "#.." ".#." "..#" "##.",
+    G('T') = "###" ".#." ".#." ".#." ".#.",
+    G('U') = "#.#" "#.#" "#.#" "#.#" "###",
+    G('V') = "#.#" "#.#" "#.#" "#.#" ".#.",
+    G('W') = "#.#" "#.#" "###" "###" "#.#",
+    G('X') = "#.#" "#.#" ".#." "#.#" "#.#",
+    G('Y') = "#.#" "#.#" ".#." ".#." ".#.",
+    G('Z') = "###" "..#" ".#." "#.." "###",
+};
+#undef G
+
+static const char *const stage_labels[HUD_STAGE_COUNT] = {
+    [HUD_STAGE_RECEIVE] = "RECEIVE",
+    [HUD_STAGE_DECODE] = "DECODE",
+    [HUD_STAGE_PRESENT] = "PRESENT",
+};
+
+static const SDL_Color stage_colors[HUD_STAGE_COUNT] = {
+    [HUD_STAGE_RECEIVE] = {0x4C, 0xAF, 0x50, 0xFF},
+    [HUD_STAGE_DECODE] = {0xFF, 0xC1, 0x07, 0xFF},
+    [HUD_STAGE_PRESENT] = {0xF4, 0x43, 0x36, 0xFF},
+};
+
+static SDL_Texture *
+create_font_atlas(SDL_Renderer *renderer) {
+    static uint32_t pixels[ATLAS_HEIGHT][ATLAS_WIDTH];
+    memset(pixels, 0, sizeof(pixels));
+    for (int i = 0; i < GLYPH_COUNT; ++i) {
+        const char *glyph = glyphs[i];
+        if (!glyph) {
+            continue;
+        }
+        assert(strlen(glyph) == GLYPH_WIDTH * GLYPH_HEIGHT);
+        for (int y = 0; y < GLYPH_HEIGHT; ++y) {
+            for (int x = 0; x < GLYPH_WIDTH; ++x) {
+                if (glyph[y * GLYPH_WIDTH + x] == '#') {
+                    // opaque white, colored on rendering
+                    pixels[y][i * CELL_WIDTH + x] = 0xFFFFFFFF;
+                }
+            }
+        }
+    }
+
+    SDL_Surface *surface =
+        SDL_CreateRGBSurfaceFrom(pixels, ATLAS_WIDTH, ATLAS_HEIGHT, 32,
+                                 ATLAS_WIDTH * 4, 0xFF000000, 0x00FF0000,
+                                 0x0000FF00, 0x000000FF);
+    if (!surface) {
+        return NULL;
+    }
+
+    // the glyphs are scaled up, they must not be blurred: create the texture
+    // with nearest pixel sampling, then restore the scale quality
+    char scale_quality[16] = "";
+    const char *hint = SDL_GetHint(SDL_HINT_RENDER_SCALE_QUALITY);
+    if (hint) {
+        snprintf(scale_quality, sizeof(scale_quality), "%s", hint);
+    }
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY,
+                hint ? scale_quality : NULL);
+    SDL_FreeSurface(surface);
+
+    if (texture) {
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+    return texture;
+}
+
+// format a latency in ms, with 1 decimal
+static void
+format_latency(char *buf, size_t size, uint32_t latency) {
+    if (!latency) {
+        // no frame presented during the period
+        snprintf(buf, size, "-");
+    } else {
+        snprintf(buf, size, "%" PRIu32 ".%" PRIu32, latency / 1000,
+                 latency % 1000 / 100);
+    }
+}
+
+static void
+format_lines(struct hud *hud) {
+    const struct hud_stats *stats = &hud->stats;
+    snprintf(hud->lines[0], HUD_LINE_MAX, "RENDER %u FPS  DECODE %u FPS",
+             stats->render_fps, stats->decode_fps);
+    snprintf(hud->lines[1], HUD_LINE_MAX,
+             "SKIPPED %u/S  BITRATE %" PRIu64 ".%02u MBPS",
+             stats->skipped_fps, stats->bit_rate / 1000000,
+             (unsigned) (stats->bit_rate / 10000 % 100));
+    snprintf(hud->lines[2], HUD_LINE_MAX,
+             "QUEUES  RECORDER %" PRId64 "  FILES %" PRId64,
+             stats->recorder_queue, stats->file_queue);
+
+    for (int i = 0; i < HUD_STAGE_COUNT; ++i) {
+        uint32_t latency = stats->count
+                         ? hud_stats_get_latency(stats, i, stats->count - 1)
+                         : 0;
+        char value[16];
+        format_latency(value, sizeof(value), latency);
+        snprintf(hud->lines[LATENCY_LINE + i], HUD_LINE_MAX, "%-8s%6s MS",
+                 stage_labels[i], value);
+    }
+}
+
+bool
+hud_init(struct hud *hud, SDL_Renderer *renderer) {
+    hud->font = create_font_atlas(renderer);
+    if (!hud->font) {
+        return false;
+    }
+    hud->renderer = renderer;
+    hud->enabled = false;
+    hud->timer = 0;
+    hud_stats_init(&hud->stats);
+    format_lines(hud);
+    return true;
+}
+
+void
+hud_destroy(struct hud *hud) {
+    if (hud->timer) {
+        SDL_RemoveTimer(hud->timer);
+    }
+    if (hud->font) {
+        SDL_DestroyTexture(hud->font);
+    }
+}
+
+static uint32_t
+refresh_timer(uint32_t interval, void *param) {
+    (void) param;
+    SDL_Event event;
+    event.type = EVENT_HUD_REFRESH;
+    SDL_PushEvent(&event);
+    return interval; // repeat
+}
+
+void
+hud_switch(struct hud *hud) {
+    if (!hud->font) {
+        LOGW("HUD not available");
+        return;
+    }
+
+    hud->enabled = !hud->enabled;
+    if (hud->enabled) {
+        // do not report the values accumulated while the HUD was hidden
+        hud_stats_init(&hud->stats);
+        format_lines(hud);
+        hud->timer = SDL_AddTimer(HUD_STATS_PERIOD_MS, refresh_timer, NULL);
+        if (!hud->timer) {
+            LOGW("Could not add timer: %s", SDL_GetError());
+        }
+    } else if (hud->timer) {
+        SDL_RemoveTimer(hud->timer);
+        hud->timer = 0;
+    }
+    LOGI("HUD %s", hud->enabled ? "enabled" : "disabled");
+}
+
+static void
+draw_text(struct hud *hud, const char *text, int x, int y, int scale) {
+    for (; *text; ++text, x += CELL_WIDTH * scale) {
+        int c = toupper((unsigned char) *text);
+        if (c <= GLYPH_FIRST || c >= GLYPH_FIRST + GLYPH_COUNT) {
+            continue;
+        }
+        SDL_Rect src = {
+            .x = (c - GLYPH_FIRST) * CELL_WIDTH,
+            .y = 0,
+            .w = GLYPH_WIDTH,
+            .h = GLYPH_HEIGHT,
+        };
+        SDL_Rect dst = {
+            .x = x,
+            .y = y,
+            .w = GLYPH_WIDTH * scale,
+            .h = GLYPH_HEIGHT * scale,
+        };
+        SDL_RenderCopy(hud->renderer, hud->font, &src, &dst);
+    }
+}
+
+// the max latency in the history, to share the scale of all the sparklines
+static uint32_t
+get_max_latency(const struct hud_stats *stats) {
+    uint32_t max = 0;
+    for (int stage = 0; stage < HUD_STAGE_COUNT; ++stage) {
+        for (unsigned i = 0; i < stats->count; ++i) {
+            uint32_t latency = hud_stats_get_latency(stats, stage, i);
+            if (latency > max) {
+                max = latency;
+            }
+        }
+    }
+    return max;
+}
+
+static void
+draw_sparkline(struct hud *hud, enum hud_stage stage, uint32_t max, int x,
+               int y, int scale) {
+    const struct hud_stats *stats = &hud->stats;
+    assert(max);
+    if (stats->count < 2) {
+        return;
+    }
+
+    SDL_Point points[HUD_STATS_HISTORY];
+    int height = GLYPH_HEIGHT * scale - 1;
+    for (unsigned i = 0; i < stats->count; ++i) {
+        uint32_t latency = hud_stats_get_latency(stats, stage, i);
+        points[i].x = x + i * scale;
+        points[i].y = y + height - (int) ((uint64_t) latency * height / max);
+    }
+    SDL_RenderDrawLines(hud->renderer, points, stats->count);
+}
+
+void
+hud_render(struct hud *hud, struct size drawable_size) {
+    if (!hud->enabled) {
+        return;
+    }
+
+    if (hud_stats_update(&hud->stats, SDL_GetTicks())) {
+        format_lines(hud);
+    }
+
+    // scale up the glyphs on large (typically HiDPI) drawables
+    int scale = drawable_size.height >= 1200 ? 3 : 2;
+    int margin = 2 * scale;
+    int line_height = (GLYPH_HEIGHT + 2) * scale;
+    int sparkline_x = margin + SPARKLINE_COLUMN * CELL_WIDTH * scale;
+
+    int width = sparkline_x + HUD_STATS_HISTORY * scale;
+    for (int i = 0; i < HUD_LINES; ++i) {
+        int w = margin + strlen(hud->lines[i]) * CELL_WIDTH * scale;
+        if (w > width) {
+            width = w;
+        }
+    }
+
+    SDL_Renderer *renderer = hud->renderer;
+    SDL_Rect panel = {
+        .x = 0,
+        .y = 0,
+        .w = width + margin,
+        .h = 2 * margin + HUD_LINES * line_height - 2 * scale,
+    };
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xA0);
+    SDL_RenderFillRect(renderer, &panel);
+
+    int y = margin;
+    SDL_SetTextureColorMod(hud->font, 0xFF, 0xFF, 0xFF);
+    for (int i = 0; i < LATENCY_LINE; ++i, y += line_height) {
+        draw_text(hud, hud->lines[i], margin, y, scale);
+    }
+
+    uint32_t max = get_max_latency(&hud->stats);
+    for (int stage = 0; stage < HUD_STAGE_COUNT; ++stage, y += line_height) {
+        SDL_Color color = stage_colors[stage];
+        SDL_SetTextureColorMod(hud->font, color.r, color.g, color.b);
+        draw_text(hud, hud->lines[LATENCY_LINE + stage], margin, y, scale);
+        if (max) {
+            SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b,
+                                   color.a);
+            draw_sparkline(hud, stage, max, sparkline_x, y, scale);
+        }
+    }
+
+    // restore the defaults (the renderer is cleared with the draw color)
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xFF);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
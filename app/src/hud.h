@@ -0,0 +1,47 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "config.h"
+#include "common.h"
+#include "hud_stats.h"
+
+#define HUD_LINES 6
+#define HUD_LINE_MAX 48
+
+// On-screen performance overlay (render and decode FPS, skipped frames, bit
+// rate, queue depths and per-stage latency sparklines), drawn over the frame.
+//
+// The text is drawn from a tiny built-in bitmap font, uploaded once to a
+// texture atlas, so that drawing the HUD only costs a few copies of small
+// rectangles per frame.
+struct hud {
+    SDL_Renderer *renderer;
+    SDL_Texture *font; // the glyph atlas
+    bool enabled;
+    // push an EVENT_HUD_REFRESH periodically while the HUD is enabled, so that
+    // the stats are sampled even if no frame is received
+    SDL_TimerID timer;
+    struct hud_stats stats;
+    // formatted on each sample
+    char lines[HUD_LINES][HUD_LINE_MAX];
+};
+
+// create the font atlas (the HUD is initially hidden)
+bool
+hud_init(struct hud *hud, SDL_Renderer *renderer);
+
+void
+hud_destroy(struct hud *hud);
+
+// show or hide the HUD
+void
+hud_switch(struct hud *hud);
+
+// draw the HUD (if enabled) at the top-left corner of the drawable
+void
+hud_render(struct hud *hud, struct size drawable_size);
+
+#endif
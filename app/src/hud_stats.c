@@ -0,0 +1,91 @@
+#include "hud_stats.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "config.h"
+#include "metrics.h"
+
+static const enum metric_id latency_metrics[HUD_STAGE_COUNT] = {
+    [HUD_STAGE_RECEIVE] = METRIC_FRAME_RECEIVE_LATENCY,
+    [HUD_STAGE_DECODE] = METRIC_FRAME_DECODE_LATENCY,
+    [HUD_STAGE_PRESENT] = METRIC_FRAME_LATENCY,
+};
+
+void
+hud_stats_init(struct hud_stats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+static void
+read_counters(struct hud_counters *counters) {
+    counters->rendered = metrics_get(METRIC_FRAMES_RENDERED);
+    counters->decoded = metrics_get(METRIC_DECODER_FRAMES);
+    counters->skipped = metrics_get(METRIC_FRAMES_SKIPPED);
+    counters->bytes = metrics_get(METRIC_STREAM_BYTES);
+    for (int i = 0; i < HUD_STAGE_COUNT; ++i) {
+        enum metric_id id = latency_metrics[i];
+        counters->latency_count[i] = metrics_get(id);
+        counters->latency_sum[i] = metrics_get_sum(id);
+    }
+}
+
+// the rate per second of a counter
+static unsigned
+rate(int64_t delta, uint32_t elapsed_ms) {
+    return delta > 0 ? delta * 1000 / elapsed_ms : 0;
+}
+
+bool
+hud_stats_update(struct hud_stats *stats, uint32_t now) {
+    if (stats->has_counters
+            && now - stats->last_sample < HUD_STATS_PERIOD_MS) {
+        return false;
+    }
+
+    struct hud_counters counters;
+    read_counters(&counters);
+    stats->recorder_queue = metrics_get(METRIC_RECORDER_QUEUE);
+    stats->file_queue = metrics_get(METRIC_FILE_QUEUE);
+
+    if (!stats->has_counters) {
+        stats->counters = counters;
+        stats->last_sample = now;
+        stats->has_counters = true;
+        return false;
+    }
+
+    const struct hud_counters *prev = &stats->counters;
+    uint32_t elapsed = now - stats->last_sample;
+    assert(elapsed);
+
+    stats->render_fps = rate(counters.rendered - prev->rendered, elapsed);
+    stats->decode_fps = rate(counters.decoded - prev->decoded, elapsed);
+    stats->skipped_fps = rate(counters.skipped - prev->skipped, elapsed);
+    int64_t bytes = counters.bytes - prev->bytes;
+    stats->bit_rate = bytes > 0 ? (uint64_t) bytes * 8 * 1000 / elapsed : 0;
+
+    for (int i = 0; i < HUD_STAGE_COUNT; ++i) {
+        int64_t count = counters.latency_count[i] - prev->latency_count[i];
+        int64_t sum = counters.latency_sum[i] - prev->latency_sum[i];
+        uint32_t avg = count > 0 && sum > 0 ? sum / count : 0;
+        stats->history[i][stats->head] = avg;
+    }
+    stats->head = (stats->head + 1) % HUD_STATS_HISTORY;
+    if (stats->count < HUD_STATS_HISTORY) {
+        ++stats->count;
+    }
+
+    stats->counters = counters;
+    stats->last_sample = now;
+    return true;
+}
+
+uint32_t
+hud_stats_get_latency(const struct hud_stats *stats, enum hud_stage stage,
+                      unsigned i) {
+    assert(i < stats->count);
+    unsigned first = (stats->head + HUD_STATS_HISTORY - stats->count)
+                   % HUD_STATS_HISTORY;
+    return stats->history[stage][(first + i) % HUD_STATS_HISTORY];
+}
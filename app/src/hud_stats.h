@@ -0,0 +1,74 @@
+#ifndef HUD_STATS_H
+#define HUD_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+
+// interval between two samples, in ms
+#define HUD_STATS_PERIOD_MS 500
+// number of samples kept for the sparklines
+#define HUD_STATS_HISTORY 64
+
+// latencies from the capture on the device
+enum hud_stage {
+    HUD_STAGE_RECEIVE,
+    HUD_STAGE_DECODE,
+    HUD_STAGE_PRESENT,
+
+    HUD_STAGE_COUNT,
+};
+
+// the values of the metrics at the time of a sample
+struct hud_counters {
+    int64_t rendered;
+    int64_t decoded;
+    int64_t skipped;
+    int64_t bytes;
+    int64_t latency_count[HUD_STAGE_COUNT];
+    int64_t latency_sum[HUD_STAGE_COUNT];
+};
+
+// The values displayed by the HUD, sampled periodically from the metrics
+// registry (see metrics.h).
+//
+// Reading the metrics never blocks, so the samples may be taken from the
+// rendering thread.
+struct hud_stats {
+    bool has_counters;
+    uint32_t last_sample; // SDL_GetTicks() of the last sample
+    struct hud_counters counters;
+
+    // over the last period
+    unsigned render_fps;
+    unsigned decode_fps;
+    unsigned skipped_fps;
+    uint64_t bit_rate; // in bits per second
+    // at the last sample
+    int64_t recorder_queue;
+    int64_t file_queue;
+
+    // average latency of each stage over each period, in µs (0 if no frame
+    // has been presented during the period)
+    uint32_t history[HUD_STAGE_COUNT][HUD_STATS_HISTORY];
+    unsigned head; // index of the next sample
+    unsigned count; // number of samples in the history
+};
+
+void
+hud_stats_init(struct hud_stats *stats);
+
+// sample the metrics if the period has elapsed since the last sample
+// the first call only records the current values of the metrics
+// return true if the values have been updated
+bool
+hud_stats_update(struct hud_stats *stats, uint32_t now);
+
+// the i-th latency of the stage in the history, from the oldest (i must be
+// lower than stats->count)
+uint32_t
+hud_stats_get_latency(const struct hud_stats *stats, enum hud_stage stage,
+                      unsigned i);
+
+#endif
@@ -465,10 +465,14 @@ input_manager_process_key(struct input_manager *im,
                 }
                 return;
             case SDLK_i:
-                if (!shift && !repeat && down) {
-                    struct fps_counter *fps_counter =
-                        im->video_buffer->fps_counter;
-                    switch_fps_counter_state(fps_counter);
+                if (!repeat && down) {
+                    if (shift) {
+                        screen_switch_hud(im->screen);
+                    } else {
+                        struct fps_counter *fps_counter =
+                            im->video_buffer->fps_counter;
+                        switch_fps_counter_state(fps_counter);
+                    }
                 }
                 return;
             case SDLK_n:
@@ -8,6 +8,7 @@
 #include <SDL2/SDL.h>
 
 #include "config.h"
+#include "async_log.h"
 #include "cli.h"
 #include "compat.h"
 #include "util/log.h"
@@ -84,19 +85,28 @@ main(int argc, char *argv[]) {
         return 0;
     }
 
+    // write the logs from a separate thread, so that logging never blocks the
+    // stream, decoder or controller threads
+    bool async_log = async_log_init();
+    if (!async_log) {
+        LOGW("Could not start the log writer, logging synchronously");
+    }
+
     LOGI("scrcpy " SCRCPY_VERSION " <https://github.com/Genymobile/scrcpy>");
 
 #ifdef SCRCPY_LAVF_REQUIRES_REGISTER_ALL
     av_register_all();
 #endif
 
-    if (avformat_network_init()) {
-        return 1;
+    int res = 1;
+    if (!avformat_network_init()) {
+        res = scrcpy(&args.opts) ? 0 : 1;
+        avformat_network_deinit(); // ignore failure
     }
 
-    int res = scrcpy(&args.opts) ? 0 : 1;
-
-    avformat_network_deinit(); // ignore failure
+    if (async_log) {
+        async_log_destroy();
+    }
 
 #if defined (__WINDOWS__) && ! defined (WINDOWS_NOCONSOLE)
     if (res != 0) {
@@ -0,0 +1,271 @@
+#include "metrics.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "config.h"
+
+enum metric_type {
+    METRIC_TYPE_COUNTER,
+    METRIC_TYPE_GAUGE,
+    METRIC_TYPE_HISTOGRAM,
+};
+
+struct metric_def {
+    const char *name;
+    const char *help;
+    enum metric_type type;
+};
+
+static const struct metric_def defs[] = {
+    [METRIC_STREAM_PACKETS] = {
+        "scrcpy_stream_packets_total",
+        "Video packets received.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_STREAM_BYTES] = {
+        "scrcpy_stream_bytes_total",
+        "Video bytes received (excluding the packet headers).",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_DECODER_FRAMES] = {
+        "scrcpy_decoder_frames_total",
+        "Frames decoded.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_DECODER_ERRORS] = {
+        "scrcpy_decoder_errors_total",
+        "Video packets which could not be decoded.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_FRAMES_RENDERED] = {
+        "scrcpy_frames_rendered_total",
+        "Frames rendered.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_FRAMES_SKIPPED] = {
+        "scrcpy_frames_skipped_total",
+        "Decoded frames dropped before being rendered.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_RECORDER_PACKETS] = {
+        "scrcpy_recorder_packets_total",
+        "Packets written to the recording.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_CONTROL_MSGS_SENT] = {
+        "scrcpy_control_msgs_sent_total",
+        "Control messages sent to the device.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_CONTROL_MSGS_MERGED] = {
+        "scrcpy_control_msgs_merged_total",
+        "Control messages merged into a pending one (touch and mouse moves).",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_CONTROL_MSGS_DROPPED] = {
+        "scrcpy_control_msgs_dropped_total",
+        "Control messages dropped because the lossy queue was full.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_CONTROL_BYTES_SENT] = {
+        "scrcpy_control_bytes_sent_total",
+        "Control bytes sent to the device.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_FILE_REQUESTS] = {
+        "scrcpy_file_requests_total",
+        "Files dropped to be installed or pushed.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_FILE_ERRORS] = {
+        "scrcpy_file_errors_total",
+        "Files which could not be installed or pushed.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_FILE_BYTES] = {
+        "scrcpy_file_bytes_total",
+        "Bytes of the files successfully installed or pushed.",
+        METRIC_TYPE_COUNTER,
+    },
+    [METRIC_RECORDER_QUEUE] = {
+        "scrcpy_recorder_queue_packets",
+        "Packets waiting to be written to the recording.",
+        METRIC_TYPE_GAUGE,
+    },
+    [METRIC_FILE_QUEUE] = {
+        "scrcpy_file_queue_requests",
+        "Files waiting to be installed or pushed.",
+        METRIC_TYPE_GAUGE,
+    },
+    [METRIC_FRAME_RECEIVE_LATENCY] = {
+        "scrcpy_frame_receive_latency_seconds",
+        "Latency from the capture on the device to the reception.",
+        METRIC_TYPE_HISTOGRAM,
+    },
+    [METRIC_FRAME_DECODE_LATENCY] = {
+        "scrcpy_frame_decode_latency_seconds",
+        "Latency from the capture on the device to the decoding.",
+        METRIC_TYPE_HISTOGRAM,
+    },
+    [METRIC_FRAME_LATENCY] = {
+        "scrcpy_frame_latency_seconds",
+        "Latency from the capture on the device to the presentation.",
+        METRIC_TYPE_HISTOGRAM,
+    },
+    [METRIC_CONTROL_RTT] = {
+        "scrcpy_control_rtt_seconds",
+        "Round-trip time of the control channel.",
+        METRIC_TYPE_HISTOGRAM,
+    },
+};
+
+static_assert(sizeof(defs) / sizeof(defs[0]) == METRIC_COUNT,
+              "missing metric definitions");
+
+// the upper bounds of the histogram buckets, in µs (all the histograms are
+// latencies)
+static const uint64_t buckets[] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000,
+};
+
+#define BUCKET_COUNT (sizeof(buckets) / sizeof(buckets[0]))
+
+struct metric_value {
+    // the value of a counter or a gauge, the sum of a histogram
+    atomic_int_least64_t value;
+    // the count of each bucket (not cumulative), the last one is +Inf
+    atomic_uint_least64_t counts[BUCKET_COUNT + 1];
+};
+
+static struct metric_value values[METRIC_COUNT];
+
+void
+metrics_inc(enum metric_id id) {
+    metrics_add(id, 1);
+}
+
+void
+metrics_add(enum metric_id id, uint64_t value) {
+    assert(defs[id].type == METRIC_TYPE_COUNTER);
+    atomic_fetch_add_explicit(&values[id].value, value,
+                              memory_order_relaxed);
+}
+
+void
+metrics_gauge_add(enum metric_id id, int64_t value) {
+    assert(defs[id].type == METRIC_TYPE_GAUGE);
+    atomic_fetch_add_explicit(&values[id].value, value,
+                              memory_order_relaxed);
+}
+
+void
+metrics_observe(enum metric_id id, uint64_t value) {
+    assert(defs[id].type == METRIC_TYPE_HISTOGRAM);
+    unsigned i = 0;
+    while (i < BUCKET_COUNT && value > buckets[i]) {
+        ++i;
+    }
+    atomic_fetch_add_explicit(&values[id].counts[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&values[id].value, value, memory_order_relaxed);
+}
+
+static uint64_t
+get_count(enum metric_id id, unsigned bucket) {
+    return atomic_load_explicit(&values[id].counts[bucket],
+                                memory_order_relaxed);
+}
+
+int64_t
+metrics_get(enum metric_id id) {
+    if (defs[id].type != METRIC_TYPE_HISTOGRAM) {
+        return atomic_load_explicit(&values[id].value, memory_order_relaxed);
+    }
+
+    uint64_t count = 0;
+    for (unsigned i = 0; i <= BUCKET_COUNT; ++i) {
+        count += get_count(id, i);
+    }
+    return count;
+}
+
+int64_t
+metrics_get_sum(enum metric_id id) {
+    assert(defs[id].type == METRIC_TYPE_HISTOGRAM);
+    return atomic_load_explicit(&values[id].value, memory_order_relaxed);
+}
+
+static size_t
+format_histogram(char *buf, size_t size, enum metric_id id) {
+    const char *name = defs[id].name;
+    // the buckets are read once, so that the +Inf bucket equals the count,
+    // even if values are observed concurrently
+    uint64_t cumulative = 0;
+    size_t len = 0;
+    for (unsigned i = 0; i <= BUCKET_COUNT; ++i) {
+        cumulative += get_count(id, i);
+        int r;
+        if (i < BUCKET_COUNT) {
+            r = snprintf(&buf[len], size - len,
+                         "%s_bucket{le=\"%g\"} %" PRIu64 "\n", name,
+                         buckets[i] / 1000000.0, cumulative);
+        } else {
+            r = snprintf(&buf[len], size - len,
+                         "%s_bucket{le=\"+Inf\"} %" PRIu64 "\n", name,
+                         cumulative);
+        }
+        if (r < 0 || (size_t) r >= size - len) {
+            return 0;
+        }
+        len += r;
+    }
+
+    int64_t sum = atomic_load_explicit(&values[id].value,
+                                       memory_order_relaxed);
+    int r = snprintf(&buf[len], size - len,
+                     "%s_sum %.6f\n%s_count %" PRIu64 "\n", name,
+                     sum / 1000000.0, name, cumulative);
+    if (r < 0 || (size_t) r >= size - len) {
+        return 0;
+    }
+    return len + r;
+}
+
+size_t
+metrics_format(char *buf, size_t size) {
+    static const char *const type_names[] = {
+        [METRIC_TYPE_COUNTER] = "counter",
+        [METRIC_TYPE_GAUGE] = "gauge",
+        [METRIC_TYPE_HISTOGRAM] = "histogram",
+    };
+
+    size_t len = 0;
+    for (unsigned id = 0; id < METRIC_COUNT; ++id) {
+        const struct metric_def *def = &defs[id];
+        int r = snprintf(&buf[len], size - len, "# HELP %s %s\n# TYPE %s %s\n",
+                         def->name, def->help, def->name,
+                         type_names[def->type]);
+        if (r < 0 || (size_t) r >= size - len) {
+            return 0;
+        }
+        len += r;
+
+        if (def->type == METRIC_TYPE_HISTOGRAM) {
+            size_t w = format_histogram(&buf[len], size - len, id);
+            if (!w) {
+                return 0;
+            }
+            len += w;
+        } else {
+            r = snprintf(&buf[len], size - len, "%s %" PRId64 "\n", def->name,
+                         metrics_get(id));
+            if (r < 0 || (size_t) r >= size - len) {
+                return 0;
+            }
+            len += r;
+        }
+    }
+    return len;
+}
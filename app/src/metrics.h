@@ -0,0 +1,82 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+// Process-wide metrics registry, fed by the modules on their hot paths (each
+// update is a single relaxed atomic operation, so the metrics are always
+// collected), and exported in the Prometheus text format (see
+// metrics_server.h).
+//
+// The metrics are defined statically (see the table in metrics.c), so that
+// updating a metric never allocates nor looks up a name.
+
+enum metric_id {
+    // counters
+    METRIC_STREAM_PACKETS,
+    METRIC_STREAM_BYTES,
+    METRIC_DECODER_FRAMES,
+    METRIC_DECODER_ERRORS,
+    METRIC_FRAMES_RENDERED,
+    METRIC_FRAMES_SKIPPED,
+    METRIC_RECORDER_PACKETS,
+    METRIC_CONTROL_MSGS_SENT,
+    METRIC_CONTROL_MSGS_MERGED,
+    METRIC_CONTROL_MSGS_DROPPED,
+    METRIC_CONTROL_BYTES_SENT,
+    METRIC_FILE_REQUESTS,
+    METRIC_FILE_ERRORS,
+    METRIC_FILE_BYTES,
+    // gauges
+    METRIC_RECORDER_QUEUE,
+    METRIC_FILE_QUEUE,
+    // histograms (the values are observed in µs, exported in seconds)
+    METRIC_FRAME_RECEIVE_LATENCY,
+    METRIC_FRAME_DECODE_LATENCY,
+    METRIC_FRAME_LATENCY,
+    METRIC_CONTROL_RTT,
+
+    METRIC_COUNT,
+};
+
+// large enough for the text of all the metrics
+#define METRICS_TEXT_MAX_SIZE 8192
+
+// increment a counter
+void
+metrics_inc(enum metric_id id);
+
+// add a value to a counter
+void
+metrics_add(enum metric_id id, uint64_t value);
+
+// add a (possibly negative) value to a gauge
+void
+metrics_gauge_add(enum metric_id id, int64_t value);
+
+// record a value (in µs) in a histogram
+void
+metrics_observe(enum metric_id id, uint64_t value);
+
+// the current value of a counter or a gauge (the count of a histogram)
+int64_t
+metrics_get(enum metric_id id);
+
+// the sum of the values (in µs) recorded in a histogram
+int64_t
+metrics_get_sum(enum metric_id id);
+
+// format all the metrics in the Prometheus text exposition format, for
+// example:
+//     # HELP scrcpy_stream_packets_total Video packets received.
+//     # TYPE scrcpy_stream_packets_total counter
+//     scrcpy_stream_packets_total 1234
+// return the length written (excluding the '\0'), or 0 if truncated
+size_t
+metrics_format(char *buf, size_t size);
+
+#endif
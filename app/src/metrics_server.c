@@ -0,0 +1,162 @@
+#include "metrics_server.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "metrics.h"
+#include "util/log.h"
+
+#define IPV4_ANY 0
+#define IPV4_LOCALHOST 0x7F000001
+
+static void
+serve_client(socket_t socket, void *userdata);
+
+static socket_t
+connect_to_server(void *userdata) {
+    struct metrics_server *server = userdata;
+    return net_connect(IPV4_LOCALHOST, server->port);
+}
+
+static const struct accept_loop_cbs accept_loop_cbs = {
+    .serve = serve_client,
+    .connect = connect_to_server,
+};
+
+bool
+metrics_server_init(struct metrics_server *server, uint16_t port,
+                    bool all_interfaces) {
+    uint32_t addr = all_interfaces ? IPV4_ANY : IPV4_LOCALHOST;
+    socket_t server_socket = net_listen(addr, port, 1);
+    if (server_socket == INVALID_SOCKET) {
+        LOGE("Could not listen on metrics port %" PRIu16, port);
+        return false;
+    }
+
+    if (!accept_loop_init(&server->loop, "metrics", server_socket,
+                          &accept_loop_cbs, server)) {
+        net_close(server_socket);
+        return false;
+    }
+
+    server->port = port;
+    return true;
+}
+
+void
+metrics_server_destroy(struct metrics_server *server) {
+    accept_loop_destroy(&server->loop);
+}
+
+static bool
+send_response(socket_t socket, const char *status, const char *body,
+              size_t body_len) {
+    char header[256];
+    int len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 %s\r\n"
+                       "Content-Type: text/plain; version=0.0.4; "
+                           "charset=utf-8\r\n"
+                       "Content-Length: %zu\r\n"
+                       "Connection: close\r\n"
+                       "\r\n", status, body_len);
+    if (len < 0 || (size_t) len >= sizeof(header)) {
+        return false;
+    }
+    return net_send_all(socket, header, len) == len
+        && net_send_all(socket, body, body_len) == (ssize_t) body_len;
+}
+
+static bool
+is_metrics_path(const char *path, size_t len) {
+    static const char metrics[] = "/metrics";
+    size_t metrics_len = sizeof(metrics) - 1;
+    // ignore the query string, if any
+    return len >= metrics_len && !memcmp(path, metrics, metrics_len)
+        && (len == metrics_len || path[metrics_len] == '?');
+}
+
+// the request line is "GET /metrics HTTP/1.1"
+static void
+process_request(socket_t socket, const char *request) {
+    if (strncmp(request, "GET ", 4)) {
+        const char body[] = "Method not allowed\n";
+        send_response(socket, "405 Method Not Allowed", body,
+                      sizeof(body) - 1);
+        return;
+    }
+
+    const char *path = &request[4];
+    size_t path_len = strcspn(path, " \r\n");
+    if (!is_metrics_path(path, path_len)) {
+        const char body[] = "Not found\n";
+        send_response(socket, "404 Not Found", body, sizeof(body) - 1);
+        return;
+    }
+
+    char body[METRICS_TEXT_MAX_SIZE];
+    size_t len = metrics_format(body, sizeof(body));
+    if (!len) {
+        LOGW("Metrics truncated");
+        const char error[] = "Metrics truncated\n";
+        send_response(socket, "500 Internal Server Error", error,
+                      sizeof(error) - 1);
+        return;
+    }
+    send_response(socket, "200 OK", body, len);
+}
+
+static void
+read_request(socket_t socket) {
+    char request[METRICS_SERVER_REQUEST_MAX];
+    size_t len = 0;
+    // read the whole request header (it has no body)
+    while (len < sizeof(request) - 1) {
+        ssize_t r = net_recv(socket, &request[len], sizeof(request) - 1 - len);
+        if (r <= 0) {
+            return;
+        }
+        len += r;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n")) {
+            process_request(socket, request);
+            return;
+        }
+    }
+
+    const char body[] = "Request too large\n";
+    send_response(socket, "431 Request Header Fields Too Large", body,
+                  sizeof(body) - 1);
+}
+
+static void
+serve_client(socket_t socket, void *userdata) {
+    (void) userdata;
+    // a stalled client must not block the next ones
+    if (net_set_timeout(socket, METRICS_SERVER_CLIENT_TIMEOUT_MS)) {
+        read_request(socket);
+    }
+}
+
+bool
+metrics_server_start(struct metrics_server *server) {
+    LOGD("Starting metrics server thread");
+
+    if (!accept_loop_start(&server->loop, "metrics-server")) {
+        return false;
+    }
+
+    LOGI("Metrics served on port %" PRIu16 " (GET /metrics)", server->port);
+    return true;
+}
+
+void
+metrics_server_stop(struct metrics_server *server) {
+    accept_loop_stop(&server->loop);
+}
+
+void
+metrics_server_join(struct metrics_server *server) {
+    accept_loop_join(&server->loop);
+}
@@ -0,0 +1,44 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "util/accept_loop.h"
+
+// max size of an HTTP request (only the request line is used)
+#define METRICS_SERVER_REQUEST_MAX 1024
+// the requests are served one at a time: a client which does not send its
+// request (or does not read the response) is disconnected after this delay
+#define METRICS_SERVER_CLIENT_TIMEOUT_MS 2000
+
+// Serve the metrics (see metrics.h) over HTTP, in the Prometheus text format,
+// on "GET /metrics", so that a monitoring server can scrape them.
+//
+// It listens on localhost only, unless all the network interfaces are
+// requested explicitly (so that a remote server can scrape it, the endpoint is
+// not authenticated). The requests are served one at a time, and each
+// connection is closed after the response.
+struct metrics_server {
+    uint16_t port;
+    struct accept_loop loop;
+};
+
+bool
+metrics_server_init(struct metrics_server *server, uint16_t port,
+                    bool all_interfaces);
+
+void
+metrics_server_destroy(struct metrics_server *server);
+
+bool
+metrics_server_start(struct metrics_server *server);
+
+void
+metrics_server_stop(struct metrics_server *server);
+
+void
+metrics_server_join(struct metrics_server *server);
+
+#endif
@@ -5,15 +5,23 @@
 
 #include "config.h"
 #include "device_msg.h"
+#include "metrics.h"
+#include "trace.h"
 #include "util/lock.h"
 #include "util/log.h"
+#include "util/tick.h"
 
 bool
-receiver_init(struct receiver *receiver, socket_t control_socket) {
+receiver_init(struct receiver *receiver, socket_t control_socket,
+              struct rtt_stats *rtt_stats, struct clock_sync *clock_sync,
+              struct encoder_stats *encoder_stats) {
     if (!(receiver->mutex = SDL_CreateMutex())) {
         return false;
     }
     receiver->control_socket = control_socket;
+    receiver->rtt_stats = rtt_stats;
+    receiver->clock_sync = clock_sync;
+    receiver->encoder_stats = encoder_stats;
     return true;
 }
 
@@ -23,7 +31,31 @@ receiver_destroy(struct receiver *receiver) {
 }
 
 static void
-process_msg(struct device_msg *msg) {
+process_pong(struct receiver *receiver, struct device_msg *msg) {
+    uint64_t now = tick_now_us();
+    uint64_t ping_timestamp = msg->pong.timestamp;
+    if (ping_timestamp > now) {
+        LOGW("Invalid pong timestamp");
+        return;
+    }
+
+    uint64_t rtt = now - ping_timestamp;
+    metrics_observe(METRIC_CONTROL_RTT, rtt);
+
+    if (receiver->rtt_stats) {
+        rtt_stats_add(receiver->rtt_stats,
+                      rtt < UINT32_MAX ? rtt : UINT32_MAX);
+    }
+
+    if (receiver->clock_sync) {
+        clock_sync_add_exchange(receiver->clock_sync, ping_timestamp,
+                                msg->pong.receive_time, msg->pong.send_time,
+                                now);
+    }
+}
+
+static void
+process_msg(struct receiver *receiver, struct device_msg *msg) {
     switch (msg->type) {
         case DEVICE_MSG_TYPE_CLIPBOARD: {
             char *current = SDL_GetClipboardText();
@@ -38,63 +70,71 @@ process_msg(struct device_msg *msg) {
             SDL_SetClipboardText(msg->clipboard.text);
             break;
         }
+        case DEVICE_MSG_TYPE_PONG:
+            process_pong(receiver, msg);
+            break;
+        case DEVICE_MSG_TYPE_ENCODER_STATS:
+            if (receiver->encoder_stats) {
+                encoder_stats_add_report(receiver->encoder_stats,
+                                         &msg->encoder_stats);
+            }
+            break;
     }
 }
 
-static ssize_t
-process_msgs(const unsigned char *buf, size_t len) {
-    size_t head = 0;
+// process all the complete messages from the ring buffer
+// return false on error
+static bool
+process_msgs(struct receiver *receiver, struct device_msg_reader *reader,
+             struct byte_ring *ring) {
     for (;;) {
         struct device_msg msg;
-        ssize_t r = device_msg_deserialize(&buf[head], len - head, &msg);
-        if (r == -1) {
-            return -1;
-        }
-        if (r == 0) {
-            return head;
+        int r = device_msg_reader_read(reader, ring, &msg);
+        if (r <= 0) {
+            return r == 0;
         }
 
-        process_msg(&msg);
+        process_msg(receiver, &msg);
         device_msg_destroy(&msg);
-
-        head += r;
-        assert(head <= len);
-        if (head == len) {
-            return head;
-        }
     }
 }
 
 static int
 run_receiver(void *data) {
     struct receiver *receiver = data;
+    trace_set_thread_name("receiver");
+
+    // the messages are parsed in place, and large payloads are streamed, so
+    // the buffer does not depend on the message size
+    unsigned char buf[RECEIVER_BUFFER_SIZE];
+    struct byte_ring ring;
+    byte_ring_init(&ring, buf, sizeof(buf));
 
-    static unsigned char buf[DEVICE_MSG_MAX_SIZE];
-    size_t head = 0;
+    struct device_msg_reader reader;
+    device_msg_reader_init(&reader);
 
     for (;;) {
-        assert(head < DEVICE_MSG_MAX_SIZE);
-        ssize_t r = net_recv(receiver->control_socket, buf + head,
-                             DEVICE_MSG_MAX_SIZE - head);
+        size_t len;
+        unsigned char *p = byte_ring_write_ptr(&ring, &len);
+        // only an incomplete header may be left in the ring
+        assert(len);
+        ssize_t r = net_recv(receiver->control_socket, p, len);
         if (r <= 0) {
             LOGD("Receiver stopped");
             break;
         }
+        byte_ring_commit(&ring, r);
 
-        head += r;
-        ssize_t consumed = process_msgs(buf, head);
-        if (consumed == -1) {
+        uint64_t trace_start = trace_begin();
+        bool ok = process_msgs(receiver, &reader, &ring);
+        trace_end("device_msgs", trace_start);
+        if (!ok) {
             // an error occurred
             break;
         }
-
-        if (consumed) {
-            head -= consumed;
-            // shift the remaining data in the buffer
-            memmove(buf, &buf[consumed], head);
-        }
     }
 
+    device_msg_reader_destroy(&reader);
     return 0;
 }
 
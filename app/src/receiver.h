@@ -6,18 +6,31 @@
 #include <SDL2/SDL_thread.h>
 
 #include "config.h"
+#include "clock_sync.h"
+#include "encoder_stats.h"
+#include "rtt_stats.h"
 #include "util/net.h"
 
+// size of the ring buffer of the receiver thread (a power of 2)
+#define RECEIVER_BUFFER_SIZE 4096
+
 // receive events from the device
 // managed by the controller
 struct receiver {
     socket_t control_socket;
     SDL_Thread *thread;
     SDL_mutex *mutex;
+    struct rtt_stats *rtt_stats; // may be NULL
+    struct clock_sync *clock_sync; // may be NULL
+    struct encoder_stats *encoder_stats; // may be NULL
 };
 
+// rtt_stats and clock_sync may be NULL (if both are NULL, pongs are ignored)
+// encoder_stats may be NULL (the encoder statistics are then ignored)
 bool
-receiver_init(struct receiver *receiver, socket_t control_socket);
+receiver_init(struct receiver *receiver, socket_t control_socket,
+              struct rtt_stats *rtt_stats, struct clock_sync *clock_sync,
+              struct encoder_stats *encoder_stats);
 
 void
 receiver_destroy(struct receiver *receiver);
@@ -5,6 +5,8 @@
 
 #include "config.h"
 #include "compat.h"
+#include "metrics.h"
+#include "trace.h"
 #include "util/lock.h"
 #include "util/log.h"
 
@@ -57,6 +59,7 @@ recorder_queue_clear(struct recorder_queue *queue) {
         struct record_packet *rec;
         queue_take(queue, next, &rec);
         record_packet_delete(rec);
+        metrics_gauge_add(METRIC_RECORDER_QUEUE, -1);
     }
 }
 
@@ -93,6 +96,8 @@ recorder_init(struct recorder *recorder,
     recorder->declared_frame_size = declared_frame_size;
     recorder->header_written = false;
     recorder->previous = NULL;
+    recorder->base_filename = NULL;
+    recorder->segment = 0;
 
     return true;
 }
@@ -102,6 +107,59 @@ recorder_destroy(struct recorder *recorder) {
     SDL_DestroyCond(recorder->queue_cond);
     SDL_DestroyMutex(recorder->mutex);
     SDL_free(recorder->filename);
+    SDL_free(recorder->base_filename);
+}
+
+// insert "-<segment>" before the extension, if any
+static char *
+get_segment_filename(const char *filename, unsigned segment) {
+    const char *ext = strrchr(filename, '.');
+    const char *slash = strrchr(filename, '/');
+    const char *backslash = strrchr(filename, '\\');
+    if (!ext || (slash && ext < slash) || (backslash && ext < backslash)) {
+        // no extension
+        ext = filename + strlen(filename);
+    }
+    int prefix_len = ext - filename;
+
+    // '-' + up to 10 digits + '\0'
+    size_t len = prefix_len + strlen(ext) + 12;
+    char *segment_filename = SDL_malloc(len);
+    if (!segment_filename) {
+        return NULL;
+    }
+    snprintf(segment_filename, len, "%.*s-%u%s", prefix_len, filename, segment,
+             ext);
+    return segment_filename;
+}
+
+bool
+recorder_next_segment(struct recorder *recorder,
+                      struct size declared_frame_size) {
+    const char *base = recorder->base_filename ? recorder->base_filename
+                                               : recorder->filename;
+    char *filename = get_segment_filename(base, recorder->segment + 1);
+    if (!filename) {
+        LOGC("Could not allocate segment filename");
+        return false;
+    }
+
+    if (recorder->base_filename) {
+        SDL_free(recorder->filename);
+    } else {
+        // keep the requested filename to name the next segments
+        recorder->base_filename = recorder->filename;
+    }
+    recorder->filename = filename;
+    ++recorder->segment;
+
+    assert(queue_is_empty(&recorder->queue));
+    recorder->stopped = false;
+    recorder->failed = false;
+    recorder->declared_frame_size = declared_frame_size;
+    recorder->header_written = false;
+    recorder->previous = NULL;
+    return true;
 }
 
 static const char *
@@ -252,12 +310,16 @@ recorder_write(struct recorder *recorder, AVPacket *packet) {
     }
 
     recorder_rescale_packet(recorder, packet);
-    return av_write_frame(recorder->ctx, packet) >= 0;
+    uint64_t trace_start = trace_begin();
+    bool ok = av_write_frame(recorder->ctx, packet) >= 0;
+    trace_end("mux_write", trace_start);
+    return ok;
 }
 
 static int
 run_recorder(void *data) {
     struct recorder *recorder = data;
+    trace_set_thread_name("recorder");
 
     for (;;) {
         mutex_lock(recorder->mutex);
@@ -289,6 +351,7 @@ run_recorder(void *data) {
 
         struct record_packet *rec;
         queue_take(&recorder->queue, next, &rec);
+        metrics_gauge_add(METRIC_RECORDER_QUEUE, -1);
 
         mutex_unlock(recorder->mutex);
 
@@ -310,7 +373,9 @@ run_recorder(void *data) {
 
         bool ok = recorder_write(recorder, &previous->packet);
         record_packet_delete(previous);
-        if (!ok) {
+        if (ok) {
+            metrics_inc(METRIC_RECORDER_PACKETS);
+        } else {
             LOGE("Could not record packet");
 
             mutex_lock(recorder->mutex);
@@ -371,6 +436,7 @@ recorder_push(struct recorder *recorder, const AVPacket *packet) {
     }
 
     queue_push(&recorder->queue, next, rec);
+    metrics_gauge_add(METRIC_RECORDER_QUEUE, 1);
     cond_signal(recorder->queue_cond);
 
     mutex_unlock(recorder->mutex);
@@ -19,7 +19,10 @@ struct record_packet {
 struct recorder_queue QUEUE(struct record_packet);
 
 struct recorder {
-    char *filename;
+    char *filename; // the current file
+    // the requested file, after a new segment has been started (NULL before)
+    char *base_filename;
+    unsigned segment; // 0 for the initial file
     enum sc_record_format format;
     AVFormatContext *ctx;
     struct size declared_frame_size;
@@ -46,6 +49,13 @@ recorder_init(struct recorder *recorder, const char *filename,
 void
 recorder_destroy(struct recorder *recorder);
 
+// continue the recording in a new file, named after the requested one with a
+// segment number ("file.mp4" -> "file-1.mp4"), for example after a
+// reconnection (the previous file must have been closed)
+bool
+recorder_next_segment(struct recorder *recorder,
+                      struct size declared_frame_size);
+
 bool
 recorder_open(struct recorder *recorder, const AVCodec *input_codec);
 
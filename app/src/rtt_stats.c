@@ -0,0 +1,101 @@
+#include "rtt_stats.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "util/lock.h"
+#include "util/log.h"
+
+bool
+rtt_stats_init(struct rtt_stats *stats, uint32_t warning_threshold_ms) {
+    if (!(stats->mutex = SDL_CreateMutex())) {
+        return false;
+    }
+    stats->warning_threshold = warning_threshold_ms * 1000;
+    stats->above_threshold = false;
+    stats->head = 0;
+    stats->count = 0;
+    stats->total = 0;
+    return true;
+}
+
+void
+rtt_stats_destroy(struct rtt_stats *stats) {
+    SDL_DestroyMutex(stats->mutex);
+}
+
+// must be called with mutex locked
+static void
+check_threshold(struct rtt_stats *stats, uint32_t rtt) {
+    if (!stats->warning_threshold) {
+        return;
+    }
+
+    // only log the transitions, not every sample
+    bool above = rtt > stats->warning_threshold;
+    if (above && !stats->above_threshold) {
+        LOGW("Control round-trip time is %u ms (threshold: %u ms)",
+             (unsigned) (rtt / 1000),
+             (unsigned) (stats->warning_threshold / 1000));
+    } else if (!above && stats->above_threshold) {
+        LOGI("Control round-trip time is back to %u ms",
+             (unsigned) (rtt / 1000));
+    }
+    stats->above_threshold = above;
+}
+
+void
+rtt_stats_add(struct rtt_stats *stats, uint32_t rtt) {
+    mutex_lock(stats->mutex);
+    stats->samples[stats->head] = rtt;
+    stats->head = (stats->head + 1) % RTT_STATS_WINDOW;
+    if (stats->count < RTT_STATS_WINDOW) {
+        ++stats->count;
+    }
+    ++stats->total;
+    check_threshold(stats, rtt);
+    mutex_unlock(stats->mutex);
+}
+
+static int
+compare_u32(const void *a, const void *b) {
+    uint32_t ua = *(const uint32_t *) a;
+    uint32_t ub = *(const uint32_t *) b;
+    return (ua > ub) - (ua < ub);
+}
+
+// nearest-rank percentile of sorted samples
+static uint32_t
+percentile(const uint32_t *sorted, unsigned count, unsigned p) {
+    assert(count);
+    assert(p > 0 && p <= 100);
+    // ceil(p * count / 100)
+    unsigned rank = (p * count + 99) / 100;
+    return sorted[rank - 1];
+}
+
+bool
+rtt_stats_get_percentiles(struct rtt_stats *stats,
+                          struct rtt_percentiles *percentiles) {
+    uint32_t sorted[RTT_STATS_WINDOW];
+
+    mutex_lock(stats->mutex);
+    unsigned count = stats->count;
+    // the order of the samples does not matter
+    memcpy(sorted, stats->samples, count * sizeof(*sorted));
+    mutex_unlock(stats->mutex);
+
+    if (!count) {
+        return false;
+    }
+
+    qsort(sorted, count, sizeof(*sorted), compare_u32);
+    percentiles->p50 = percentile(sorted, count, 50);
+    percentiles->p90 = percentile(sorted, count, 90);
+    percentiles->p99 = percentile(sorted, count, 99);
+    percentiles->max = sorted[count - 1];
+    percentiles->count = count;
+    return true;
+}
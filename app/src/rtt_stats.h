@@ -0,0 +1,51 @@
+#ifndef RTT_STATS_H
+#define RTT_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL2/SDL_mutex.h>
+
+#include "config.h"
+
+// number of recent samples the percentiles are computed from
+#define RTT_STATS_WINDOW 128
+
+// round-trip times of the control channel, measured by ping/pong messages
+// (including the queuing in the controller, so it is the input latency, minus
+// the injection on the device)
+struct rtt_stats {
+    SDL_mutex *mutex;
+    uint32_t warning_threshold; // in µs, 0 to disable the warning
+    bool above_threshold;
+    // circular buffer of the last samples, in µs
+    uint32_t samples[RTT_STATS_WINDOW];
+    unsigned head;
+    unsigned count; // number of valid samples (<= RTT_STATS_WINDOW)
+    uint64_t total; // number of samples since the beginning
+};
+
+// in µs, over the last (at most RTT_STATS_WINDOW) samples
+struct rtt_percentiles {
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t max;
+    unsigned count; // number of samples
+};
+
+bool
+rtt_stats_init(struct rtt_stats *stats, uint32_t warning_threshold_ms);
+
+void
+rtt_stats_destroy(struct rtt_stats *stats);
+
+// record a sample, in µs
+void
+rtt_stats_add(struct rtt_stats *stats, uint32_t rtt);
+
+// return false if there is no sample yet
+bool
+rtt_stats_get_percentiles(struct rtt_stats *stats,
+                          struct rtt_percentiles *percentiles);
+
+#endif
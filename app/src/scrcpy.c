@@ -1,5 +1,7 @@
 #include "scrcpy.h"
 
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
@@ -14,21 +16,30 @@
 #endif
 
 #include "config.h"
+#include "async_log.h"
+#include "automation.h"
+#include "clock_sync.h"
 #include "command.h"
 #include "common.h"
 #include "compat.h"
 #include "controller.h"
 #include "decoder.h"
 #include "device.h"
+#include "encoder_stats.h"
 #include "events.h"
 #include "file_handler.h"
 #include "fps_counter.h"
+#include "frame_latency.h"
 #include "input_manager.h"
+#include "metrics_server.h"
 #include "recorder.h"
+#include "rtt_stats.h"
 #include "screen.h"
 #include "server.h"
+#include "startup_timeline.h"
 #include "stream.h"
 #include "tiny_xpm.h"
+#include "trace.h"
 #include "video_buffer.h"
 #include "util/lock.h"
 #include "util/log.h"
@@ -37,12 +48,48 @@
 static struct server server = SERVER_INITIALIZER;
 static struct screen screen = SCREEN_INITIALIZER;
 static struct fps_counter fps_counter;
+// the probes below are enabled if display and control are enabled (they
+// require the messages from the device)
+static struct rtt_stats rtt_stats;
+static struct clock_sync clock_sync;
+static struct frame_latency frame_latency;
+static struct encoder_stats encoder_stats;
 static struct video_buffer video_buffer;
 static struct stream stream;
 static struct decoder decoder;
 static struct recorder recorder;
 static struct controller controller;
 static struct file_handler file_handler;
+static struct startup_timeline startup_timeline;
+// &startup_timeline if enabled, NULL otherwise
+static struct startup_timeline *timeline;
+static struct automation automation_server;
+// &automation_server if enabled, NULL otherwise
+static struct automation *automation;
+static struct metrics_server metrics_server;
+static struct server_params server_params;
+
+// the parts restarted on reconnection (see --reconnect)
+struct session {
+    bool server_started;
+    bool stream_started;
+    bool controller_initialized;
+    bool controller_started;
+};
+
+#define SESSION_INITIALIZER { \
+    .server_started = false, \
+    .stream_started = false, \
+    .controller_initialized = false, \
+    .controller_started = false, \
+}
+
+static struct session session = SESSION_INITIALIZER;
+
+// delay between two reconnection attempts
+#define RECONNECT_DELAY_MS 1000
+// interval between two checks of the trace requests (on SIGUSR1)
+#define TRACE_REQUEST_POLL_MS 100
 
 static struct input_manager input_manager = {
     .controller = &controller,
@@ -70,11 +117,41 @@ BOOL WINAPI windows_ctrl_handler(DWORD ctrl_type) {
 }
 #endif // _WIN32
 
+#ifndef _WIN32
+// set on SIGUSR1 to write the trace (from the event loop, it is not
+// signal-safe): only a lock-free atomic may be accessed from the handler
+static atomic_bool trace_requested;
+static SDL_TimerID trace_timer;
+
+static void
+sigusr1_handler(int signum) {
+    (void) signum;
+    atomic_store_explicit(&trace_requested, true, memory_order_relaxed);
+}
+
+// poll the flag set by the signal handler (SDL_PushEvent() is not
+// async-signal-safe, but it may be called from the timer thread)
+static uint32_t
+trace_request_timer(uint32_t interval, void *param) {
+    (void) param;
+    if (atomic_exchange_explicit(&trace_requested, false,
+                                 memory_order_relaxed)) {
+        SDL_Event event;
+        event.type = EVENT_WRITE_TRACE;
+        SDL_PushEvent(&event);
+    }
+    return interval; // repeat
+}
+#endif
+
 // init SDL and set appropriate hints
 static bool
 sdl_init_and_configure(bool display, const char *render_driver,
                        bool disable_screensaver) {
-    uint32_t flags = display ? SDL_INIT_VIDEO : SDL_INIT_EVENTS;
+    // the timers are used to follow the window size, to refresh the HUD and
+    // to poll the trace requests
+    uint32_t flags = display ? SDL_INIT_VIDEO | SDL_INIT_TIMER
+                             : SDL_INIT_EVENTS | SDL_INIT_TIMER;
     if (SDL_Init(flags)) {
         LOGC("Could not initialize SDL: %s", SDL_GetError());
         return false;
@@ -167,14 +244,118 @@ enum event_result {
     EVENT_RESULT_CONTINUE,
     EVENT_RESULT_STOPPED_BY_USER,
     EVENT_RESULT_STOPPED_BY_EOS,
+    EVENT_RESULT_RECONNECT_DONE,
 };
 
+// acknowledge the frame just displayed, so that the device stops sending
+// frames faster than they can be displayed
+static void
+ack_frame(void) {
+    if (video_buffer.consumed_pts == AV_NOPTS_VALUE) {
+        return;
+    }
+
+    struct control_msg msg;
+    msg.type = CONTROL_MSG_TYPE_ACK_FRAME;
+    msg.ack_frame.pts = video_buffer.consumed_pts;
+    msg.ack_frame.skipped_frames =
+        MIN(video_buffer.consumed_skipped_frames, UINT16_MAX);
+    // merged into the pending ack, if it has not been sent yet
+    controller_push_msg(&controller, &msg);
+}
+
+// the last max size requested to follow the window size, 0 if none (a new
+// server does not know it, so it is requested again on reconnection)
+static uint16_t requested_max_size;
+
+static void
+request_video_size(uint16_t max_size) {
+    struct control_msg msg;
+    msg.type = CONTROL_MSG_TYPE_SET_VIDEO_SIZE;
+    msg.set_video_size.max_size = max_size;
+    msg.set_video_size.set_crop = false; // keep the current crop
+    if (!controller_push_msg(&controller, &msg)) {
+        LOGW("Could not request 'set video size'");
+    }
+}
+
+static void
+request_video_size_for_window(void) {
+    uint16_t max_size;
+    if (!screen_follow_window_size(&screen, &max_size)) {
+        return;
+    }
+
+    requested_max_size = max_size;
+    request_video_size(max_size);
+}
+
+static void
+set_video_paused(bool paused) {
+    struct control_msg msg;
+    msg.type = CONTROL_MSG_TYPE_SET_VIDEO_PAUSED;
+    msg.set_video_paused.paused = paused;
+    if (!controller_push_msg(&controller, &msg)) {
+        LOGW("Could not request 'set video paused'");
+        return;
+    }
+    LOGD("Video %s (window %s)", paused ? "paused" : "resumed",
+                                 paused ? "hidden" : "shown");
+}
+
+// called on the first frame, which ends the startup
+// (written to a dedicated file: stdout also relays the server output)
+static void
+write_startup_timeline(const char *filename) {
+    startup_timeline_add(timeline, "first_frame", timeline->origin,
+                         SDL_GetTicks());
+    char json[4096];
+    if (!startup_timeline_to_json(timeline, json, sizeof(json))) {
+        LOGW("Startup timeline truncated");
+        return;
+    }
+
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        LOGE("Could not open startup timeline file: %s", filename);
+        return;
+    }
+    bool ok = fprintf(file, "%s\n", json) >= 0;
+    ok = !fclose(file) && ok;
+    if (!ok) {
+        LOGE("Could not write startup timeline file: %s", filename);
+        return;
+    }
+    LOGI("Startup timeline written to %s", filename);
+}
+
 static enum event_result
 handle_event(SDL_Event *event, const struct scrcpy_options *options) {
     switch (event->type) {
         case EVENT_STREAM_STOPPED:
             LOGD("Video stream stopped");
             return EVENT_RESULT_STOPPED_BY_EOS;
+        case EVENT_RECONNECT_DONE:
+            return EVENT_RESULT_RECONNECT_DONE;
+        case EVENT_WRITE_TRACE:
+            trace_write(options->trace_filename);
+            break;
+        case EVENT_FILE_PROGRESS:
+            file_handler_report_progress(&file_handler);
+            break;
+        case EVENT_FOLLOW_WINDOW_SIZE:
+            // the window size is stable, even if no new frame is received
+            if (session.controller_started) {
+                request_video_size_for_window();
+            }
+            break;
+        case EVENT_HUD_REFRESH:
+            // render the HUD even if no frame is received, so that it does
+            // not keep showing stale values
+            if (screen.has_frame) {
+                screen_render(&screen, false);
+            }
+            break;
         case SDL_QUIT:
             LOGD("User requested to quit");
             return EVENT_RESULT_STOPPED_BY_USER;
@@ -183,16 +364,35 @@ handle_event(SDL_Event *event, const struct scrcpy_options *options) {
                 screen.has_frame = true;
                 // this is the very first frame, show the window
                 screen_show_window(&screen);
+                if (timeline) {
+                    write_startup_timeline(
+                            options->startup_timeline_filename);
+                }
             }
             if (!screen_update_frame(&screen, &video_buffer)) {
                 return EVENT_RESULT_CONTINUE;
             }
+            if (session.controller_started) {
+                frame_latency_on_presented(&frame_latency,
+                                           video_buffer.consumed_pts);
+                ack_frame();
+            }
+            if (options->follow_window_size) {
+                request_video_size_for_window();
+            }
             break;
-        case SDL_WINDOWEVENT:
+        case SDL_WINDOWEVENT: {
+            bool was_hidden = screen.hidden;
             screen_handle_window_event(&screen, &event->window);
+            // the recording must not be paused
+            if (session.controller_started && !options->record_filename
+                    && screen.hidden != was_hidden) {
+                set_video_paused(screen.hidden);
+            }
             break;
+        }
         case SDL_TEXTINPUT:
-            if (!options->control) {
+            if (!session.controller_started) {
                 break;
             }
             input_manager_process_text_input(&input_manager, &event->text);
@@ -204,13 +404,13 @@ handle_event(SDL_Event *event, const struct scrcpy_options *options) {
             input_manager_process_key(&input_manager, &event->key);
             break;
         case SDL_MOUSEMOTION:
-            if (!options->control) {
+            if (!session.controller_started) {
                 break;
             }
             input_manager_process_mouse_motion(&input_manager, &event->motion);
             break;
         case SDL_MOUSEWHEEL:
-            if (!options->control) {
+            if (!session.controller_started) {
                 break;
             }
             input_manager_process_mouse_wheel(&input_manager, &event->wheel);
@@ -227,7 +427,7 @@ handle_event(SDL_Event *event, const struct scrcpy_options *options) {
             input_manager_process_touch(&input_manager, &event->tfinger);
             break;
         case SDL_DROPFILE: {
-            if (!options->control) {
+            if (!session.controller_started) {
                 break;
             }
             file_handler_action_t action;
@@ -243,29 +443,6 @@ handle_event(SDL_Event *event, const struct scrcpy_options *options) {
     return EVENT_RESULT_CONTINUE;
 }
 
-static bool
-event_loop(const struct scrcpy_options *options) {
-#ifdef CONTINUOUS_RESIZING_WORKAROUND
-    if (options->display) {
-        SDL_AddEventWatch(event_watcher, NULL);
-    }
-#endif
-    SDL_Event event;
-    while (SDL_WaitEvent(&event)) {
-        enum event_result result = handle_event(&event, options);
-        switch (result) {
-            case EVENT_RESULT_STOPPED_BY_USER:
-                return true;
-            case EVENT_RESULT_STOPPED_BY_EOS:
-                LOGW("Device disconnected");
-                return false;
-            case EVENT_RESULT_CONTINUE:
-                break;
-        }
-    }
-    return false;
-}
-
 static SDL_LogPriority
 sdl_priority_from_av_level(int level) {
     switch (level) {
@@ -290,22 +467,317 @@ av_log_callback(void *avcl, int level, const char *fmt, va_list vl) {
     if (priority == 0) {
         return;
     }
-    char *local_fmt = SDL_malloc(strlen(fmt) + 10);
-    if (!local_fmt) {
-        LOGC("Could not allocate string");
+    if (priority < SDL_LogGetPriority(SDL_LOG_CATEGORY_VIDEO)) {
+        // do not even format the message
+        return;
+    }
+    // format on the stack (the message is copied by the logger anyway)
+    char msg[ASYNC_LOG_MESSAGE_SIZE];
+    vsnprintf(msg, sizeof(msg), fmt, vl);
+    // FFmpeg terminates its lines by '\n', the logger adds its own
+    size_t len = strlen(msg);
+    if (len && msg[len - 1] == '\n') {
+        msg[len - 1] = '\0';
+    }
+    SDL_LogMessage(SDL_LOG_CATEGORY_VIDEO, priority, "[FFmpeg] %s", msg);
+}
+
+// Startup is split into two branches running in parallel:
+//  - the "server" branch (in a separate thread): push the server, enable the
+//    tunnel, execute the server, connect to it and read the device info;
+//  - the "local" branch (in the main thread, as required by SDL): initialize
+//    SDL, create the window and the renderer.
+// Both are joined before starting the stream, which needs the device info.
+struct server_startup {
+    const char *serial;
+    const struct server_params *params;
+    bool started; // server_start() succeeded
+    bool connected; // connected and device info read
+    char device_name[DEVICE_NAME_FIELD_LENGTH];
+    struct size frame_size;
+    uint32_t duration; // ms
+};
+
+struct reconnect {
+    unsigned attempts; // for the current disconnection
+    uint32_t disconnected_at;
+    SDL_Thread *thread; // running run_reconnect(), NULL if none
+    struct server_startup startup;
+};
+
+static struct reconnect reconnect = {
+    .attempts = 0,
+    .thread = NULL,
+};
+
+static int
+run_server_startup(void *data) {
+    struct server_startup *startup = data;
+    uint32_t start = SDL_GetTicks();
+
+    startup->started = server_start(&server, startup->serial,
+                                    startup->params);
+    if (startup->started && server_connect_to(&server)) {
+        // screenrecord does not send frames when the screen content does not
+        // change therefore, we transmit the screen size before the video
+        // stream, to be able to init the window immediately
+        uint32_t read_start = SDL_GetTicks();
+        startup->connected = device_read_info(server.video_socket,
+                                              startup->device_name,
+                                              &startup->frame_size);
+        startup_timeline_add(startup->params->timeline, "device_read_info",
+                             read_start, SDL_GetTicks());
+    }
+
+    startup->duration = SDL_GetTicks() - start;
+    return 0;
+}
+
+static bool
+init_local(const struct scrcpy_options *options) {
+    uint32_t start = SDL_GetTicks();
+    bool ok = sdl_init_and_configure(options->display, options->render_driver,
+                                     options->disable_screensaver);
+    startup_timeline_add(timeline, "sdl_init_and_configure", start,
+                         SDL_GetTicks());
+    if (!ok || !options->display) {
+        return ok;
+    }
+
+    start = SDL_GetTicks();
+    ok = screen_init_window(&screen, options->always_on_top,
+                            options->window_borderless, options->mipmaps);
+    startup_timeline_add(timeline, "screen_init_window", start,
+                         SDL_GetTicks());
+    return ok;
+}
+
+// start the stream and the controller on the sockets of the connected server
+static bool
+start_session(const struct scrcpy_options *options, struct decoder *dec,
+              struct recorder *rec) {
+    bool probes = options->display && options->control;
+    stream_init(&stream, server.video_socket, dec, rec,
+                probes ? &frame_latency : NULL);
+
+    // now we consumed the header values, the socket receives the video stream
+    // start the stream
+    if (!stream_start(&stream)) {
+        return false;
+    }
+    session.stream_started = true;
+
+    if (options->display && options->control) {
+        // the reports of the new device encoder start from 0
+        encoder_stats_reset(&encoder_stats);
+
+        enum control_msg_encoding encoding = options->legacy_control
+                                           ? CONTROL_MSG_ENCODING_LEGACY
+                                           : CONTROL_MSG_ENCODING_COMPACT;
+        if (!controller_init(&controller, server.control_socket, encoding,
+                             &rtt_stats, &clock_sync, &encoder_stats)) {
+            return false;
+        }
+        session.controller_initialized = true;
+
+        if (!controller_start(&controller)) {
+            return false;
+        }
+        session.controller_started = true;
+
+        if (automation) {
+            automation_set_controller(automation, &controller);
+        }
+    }
+
+    return true;
+}
+
+// the device state is not kept by a new server, request it again
+static void
+configure_device(const struct scrcpy_options *options) {
+    if (!session.controller_started) {
         return;
     }
-    // strcpy is safe here, the destination is large enough
-    strcpy(local_fmt, "[FFmpeg] ");
-    strcpy(local_fmt + 9, fmt);
-    SDL_LogMessageV(SDL_LOG_CATEGORY_VIDEO, priority, local_fmt, vl);
-    SDL_free(local_fmt);
+
+    if (options->turn_screen_off) {
+        struct control_msg msg;
+        msg.type = CONTROL_MSG_TYPE_SET_SCREEN_POWER_MODE;
+        msg.set_screen_power_mode.mode = SCREEN_POWER_MODE_OFF;
+
+        if (!controller_push_msg(&controller, &msg)) {
+            LOGW("Could not request 'set screen power mode'");
+        }
+    }
+
+    if (requested_max_size) {
+        request_video_size(requested_max_size);
+    }
+
+    if (screen.hidden && !options->record_filename) {
+        set_video_paused(true);
+    }
+}
+
+// stop the session after the end of the stream (the stream thread has already
+// terminated), keeping the window, the decoder and the recorder
+static void
+stop_session(void) {
+    input_manager.control = false;
+    if (automation) {
+        automation_set_controller(automation, NULL);
+    }
+    if (session.controller_started) {
+        controller_stop(&controller);
+    }
+    if (session.server_started) {
+        server_stop(&server);
+    }
+    if (session.stream_started) {
+        stream_join(&stream);
+    }
+    if (session.controller_started) {
+        controller_join(&controller);
+    }
+    if (session.controller_initialized) {
+        controller_destroy(&controller);
+    }
+    if (session.server_started) {
+        server_destroy(&server);
+    }
+    session = (struct session) SESSION_INITIALIZER;
+}
+
+static int
+run_reconnect(void *data) {
+    struct server_startup *startup = data;
+    if (reconnect.attempts > 1) {
+        SDL_Delay(RECONNECT_DELAY_MS);
+    }
+    run_server_startup(startup);
+
+    SDL_Event event;
+    event.type = EVENT_RECONNECT_DONE;
+    SDL_PushEvent(&event);
+    return 0;
+}
+
+static bool
+start_reconnect(const struct scrcpy_options *options) {
+    ++reconnect.attempts;
+    LOGI("Reconnecting (attempt %u/%" PRIu16 ")...", reconnect.attempts,
+         options->reconnect_retries);
+
+    server_init(&server);
+    reconnect.startup = (struct server_startup) {
+        .serial = options->serial,
+        .params = &server_params,
+        .started = false,
+        .connected = false,
+    };
+    reconnect.thread =
+        SDL_CreateThread(run_reconnect, "reconnect", &reconnect.startup);
+    if (!reconnect.thread) {
+        LOGC("Could not start reconnect thread");
+        return false;
+    }
+    return true;
+}
+
+// called on the end of the video stream
+static bool
+handle_disconnection(const struct scrcpy_options *options) {
+    if (reconnect.attempts >= options->reconnect_retries) {
+        return false;
+    }
+
+    stop_session();
+    reconnect.disconnected_at = SDL_GetTicks();
+    // only the initial startup is measured
+    server_params.timeline = NULL;
+    return start_reconnect(options);
+}
+
+// called once the reconnect thread has terminated
+static bool
+handle_reconnect_done(const struct scrcpy_options *options) {
+    SDL_WaitThread(reconnect.thread, NULL);
+    reconnect.thread = NULL;
+    session.server_started = reconnect.startup.started;
+
+    if (!reconnect.startup.connected) {
+        if (session.server_started) {
+            server_stop(&server);
+            server_destroy(&server);
+            session.server_started = false;
+        }
+        if (reconnect.attempts >= options->reconnect_retries) {
+            LOGE("Could not reconnect after %u attempts", reconnect.attempts);
+            return false;
+        }
+        return start_reconnect(options);
+    }
+
+    struct recorder *rec = stream.recorder;
+    if (rec && !recorder_next_segment(rec, reconnect.startup.frame_size)) {
+        return false;
+    }
+
+    if (!start_session(options, stream.decoder, rec)) {
+        return false;
+    }
+
+    input_manager.control = options->control;
+    configure_device(options);
+
+    LOGI("Reconnected after %" PRIu32 " ms of downtime (%u attempts)",
+         SDL_GetTicks() - reconnect.disconnected_at, reconnect.attempts);
+    reconnect.attempts = 0;
+    return true;
+}
+
+static bool
+event_loop(const struct scrcpy_options *options) {
+#ifdef CONTINUOUS_RESIZING_WORKAROUND
+    if (options->display) {
+        SDL_AddEventWatch(event_watcher, NULL);
+    }
+#endif
+    SDL_Event event;
+    while (SDL_WaitEvent(&event)) {
+        enum event_result result = handle_event(&event, options);
+        switch (result) {
+            case EVENT_RESULT_STOPPED_BY_USER:
+                return true;
+            case EVENT_RESULT_STOPPED_BY_EOS:
+                LOGW("Device disconnected");
+                if (!handle_disconnection(options)) {
+                    return false;
+                }
+                break;
+            case EVENT_RESULT_RECONNECT_DONE:
+                if (!handle_reconnect_done(options)) {
+                    return false;
+                }
+                break;
+            case EVENT_RESULT_CONTINUE:
+                break;
+        }
+    }
+    return false;
 }
 
 bool
 scrcpy(const struct scrcpy_options *options) {
+    if (options->startup_timeline_filename) {
+        if (!startup_timeline_init(&startup_timeline, SDL_GetTicks())) {
+            return false;
+        }
+        timeline = &startup_timeline;
+    }
+
     bool record = !!options->record_filename;
-    struct server_params params = {
+    server_params = (struct server_params) {
         .log_level = options->log_level,
         .crop = options->crop,
         .port_range = options->port_range,
@@ -319,43 +791,105 @@ scrcpy(const struct scrcpy_options *options) {
         .stay_awake = options->stay_awake,
         .codec_options = options->codec_options,
         .force_adb_forward = options->force_adb_forward,
+        .direct_tcp = options->direct_tcp,
+        .direct_tcp_addr = options->direct_tcp_addr,
+        .direct_tcp_port = options->direct_tcp_port,
+        .direct_tcp_all_interfaces = options->direct_tcp_all_interfaces,
+        .busy_poll_us = options->busy_poll_us,
+        .persistent_timeout = options->persistent_server_timeout,
+        .legacy_control = options->legacy_control,
+        .timeline = timeline,
+    };
+
+    struct server_startup startup = {
+        .serial = options->serial,
+        .params = &server_params,
+        .started = false,
+        .connected = false,
     };
-    if (!server_start(&server, options->serial, &params)) {
+    SDL_Thread *startup_thread =
+        SDL_CreateThread(run_server_startup, "server-startup", &startup);
+    if (!startup_thread) {
+        LOGC("Could not start server startup thread");
+        if (timeline) {
+            startup_timeline_destroy(timeline);
+        }
         return false;
     }
 
     bool ret = false;
 
+    if (options->trace_filename) {
+        trace_init();
+        trace_set_thread_name("main");
+#ifndef _WIN32
+        signal(SIGUSR1, sigusr1_handler);
+        trace_timer = SDL_AddTimer(TRACE_REQUEST_POLL_MS, trace_request_timer,
+                                   NULL);
+        if (!trace_timer) {
+            LOGW("Could not add timer: %s", SDL_GetError());
+        }
+#endif
+    }
+
+    bool rtt_stats_initialized = false;
+    bool clock_sync_initialized = false;
+    bool frame_latency_initialized = false;
+    bool encoder_stats_initialized = false;
     bool fps_counter_initialized = false;
     bool video_buffer_initialized = false;
     bool file_handler_initialized = false;
     bool recorder_initialized = false;
-    bool stream_started = false;
-    bool controller_initialized = false;
-    bool controller_started = false;
+    bool automation_started = false;
+    bool metrics_server_initialized = false;
+    bool metrics_server_started = false;
 
-    if (!sdl_init_and_configure(options->display, options->render_driver,
-                                options->disable_screensaver)) {
-        goto end;
-    }
+    uint32_t local_start = SDL_GetTicks();
+    bool local_ok = init_local(options);
+    uint32_t local_duration = SDL_GetTicks() - local_start;
 
-    if (!server_connect_to(&server)) {
-        goto end;
-    }
+    SDL_WaitThread(startup_thread, NULL);
+    session.server_started = startup.started;
 
-    char device_name[DEVICE_NAME_FIELD_LENGTH];
-    struct size frame_size;
+    LOGD("Startup: server %" PRIu32 " ms, local %" PRIu32 " ms in parallel "
+         "(critical path: %s)", startup.duration, local_duration,
+         startup.duration >= local_duration ? "server" : "local");
 
-    // screenrecord does not send frames when the screen content does not
-    // change therefore, we transmit the screen size before the video stream,
-    // to be able to init the window immediately
-    if (!device_read_info(server.video_socket, device_name, &frame_size)) {
+    if (!local_ok || !startup.connected) {
         goto end;
     }
 
+    const char *device_name = startup.device_name;
+    struct size frame_size = startup.frame_size;
+
     struct decoder *dec = NULL;
     if (options->display) {
-        if (!fps_counter_init(&fps_counter)) {
+        if (options->control) {
+            if (!rtt_stats_init(&rtt_stats, options->rtt_warning)) {
+                goto end;
+            }
+            rtt_stats_initialized = true;
+
+            if (!clock_sync_init(&clock_sync)) {
+                goto end;
+            }
+            clock_sync_initialized = true;
+
+            if (!frame_latency_init(&frame_latency, &clock_sync)) {
+                goto end;
+            }
+            frame_latency_initialized = true;
+
+            if (!encoder_stats_init(&encoder_stats)) {
+                goto end;
+            }
+            encoder_stats_initialized = true;
+        }
+
+        if (!fps_counter_init(&fps_counter,
+                              options->control ? &rtt_stats : NULL,
+                              options->control ? &frame_latency : NULL,
+                              options->control ? &encoder_stats : NULL)) {
             goto end;
         }
         fps_counter_initialized = true;
@@ -368,14 +902,26 @@ scrcpy(const struct scrcpy_options *options) {
 
         if (options->control) {
             if (!file_handler_init(&file_handler, server.serial,
-                                   options->push_target)) {
+                                   options->push_target,
+                                   options->push_workers)) {
                 goto end;
             }
             file_handler_initialized = true;
         }
 
-        decoder_init(&decoder, &video_buffer);
+        decoder_init(&decoder, &video_buffer,
+                     options->control ? &frame_latency : NULL);
         dec = &decoder;
+
+        if (options->automation_socket) {
+            // automation requires control (checked by the CLI parser)
+            if (!automation_init(&automation_server,
+                                 options->automation_socket, &video_buffer,
+                                 &rtt_stats)) {
+                goto end;
+            }
+            automation = &automation_server;
+        }
     }
 
     struct recorder *rec = NULL;
@@ -390,52 +936,47 @@ scrcpy(const struct scrcpy_options *options) {
         recorder_initialized = true;
     }
 
-    av_log_set_callback(av_log_callback);
+    if (options->metrics_port) {
+        if (!metrics_server_init(&metrics_server, options->metrics_port,
+                                 options->metrics_all_interfaces)) {
+            goto end;
+        }
+        metrics_server_initialized = true;
+
+        if (!metrics_server_start(&metrics_server)) {
+            goto end;
+        }
+        metrics_server_started = true;
+    }
 
-    stream_init(&stream, server.video_socket, dec, rec);
+    av_log_set_callback(av_log_callback);
 
-    // now we consumed the header values, the socket receives the video stream
-    // start the stream
-    if (!stream_start(&stream)) {
+    if (!start_session(options, dec, rec)) {
         goto end;
     }
-    stream_started = true;
 
     if (options->display) {
-        if (options->control) {
-            if (!controller_init(&controller, server.control_socket)) {
-                goto end;
-            }
-            controller_initialized = true;
-
-            if (!controller_start(&controller)) {
-                goto end;
-            }
-            controller_started = true;
-        }
-
         const char *window_title =
             options->window_title ? options->window_title : device_name;
 
-        if (!screen_init_rendering(&screen, window_title, frame_size,
-                                   options->always_on_top, options->window_x,
-                                   options->window_y, options->window_width,
-                                   options->window_height,
-                                   options->window_borderless,
-                                   options->rotation, options-> mipmaps)) {
+        uint32_t start = SDL_GetTicks();
+        bool ok = screen_init_rendering(&screen, window_title, frame_size,
+                                        options->window_x, options->window_y,
+                                        options->window_width,
+                                        options->window_height,
+                                        options->rotation);
+        startup_timeline_add(timeline, "screen_init_rendering", start,
+                             SDL_GetTicks());
+        if (!ok) {
             goto end;
         }
 
-        if (options->turn_screen_off) {
-            struct control_msg msg;
-            msg.type = CONTROL_MSG_TYPE_SET_SCREEN_POWER_MODE;
-            msg.set_screen_power_mode.mode = SCREEN_POWER_MODE_OFF;
-
-            if (!controller_push_msg(&controller, &msg)) {
-                LOGW("Could not request 'set screen power mode'");
-            }
+        if (options->follow_window_size) {
+            screen_enable_follow_window_size(&screen, options->max_size);
         }
 
+        configure_device(options);
+
         if (options->fullscreen) {
             screen_switch_fullscreen(&screen);
         }
@@ -443,18 +984,50 @@ scrcpy(const struct scrcpy_options *options) {
 
     input_manager_init(&input_manager, options);
 
+    if (automation) {
+        if (!automation_start(automation)) {
+            goto end;
+        }
+        automation_started = true;
+    }
+
     ret = event_loop(options);
     LOGD("quit...");
 
+end:
+    // the window may have been created even if the startup failed
     screen_destroy(&screen);
 
-end:
+    if (reconnect.thread) {
+        // the user quit while reconnecting
+        SDL_WaitThread(reconnect.thread, NULL);
+        session.server_started = reconnect.startup.started;
+    }
+
+    // stop the automation thread first, it pushes to the controller
+    if (automation_started) {
+        automation_stop(automation);
+        automation_join(automation);
+    }
+    if (automation) {
+        automation_destroy(automation);
+        automation = NULL;
+    }
+
+    if (metrics_server_started) {
+        metrics_server_stop(&metrics_server);
+        metrics_server_join(&metrics_server);
+    }
+    if (metrics_server_initialized) {
+        metrics_server_destroy(&metrics_server);
+    }
+
     // stop stream and controller so that they don't continue once their socket
     // is shutdown
-    if (stream_started) {
+    if (session.stream_started) {
         stream_stop(&stream);
     }
-    if (controller_started) {
+    if (session.controller_started) {
         controller_stop(&controller);
     }
     if (file_handler_initialized) {
@@ -465,17 +1038,19 @@ end:
     }
 
     // shutdown the sockets and kill the server
-    server_stop(&server);
+    if (session.server_started) {
+        server_stop(&server);
+    }
 
     // now that the sockets are shutdown, the stream and controller are
     // interrupted, we can join them
-    if (stream_started) {
+    if (session.stream_started) {
         stream_join(&stream);
     }
-    if (controller_started) {
+    if (session.controller_started) {
         controller_join(&controller);
     }
-    if (controller_initialized) {
+    if (session.controller_initialized) {
         controller_destroy(&controller);
     }
 
@@ -497,7 +1072,41 @@ end:
         fps_counter_destroy(&fps_counter);
     }
 
-    server_destroy(&server);
+    if (encoder_stats_initialized) {
+        encoder_stats_destroy(&encoder_stats);
+    }
+
+    if (frame_latency_initialized) {
+        frame_latency_destroy(&frame_latency);
+    }
+
+    if (clock_sync_initialized) {
+        clock_sync_destroy(&clock_sync);
+    }
+
+    if (rtt_stats_initialized) {
+        rtt_stats_destroy(&rtt_stats);
+    }
+
+    if (session.server_started) {
+        server_destroy(&server);
+    }
+
+    if (options->trace_filename) {
+#ifndef _WIN32
+        signal(SIGUSR1, SIG_DFL);
+        if (trace_timer) {
+            SDL_RemoveTimer(trace_timer);
+        }
+#endif
+        // all the traced threads are joined
+        trace_write(options->trace_filename);
+        trace_destroy();
+    }
+
+    if (timeline) {
+        startup_timeline_destroy(timeline);
+    }
 
     return ret;
 }
@@ -51,6 +51,9 @@ struct scrcpy_options {
     const char *push_target;
     const char *render_driver;
     const char *codec_options;
+    const char *automation_socket;
+    const char *trace_filename;
+    const char *startup_timeline_filename;
     enum sc_log_level log_level;
     enum sc_record_format record_format;
     struct sc_port_range port_range;
@@ -65,6 +68,16 @@ struct scrcpy_options {
     uint16_t window_width;
     uint16_t window_height;
     uint16_t display_id;
+    uint32_t direct_tcp_addr; // IPv4, host byte order
+    uint16_t direct_tcp_port;
+    uint32_t busy_poll_us;
+    uint32_t persistent_server_timeout; // in seconds, 0 to disable
+    uint16_t reconnect_retries; // 0 to exit on disconnection
+    uint32_t rtt_warning; // in ms, 0 to disable
+    uint16_t metrics_port; // 0 to disable
+    // serve the metrics on all the network interfaces, not only localhost
+    bool metrics_all_interfaces;
+    uint8_t push_workers;
     bool show_touches;
     bool fullscreen;
     bool always_on_top;
@@ -79,6 +92,10 @@ struct scrcpy_options {
     bool force_adb_forward;
     bool disable_screensaver;
     bool forward_key_repeat;
+    bool follow_window_size;
+    bool direct_tcp;
+    bool direct_tcp_all_interfaces;
+    bool legacy_control;
 };
 
 #define SCRCPY_OPTIONS_DEFAULT { \
@@ -89,6 +106,9 @@ struct scrcpy_options {
     .push_target = NULL, \
     .render_driver = NULL, \
     .codec_options = NULL, \
+    .automation_socket = NULL, \
+    .trace_filename = NULL, \
+    .startup_timeline_filename = NULL, \
     .log_level = SC_LOG_LEVEL_INFO, \
     .record_format = SC_RECORD_FORMAT_AUTO, \
     .port_range = { \
@@ -109,6 +129,15 @@ struct scrcpy_options {
     .window_width = 0, \
     .window_height = 0, \
     .display_id = 0, \
+    .direct_tcp_addr = 0, \
+    .direct_tcp_port = DEFAULT_LOCAL_PORT_RANGE_FIRST, \
+    .busy_poll_us = 0, \
+    .persistent_server_timeout = 0, \
+    .reconnect_retries = 0, \
+    .rtt_warning = 0, \
+    .metrics_port = 0, \
+    .metrics_all_interfaces = false, \
+    .push_workers = 2, \
     .show_touches = false, \
     .fullscreen = false, \
     .always_on_top = false, \
@@ -123,6 +152,10 @@ struct scrcpy_options {
     .force_adb_forward = false, \
     .disable_screensaver = false, \
     .forward_key_repeat = true, \
+    .follow_window_size = false, \
+    .direct_tcp = false, \
+    .direct_tcp_all_interfaces = false, \
+    .legacy_control = false, \
 }
 
 bool
@@ -7,15 +7,25 @@
 #include "config.h"
 #include "common.h"
 #include "compat.h"
+#include "events.h"
 #include "icon.xpm"
 #include "scrcpy.h"
 #include "tiny_xpm.h"
+#include "trace.h"
 #include "video_buffer.h"
 #include "util/lock.h"
 #include "util/log.h"
 
 #define DISPLAY_MARGINS 96
 
+// delay after the last window resize before requesting a new video size
+#define FOLLOW_WINDOW_SIZE_DELAY_MS 500
+
+// the initial window size, before the frame size is known (the window is
+// hidden until then)
+#define PLACEHOLDER_WINDOW_WIDTH 640
+#define PLACEHOLDER_WINDOW_HEIGHT 480
+
 static inline struct size
 get_rotated_size(struct size size, int rotation) {
     struct size rotated_size;
@@ -159,13 +169,18 @@ get_initial_optimal_size(struct size content_size, uint16_t req_width,
 
 static void
 screen_update_content_rect(struct screen *screen) {
+    int ww;
+    int wh;
     int dw;
     int dh;
+    SDL_GetWindowSize(screen->window, &ww, &wh);
     SDL_GL_GetDrawableSize(screen->window, &dw, &dh);
 
     struct size content_size = screen->content_size;
     // The drawable size is the window size * the HiDPI scale
     struct size drawable_size = {dw, dh};
+    screen->window_size = (struct size) {ww, wh};
+    screen->drawable_size = drawable_size;
 
     SDL_Rect *rect = &screen->rect;
 
@@ -227,21 +242,8 @@ create_texture(struct screen *screen) {
 }
 
 bool
-screen_init_rendering(struct screen *screen, const char *window_title,
-                      struct size frame_size, bool always_on_top,
-                      int16_t window_x, int16_t window_y, uint16_t window_width,
-                      uint16_t window_height, bool window_borderless,
-                      uint8_t rotation, bool mipmaps) {
-    screen->frame_size = frame_size;
-    screen->rotation = rotation;
-    if (rotation) {
-        LOGI("Initial display rotation set to %u", rotation);
-    }
-    struct size content_size = get_rotated_size(frame_size, screen->rotation);
-    screen->content_size = content_size;
-
-    struct size window_size =
-        get_initial_optimal_size(content_size, window_width, window_height);
+screen_init_window(struct screen *screen, bool always_on_top,
+                   bool window_borderless, bool mipmaps) {
     uint32_t window_flags = SDL_WINDOW_HIDDEN | SDL_WINDOW_RESIZABLE;
 #ifdef HIDPI_SUPPORT
     window_flags |= SDL_WINDOW_ALLOW_HIGHDPI;
@@ -258,13 +260,12 @@ screen_init_rendering(struct screen *screen, const char *window_title,
         window_flags |= SDL_WINDOW_BORDERLESS;
     }
 
-    int x = window_x != SC_WINDOW_POSITION_UNDEFINED
-          ? window_x : (int) SDL_WINDOWPOS_UNDEFINED;
-    int y = window_y != SC_WINDOW_POSITION_UNDEFINED
-          ? window_y : (int) SDL_WINDOWPOS_UNDEFINED;
-    screen->window = SDL_CreateWindow(window_title, x, y,
-                                      window_size.width, window_size.height,
-                                      window_flags);
+    // the frame size is not known yet, the window will be resized and
+    // positioned by screen_init_rendering() before being shown
+    screen->window = SDL_CreateWindow("scrcpy", SDL_WINDOWPOS_UNDEFINED,
+                                      SDL_WINDOWPOS_UNDEFINED,
+                                      PLACEHOLDER_WINDOW_WIDTH,
+                                      PLACEHOLDER_WINDOW_HEIGHT, window_flags);
     if (!screen->window) {
         LOGC("Could not create window: %s", SDL_GetError());
         return false;
@@ -309,6 +310,11 @@ screen_init_rendering(struct screen *screen, const char *window_title,
         LOGD("Trilinear filtering disabled (not an OpenGL renderer)");
     }
 
+    if (!hud_init(&screen->hud, screen->renderer)) {
+        // not fatal, the HUD is just not available
+        LOGW("Could not create the HUD font: %s", SDL_GetError());
+    }
+
     SDL_Surface *icon = read_xpm(icon_xpm);
     if (icon) {
         SDL_SetWindowIcon(screen->window, icon);
@@ -317,20 +323,47 @@ screen_init_rendering(struct screen *screen, const char *window_title,
         LOGW("Could not load icon");
     }
 
+    return true;
+}
+
+bool
+screen_init_rendering(struct screen *screen, const char *window_title,
+                      struct size frame_size, int16_t window_x,
+                      int16_t window_y, uint16_t window_width,
+                      uint16_t window_height, uint8_t rotation) {
+    screen->frame_size = frame_size;
+    screen->rotation = rotation;
+    if (rotation) {
+        LOGI("Initial display rotation set to %u", rotation);
+    }
+    struct size content_size = get_rotated_size(frame_size, screen->rotation);
+    screen->content_size = content_size;
+
+    SDL_SetWindowTitle(screen->window, window_title);
+
     LOGI("Initial texture: %" PRIu16 "x%" PRIu16, frame_size.width,
                                                   frame_size.height);
     screen->texture = create_texture(screen);
     if (!screen->texture) {
         LOGC("Could not create texture: %s", SDL_GetError());
-        screen_destroy(screen);
         return false;
     }
 
-    // Reset the window size to trigger a SIZE_CHANGED event, to workaround
-    // HiDPI issues with some SDL renderers when several displays having
-    // different HiDPI scaling are connected
+    // Setting the window size also triggers a SIZE_CHANGED event, to
+    // workaround HiDPI issues with some SDL renderers when several displays
+    // having different HiDPI scaling are connected
+    struct size window_size =
+        get_initial_optimal_size(content_size, window_width, window_height);
     SDL_SetWindowSize(screen->window, window_size.width, window_size.height);
 
+    // like SDL_CreateWindow() does, center the window if its position is
+    // undefined
+    int x = window_x != SC_WINDOW_POSITION_UNDEFINED
+          ? window_x : (int) SDL_WINDOWPOS_CENTERED;
+    int y = window_y != SC_WINDOW_POSITION_UNDEFINED
+          ? window_y : (int) SDL_WINDOWPOS_CENTERED;
+    SDL_SetWindowPosition(screen->window, x, y);
+
     screen_update_content_rect(screen);
 
     return true;
@@ -343,6 +376,10 @@ screen_show_window(struct screen *screen) {
 
 void
 screen_destroy(struct screen *screen) {
+    if (screen->follow.timer) {
+        SDL_RemoveTimer(screen->follow.timer);
+    }
+    hud_destroy(&screen->hud);
     if (screen->texture) {
         SDL_DestroyTexture(screen->texture);
     }
@@ -411,6 +448,16 @@ screen_set_rotation(struct screen *screen, unsigned rotation) {
     screen_render(screen, true);
 }
 
+// the sizes are considered to have the same aspect ratio if they differ by
+// less than 2% (the device rounds the video dimensions to multiples of 8)
+static bool
+is_same_aspect_ratio(struct size a, struct size b) {
+    int64_t lhs = (int64_t) a.width * b.height;
+    int64_t rhs = (int64_t) b.width * a.height;
+    int64_t diff = lhs > rhs ? lhs - rhs : rhs - lhs;
+    return diff * 50 <= lhs;
+}
+
 // recreate the texture and resize the window if the frame size has changed
 static bool
 prepare_for_frame(struct screen *screen, struct size new_frame_size) {
@@ -423,7 +470,15 @@ prepare_for_frame(struct screen *screen, struct size new_frame_size) {
 
         struct size new_content_size =
             get_rotated_size(new_frame_size, screen->rotation);
-        set_content_size(screen, new_content_size);
+        if (screen->follow.enabled && !screen->resize_pending
+                && is_same_aspect_ratio(screen->content_size,
+                                        new_content_size)) {
+            // The video size has been adapted to the window size, so the
+            // window must not be resized (it would cause a feedback loop)
+            screen->content_size = new_content_size;
+        } else {
+            set_content_size(screen, new_content_size);
+        }
 
         screen_update_content_rect(screen);
 
@@ -464,7 +519,9 @@ screen_update_frame(struct screen *screen, struct video_buffer *vb) {
         mutex_unlock(vb->mutex);
         return false;
     }
+    uint64_t trace_start = trace_begin();
     update_texture(screen, frame);
+    trace_end("upload", trace_start);
     mutex_unlock(vb->mutex);
 
     screen_render(screen, false);
@@ -502,7 +559,11 @@ screen_render(struct screen *screen, bool update_content_rect) {
         SDL_RenderCopyEx(screen->renderer, screen->texture, NULL, dstrect,
                          angle, NULL, 0);
     }
+    hud_render(&screen->hud, screen->drawable_size);
+
+    uint64_t trace_start = trace_begin();
     SDL_RenderPresent(screen->renderer);
+    trace_end("present", trace_start);
 }
 
 void
@@ -522,6 +583,12 @@ screen_switch_fullscreen(struct screen *screen) {
     screen_render(screen, true);
 }
 
+void
+screen_switch_hud(struct screen *screen) {
+    hud_switch(&screen->hud);
+    screen_render(screen, false);
+}
+
 void
 screen_resize_to_fit(struct screen *screen) {
     if (screen->fullscreen || screen->maximized) {
@@ -552,20 +619,105 @@ screen_resize_to_pixel_perfect(struct screen *screen) {
                                             content_size.height);
 }
 
+void
+screen_enable_follow_window_size(struct screen *screen,
+                                 uint16_t max_size_limit) {
+    screen->follow.enabled = true;
+    screen->follow.max_size_limit = max_size_limit;
+    screen->follow.requested_max_size = MAX(screen->frame_size.width,
+                                            screen->frame_size.height);
+}
+
+bool
+screen_follow_window_size(struct screen *screen, uint16_t *max_size) {
+    if (!screen->follow.enabled || !screen->follow.pending) {
+        return false;
+    }
+
+    uint32_t now = SDL_GetTicks();
+    if (now - screen->follow.resize_time < FOLLOW_WINDOW_SIZE_DELAY_MS) {
+        // the window is still being resized
+        return false;
+    }
+    screen->follow.pending = false;
+
+    // the displayed size, in pixels (rect is expressed in drawable
+    // coordinates, so it includes the HiDPI scale)
+    uint32_t target = MAX(screen->rect.w, screen->rect.h);
+    // round up to a multiple of 8, as required by the encoder
+    target = (target + 7) & ~7u;
+    uint16_t limit = screen->follow.max_size_limit;
+    if (limit && target > limit) {
+        target = limit;
+    } else if (target > 0xFFF8) {
+        target = 0xFFF8;
+    }
+
+    // Hysteresis: request a bigger video as soon as it is displayed upscaled,
+    // but request a smaller one only if it is significantly downscaled, to
+    // avoid restarting the encoder for small window adjustments
+    uint16_t current = screen->follow.requested_max_size;
+    if (target > current || target < (uint32_t) current * 3 / 4) {
+        LOGD("Following window size: requesting max size %" PRIu32, target);
+        screen->follow.requested_max_size = target;
+        *max_size = target;
+        return true;
+    }
+
+    return false;
+}
+
+// wake up the event loop once the window size is stable (the window may be
+// resized while no frame is received)
+static uint32_t
+follow_window_size_timer(uint32_t interval, void *param) {
+    (void) interval;
+    (void) param;
+    SDL_Event event;
+    event.type = EVENT_FOLLOW_WINDOW_SIZE;
+    SDL_PushEvent(&event);
+    return 0; // do not repeat
+}
+
 void
 screen_handle_window_event(struct screen *screen,
                            const SDL_WindowEvent *event) {
     switch (event->event) {
         case SDL_WINDOWEVENT_EXPOSED:
+            screen->hidden = false;
             screen_render(screen, true);
             break;
+        case SDL_WINDOWEVENT_SHOWN:
+            screen->hidden = false;
+            break;
+        case SDL_WINDOWEVENT_HIDDEN:
+        case SDL_WINDOWEVENT_MINIMIZED:
+            screen->hidden = true;
+            break;
         case SDL_WINDOWEVENT_SIZE_CHANGED:
             screen_render(screen, true);
+            if (screen->follow.enabled) {
+                screen->follow.pending = true;
+                screen->follow.resize_time = SDL_GetTicks();
+                // restart the delay (slightly longer, so that it is elapsed
+                // according to SDL_GetTicks() when the timer fires)
+                if (screen->follow.timer) {
+                    SDL_RemoveTimer(screen->follow.timer);
+                }
+                screen->follow.timer =
+                    SDL_AddTimer(FOLLOW_WINDOW_SIZE_DELAY_MS + 10,
+                                 follow_window_size_timer, NULL);
+                if (!screen->follow.timer) {
+                    LOGW("Could not add timer: %s", SDL_GetError());
+                }
+            }
             break;
         case SDL_WINDOWEVENT_MAXIMIZED:
+            screen->hidden = false;
             screen->maximized = true;
             break;
         case SDL_WINDOWEVENT_RESTORED:
+            screen->hidden = false;
             if (screen->fullscreen) {
                 // On Windows, in maximized+fullscreen, disabling fullscreen
                 // mode unexpectedly triggers the "restored" then "maximized"
@@ -626,9 +778,15 @@ screen_convert_window_to_frame_coords(struct screen *screen,
 void
 screen_hidpi_scale_coords(struct screen *screen, int32_t *x, int32_t *y) {
     // take the HiDPI scaling (dw/ww and dh/wh) into account
-    int ww, wh, dw, dh;
-    SDL_GetWindowSize(screen->window, &ww, &wh);
-    SDL_GL_GetDrawableSize(screen->window, &dw, &dh);
+    // the sizes are cached, they are updated on every window size change
+    int32_t ww = screen->window_size.width;
+    int32_t wh = screen->window_size.height;
+    int32_t dw = screen->drawable_size.width;
+    int32_t dh = screen->drawable_size.height;
+    if (!ww || !wh) {
+        // not rendered yet
+        return;
+    }
 
     // scale for HiDPI (64 bits for intermediate multiplications)
     *x = (int64_t) *x * dw / ww;
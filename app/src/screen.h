@@ -7,6 +7,7 @@
 
 #include "config.h"
 #include "common.h"
+#include "hud.h"
 #include "opengl.h"
 
 struct video_buffer;
@@ -29,11 +30,27 @@ struct screen {
     unsigned rotation;
     // rectangle of the content (excluding black borders)
     struct SDL_Rect rect;
+    // window and drawable sizes, updated along with the content rectangle, so
+    // that converting mouse coordinates does not query SDL on every event
+    struct size window_size;
+    struct size drawable_size;
     bool has_frame;
     bool fullscreen;
     bool maximized;
+    bool hidden; // minimized or hidden
     bool no_window;
     bool mipmaps;
+    struct hud hud;
+
+    // request the device to adapt the video size to the window size
+    struct {
+        bool enabled;
+        uint16_t max_size_limit; // 0 for unlimited
+        uint16_t requested_max_size; // the last max size requested
+        bool pending; // window resized, not handled yet
+        uint32_t resize_time; // SDL_GetTicks() of the last window resize
+        SDL_TimerID timer; // posts EVENT_FOLLOW_WINDOW_SIZE after the delay
+    } follow;
 };
 
 #define SCREEN_INITIALIZER { \
@@ -62,25 +79,51 @@ struct screen {
         .w = 0, \
         .h = 0, \
     }, \
+    .window_size = { \
+        .width = 0, \
+        .height = 0, \
+    }, \
+    .drawable_size = { \
+        .width = 0, \
+        .height = 0, \
+    }, \
     .has_frame = false, \
     .fullscreen = false, \
     .maximized = false, \
+    .hidden = false, \
     .no_window = false, \
     .mipmaps = false, \
+    .hud = {0}, \
+    .follow = { \
+        .enabled = false, \
+        .max_size_limit = 0, \
+        .requested_max_size = 0, \
+        .pending = false, \
+        .resize_time = 0, \
+        .timer = 0, \
+    }, \
 }
 
 // initialize default values
 void
 screen_init(struct screen *screen);
 
-// initialize screen, create window, renderer and texture (window is hidden)
+// create the window (hidden) and the renderer
+// the frame size is not needed, so that it may run before the device is
+// connected
+bool
+screen_init_window(struct screen *screen, bool always_on_top,
+                   bool window_borderless, bool mipmaps);
+
+// create the texture, then size and position the window for the frame size
+// (the window stays hidden)
+// must be called after screen_init_window()
 // window_x and window_y accept SC_WINDOW_POSITION_UNDEFINED
 bool
 screen_init_rendering(struct screen *screen, const char *window_title,
-                      struct size frame_size, bool always_on_top,
-                      int16_t window_x, int16_t window_y, uint16_t window_width,
-                      uint16_t window_height, bool window_borderless,
-                      uint8_t rotation, bool mipmaps);
+                      struct size frame_size, int16_t window_x,
+                      int16_t window_y, uint16_t window_width,
+                      uint16_t window_height, uint8_t rotation);
 
 // show the window
 void
@@ -105,6 +148,10 @@ screen_render(struct screen *screen, bool update_content_rect);
 void
 screen_switch_fullscreen(struct screen *screen);
 
+// show or hide the performance HUD
+void
+screen_switch_hud(struct screen *screen);
+
 // resize window to optimal size (remove black borders)
 void
 screen_resize_to_fit(struct screen *screen);
@@ -117,6 +164,19 @@ screen_resize_to_pixel_perfect(struct screen *screen);
 void
 screen_set_rotation(struct screen *screen, unsigned rotation);
 
+// enable the "follow window size" mode (must be called after
+// screen_init_rendering())
+// max_size_limit is the video size requested by the user (0 for unlimited)
+void
+screen_enable_follow_window_size(struct screen *screen,
+                                 uint16_t max_size_limit);
+
+// In "follow window size" mode, once the window size is stable, compute the
+// video max size matching the window size.
+// Return true if a new max size must be requested to the device.
+bool
+screen_follow_window_size(struct screen *screen, uint16_t *max_size);
+
 // react to window events
 void
 screen_handle_window_event(struct screen *screen, const SDL_WindowEvent *event);
@@ -5,21 +5,43 @@
 #include <inttypes.h>
 #include <libgen.h>
 #include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL_rwops.h>
 #include <SDL2/SDL_thread.h>
 #include <SDL2/SDL_timer.h>
 #include <SDL2/SDL_platform.h>
 
 #include "config.h"
+#include "adb_client.h"
 #include "command.h"
+#include "startup_timeline.h"
+#include "util/buffer_util.h"
 #include "util/log.h"
 #include "util/net.h"
 #include "util/str_util.h"
 
 #define SOCKET_NAME "scrcpy"
+// a persistent server listens on its own socket, so that it does not prevent
+// a normal session from listening on SOCKET_NAME
+#define PERSISTENT_SOCKET_NAME "scrcpy-persistent"
 #define SERVER_FILENAME "scrcpy-server"
 
 #define DEFAULT_SERVER_PATH PREFIX "/share/scrcpy/" SERVER_FILENAME
-#define DEVICE_SERVER_PATH "/data/local/tmp/scrcpy-server.jar"
+// the server is stored on the device under a name containing the hash of its
+// content, so that an identical copy may be reused across launches
+#define DEVICE_SERVER_DIR "/data/local/tmp"
+#define DEVICE_SERVER_PATH_FORMAT \
+    DEVICE_SERVER_DIR "/scrcpy-server-%016" PRIx64 ".jar"
+
+#define IPV4_LOCALHOST 0x7F000001
+
+// in forward mode, the client connects to the server until it listens
+#define CONNECT_TIMEOUT_MS 10000
+#define CONNECT_FIRST_DELAY_MS 2
+#define CONNECT_MAX_DELAY_MS 100
+
+// large enough to absorb a burst of video packets (the kernel may cap it)
+#define VIDEO_SOCKET_RECV_BUFFER_SIZE (4 * 1024 * 1024)
 
 static char *
 get_server_path(void) {
@@ -87,9 +109,88 @@ get_server_path(void) {
 #endif
 }
 
+// compute the FNV-1a hash of the file content, to identify the server version
+// (this is not a security measure)
 static bool
-push_server(const char *serial) {
+hash_file(const char *path, uint64_t *hash, uint64_t *size) {
+    SDL_RWops *file = SDL_RWFromFile(path, "rb");
+    if (!file) {
+        LOGE("Could not open %s", path);
+        return false;
+    }
+
+    uint64_t h = 0xcbf29ce484222325;
+    uint64_t total = 0;
+    uint8_t buf[4096];
+    size_t r;
+    while ((r = SDL_RWread(file, buf, 1, sizeof(buf))) > 0) {
+        for (size_t i = 0; i < r; ++i) {
+            h ^= buf[i];
+            h *= 0x100000001b3;
+        }
+        total += r;
+    }
+    SDL_RWclose(file);
+
+    *hash = h;
+    *size = total;
+    return true;
+}
+
+// check whether an identical server is already present on the device
+static bool
+is_server_on_device(const char *serial, const char *device_path,
+                    uint64_t size) {
+    bool exists;
+    uint32_t device_size;
+    enum adb_client_result r =
+        adb_client_stat(serial, device_path, &exists, &device_size);
+    // the file name contains the hash, the size detects a truncated push
+    return r == ADB_CLIENT_SUCCESS && exists && device_size == size;
+}
+
+// a server of another version is removed only if it has not been modified for
+// this delay, since it may have just been pushed by another client of the same
+// device, and not be started yet
+#define STALE_SERVER_MIN_AGE_MINUTES "10"
+
+// remove the servers left by previous versions (ignore failure)
+static void
+remove_stale_servers(const char *serial, const char *device_path) {
+    const char *name = strrchr(device_path, '/') + 1;
+    char exclude[64];
+    snprintf(exclude, sizeof(exclude), "'%s'", name);
+    const char *const cmd[] = {"find", DEVICE_SERVER_DIR, "-maxdepth", "1",
+                               "-name", "'scrcpy-server*.jar'",
+                               "!", "-name", exclude,
+                               "-mmin", "+" STALE_SERVER_MIN_AGE_MINUTES,
+                               "-delete"};
+    socket_t socket;
+    enum adb_client_result r =
+        adb_client_shell(serial, cmd, ARRAY_LEN(cmd), &socket);
+    if (r != ADB_CLIENT_SUCCESS) {
+        return;
+    }
+    char buf[256];
+    // wait for the command to complete
+    while (net_recv(socket, buf, sizeof(buf)) > 0) {
+        // ignore the output
+    }
+    net_close(socket);
+}
+
+// the duration of the last push by this process, to report the time saved by
+// the next launches which skip it (on reconnection)
+static uint32_t last_push_duration;
+static uint64_t total_push_saved;
+
+static bool
+push_server(struct server *server) {
+    uint32_t start = SDL_GetTicks();
+
     char *server_path = get_server_path();
+    startup_timeline_add(server->timeline, "get_server_path", start,
+                         SDL_GetTicks());
     if (!server_path) {
         return false;
     }
@@ -98,31 +199,104 @@ push_server(const char *serial) {
         SDL_free(server_path);
         return false;
     }
-    process_t process = adb_push(serial, server_path, DEVICE_SERVER_PATH);
+
+    uint64_t hash;
+    uint64_t size;
+    if (!hash_file(server_path, &hash, &size)) {
+        SDL_free(server_path);
+        return false;
+    }
+    snprintf(server->device_server_path, sizeof(server->device_server_path),
+             DEVICE_SERVER_PATH_FORMAT, hash);
+    const char *device_path = server->device_server_path;
+
+    if (is_server_on_device(server->serial, device_path, size)) {
+        SDL_free(server_path);
+        uint32_t check_duration = SDL_GetTicks() - start;
+        if (last_push_duration > check_duration) {
+            uint32_t saved = last_push_duration - check_duration;
+            total_push_saved += saved;
+            LOGI("Server already on the device, push skipped (%" PRIu64
+                 " bytes, checked in %" PRIu32 " ms instead of %" PRIu32
+                 " ms for the last push: %" PRIu32 " ms saved, %" PRIu64
+                 " ms in total)", size, check_duration, last_push_duration,
+                 saved, total_push_saved);
+        } else {
+            // the push duration is unknown (not pushed by this process)
+            LOGI("Server already on the device, push of %" PRIu64 " bytes "
+                 "skipped (checked in %" PRIu32 " ms)", size, check_duration);
+        }
+        return true;
+    }
+
+    bool ok;
+    enum adb_client_result r =
+        adb_client_push(server->serial, server_path, device_path);
+    if (r == ADB_CLIENT_SUCCESS) {
+        ok = true;
+    } else {
+        // fallback to the adb executable, which starts the adb server
+        const char *const local[] = {server_path};
+        process_t process = adb_push(server->serial, local, 1, device_path);
+        ok = process_check_success(process, "adb push");
+    }
     SDL_free(server_path);
-    return process_check_success(process, "adb push");
+
+    if (ok) {
+        last_push_duration = SDL_GetTicks() - start;
+        LOGI("Server pushed (%" PRIu64 " bytes) in %" PRIu32 " ms", size,
+             last_push_duration);
+        // only on a push, so that a launch reusing the server costs a single
+        // check
+        remove_stale_servers(server->serial, device_path);
+    }
+    return ok;
 }
 
+// The adb commands are executed through the adb server protocol directly; the
+// adb executable is only used as a fallback if the adb server is unavailable
+// or if the request failed (the adb executable may handle cases this client
+// does not).
+
 static bool
 enable_tunnel_reverse(const char *serial, uint16_t local_port) {
+    enum adb_client_result r =
+        adb_client_reverse(serial, SOCKET_NAME, local_port);
+    if (r == ADB_CLIENT_SUCCESS) {
+        return true;
+    }
     process_t process = adb_reverse(serial, SOCKET_NAME, local_port);
     return process_check_success(process, "adb reverse");
 }
 
 static bool
 disable_tunnel_reverse(const char *serial) {
+    enum adb_client_result r = adb_client_reverse_remove(serial, SOCKET_NAME);
+    if (r == ADB_CLIENT_SUCCESS) {
+        return true;
+    }
     process_t process = adb_reverse_remove(serial, SOCKET_NAME);
     return process_check_success(process, "adb reverse --remove");
 }
 
 static bool
-enable_tunnel_forward(const char *serial, uint16_t local_port) {
-    process_t process = adb_forward(serial, local_port, SOCKET_NAME);
+enable_tunnel_forward(const char *serial, uint16_t local_port,
+                      const char *socket_name) {
+    enum adb_client_result r =
+        adb_client_forward(serial, local_port, socket_name);
+    if (r == ADB_CLIENT_SUCCESS) {
+        return true;
+    }
+    process_t process = adb_forward(serial, local_port, socket_name);
     return process_check_success(process, "adb forward");
 }
 
 static bool
 disable_tunnel_forward(const char *serial, uint16_t local_port) {
+    enum adb_client_result r = adb_client_forward_remove(serial, local_port);
+    if (r == ADB_CLIENT_SUCCESS) {
+        return true;
+    }
     process_t process = adb_forward_remove(serial, local_port);
     return process_check_success(process, "adb forward --remove");
 }
@@ -137,7 +311,6 @@ disable_tunnel(struct server *server) {
 
 static socket_t
 listen_on_port(uint16_t port) {
-#define IPV4_LOCALHOST 0x7F000001
     return net_listen(IPV4_LOCALHOST, port, 1);
 }
 
@@ -191,9 +364,13 @@ static bool
 enable_tunnel_forward_any_port(struct server *server,
                                struct sc_port_range port_range) {
     server->tunnel_forward = true;
+    // attach_to_server() and open_session() connect to the persistent server
+    // through this tunnel
+    const char *socket_name = server->persistent ? PERSISTENT_SOCKET_NAME
+                                                 : SOCKET_NAME;
     uint16_t port = port_range.first;
     for (;;) {
-        if (enable_tunnel_forward(server->serial, port)) {
+        if (enable_tunnel_forward(server->serial, port, socket_name)) {
             // success
             server->local_port = port;
             return true;
@@ -221,7 +398,11 @@ enable_tunnel_any_port(struct server *server, struct sc_port_range port_range,
                        bool force_adb_forward) {
     if (!force_adb_forward) {
         // Attempt to use "adb reverse"
-        if (enable_tunnel_reverse_any_port(server, port_range)) {
+        uint32_t start = SDL_GetTicks();
+        bool ok = enable_tunnel_reverse_any_port(server, port_range);
+        startup_timeline_add(server->timeline, "enable_tunnel_reverse", start,
+                             SDL_GetTicks());
+        if (ok) {
             return true;
         }
 
@@ -231,7 +412,11 @@ enable_tunnel_any_port(struct server *server, struct sc_port_range port_range,
         LOGW("'adb reverse' failed, fallback to 'adb forward'");
     }
 
-    return enable_tunnel_forward_any_port(server, port_range);
+    uint32_t start = SDL_GetTicks();
+    bool ok = enable_tunnel_forward_any_port(server, port_range);
+    startup_timeline_add(server->timeline, "enable_tunnel_forward", start,
+                         SDL_GetTicks());
+    return ok;
 }
 
 static const char *
@@ -251,50 +436,120 @@ log_level_to_server_string(enum sc_log_level level) {
     }
 }
 
-static process_t
-execute_server(struct server *server, const struct server_params *params) {
-    char max_size_string[6];
-    char bit_rate_string[11];
-    char max_fps_string[6];
-    char lock_video_orientation_string[5];
-    char display_id_string[6];
-    sprintf(max_size_string, "%"PRIu16, params->max_size);
-    sprintf(bit_rate_string, "%"PRIu32, params->bit_rate);
-    sprintf(max_fps_string, "%"PRIu16, params->max_fps);
-    sprintf(lock_video_orientation_string, "%"PRIi8, params->lock_video_orientation);
-    sprintf(display_id_string, "%"PRIu16, params->display_id);
-    const char *const cmd[] = {
-        "shell",
-        "CLASSPATH=" DEVICE_SERVER_PATH,
-        "app_process",
-#ifdef SERVER_DEBUGGER
-# define SERVER_DEBUGGER_PORT "5005"
-# ifdef SERVER_DEBUGGER_METHOD_NEW
-        /* Android 9 and above */
-        "-XjdwpProvider:internal -XjdwpOptions:transport=dt_socket,suspend=y,server=y,address="
-# else
-        /* Android 8 and below */
-        "-agentlib:jdwp=transport=dt_socket,suspend=y,server=y,address="
-# endif
-            SERVER_DEBUGGER_PORT,
-#endif
-        "/", // unused
-        "com.genymobile.scrcpy.Server",
+#define SERVER_ARGS_COUNT 18
+
+// the arguments of com.genymobile.scrcpy.Server
+struct server_args {
+    char max_size[6];
+    char bit_rate[11];
+    char max_fps[6];
+    char lock_video_orientation[5];
+    char display_id[6];
+    char tcp_port[6];
+    char idle_timeout[11];
+    const char *argv[SERVER_ARGS_COUNT];
+};
+
+static void
+build_server_args(struct server_args *args, const struct server *server,
+                  const struct server_params *params) {
+    sprintf(args->max_size, "%"PRIu16, params->max_size);
+    sprintf(args->bit_rate, "%"PRIu32, params->bit_rate);
+    sprintf(args->max_fps, "%"PRIu16, params->max_fps);
+    sprintf(args->lock_video_orientation, "%"PRIi8,
+            params->lock_video_orientation);
+    sprintf(args->display_id, "%"PRIu16, params->display_id);
+    // 0 means that the connection goes through an adb tunnel
+    sprintf(args->tcp_port, "%"PRIu16,
+            server->direct_tcp ? server->direct_tcp_port : 0);
+    // 0 means that the server is not persistent
+    sprintf(args->idle_timeout, "%"PRIu32, params->persistent_timeout);
+
+    const char *const argv[] = {
         SCRCPY_VERSION,
         log_level_to_server_string(params->log_level),
-        max_size_string,
-        bit_rate_string,
-        max_fps_string,
-        lock_video_orientation_string,
+        args->max_size,
+        args->bit_rate,
+        args->max_fps,
+        args->lock_video_orientation,
         server->tunnel_forward ? "true" : "false",
         params->crop ? params->crop : "-",
         "true", // always send frame meta (packet boundaries + timestamp)
         params->control ? "true" : "false",
-        display_id_string,
+        args->display_id,
         params->show_touches ? "true" : "false",
         params->stay_awake ? "true" : "false",
         params->codec_options ? params->codec_options : "-",
+        args->tcp_port,
+        args->idle_timeout,
+        params->legacy_control ? "false" : "true", // compact control
+        params->direct_tcp_all_interfaces ? "true" : "false",
     };
+    static_assert(sizeof(argv) == sizeof(args->argv), "wrong args count");
+    memcpy(args->argv, argv, sizeof(argv));
+}
+
+// join the server arguments by '\n' (none of them may contain '\n')
+static char *
+join_server_args(const struct server_args *args) {
+    size_t len = 0;
+    for (size_t i = 0; i < SERVER_ARGS_COUNT; ++i) {
+        len += strlen(args->argv[i]) + 1;
+    }
+    char *joined = SDL_malloc(len);
+    if (!joined) {
+        LOGC("Could not allocate session args");
+        return NULL;
+    }
+    size_t w = xstrjoin(joined, args->argv, '\n', len);
+    assert(w == len - 1);
+    (void) w;
+    return joined;
+}
+
+// start the server on the device, either through the adb server protocol (on
+// success, server->shell_socket is set) or by the adb executable (on success,
+// server->process is set)
+//
+// a persistent server is started in the background: on success, the command
+// has already terminated, and neither shell_socket nor process is set
+static bool
+execute_server(struct server *server, const struct server_args *args) {
+    char classpath[sizeof("CLASSPATH=") + sizeof(server->device_server_path)];
+    sprintf(classpath, "CLASSPATH=%s", server->device_server_path);
+    const char *cmd[8 + SERVER_ARGS_COUNT];
+    size_t len = 0;
+    cmd[len++] = "shell";
+    cmd[len++] = classpath;
+    if (server->persistent) {
+        // the server must survive the end of the shell
+        cmd[len++] = "nohup";
+    }
+    cmd[len++] = "app_process";
+#ifdef SERVER_DEBUGGER
+# define SERVER_DEBUGGER_PORT "5005"
+# ifdef SERVER_DEBUGGER_METHOD_NEW
+    /* Android 9 and above */
+    cmd[len++] = "-XjdwpProvider:internal -XjdwpOptions:transport=dt_socket,"
+                 "suspend=y,server=y,address=" SERVER_DEBUGGER_PORT;
+# else
+    /* Android 8 and below */
+    cmd[len++] = "-agentlib:jdwp=transport=dt_socket,suspend=y,server=y,"
+                 "address=" SERVER_DEBUGGER_PORT;
+# endif
+#endif
+    cmd[len++] = "/"; // unused
+    cmd[len++] = "com.genymobile.scrcpy.Server";
+    for (size_t i = 0; i < SERVER_ARGS_COUNT; ++i) {
+        cmd[len++] = args->argv[i];
+    }
+    if (server->persistent) {
+        // interpreted by the device shell
+        cmd[len++] = ">/dev/null";
+        cmd[len++] = "2>&1";
+        cmd[len++] = "&";
+    }
+    assert(len <= sizeof(cmd) / sizeof(cmd[0]));
 #ifdef SERVER_DEBUGGER
     LOGI("Server debugger waiting for a client on device port "
          SERVER_DEBUGGER_PORT "...");
@@ -306,16 +561,71 @@ execute_server(struct server *server, const struct server_params *params) {
     //     Port: 5005
     // Then click on "Debug"
 #endif
-    return adb_execute(server->serial, cmd, sizeof(cmd) / sizeof(cmd[0]));
+    // the first argument is the adb command ("shell")
+    enum adb_client_result r =
+        adb_client_shell(server->serial, &cmd[1], len - 1,
+                         &server->shell_socket);
+    if (r == ADB_CLIENT_SUCCESS) {
+        if (server->persistent) {
+            // wait for the shell to exit, the server runs in the background
+            char buf[256];
+            while (net_recv(server->shell_socket, buf, sizeof(buf)) > 0) {
+                // discard
+            }
+            net_close(server->shell_socket);
+            server->shell_socket = INVALID_SOCKET;
+        }
+        return true;
+    }
+
+    if (server->persistent) {
+        process_t process = adb_execute(server->serial, cmd, len);
+        return process_check_success(process, "adb shell");
+    }
+
+    server->process = adb_execute(server->serial, cmd, len);
+    return server->process != PROCESS_NONE;
+}
+
+// forward the server output to stdout (like "adb shell" does) until the server
+// terminates
+static void
+relay_server_output(socket_t shell_socket) {
+    char buf[1024];
+    ssize_t r;
+    while ((r = net_recv(shell_socket, buf, sizeof(buf))) > 0) {
+        fwrite(buf, 1, r, stdout);
+        fflush(stdout);
+    }
+}
+
+static void
+terminate_server(struct server *server) {
+    if (server->process != PROCESS_NONE) {
+        cmd_terminate(server->process);
+    } else {
+        // the server is killed when its shell stream is closed; shutdown()
+        // also wakes up relay_server_output()
+        net_shutdown(server->shell_socket, SHUT_RDWR);
+    }
 }
 
 static socket_t
-connect_and_read_byte(uint16_t port) {
-    socket_t socket = net_connect(IPV4_LOCALHOST, port);
+connect_and_read_byte(uint32_t addr, uint16_t port) {
+    socket_t socket = net_socket();
     if (socket == INVALID_SOCKET) {
         return INVALID_SOCKET;
     }
 
+    // must be set before connecting to be taken into account for the TCP
+    // window scale
+    net_set_recv_buffer_size(socket, VIDEO_SOCKET_RECV_BUFFER_SIZE);
+
+    if (!net_connect_socket(socket, addr, port)) {
+        net_close(socket);
+        return INVALID_SOCKET;
+    }
+
     char byte;
     // the connection may succeed even if the server behind the "adb tunnel"
     // is not listening, so read one byte to detect a working connection
@@ -327,20 +637,56 @@ connect_and_read_byte(uint16_t port) {
     return socket;
 }
 
+// retry with an exponential backoff: the first attempts are close together,
+// so that the connection is established as soon as the server listens
+// the number of attempts is written to *attempts
 static socket_t
-connect_to_server(uint16_t port, uint32_t attempts, uint32_t delay) {
-    do {
-        LOGD("Remaining connection attempts: %d", (int) attempts);
-        socket_t socket = connect_and_read_byte(port);
+connect_to_server(uint32_t addr, uint16_t port, uint32_t timeout,
+                  unsigned *attempts) {
+    uint32_t start = SDL_GetTicks();
+    uint32_t delay = CONNECT_FIRST_DELAY_MS;
+    *attempts = 0;
+    for (;;) {
+        ++*attempts;
+        socket_t socket = connect_and_read_byte(addr, port);
+        uint32_t elapsed = SDL_GetTicks() - start;
         if (socket != INVALID_SOCKET) {
             // it worked!
+            LOGD("Connected to server in %" PRIu32 " ms (%u attempts)",
+                 elapsed, *attempts);
             return socket;
         }
-        if (attempts) {
-            SDL_Delay(delay);
+        if (elapsed >= timeout) {
+            LOGE("Could not connect to server in %" PRIu32 " ms "
+                 "(%u attempts)", elapsed, *attempts);
+            return INVALID_SOCKET;
+        }
+        SDL_Delay(delay);
+        delay *= 2;
+        if (delay > CONNECT_MAX_DELAY_MS) {
+            delay = CONNECT_MAX_DELAY_MS;
         }
-    } while (--attempts > 0);
-    return INVALID_SOCKET;
+    }
+}
+
+static void
+get_server_address(const struct server *server, uint32_t *addr,
+                   uint16_t *port) {
+    *addr = server->direct_tcp ? server->direct_tcp_addr : IPV4_LOCALHOST;
+    *port = server->direct_tcp ? server->direct_tcp_port : server->local_port;
+}
+
+static bool
+send_session_args(socket_t socket, const char *session_args) {
+    size_t len = strlen(session_args);
+    if (len > 0xFFFF) {
+        LOGE("Session args too long");
+        return false;
+    }
+    uint8_t header[2];
+    buffer_write16be(header, (uint16_t) len);
+    return net_send_all(socket, header, 2) == 2
+        && net_send_all(socket, session_args, len) == (ssize_t) len;
 }
 
 static void
@@ -352,6 +698,61 @@ close_socket(socket_t socket) {
     }
 }
 
+// the reply of a persistent server to the session args
+#define SESSION_ACCEPTED 0
+
+// connect the control socket to a persistent server, send the session args and
+// wait for the server to accept them
+static bool
+open_session(struct server *server, uint32_t addr, uint16_t port) {
+    assert(server->persistent);
+    // we know that the device is listening, we don't need several attempts
+    server->control_socket = net_connect(addr, port);
+    if (server->control_socket == INVALID_SOCKET) {
+        return false;
+    }
+
+    if (!send_session_args(server->control_socket, server->session_args)) {
+        LOGE("Could not send session args to the server");
+        return false;
+    }
+
+    uint8_t status;
+    // the server closes the connection if it does not reply
+    return net_recv(server->control_socket, &status, 1) == 1
+        && status == SESSION_ACCEPTED;
+}
+
+// connect to a persistent server started by a previous client, if any
+static bool
+attach_to_server(struct server *server) {
+    assert(server->persistent && server->tunnel_forward);
+    uint32_t addr;
+    uint16_t port;
+    get_server_address(server, &addr, &port);
+    // a single attempt: if the server is running, it is already listening
+    server->video_socket = connect_and_read_byte(addr, port);
+    if (server->video_socket == INVALID_SOCKET) {
+        return false;
+    }
+
+    if (!open_session(server, addr, port)) {
+        // the running server is incompatible (it has been started by another
+        // version of the client): it has released its socket and exits, so a
+        // new server may be started
+        LOGI("The running server rejected the session, starting a new one");
+        close_socket(server->video_socket);
+        server->video_socket = INVALID_SOCKET;
+        if (server->control_socket != INVALID_SOCKET) {
+            close_socket(server->control_socket);
+            server->control_socket = INVALID_SOCKET;
+        }
+        return false;
+    }
+
+    return true;
+}
+
 void
 server_init(struct server *server) {
     *server = (struct server) SERVER_INITIALIZER;
@@ -360,7 +761,11 @@ server_init(struct server *server) {
 static int
 run_wait_server(void *data) {
     struct server *server = data;
-    cmd_simple_wait(server->process, NULL); // ignore exit code
+    if (server->process != PROCESS_NONE) {
+        cmd_simple_wait(server->process, NULL); // ignore exit code
+    } else {
+        relay_server_output(server->shell_socket);
+    }
     // no need for synchronization, server_socket is initialized before this
     // thread was created
     if (server->server_socket != INVALID_SOCKET
@@ -377,6 +782,10 @@ bool
 server_start(struct server *server, const char *serial,
              const struct server_params *params) {
     server->port_range = params->port_range;
+    server->timeline = params->timeline;
+    // a persistent server listens for successive clients, so it is only
+    // compatible with "adb forward" (the client connects to the device)
+    server->persistent = params->persistent_timeout != 0;
 
     if (serial) {
         server->serial = SDL_strdup(serial);
@@ -385,36 +794,79 @@ server_start(struct server *server, const char *serial,
         }
     }
 
-    if (!push_server(serial)) {
+    if (params->direct_tcp) {
+        // the device listens on a TCP port, and the client connects to it
+        // directly (no adb tunnel)
+        server->direct_tcp = true;
+        server->direct_tcp_addr = params->direct_tcp_addr;
+        server->direct_tcp_port = params->direct_tcp_port;
+        server->tunnel_forward = true;
+    } else if (!enable_tunnel_any_port(server, params->port_range,
+                                       params->force_adb_forward
+                                           || server->persistent)) {
         goto error1;
     }
+    server->busy_poll_us = params->busy_poll_us;
 
-    if (!enable_tunnel_any_port(server, params->port_range,
-                                params->force_adb_forward)) {
-        goto error1;
+    struct server_args args;
+    build_server_args(&args, server, params);
+
+    if (server->persistent) {
+        server->session_args = join_server_args(&args);
+        if (!server->session_args) {
+            goto error2;
+        }
+
+        uint32_t start = SDL_GetTicks();
+        bool attached = attach_to_server(server);
+        startup_timeline_add(server->timeline, "attach_to_server", start,
+                             SDL_GetTicks());
+        if (attached) {
+            LOGI("Attached to the running server");
+            server->tunnel_enabled = !server->direct_tcp;
+            return true;
+        }
     }
 
-    // server will connect to our server socket
-    server->process = execute_server(server, params);
-    if (server->process == PROCESS_NONE) {
+    uint32_t start = SDL_GetTicks();
+    bool ok = push_server(server);
+    startup_timeline_add(server->timeline, "push_server", start,
+                         SDL_GetTicks());
+    if (!ok) {
         goto error2;
     }
 
-    // If the server process dies before connecting to the server socket, then
-    // the client will be stuck forever on accept(). To avoid the problem, we
-    // must be able to wake up the accept() call when the server dies. To keep
-    // things simple and multiplatform, just spawn a new thread waiting for the
-    // server process and calling shutdown()/close() on the server socket if
-    // necessary to wake up any accept() blocking call.
-    server->wait_server_thread =
-        SDL_CreateThread(run_wait_server, "wait-server", server);
-    if (!server->wait_server_thread) {
-        cmd_terminate(server->process);
-        cmd_simple_wait(server->process, NULL); // ignore exit code
+    // server will connect to our server socket
+    start = SDL_GetTicks();
+    ok = execute_server(server, &args);
+    startup_timeline_add(server->timeline, "execute_server", start,
+                         SDL_GetTicks());
+    if (!ok) {
         goto error2;
     }
 
-    server->tunnel_enabled = true;
+    if (!server->persistent) {
+        // If the server process dies before connecting to the server socket,
+        // then the client will be stuck forever on accept(). To avoid the
+        // problem, we must be able to wake up the accept() call when the
+        // server dies. To keep things simple and multiplatform, just spawn a
+        // new thread waiting for the server process and calling
+        // shutdown()/close() on the server socket if necessary to wake up any
+        // accept() blocking call.
+        server->wait_server_thread =
+            SDL_CreateThread(run_wait_server, "wait-server", server);
+        if (!server->wait_server_thread) {
+            terminate_server(server);
+            if (server->process != PROCESS_NONE) {
+                cmd_simple_wait(server->process, NULL); // ignore exit code
+            } else {
+                net_close(server->shell_socket);
+            }
+            goto error2;
+        }
+    }
+
+    server->tunnel_enabled = !server->direct_tcp;
 
     return true;
 
@@ -427,14 +879,35 @@ error2:
         (void) was_closed;
         close_socket(server->server_socket);
     }
-    disable_tunnel(server);
+    if (!server->direct_tcp) {
+        disable_tunnel(server);
+    }
+    SDL_free(server->session_args);
+    server->session_args = NULL;
 error1:
     SDL_free(server->serial);
     return false;
 }
 
+static void
+tune_sockets(struct server *server) {
+    // control messages are small and latency-sensitive
+    net_set_tcp_nodelay(server->control_socket, true);
+    if (!server->tunnel_forward) {
+        // in forward mode, it has been set before connecting
+        net_set_recv_buffer_size(server->video_socket,
+                                 VIDEO_SOCKET_RECV_BUFFER_SIZE);
+    }
+
+    if (server->busy_poll_us) {
+        net_set_busy_poll(server->video_socket, server->busy_poll_us);
+        net_set_busy_poll(server->control_socket, server->busy_poll_us);
+    }
+}
+
 bool
 server_connect_to(struct server *server) {
+    uint32_t start = SDL_GetTicks();
     if (!server->tunnel_forward) {
         server->video_socket = net_accept(server->server_socket);
         if (server->video_socket == INVALID_SOCKET) {
@@ -453,26 +926,47 @@ server_connect_to(struct server *server) {
             close_socket(server->server_socket);
             // otherwise, it is closed by run_wait_server()
         }
+        LOGD("Server connected in %" PRIu32 " ms", SDL_GetTicks() - start);
+        startup_timeline_add(server->timeline, "accept_connections", start,
+                             SDL_GetTicks());
     } else {
-        uint32_t attempts = 100;
-        uint32_t delay = 100; // ms
-        server->video_socket =
-            connect_to_server(server->local_port, attempts, delay);
+        uint32_t addr;
+        uint16_t port;
+        get_server_address(server, &addr, &port);
         if (server->video_socket == INVALID_SOCKET) {
-            return false;
-        }
-
-        // we know that the device is listening, we don't need several attempts
-        server->control_socket =
-            net_connect(IPV4_LOCALHOST, server->local_port);
-        if (server->control_socket == INVALID_SOCKET) {
-            return false;
-        }
+            unsigned attempts;
+            server->video_socket =
+                connect_to_server(addr, port, CONNECT_TIMEOUT_MS, &attempts);
+            startup_timeline_add_attempts(server->timeline,
+                                          "connect_to_server", start,
+                                          SDL_GetTicks(), attempts);
+            if (server->video_socket == INVALID_SOCKET) {
+                return false;
+            }
+
+            if (server->persistent) {
+                if (!open_session(server, addr, port)) {
+                    LOGE("The server rejected the session");
+                    return false;
+                }
+            } else {
+                // we know that the device is listening, we don't need several
+                // attempts
+                server->control_socket = net_connect(addr, port);
+                if (server->control_socket == INVALID_SOCKET) {
+                    return false;
+                }
+            }
+        } // else already connected by attach_to_server()
     }
 
-    // we don't need the adb tunnel anymore
-    disable_tunnel(server); // ignore failure
-    server->tunnel_enabled = false;
+    tune_sockets(server);
+
+    if (server->tunnel_enabled) {
+        // we don't need the adb tunnel anymore
+        disable_tunnel(server); // ignore failure
+        server->tunnel_enabled = false;
+    }
 
     return true;
 }
@@ -490,19 +984,29 @@ server_stop(struct server *server) {
         close_socket(server->control_socket);
     }
 
-    assert(server->process != PROCESS_NONE);
+    if (!server->persistent) {
+        assert(server->process != PROCESS_NONE
+                || server->shell_socket != INVALID_SOCKET);
 
-    cmd_terminate(server->process);
+        terminate_server(server);
+    } // else the server keeps running, waiting for the next client
 
     if (server->tunnel_enabled) {
         // ignore failure
         disable_tunnel(server);
     }
 
-    SDL_WaitThread(server->wait_server_thread, NULL);
+    if (server->wait_server_thread) {
+        SDL_WaitThread(server->wait_server_thread, NULL);
+    }
+
+    if (server->shell_socket != INVALID_SOCKET) {
+        net_close(server->shell_socket);
+    }
 }
 
 void
 server_destroy(struct server *server) {
+    SDL_free(server->session_args);
     SDL_free(server->serial);
 }
@@ -10,12 +10,16 @@
 #include "command.h"
 #include "common.h"
 #include "scrcpy.h"
+#include "startup_timeline.h"
 #include "util/log.h"
 #include "util/net.h"
 
 struct server {
     char *serial;
-    process_t process;
+    // the path of the server on the device, named after its content hash
+    char device_server_path[64];
+    process_t process; // if started by the adb executable
+    socket_t shell_socket; // if started through the adb server protocol
     SDL_Thread *wait_server_thread;
     atomic_flag server_socket_closed;
     socket_t server_socket; // only used if !tunnel_forward
@@ -25,11 +29,23 @@ struct server {
     uint16_t local_port; // selected from port_range
     bool tunnel_enabled;
     bool tunnel_forward; // use "adb forward" instead of "adb reverse"
+    // connect directly to the device over TCP, without any adb tunnel
+    bool direct_tcp;
+    uint32_t direct_tcp_addr;
+    uint16_t direct_tcp_port;
+    unsigned busy_poll_us; // 0 to disable busy polling
+    struct startup_timeline *timeline; // NULL if disabled
+    // the server outlives the client, see server_params.persistent_timeout
+    bool persistent;
+    // the server arguments separated by '\n', sent to a persistent server on
+    // connection (it may have been started by a previous client)
+    char *session_args;
 };
 
 #define SERVER_INITIALIZER { \
     .serial = NULL, \
     .process = PROCESS_NONE, \
+    .shell_socket = INVALID_SOCKET, \
     .wait_server_thread = NULL, \
     .server_socket_closed = ATOMIC_FLAG_INIT, \
     .server_socket = INVALID_SOCKET, \
@@ -42,6 +58,13 @@ struct server {
     .local_port = 0, \
     .tunnel_enabled = false, \
     .tunnel_forward = false, \
+    .direct_tcp = false, \
+    .direct_tcp_addr = 0, \
+    .direct_tcp_port = 0, \
+    .busy_poll_us = 0, \
+    .timeline = NULL, \
+    .persistent = false, \
+    .session_args = NULL, \
 }
 
 struct server_params {
@@ -58,6 +81,18 @@ struct server_params {
     bool show_touches;
     bool stay_awake;
     bool force_adb_forward;
+    bool direct_tcp;
+    uint32_t direct_tcp_addr;
+    uint16_t direct_tcp_port;
+    // listen on all the device network interfaces rather than loopback only
+    bool direct_tcp_all_interfaces;
+    unsigned busy_poll_us;
+    struct startup_timeline *timeline; // NULL if disabled
+    // if not 0, keep the server running on the device between clients, until
+    // no client is attached for this duration (in seconds)
+    uint32_t persistent_timeout;
+    // the encoding of the control messages (see control_msg.h)
+    bool legacy_control;
 };
 
 // init default values
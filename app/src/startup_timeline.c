@@ -0,0 +1,91 @@
+#include "startup_timeline.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "config.h"
+#include "util/lock.h"
+#include "util/log.h"
+
+bool
+startup_timeline_init(struct startup_timeline *timeline, uint32_t origin) {
+    if (!(timeline->mutex = SDL_CreateMutex())) {
+        return false;
+    }
+    timeline->origin = origin;
+    timeline->count = 0;
+    return true;
+}
+
+void
+startup_timeline_destroy(struct startup_timeline *timeline) {
+    SDL_DestroyMutex(timeline->mutex);
+}
+
+void
+startup_timeline_add(struct startup_timeline *timeline, const char *name,
+                     uint32_t start, uint32_t end) {
+    startup_timeline_add_attempts(timeline, name, start, end, 0);
+}
+
+void
+startup_timeline_add_attempts(struct startup_timeline *timeline,
+                              const char *name, uint32_t start, uint32_t end,
+                              unsigned attempts) {
+    if (!timeline) {
+        return;
+    }
+
+    mutex_lock(timeline->mutex);
+    if (timeline->count < STARTUP_TIMELINE_MAX_SPANS) {
+        struct startup_span *span = &timeline->spans[timeline->count++];
+        span->name = name;
+        span->start = start;
+        span->end = end;
+        span->attempts = attempts;
+    } else {
+        LOGW("Startup timeline full, span %s ignored", name);
+    }
+    mutex_unlock(timeline->mutex);
+}
+
+bool
+startup_timeline_to_json(struct startup_timeline *timeline, char *buf,
+                         size_t len) {
+    assert(len);
+
+    size_t pos = 0;
+    bool ok = true;
+
+#define APPEND(...) \
+    do { \
+        int w = snprintf(&buf[pos], len - pos, __VA_ARGS__); \
+        if (w < 0 || (size_t) w >= len - pos) { \
+            ok = false; \
+            goto end; \
+        } \
+        pos += w; \
+    } while (0)
+
+    mutex_lock(timeline->mutex);
+
+    APPEND("{\"spans\":[");
+    for (unsigned i = 0; i < timeline->count; ++i) {
+        struct startup_span *span = &timeline->spans[i];
+        APPEND("%s{\"name\":\"%s\",\"start_ms\":%" PRIu32 ",\"end_ms\":%"
+               PRIu32, i ? "," : "", span->name,
+               span->start - timeline->origin, span->end - timeline->origin);
+        if (span->attempts) {
+            APPEND(",\"attempts\":%u", span->attempts);
+        }
+        APPEND("}");
+    }
+    APPEND("]}");
+
+#undef APPEND
+
+end:
+    mutex_unlock(timeline->mutex);
+    return ok;
+}
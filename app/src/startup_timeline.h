@@ -0,0 +1,58 @@
+#ifndef STARTUP_TIMELINE_H
+#define STARTUP_TIMELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL2/SDL_mutex.h>
+
+#include "config.h"
+
+#define STARTUP_TIMELINE_MAX_SPANS 32
+
+// a startup phase, in ms (SDL_GetTicks())
+struct startup_span {
+    const char *name; // static string
+    uint32_t start;
+    uint32_t end;
+    unsigned attempts; // for a retried phase, 0 otherwise
+};
+
+// record the startup phases, possibly from several threads, to report them as
+// a single JSON line
+struct startup_timeline {
+    SDL_mutex *mutex;
+    uint32_t origin; // SDL_GetTicks() at the beginning of the startup
+    struct startup_span spans[STARTUP_TIMELINE_MAX_SPANS];
+    unsigned count;
+};
+
+bool
+startup_timeline_init(struct startup_timeline *timeline, uint32_t origin);
+
+void
+startup_timeline_destroy(struct startup_timeline *timeline);
+
+// record a span; timeline may be NULL (if disabled), then it does nothing
+void
+startup_timeline_add(struct startup_timeline *timeline, const char *name,
+                     uint32_t start, uint32_t end);
+
+// record a span of a phase retried until success (or failure), with the
+// number of attempts
+void
+startup_timeline_add_attempts(struct startup_timeline *timeline,
+                              const char *name, uint32_t start, uint32_t end,
+                              unsigned attempts);
+
+// format the timeline as a single JSON object, with times relative to the
+// origin, for example:
+//     {"spans":[{"name":"push_server","start_ms":2,"end_ms":58},
+//               {"name":"connect_to_server","start_ms":60,"end_ms":95,
+//                "attempts":3}]}
+// return false if the output is truncated
+bool
+startup_timeline_to_json(struct startup_timeline *timeline, char *buf,
+                         size_t len);
+
+#endif
@@ -12,13 +12,15 @@
 #include "compat.h"
 #include "decoder.h"
 #include "events.h"
+#include "metrics.h"
 #include "recorder.h"
+#include "trace.h"
 #include "util/buffer_util.h"
 #include "util/log.h"
 
 #define BUFSIZE 0x10000
 
-#define HEADER_SIZE 12
+#define HEADER_SIZE 20
 #define NO_PTS UINT64_C(-1)
 
 static bool
@@ -27,13 +29,16 @@ stream_recv_packet(struct stream *stream, AVPacket *packet) {
     // record, we retrieve the timestamps separately, from a "meta" header
     // added by the server before each raw packet.
     //
-    // The "meta" header length is 12 bytes:
-    // [. . . . . . . .|. . . .]. . . . . . . . . . . . . . . ...
-    //  <-------------> <-----> <-----------------------------...
-    //        PTS        packet        raw packet
-    //                    size
+    // The "meta" header length is 20 bytes:
+    // [. . . . . . . .|. . . . . . . .|. . . .]. . . . . . . . . . . . . ...
+    //  <-------------> <-------------> <-----> <---------------------------...
+    //        PTS         capture time   packet          raw packet
+    //                                    size
     //
     // It is followed by <packet_size> bytes containing the packet/frame.
+    //
+    // The capture time is absolute, in µs on the device monotonic clock (0 for
+    // config packets), to measure the latency (see frame_latency.h).
 
     uint8_t header[HEADER_SIZE];
     ssize_t r = net_recv_all(stream->socket, header, HEADER_SIZE);
@@ -42,7 +47,8 @@ stream_recv_packet(struct stream *stream, AVPacket *packet) {
     }
 
     uint64_t pts = buffer_read64be(header);
-    uint32_t len = buffer_read32be(&header[8]);
+    uint64_t capture_time = buffer_read64be(&header[8]);
+    uint32_t len = buffer_read32be(&header[16]);
     assert(pts == NO_PTS || (pts & 0x8000000000000000) == 0);
     assert(len);
 
@@ -59,6 +65,14 @@ stream_recv_packet(struct stream *stream, AVPacket *packet) {
 
     packet->pts = pts != NO_PTS ? (int64_t) pts : AV_NOPTS_VALUE;
 
+    metrics_inc(METRIC_STREAM_PACKETS);
+    metrics_add(METRIC_STREAM_BYTES, len);
+
+    if (stream->frame_latency && pts != NO_PTS) {
+        frame_latency_on_received(stream->frame_latency, packet->pts,
+                                  capture_time);
+    }
+
     return true;
 }
 
@@ -80,8 +94,14 @@ process_config_packet(struct stream *stream, AVPacket *packet) {
 
 static bool
 process_frame(struct stream *stream, AVPacket *packet) {
-    if (stream->decoder && !decoder_push(stream->decoder, packet)) {
-        return false;
+    if (stream->decoder) {
+        // the frame is offered to the video buffer from the decoder
+        uint64_t trace_start = trace_begin();
+        bool ok = decoder_push(stream->decoder, packet);
+        trace_end("decode", trace_start);
+        if (!ok) {
+            return false;
+        }
     }
 
     if (stream->recorder) {
@@ -102,9 +122,11 @@ stream_parse(struct stream *stream, AVPacket *packet) {
     int in_len = packet->size;
     uint8_t *out_data = NULL;
     int out_len = 0;
+    uint64_t trace_start = trace_begin();
     int r = av_parser_parse2(stream->parser, stream->codec_ctx,
                              &out_data, &out_len, in_data, in_len,
                              AV_NOPTS_VALUE, AV_NOPTS_VALUE, -1);
+    trace_end("parse", trace_start);
 
     // PARSER_FLAG_COMPLETE_FRAMES is set
     assert(r == in_len);
@@ -184,6 +206,7 @@ stream_push_packet(struct stream *stream, AVPacket *packet) {
 static int
 run_stream(void *data) {
     struct stream *stream = data;
+    trace_set_thread_name("stream");
 
     AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
     if (!codec) {
@@ -226,7 +249,9 @@ run_stream(void *data) {
 
     for (;;) {
         AVPacket packet;
+        uint64_t trace_start = trace_begin();
         bool ok = stream_recv_packet(stream, &packet);
+        trace_end("recv", trace_start);
         if (!ok) {
             // end of stream
             break;
@@ -270,10 +295,12 @@ end:
 
 void
 stream_init(struct stream *stream, socket_t socket,
-            struct decoder *decoder, struct recorder *recorder) {
+            struct decoder *decoder, struct recorder *recorder,
+            struct frame_latency *frame_latency) {
     stream->socket = socket;
     stream->decoder = decoder,
     stream->recorder = recorder;
+    stream->frame_latency = frame_latency;
     stream->has_pending = false;
 }
 
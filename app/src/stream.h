@@ -8,6 +8,7 @@
 #include <SDL2/SDL_thread.h>
 
 #include "config.h"
+#include "frame_latency.h"
 #include "util/net.h"
 
 struct video_buffer;
@@ -18,6 +19,7 @@ struct stream {
     SDL_Thread *thread;
     struct decoder *decoder;
     struct recorder *recorder;
+    struct frame_latency *frame_latency; // may be NULL
     AVCodecContext *codec_ctx;
     AVCodecParserContext *parser;
     // successive packets may need to be concatenated, until a non-config
@@ -28,7 +30,8 @@ struct stream {
 
 void
 stream_init(struct stream *stream, socket_t socket,
-            struct decoder *decoder, struct recorder *recorder);
+            struct decoder *decoder, struct recorder *recorder,
+            struct frame_latency *frame_latency);
 
 bool
 stream_start(struct stream *stream);
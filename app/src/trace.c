@@ -0,0 +1,284 @@
+#include "trace.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL_stdinc.h>
+#include <SDL2/SDL_thread.h>
+
+#include "config.h"
+#include "util/log.h"
+#include "util/tick.h"
+
+static_assert(!(TRACE_THREAD_CAPACITY & (TRACE_THREAD_CAPACITY - 1)),
+              "TRACE_THREAD_CAPACITY must be a power of 2");
+
+struct trace_span {
+    const char *name;
+    uint64_t start; // in µs, tick_now_us()
+    uint32_t duration; // in µs
+};
+
+// written only by its thread, read by trace_write() from any thread
+struct trace_buffer {
+    _Atomic(const char *) thread_name;
+    // false once its thread has exited, so that a thread with the same name
+    // (restarted on reconnection) continues the same ring buffer
+    atomic_bool in_use;
+    struct trace_span *spans; // ring buffer of TRACE_THREAD_CAPACITY spans
+    // total number of spans recorded (published with release semantics, once
+    // the span is written)
+    atomic_uint_least64_t count;
+};
+
+static atomic_bool enabled;
+static uint64_t origin;
+static struct trace_buffer buffers[TRACE_MAX_THREADS];
+// number of buffers claimed (may exceed TRACE_MAX_THREADS)
+static atomic_uint buffer_count;
+// the spans of the threads beyond TRACE_MAX_THREADS are not recorded
+static struct trace_buffer overflow;
+
+static _Thread_local struct trace_buffer *current;
+// to release the buffer of a thread when it exits
+static SDL_TLSID release_tls;
+
+bool
+trace_init(void) {
+    if (!release_tls) {
+        release_tls = SDL_TLSCreate();
+        if (!release_tls) {
+            LOGE("Could not create trace thread-local storage");
+            return false;
+        }
+    }
+    origin = tick_now_us();
+    atomic_store_explicit(&enabled, true, memory_order_release);
+    return true;
+}
+
+void
+trace_destroy(void) {
+    atomic_store_explicit(&enabled, false, memory_order_relaxed);
+    unsigned count = atomic_load_explicit(&buffer_count, memory_order_relaxed);
+    if (count > TRACE_MAX_THREADS) {
+        count = TRACE_MAX_THREADS;
+    }
+    for (unsigned i = 0; i < count; ++i) {
+        SDL_free(buffers[i].spans);
+        buffers[i].spans = NULL;
+    }
+}
+
+// called by SDL when a thread owning a buffer exits
+static void SDLCALL
+release_buffer(void *data) {
+    struct trace_buffer *buf = data;
+    atomic_store_explicit(&buf->in_use, false, memory_order_release);
+}
+
+// the buffer released by a previous thread with the same name, if any
+static struct trace_buffer *
+reuse_buffer(const char *name) {
+    unsigned count = atomic_load_explicit(&buffer_count, memory_order_acquire);
+    if (count > TRACE_MAX_THREADS) {
+        count = TRACE_MAX_THREADS;
+    }
+    for (unsigned i = 0; i < count; ++i) {
+        struct trace_buffer *buf = &buffers[i];
+        const char *buf_name =
+            atomic_load_explicit(&buf->thread_name, memory_order_relaxed);
+        bool in_use = false;
+        if (buf_name && !strcmp(buf_name, name)
+                && atomic_compare_exchange_strong_explicit(
+                        &buf->in_use, &in_use, true, memory_order_acquire,
+                        memory_order_relaxed)) {
+            return buf;
+        }
+    }
+    return NULL;
+}
+
+// claim a buffer for the current thread, named name (may be NULL)
+static struct trace_buffer *
+claim_buffer(const char *name) {
+    struct trace_buffer *buf = name ? reuse_buffer(name) : NULL;
+    if (!buf) {
+        unsigned i = atomic_fetch_add_explicit(&buffer_count, 1,
+                                               memory_order_acq_rel);
+        if (i >= TRACE_MAX_THREADS) {
+            LOGW("Too many traced threads, spans ignored");
+            return &overflow;
+        }
+
+        buf = &buffers[i];
+        atomic_store_explicit(&buf->in_use, true, memory_order_relaxed);
+        atomic_store_explicit(&buf->thread_name, name, memory_order_relaxed);
+        buf->spans = SDL_malloc(TRACE_THREAD_CAPACITY * sizeof(*buf->spans));
+        if (!buf->spans) {
+            LOGW("Could not allocate trace buffer");
+        }
+    }
+
+    if (SDL_TLSSet(release_tls, buf, release_buffer)) {
+        LOGW("Could not register the trace buffer release");
+    }
+    return buf;
+}
+
+// the buffer of the current thread, claimed on first use (NULL if it could
+// not be allocated)
+static struct trace_buffer *
+get_buffer(void) {
+    if (!current) {
+        current = claim_buffer(NULL);
+    }
+    return current->spans ? current : NULL;
+}
+
+void
+trace_set_thread_name(const char *name) {
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed)) {
+        return;
+    }
+    if (!current) {
+        current = claim_buffer(name);
+        return;
+    }
+    if (current->spans) {
+        atomic_store_explicit(&current->thread_name, name,
+                              memory_order_relaxed);
+    }
+}
+
+uint64_t
+trace_begin(void) {
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed)) {
+        return 0;
+    }
+    return tick_now_us();
+}
+
+void
+trace_end(const char *name, uint64_t start) {
+    if (!start) {
+        return;
+    }
+    uint64_t now = tick_now_us();
+
+    struct trace_buffer *buf = get_buffer();
+    if (!buf) {
+        return;
+    }
+
+    // only this thread writes the count
+    uint64_t n = atomic_load_explicit(&buf->count, memory_order_relaxed);
+    struct trace_span *span = &buf->spans[n % TRACE_THREAD_CAPACITY];
+    span->name = name;
+    span->start = start;
+    span->duration = now > start ? now - start : 0;
+    atomic_store_explicit(&buf->count, n + 1, memory_order_release);
+}
+
+// copy the spans of a buffer which are not overwritten during the copy
+// return the number of spans copied into spans, from *first (in recording
+// order)
+static unsigned
+copy_spans(struct trace_buffer *buf, struct trace_span *spans,
+           uint64_t *first) {
+    uint64_t end = atomic_load_explicit(&buf->count, memory_order_acquire);
+    uint64_t begin = end > TRACE_THREAD_CAPACITY
+                   ? end - TRACE_THREAD_CAPACITY : 0;
+    for (uint64_t i = begin; i < end; ++i) {
+        spans[i % TRACE_THREAD_CAPACITY] =
+            buf->spans[i % TRACE_THREAD_CAPACITY];
+    }
+
+    // the copy must not be reordered after the count is read again
+    atomic_thread_fence(memory_order_acquire);
+    // the thread may have overwritten the oldest spans meanwhile, and may be
+    // writing the span at new_end, whose slot is the one of
+    // new_end - TRACE_THREAD_CAPACITY
+    uint64_t new_end = atomic_load_explicit(&buf->count,
+                                            memory_order_relaxed);
+    if (new_end + 1 > begin + TRACE_THREAD_CAPACITY) {
+        begin = new_end + 1 - TRACE_THREAD_CAPACITY;
+    }
+    *first = begin;
+    return end > begin ? end - begin : 0;
+}
+
+static bool
+write_buffer(FILE *file, struct trace_buffer *buf, unsigned tid,
+             struct trace_span *spans, bool *first_event) {
+    uint64_t first;
+    unsigned count = copy_spans(buf, spans, &first);
+    if (!count) {
+        return true;
+    }
+
+    const char *thread_name =
+        atomic_load_explicit(&buf->thread_name, memory_order_relaxed);
+    if (thread_name) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                      "\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                *first_event ? "" : ",\n", tid, thread_name);
+        *first_event = false;
+    }
+
+    for (unsigned i = 0; i < count; ++i) {
+        const struct trace_span *span =
+            &spans[(first + i) % TRACE_THREAD_CAPACITY];
+        if (span->start < origin) {
+            continue;
+        }
+        fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                      "\"ts\":%" PRIu64 ",\"dur\":%" PRIu32 "}",
+                *first_event ? "" : ",\n", span->name, tid,
+                span->start - origin, span->duration);
+        *first_event = false;
+    }
+    return !ferror(file);
+}
+
+bool
+trace_write(const char *filename) {
+    struct trace_span *spans =
+        SDL_malloc(TRACE_THREAD_CAPACITY * sizeof(*spans));
+    if (!spans) {
+        LOGE("Could not allocate trace spans");
+        return false;
+    }
+
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        LOGE("Could not open trace file: %s", filename);
+        SDL_free(spans);
+        return false;
+    }
+
+    unsigned count = atomic_load_explicit(&buffer_count,
+                                          memory_order_acquire);
+    if (count > TRACE_MAX_THREADS) {
+        count = TRACE_MAX_THREADS;
+    }
+
+    bool ok = fputs("{\"traceEvents\":[\n", file) >= 0;
+    bool first_event = true;
+    for (unsigned i = 0; ok && i < count; ++i) {
+        ok = write_buffer(file, &buffers[i], i + 1, spans, &first_event);
+    }
+    ok = ok && fputs("\n]}\n", file) >= 0;
+    ok = !fclose(file) && ok;
+    SDL_free(spans);
+
+    if (!ok) {
+        LOGE("Could not write trace file: %s", filename);
+        return false;
+    }
+
+    LOGI("Trace written to %s", filename);
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "config.h"
+
+// Timeline of the hot operations of each thread (receiving, parsing, decoding,
+// uploading and presenting the frames, muxing, sending the control
+// messages), exported in the Chrome trace event format, to be opened in
+// chrome://tracing or <https://ui.perfetto.dev>.
+//
+// Each thread records its spans into its own ring buffer, without lock: the
+// last TRACE_THREAD_CAPACITY spans of each thread are kept. When tracing is
+// disabled, a span costs a single relaxed atomic load.
+//
+// A buffer is released when its thread exits: a new thread with the same name
+// (for example restarted on reconnection) continues it, so that
+// TRACE_MAX_THREADS is not exhausted by restarted threads.
+//
+// The tracer is process-wide (like the metrics registry), so that the spans
+// can be recorded from any module without passing a context.
+//
+// Span and thread names must be static strings, they are not escaped.
+
+#define TRACE_MAX_THREADS 16
+#define TRACE_THREAD_CAPACITY (1 << 16) // must be a power of 2
+
+// enable tracing (must be called before the traced threads are started)
+bool
+trace_init(void);
+
+// disable tracing and release the buffers (must be called once the traced
+// threads are joined)
+void
+trace_destroy(void);
+
+// name the current thread in the trace
+void
+trace_set_thread_name(const char *name);
+
+// the start time of a span, or 0 if tracing is disabled
+uint64_t
+trace_begin(void);
+
+// record a span on the current thread, from start (returned by
+// trace_begin()) to now; does nothing if start is 0
+void
+trace_end(const char *name, uint64_t start);
+
+// write the spans recorded so far (tracing continues), for example:
+//     {"traceEvents":[
+//     {"name":"decode","ph":"X","pid":1,"tid":2,"ts":1234,"dur":567},
+//     ...
+//     ]}
+// the times are in µs, relative to trace_init()
+bool
+trace_write(const char *filename);
+
+#endif
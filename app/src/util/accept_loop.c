@@ -0,0 +1,93 @@
+#include "accept_loop.h"
+
+#include "config.h"
+#include "lock.h"
+#include "log.h"
+
+bool
+accept_loop_init(struct accept_loop *loop, const char *name,
+                 socket_t server_socket, const struct accept_loop_cbs *cbs,
+                 void *cbs_userdata) {
+    if (!(loop->mutex = SDL_CreateMutex())) {
+        return false;
+    }
+
+    loop->name = name;
+    loop->server_socket = server_socket;
+    loop->client_socket = INVALID_SOCKET;
+    loop->stopped = false;
+    loop->cbs = cbs;
+    loop->cbs_userdata = cbs_userdata;
+    return true;
+}
+
+void
+accept_loop_destroy(struct accept_loop *loop) {
+    net_close(loop->server_socket);
+    SDL_DestroyMutex(loop->mutex);
+}
+
+static int
+run_accept_loop(void *data) {
+    struct accept_loop *loop = data;
+    for (;;) {
+        socket_t socket = net_accept(loop->server_socket);
+
+        mutex_lock(loop->mutex);
+        if (loop->stopped) {
+            mutex_unlock(loop->mutex);
+            if (socket != INVALID_SOCKET) {
+                net_close(socket);
+            }
+            break;
+        }
+        loop->client_socket = socket;
+        mutex_unlock(loop->mutex);
+
+        if (socket == INVALID_SOCKET) {
+            LOGE("Could not accept %s client", loop->name);
+            break;
+        }
+
+        loop->cbs->serve(socket, loop->cbs_userdata);
+
+        mutex_lock(loop->mutex);
+        loop->client_socket = INVALID_SOCKET;
+        mutex_unlock(loop->mutex);
+        net_close(socket);
+    }
+    LOGD("%s accept loop ended", loop->name);
+    return 0;
+}
+
+bool
+accept_loop_start(struct accept_loop *loop, const char *thread_name) {
+    loop->thread = SDL_CreateThread(run_accept_loop, thread_name, loop);
+    if (!loop->thread) {
+        LOGC("Could not start %s thread", thread_name);
+        return false;
+    }
+    return true;
+}
+
+void
+accept_loop_stop(struct accept_loop *loop) {
+    mutex_lock(loop->mutex);
+    loop->stopped = true;
+    if (loop->client_socket != INVALID_SOCKET) {
+        // wake up the blocking recv()
+        net_shutdown(loop->client_socket, SHUT_RDWR);
+    }
+    mutex_unlock(loop->mutex);
+
+    // wake up the blocking accept()
+    socket_t socket = loop->cbs->connect(loop->cbs_userdata);
+    if (socket != INVALID_SOCKET) {
+        net_close(socket);
+    }
+}
+
+void
+accept_loop_join(struct accept_loop *loop) {
+    SDL_WaitThread(loop->thread, NULL);
+}
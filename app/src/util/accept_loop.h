@@ -0,0 +1,52 @@
+#ifndef ACCEPT_LOOP_H
+#define ACCEPT_LOOP_H
+
+#include <stdbool.h>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
+
+#include "config.h"
+#include "net.h"
+
+struct accept_loop_cbs {
+    // serve a client until it disconnects (its socket is shut down on stop)
+    void (*serve)(socket_t socket, void *userdata);
+    // connect to the server socket, to wake up the blocking accept() on stop
+    // (shutting down a listening socket is not portable)
+    socket_t (*connect)(void *userdata);
+};
+
+// Accept the clients of a listening socket on a dedicated thread, and serve
+// them one at a time.
+struct accept_loop {
+    const char *name; // for the logs
+    socket_t server_socket;
+    socket_t client_socket; // INVALID_SOCKET if no client is connected
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    bool stopped;
+    const struct accept_loop_cbs *cbs;
+    void *cbs_userdata;
+};
+
+// on success, server_socket is owned by the loop (closed by
+// accept_loop_destroy())
+bool
+accept_loop_init(struct accept_loop *loop, const char *name,
+                 socket_t server_socket, const struct accept_loop_cbs *cbs,
+                 void *cbs_userdata);
+
+void
+accept_loop_destroy(struct accept_loop *loop);
+
+bool
+accept_loop_start(struct accept_loop *loop, const char *thread_name);
+
+// stop accepting, and disconnect the current client, if any
+void
+accept_loop_stop(struct accept_loop *loop);
+
+void
+accept_loop_join(struct accept_loop *loop);
+
+#endif
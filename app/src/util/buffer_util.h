@@ -2,6 +2,7 @@
 #define BUFFER_UTIL_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "config.h"
@@ -26,6 +27,38 @@ buffer_write64be(uint8_t *buf, uint64_t value) {
     buffer_write32be(&buf[4], (uint32_t) value);
 }
 
+static inline void
+buffer_write32le(uint8_t *buf, uint32_t value) {
+    buf[0] = value;
+    buf[1] = value >> 8;
+    buf[2] = value >> 16;
+    buf[3] = value >> 24;
+}
+
+// max number of bytes written by buffer_write_varint()
+#define BUFFER_VARINT_MAX_SIZE 10
+
+// write an unsigned LEB128 varint (7 bits per byte, least significant first)
+// return the number of bytes written
+static inline size_t
+buffer_write_varint(uint8_t *buf, uint64_t value) {
+    size_t i = 0;
+    while (value >= 0x80) {
+        buf[i++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    buf[i++] = value;
+    return i;
+}
+
+// write a signed varint, zigzag-encoded so that small negative values are
+// short too (0 -> 0, -1 -> 1, 1 -> 2, -2 -> 3...)
+static inline size_t
+buffer_write_svarint(uint8_t *buf, int64_t value) {
+    uint64_t zigzag = ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+    return buffer_write_varint(buf, zigzag);
+}
+
 static inline uint16_t
 buffer_read16be(const uint8_t *buf) {
     return (buf[0] << 8) | buf[1];
@@ -43,4 +76,9 @@ buffer_read64be(const uint8_t *buf) {
     return ((uint64_t) msb << 32) | lsb;
 }
 
+static inline uint32_t
+buffer_read32le(const uint8_t *buf) {
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t) buf[3] << 24);
+}
+
 #endif
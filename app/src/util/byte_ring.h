@@ -0,0 +1,86 @@
+// circular byte buffer, to receive a stream and parse it in place
+#ifndef BYTE_RING_H
+#define BYTE_RING_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "config.h"
+
+// The storage is provided by the caller, its capacity must be a power of 2.
+//
+// head and tail are free-running (they are only reduced modulo the capacity
+// to index data), so that the whole capacity is usable.
+struct byte_ring {
+    unsigned char *data;
+    size_t capacity;
+    size_t head; // write index
+    size_t tail; // read index
+};
+
+static inline void
+byte_ring_init(struct byte_ring *ring, unsigned char *data, size_t capacity) {
+    assert(capacity && !(capacity & (capacity - 1)));
+    ring->data = data;
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+// number of bytes available for reading
+static inline size_t
+byte_ring_len(const struct byte_ring *ring) {
+    return ring->head - ring->tail;
+}
+
+// contiguous space to write into (*len may be less than the free space if
+// it wraps around), to be committed by byte_ring_commit()
+static inline unsigned char *
+byte_ring_write_ptr(struct byte_ring *ring, size_t *len) {
+    size_t index = ring->head & (ring->capacity - 1);
+    size_t free = ring->capacity - byte_ring_len(ring);
+    size_t until_end = ring->capacity - index;
+    *len = free < until_end ? free : until_end;
+    return &ring->data[index];
+}
+
+static inline void
+byte_ring_commit(struct byte_ring *ring, size_t len) {
+    assert(len <= ring->capacity - byte_ring_len(ring));
+    ring->head += len;
+}
+
+// contiguous bytes to read (*len may be less than byte_ring_len() if they wrap
+// around), to be consumed by byte_ring_consume()
+static inline const unsigned char *
+byte_ring_read_ptr(const struct byte_ring *ring, size_t *len) {
+    size_t index = ring->tail & (ring->capacity - 1);
+    size_t available = byte_ring_len(ring);
+    size_t until_end = ring->capacity - index;
+    *len = available < until_end ? available : until_end;
+    return &ring->data[index];
+}
+
+static inline void
+byte_ring_consume(struct byte_ring *ring, size_t len) {
+    assert(len <= byte_ring_len(ring));
+    ring->tail += len;
+}
+
+// copy the first len bytes (len <= byte_ring_len()) without consuming them
+static inline void
+byte_ring_peek(const struct byte_ring *ring, void *dst, size_t len) {
+    assert(len <= byte_ring_len(ring));
+    size_t index = ring->tail & (ring->capacity - 1);
+    size_t until_end = ring->capacity - index;
+    if (len <= until_end) {
+        memcpy(dst, &ring->data[index], len);
+    } else {
+        memcpy(dst, &ring->data[index], until_end);
+        memcpy((unsigned char *) dst + until_end, ring->data, len - until_end);
+    }
+}
+
+#endif
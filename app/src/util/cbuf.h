@@ -26,6 +26,15 @@
 #define cbuf_is_full(PCBUF) \
     (((PCBUF)->head + 1) % cbuf_size_(PCBUF) == (PCBUF)->tail)
 
+// pointer to the next item to take (the cbuf must not be empty)
+#define cbuf_first(PCBUF) \
+    (&(PCBUF)->data[(PCBUF)->tail])
+
+// pointer to the last pushed item (the cbuf must not be empty)
+#define cbuf_last(PCBUF) \
+    (&(PCBUF)->data[((PCBUF)->head + cbuf_size_(PCBUF) - 1) \
+                        % cbuf_size_(PCBUF)])
+
 #define cbuf_init(PCBUF) \
     (void) ((PCBUF)->head = (PCBUF)->tail = 0)
 
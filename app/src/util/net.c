@@ -1,6 +1,7 @@
 #include "net.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <SDL2/SDL_platform.h>
 
 #include "config.h"
@@ -11,7 +12,11 @@
 #else
 # include <sys/types.h>
 # include <sys/socket.h>
+# include <sys/stat.h>
+# include <sys/time.h>
+# include <sys/un.h>
 # include <netinet/in.h>
+# include <netinet/tcp.h>
 # include <arpa/inet.h>
 # include <unistd.h>
 # define SOCKET_ERROR -1
@@ -20,21 +25,45 @@
   typedef struct in_addr IN_ADDR;
 #endif
 
+// do not raise SIGPIPE if the peer closed the connection, fail with EPIPE
+#ifdef MSG_NOSIGNAL
+# define SEND_FLAGS MSG_NOSIGNAL
+#else
+# define SEND_FLAGS 0
+#endif
+
 socket_t
-net_connect(uint32_t addr, uint16_t port) {
+net_socket(void) {
     socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
     if (sock == INVALID_SOCKET) {
         perror("socket");
-        return INVALID_SOCKET;
     }
+    return sock;
+}
 
+bool
+net_connect_socket(socket_t socket, uint32_t addr, uint16_t port) {
     SOCKADDR_IN sin;
     sin.sin_family = AF_INET;
     sin.sin_addr.s_addr = htonl(addr);
     sin.sin_port = htons(port);
 
-    if (connect(sock, (SOCKADDR *) &sin, sizeof(sin)) == SOCKET_ERROR) {
+    if (connect(socket, (SOCKADDR *) &sin, sizeof(sin)) == SOCKET_ERROR) {
         perror("connect");
+        return false;
+    }
+
+    return true;
+}
+
+socket_t
+net_connect(uint32_t addr, uint16_t port) {
+    socket_t sock = net_socket();
+    if (sock == INVALID_SOCKET) {
+        return INVALID_SOCKET;
+    }
+
+    if (!net_connect_socket(sock, addr, port)) {
         net_close(sock);
         return INVALID_SOCKET;
     }
@@ -76,6 +105,90 @@ net_listen(uint32_t addr, uint16_t port, int backlog) {
     return sock;
 }
 
+#ifndef __WINDOWS__
+static bool
+init_unix_address(struct sockaddr_un *sun, const char *path) {
+    size_t len = strlen(path);
+    if (len >= sizeof(sun->sun_path)) {
+        LOGE("Unix socket path too long: %s", path);
+        return false;
+    }
+    memset(sun, 0, sizeof(*sun));
+    sun->sun_family = AF_UNIX;
+    memcpy(sun->sun_path, path, len + 1);
+    return true;
+}
+#endif
+
+socket_t
+net_listen_unix(const char *path, int backlog) {
+#ifdef __WINDOWS__
+    (void) path;
+    (void) backlog;
+    LOGE("Unix domain sockets are not supported on Windows");
+    return INVALID_SOCKET;
+#else
+    struct sockaddr_un sun;
+    if (!init_unix_address(&sun, path)) {
+        return INVALID_SOCKET;
+    }
+
+    // never remove anything else than a socket
+    struct stat st;
+    if (!stat(path, &st) && S_ISSOCK(st.st_mode)) {
+        unlink(path);
+    }
+
+    socket_t sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock == INVALID_SOCKET) {
+        perror("socket");
+        return INVALID_SOCKET;
+    }
+
+    if (bind(sock, (SOCKADDR *) &sun, sizeof(sun)) == SOCKET_ERROR) {
+        perror("bind");
+        net_close(sock);
+        return INVALID_SOCKET;
+    }
+
+    if (listen(sock, backlog) == SOCKET_ERROR) {
+        perror("listen");
+        net_close(sock);
+        return INVALID_SOCKET;
+    }
+
+    return sock;
+#endif
+}
+
+socket_t
+net_connect_unix(const char *path) {
+#ifdef __WINDOWS__
+    (void) path;
+    LOGE("Unix domain sockets are not supported on Windows");
+    return INVALID_SOCKET;
+#else
+    struct sockaddr_un sun;
+    if (!init_unix_address(&sun, path)) {
+        return INVALID_SOCKET;
+    }
+
+    socket_t sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock == INVALID_SOCKET) {
+        perror("socket");
+        return INVALID_SOCKET;
+    }
+
+    if (connect(sock, (SOCKADDR *) &sun, sizeof(sun)) == SOCKET_ERROR) {
+        perror("connect");
+        net_close(sock);
+        return INVALID_SOCKET;
+    }
+
+    return sock;
+#endif
+}
+
 socket_t
 net_accept(socket_t server_socket) {
     SOCKADDR_IN csin;
@@ -95,14 +208,14 @@ net_recv_all(socket_t socket, void *buf, size_t len) {
 
 ssize_t
 net_send(socket_t socket, const void *buf, size_t len) {
-    return send(socket, buf, len, 0);
+    return send(socket, buf, len, SEND_FLAGS);
 }
 
 ssize_t
 net_send_all(socket_t socket, const void *buf, size_t len) {
     ssize_t w = 0;
     while (len > 0) {
-        w = send(socket, buf, len, 0);
+        w = send(socket, buf, len, SEND_FLAGS);
         if (w == -1) {
             return -1;
         }
@@ -145,3 +258,93 @@ net_close(socket_t socket) {
     return !close(socket);
 #endif
 }
+
+bool
+net_set_tcp_nodelay(socket_t socket, bool tcp_nodelay) {
+    int value = tcp_nodelay;
+    if (setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const void *) &value,
+                   sizeof(value)) == SOCKET_ERROR) {
+        perror("setsockopt(TCP_NODELAY)");
+        return false;
+    }
+    return true;
+}
+
+bool
+net_set_recv_buffer_size(socket_t socket, int size) {
+    if (setsockopt(socket, SOL_SOCKET, SO_RCVBUF, (const void *) &size,
+                   sizeof(size)) == SOCKET_ERROR) {
+        perror("setsockopt(SO_RCVBUF)");
+        return false;
+    }
+    return true;
+}
+
+bool
+net_set_timeout(socket_t socket, uint32_t timeout_ms) {
+#ifdef __WINDOWS__
+    DWORD value = timeout_ms;
+#else
+    struct timeval value = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+#endif
+    if (setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const void *) &value,
+                   sizeof(value)) == SOCKET_ERROR) {
+        perror("setsockopt(SO_RCVTIMEO)");
+        return false;
+    }
+    if (setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const void *) &value,
+                   sizeof(value)) == SOCKET_ERROR) {
+        perror("setsockopt(SO_SNDTIMEO)");
+        return false;
+    }
+    return true;
+}
+
+bool
+net_set_busy_poll(socket_t socket, unsigned usec) {
+#ifdef SO_BUSY_POLL
+    int value = usec;
+    if (setsockopt(socket, SOL_SOCKET, SO_BUSY_POLL, (const void *) &value,
+                   sizeof(value)) == SOCKET_ERROR) {
+        perror("setsockopt(SO_BUSY_POLL)");
+        return false;
+    }
+    return true;
+#else
+    (void) socket;
+    (void) usec;
+    LOGW("Busy polling is not supported on this platform");
+    return false;
+#endif
+}
+
+bool
+net_parse_ipv4(const char *s, uint32_t *ipv4) {
+    uint32_t result = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (i && *s++ != '.') {
+            return false;
+        }
+        if (*s < '0' || *s > '9') {
+            return false;
+        }
+        unsigned value = 0;
+        int digits = 0;
+        while (*s >= '0' && *s <= '9') {
+            value = value * 10 + (*s++ - '0');
+            if (++digits > 3 || value > 255) {
+                return false;
+            }
+        }
+        result = (result << 8) | value;
+    }
+    if (*s) {
+        // trailing characters
+        return false;
+    }
+    *ipv4 = result;
+    return true;
+}
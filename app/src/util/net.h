@@ -25,12 +25,28 @@ net_init(void);
 void
 net_cleanup(void);
 
+// create a TCP (IPv4) socket, to be connected by net_connect_socket()
+socket_t
+net_socket(void);
+
+// connect a socket created by net_socket(), to set options before connecting
+bool
+net_connect_socket(socket_t socket, uint32_t addr, uint16_t port);
+
 socket_t
 net_connect(uint32_t addr, uint16_t port);
 
 socket_t
 net_listen(uint32_t addr, uint16_t port, int backlog);
 
+// listen on a Unix domain socket (not supported on Windows)
+// an existing socket file at path (left by a previous instance) is replaced
+socket_t
+net_listen_unix(const char *path, int backlog);
+
+socket_t
+net_connect_unix(const char *path);
+
 socket_t
 net_accept(socket_t server_socket);
 
@@ -54,4 +70,29 @@ net_shutdown(socket_t socket, int how);
 bool
 net_close(socket_t socket);
 
+// disable Nagle's algorithm, to send small messages immediately
+bool
+net_set_tcp_nodelay(socket_t socket, bool tcp_nodelay);
+
+// set the receive buffer size (SO_RCVBUF)
+// to be effective on the TCP window, it must be set before connecting
+bool
+net_set_recv_buffer_size(socket_t socket, int size);
+
+// set the timeout of the blocking receive and send calls (SO_RCVTIMEO and
+// SO_SNDTIMEO), so that a stalled peer cannot block the caller forever
+bool
+net_set_timeout(socket_t socket, uint32_t timeout_ms);
+
+// poll the network device for up to usec microseconds on blocking receive,
+// instead of waiting for an interrupt (SO_BUSY_POLL, Linux only)
+// it reduces latency at the cost of CPU usage
+bool
+net_set_busy_poll(socket_t socket, unsigned usec);
+
+// parse an IPv4 address in dotted-decimal notation (e.g. "192.168.1.2")
+// the result is in host byte order
+bool
+net_parse_ipv4(const char *s, uint32_t *ipv4);
+
 #endif
@@ -0,0 +1,19 @@
+#ifndef TICK_H
+#define TICK_H
+
+#include <stdint.h>
+#include <SDL2/SDL_timer.h>
+
+#include "config.h"
+
+// monotonic time in µs (SDL_GetTicks() is in ms, too coarse for latencies)
+static inline uint64_t
+tick_now_us(void) {
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t counter = SDL_GetPerformanceCounter();
+    // avoid overflow of counter * 1000000
+    return counter / frequency * 1000000
+         + counter % frequency * 1000000 / frequency;
+}
+
+#endif
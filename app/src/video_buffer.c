@@ -1,11 +1,14 @@
 #include "video_buffer.h"
 
 #include <assert.h>
+#include <string.h>
 #include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_stdinc.h>
 #include <libavutil/avutil.h>
 #include <libavformat/avformat.h>
 
 #include "config.h"
+#include "metrics.h"
 #include "util/lock.h"
 #include "util/log.h"
 
@@ -41,6 +44,10 @@ video_buffer_init(struct video_buffer *vb, struct fps_counter *fps_counter,
     // consumed
     vb->rendering_frame_consumed = true;
 
+    vb->skipped_frames = 0;
+    vb->consumed_pts = AV_NOPTS_VALUE;
+    vb->consumed_skipped_frames = 0;
+
     return true;
 
 error_2:
@@ -79,6 +86,8 @@ video_buffer_offer_decoded_frame(struct video_buffer *vb,
         }
     } else if (!vb->rendering_frame_consumed) {
         fps_counter_add_skipped_frame(vb->fps_counter);
+        metrics_inc(METRIC_FRAMES_SKIPPED);
+        ++vb->skipped_frames;
     }
 
     video_buffer_swap_frames(vb);
@@ -94,6 +103,10 @@ video_buffer_consume_rendered_frame(struct video_buffer *vb) {
     assert(!vb->rendering_frame_consumed);
     vb->rendering_frame_consumed = true;
     fps_counter_add_rendered_frame(vb->fps_counter);
+    metrics_inc(METRIC_FRAMES_RENDERED);
+    vb->consumed_pts = vb->rendering_frame->pts;
+    vb->consumed_skipped_frames = vb->skipped_frames;
+    vb->skipped_frames = 0;
     if (vb->render_expired_frames) {
         // unblock video_buffer_offer_decoded_frame()
         cond_signal(vb->rendering_frame_consumed_cond);
@@ -111,3 +124,62 @@ video_buffer_interrupt(struct video_buffer *vb) {
         cond_signal(vb->rendering_frame_consumed_cond);
     }
 }
+
+struct size
+video_buffer_get_frame_size(struct video_buffer *vb) {
+    struct size size = {0, 0};
+    mutex_lock(vb->mutex);
+    // the rendering frame is the last decoded one (whether consumed or not)
+    if (vb->rendering_frame->data[0]) {
+        size.width = vb->rendering_frame->width;
+        size.height = vb->rendering_frame->height;
+    }
+    mutex_unlock(vb->mutex);
+    return size;
+}
+
+static uint8_t *
+copy_plane(uint8_t *dst, const uint8_t *src, int linesize, int width,
+           int height) {
+    for (int y = 0; y < height; ++y) {
+        memcpy(dst, src, width);
+        dst += width;
+        src += linesize;
+    }
+    return dst;
+}
+
+bool
+video_buffer_copy_frame(struct video_buffer *vb, uint8_t **data, size_t *len,
+                        struct size *size) {
+    mutex_lock(vb->mutex);
+    const AVFrame *frame = vb->rendering_frame;
+    if (!frame->data[0]) {
+        mutex_unlock(vb->mutex);
+        return false;
+    }
+
+    // the decoded frames are YUV420P (as expected by the screen texture)
+    int w = frame->width;
+    int h = frame->height;
+    int cw = (w + 1) / 2;
+    int ch = (h + 1) / 2;
+    size_t frame_len = (size_t) w * h + 2 * (size_t) cw * ch;
+    uint8_t *buf = SDL_malloc(frame_len);
+    if (!buf) {
+        mutex_unlock(vb->mutex);
+        LOGW("Could not allocate frame copy");
+        return false;
+    }
+
+    uint8_t *p = copy_plane(buf, frame->data[0], frame->linesize[0], w, h);
+    p = copy_plane(p, frame->data[1], frame->linesize[1], cw, ch);
+    copy_plane(p, frame->data[2], frame->linesize[2], cw, ch);
+    mutex_unlock(vb->mutex);
+
+    *data = buf;
+    *len = frame_len;
+    size->width = w;
+    size->height = h;
+    return true;
+}
@@ -2,9 +2,11 @@
 #define VIDEO_BUFFER_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <SDL2/SDL_mutex.h>
 
 #include "config.h"
+#include "common.h"
 #include "fps_counter.h"
 
 // forward declarations
@@ -19,6 +21,13 @@ struct video_buffer {
     SDL_cond *rendering_frame_consumed_cond;
     bool rendering_frame_consumed;
     struct fps_counter *fps_counter;
+
+    // number of frames skipped since the last consumed frame
+    unsigned skipped_frames;
+    // PTS of the last consumed frame, and the number of frames skipped
+    // before it (only accessed by the consumer)
+    int64_t consumed_pts;
+    unsigned consumed_skipped_frames;
 };
 
 bool
@@ -42,6 +51,19 @@ video_buffer_offer_decoded_frame(struct video_buffer *vb,
 const AVFrame *
 video_buffer_consume_rendered_frame(struct video_buffer *vb);
 
+// the size of the last decoded frame (0x0 if there is none yet)
+// this function locks frames->mutex during its execution
+struct size
+video_buffer_get_frame_size(struct video_buffer *vb);
+
+// copy the last decoded frame as raw YUV 4:2:0 planar (I420), without padding
+// the buffer is allocated by SDL_malloc() and must be released by SDL_free()
+// return false if there is no frame yet (or on allocation failure)
+// this function locks frames->mutex during its execution
+bool
+video_buffer_copy_frame(struct video_buffer *vb, uint8_t **data, size_t *len,
+                        struct size *size);
+
 // wake up and avoid any blocking call
 void
 video_buffer_interrupt(struct video_buffer *vb);
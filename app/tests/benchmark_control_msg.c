@@ -0,0 +1,95 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <SDL2/SDL_timer.h>
+
+#include "control_msg.h"
+
+// Measure the size and the serialization throughput of both control message
+// encodings, for a synthetic stream of input events: a two-finger pinch (the
+// fingers moving alternately), a mouse drag and a few keys.
+
+#define EVENT_COUNT 1000000
+#define ROUNDS 4
+
+static void
+init_event(struct control_msg *msg, int i) {
+    int step = i % 1000;
+    if (step < 900) {
+        // pinch: fingers 0 and 1 move alternately, a few pixels at a time
+        int finger = step % 2;
+        int offset = step / 2;
+        msg->type = CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT;
+        msg->inject_touch_event.action = step < 2 ? AMOTION_EVENT_ACTION_DOWN
+                                                  : AMOTION_EVENT_ACTION_MOVE;
+        msg->inject_touch_event.pointer_id = finger;
+        msg->inject_touch_event.position.screen_size.width = 1080;
+        msg->inject_touch_event.position.screen_size.height = 2340;
+        msg->inject_touch_event.position.point.x =
+            finger ? 600 + offset : 480 - offset;
+        msg->inject_touch_event.position.point.y =
+            finger ? 1200 + offset * 2 : 1100 - offset * 2;
+        msg->inject_touch_event.pressure = 1.f;
+        msg->inject_touch_event.buttons = 0;
+    } else if (step < 990) {
+        // mouse drag
+        msg->type = CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT;
+        msg->inject_touch_event.action = AMOTION_EVENT_ACTION_MOVE;
+        msg->inject_touch_event.pointer_id = POINTER_ID_MOUSE;
+        msg->inject_touch_event.position.screen_size.width = 1080;
+        msg->inject_touch_event.position.screen_size.height = 2340;
+        msg->inject_touch_event.position.point.x = 100 + (step - 900) * 3;
+        msg->inject_touch_event.position.point.y = 300 + (step - 900);
+        msg->inject_touch_event.pressure = 1.f;
+        msg->inject_touch_event.buttons = AMOTION_EVENT_BUTTON_PRIMARY;
+    } else {
+        msg->type = CONTROL_MSG_TYPE_INJECT_KEYCODE;
+        msg->inject_keycode.action = step % 2 ? AKEY_EVENT_ACTION_UP
+                                              : AKEY_EVENT_ACTION_DOWN;
+        msg->inject_keycode.keycode = AKEYCODE_A;
+        msg->inject_keycode.repeat = 0;
+        msg->inject_keycode.metastate = 0;
+    }
+}
+
+static void
+run(enum control_msg_encoding encoding, const char *name) {
+    static unsigned char buf[CONTROL_MSG_MAX_SIZE];
+    static struct control_msg msgs[1000];
+    for (int i = 0; i < 1000; ++i) {
+        init_event(&msgs[i], i);
+    }
+
+    uint64_t bytes = 0;
+    uint32_t best = UINT32_MAX;
+    for (int round = 0; round < ROUNDS; ++round) {
+        struct control_msg_encoder encoder;
+        control_msg_encoder_init(&encoder, encoding);
+
+        bytes = 0;
+        uint32_t start = SDL_GetTicks();
+        for (int i = 0; i < EVENT_COUNT; ++i) {
+            size_t len = control_msg_encode(&encoder, &msgs[i % 1000], buf);
+            assert(len);
+            bytes += len;
+        }
+        uint32_t elapsed = SDL_GetTicks() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    printf("%-7s %.2f bytes/event, %d events in %" PRIu32 " ms: "
+           "%.1f Mevents/s\n", name, (double) bytes / EVENT_COUNT,
+           EVENT_COUNT, best,
+           best ? EVENT_COUNT / 1000.0 / best : 0.0);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    run(CONTROL_MSG_ENCODING_LEGACY, "legacy");
+    run(CONTROL_MSG_ENCODING_COMPACT, "compact");
+    return 0;
+}
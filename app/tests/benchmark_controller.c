@@ -0,0 +1,135 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_timer.h>
+
+#include "controller.h"
+#include "util/net.h"
+
+// Measure the throughput of the controller (messages per second) and the
+// number of send calls per message, for a burst of key events sent to a local
+// socket sink, in both control message encodings.
+//
+// Key events are never merged nor dropped (contrary to touch moves), so that
+// every message pushed is sent.
+
+#define IPV4_LOCALHOST 0x7F000001
+#define MSG_COUNT 200000
+
+struct sink {
+    socket_t socket;
+    uint64_t expected_bytes;
+    uint64_t received_bytes;
+};
+
+static int
+run_sink(void *data) {
+    struct sink *sink = data;
+    static char buf[0x10000];
+    while (sink->received_bytes < sink->expected_bytes) {
+        ssize_t r = net_recv(sink->socket, buf, sizeof(buf));
+        if (r <= 0) {
+            break;
+        }
+        sink->received_bytes += r;
+    }
+    return 0;
+}
+
+static socket_t
+listen_on_any_port(uint16_t *port) {
+    for (uint16_t p = 27500; p < 27600; ++p) {
+        socket_t server_socket = net_listen(IPV4_LOCALHOST, p, 1);
+        if (server_socket != INVALID_SOCKET) {
+            *port = p;
+            return server_socket;
+        }
+    }
+    return INVALID_SOCKET;
+}
+
+static void
+init_key_msg(struct control_msg *msg, int i) {
+    msg->type = CONTROL_MSG_TYPE_INJECT_KEYCODE;
+    msg->inject_keycode.action = i % 2 ? AKEY_EVENT_ACTION_UP
+                                       : AKEY_EVENT_ACTION_DOWN;
+    msg->inject_keycode.keycode = AKEYCODE_A;
+    msg->inject_keycode.repeat = 0;
+    msg->inject_keycode.metastate = 0;
+}
+
+static void
+run(enum control_msg_encoding encoding, const char *name) {
+    uint16_t port;
+    socket_t server_socket = listen_on_any_port(&port);
+    assert(server_socket != INVALID_SOCKET);
+    socket_t control_socket = net_connect(IPV4_LOCALHOST, port);
+    assert(control_socket != INVALID_SOCKET);
+    net_set_tcp_nodelay(control_socket, true);
+
+    struct control_msg msg;
+    init_key_msg(&msg, 0);
+    static unsigned char buf[CONTROL_MSG_MAX_SIZE];
+    // key events are stateless, they have the same size in a stream
+    struct control_msg_encoder encoder;
+    control_msg_encoder_init(&encoder, encoding);
+    size_t msg_size = control_msg_encode(&encoder, &msg, buf);
+
+    struct sink sink = {
+        .socket = net_accept(server_socket),
+        .expected_bytes = (uint64_t) msg_size * MSG_COUNT,
+        .received_bytes = 0,
+    };
+    assert(sink.socket != INVALID_SOCKET);
+
+    struct controller controller;
+    bool ok = controller_init(&controller, control_socket, encoding, NULL,
+                              NULL, NULL);
+    assert(ok);
+    ok = controller_start(&controller);
+    assert(ok);
+
+    SDL_Thread *sink_thread = SDL_CreateThread(run_sink, "sink", &sink);
+    assert(sink_thread);
+
+    uint32_t start = SDL_GetTicks();
+    for (int i = 0; i < MSG_COUNT; ++i) {
+        init_key_msg(&msg, i);
+        ok = controller_push_msg(&controller, &msg);
+        assert(ok);
+    }
+    SDL_WaitThread(sink_thread, NULL);
+    uint32_t elapsed = SDL_GetTicks() - start;
+    assert(sink.received_bytes == sink.expected_bytes);
+
+    controller_stop(&controller);
+    // wake up the receiver
+    net_shutdown(control_socket, SHUT_RDWR);
+    controller_join(&controller);
+
+    printf("%-7s %d messages (%zu bytes each) in %" PRIu32 " ms: "
+           "%.0f messages/s, %.3f send calls per message\n", name, MSG_COUNT,
+           msg_size, elapsed,
+           elapsed ? MSG_COUNT * 1000.0 / elapsed : 0.0,
+           (double) controller.send_calls / controller.sent_msgs);
+
+    controller_destroy(&controller);
+    net_close(control_socket);
+    net_close(sink.socket);
+    net_close(server_socket);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    bool ok = net_init();
+    assert(ok);
+
+    run(CONTROL_MSG_ENCODING_LEGACY, "legacy");
+    run(CONTROL_MSG_ENCODING_COMPACT, "compact");
+
+    net_cleanup();
+    return 0;
+}
@@ -0,0 +1,355 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL_stdinc.h>
+#include <SDL2/SDL_thread.h>
+
+#include "adb_client.h"
+#include "util/buffer_util.h"
+#include "util/net.h"
+
+#define IPV4_LOCALHOST 0x7F000001
+
+// a fake adb server, replying to the requests of the adb client
+struct fake_adb {
+    socket_t server_socket;
+    uint16_t port;
+    SDL_Thread *thread;
+    int connections; // number of connections to serve
+    const char *fail_prefix; // reply FAIL to requests starting with it
+    // all received requests, separated by '\n'
+    char requests[4096];
+    size_t requests_len;
+    // the file received by "sync:"
+    char pushed_path[256];
+    char pushed_data[256];
+    size_t pushed_len;
+    bool quit_received;
+};
+
+static bool
+starts_with(const char *s, const char *prefix) {
+    return !strncmp(s, prefix, strlen(prefix));
+}
+
+static bool
+read_request(socket_t socket, char *request, size_t size) {
+    char hex[5] = {0};
+    if (net_recv_all(socket, hex, 4) != 4) {
+        return false;
+    }
+    size_t len = strtoul(hex, NULL, 16);
+    assert(len < size);
+    if (len && net_recv_all(socket, request, len) != (ssize_t) len) {
+        return false;
+    }
+    request[len] = '\0';
+    return true;
+}
+
+static void
+send_str(socket_t socket, const char *s) {
+    ssize_t w = net_send_all(socket, s, strlen(s));
+    assert(w == (ssize_t) strlen(s));
+    (void) w;
+}
+
+static void
+serve_sync(struct fake_adb *adb, socket_t socket) {
+    uint8_t header[8];
+    while (net_recv_all(socket, header, 8) == 8) {
+        uint32_t len = buffer_read32le(&header[4]);
+        if (!memcmp(header, "SEND", 4)) {
+            assert(len < sizeof(adb->pushed_path));
+            net_recv_all(socket, adb->pushed_path, len);
+            adb->pushed_path[len] = '\0';
+        } else if (!memcmp(header, "DATA", 4)) {
+            assert(adb->pushed_len + len <= sizeof(adb->pushed_data));
+            net_recv_all(socket, &adb->pushed_data[adb->pushed_len], len);
+            adb->pushed_len += len;
+        } else if (!memcmp(header, "DONE", 4)) {
+            uint8_t okay[8] = {'O', 'K', 'A', 'Y', 0, 0, 0, 0};
+            net_send_all(socket, okay, sizeof(okay));
+        } else if (!memcmp(header, "STAT", 4)) {
+            char path[256];
+            assert(len < sizeof(path));
+            net_recv_all(socket, path, len);
+            path[len] = '\0';
+            // only "/existing" exists, its size is 1234
+            bool exists = !strcmp(path, "/existing");
+            uint8_t reply[16] = {'S', 'T', 'A', 'T'};
+            buffer_write32le(&reply[4], exists ? 0100644 : 0);
+            buffer_write32le(&reply[8], exists ? 1234 : 0);
+            buffer_write32le(&reply[12], exists ? 1600000000 : 0);
+            net_send_all(socket, reply, sizeof(reply));
+        } else if (!memcmp(header, "QUIT", 4)) {
+            adb->quit_received = true;
+            return;
+        } else {
+            assert(!"unexpected sync packet");
+        }
+    }
+}
+
+static void
+serve_connection(struct fake_adb *adb, socket_t socket) {
+    char request[1024];
+    while (read_request(socket, request, sizeof(request))) {
+        size_t len = strlen(request);
+        assert(adb->requests_len + len + 1 < sizeof(adb->requests));
+        memcpy(&adb->requests[adb->requests_len], request, len);
+        adb->requests_len += len;
+        adb->requests[adb->requests_len++] = '\n';
+        adb->requests[adb->requests_len] = '\0';
+
+        if (adb->fail_prefix && starts_with(request, adb->fail_prefix)) {
+            send_str(socket, "FAIL0005error");
+            return;
+        }
+
+        if (starts_with(request, "host:transport")) {
+            // the next request is for the device
+            send_str(socket, "OKAY");
+        } else if (!strcmp(request, "sync:")) {
+            send_str(socket, "OKAY");
+            serve_sync(adb, socket);
+            return;
+        } else if (starts_with(request, "shell:")) {
+            send_str(socket, "OKAYhello\n");
+            return;
+        } else {
+            // forward, killforward, reverse: one status for the service, one
+            // for the operation
+            send_str(socket, "OKAYOKAY");
+            return;
+        }
+    }
+}
+
+static int
+run_fake_adb(void *data) {
+    struct fake_adb *adb = data;
+    for (int i = 0; i < adb->connections; ++i) {
+        socket_t socket = net_accept(adb->server_socket);
+        assert(socket != INVALID_SOCKET);
+        serve_connection(adb, socket);
+        net_close(socket);
+    }
+    return 0;
+}
+
+static void
+fake_adb_start(struct fake_adb *adb, int connections) {
+    memset(adb, 0, sizeof(*adb));
+    adb->server_socket = INVALID_SOCKET;
+    for (uint16_t p = 27400; p < 27500; ++p) {
+        adb->server_socket = net_listen(IPV4_LOCALHOST, p, 1);
+        if (adb->server_socket != INVALID_SOCKET) {
+            adb->port = p;
+            break;
+        }
+    }
+    assert(adb->server_socket != INVALID_SOCKET);
+
+    char port[6];
+    sprintf(port, "%d", (int) adb->port);
+    SDL_setenv("ANDROID_ADB_SERVER_PORT", port, 1);
+
+    adb->connections = connections;
+    adb->thread = SDL_CreateThread(run_fake_adb, "fake-adb", adb);
+    assert(adb->thread);
+}
+
+static void
+fake_adb_join(struct fake_adb *adb) {
+    SDL_WaitThread(adb->thread, NULL);
+    net_close(adb->server_socket);
+}
+
+static void test_server_port(void) {
+    SDL_setenv("ANDROID_ADB_SERVER_PORT", "5038", 1);
+    assert(adb_client_get_server_port() == 5038);
+
+    SDL_setenv("ANDROID_ADB_SERVER_PORT", "invalid", 1);
+    assert(adb_client_get_server_port() == ADB_CLIENT_DEFAULT_SERVER_PORT);
+}
+
+static void test_reverse(void) {
+    struct fake_adb adb;
+    fake_adb_start(&adb, 2);
+
+    enum adb_client_result r = adb_client_reverse("0123456789", "scrcpy",
+                                                  27183);
+    assert(r == ADB_CLIENT_SUCCESS);
+    r = adb_client_reverse_remove("0123456789", "scrcpy");
+    assert(r == ADB_CLIENT_SUCCESS);
+
+    fake_adb_join(&adb);
+    assert(!strcmp(adb.requests,
+                   "host:transport:0123456789\n"
+                   "reverse:forward:localabstract:scrcpy;tcp:27183\n"
+                   "host:transport:0123456789\n"
+                   "reverse:killforward:localabstract:scrcpy\n"));
+}
+
+static void test_forward(void) {
+    struct fake_adb adb;
+    fake_adb_start(&adb, 3);
+
+    enum adb_client_result r = adb_client_forward("0123456789", 27183,
+                                                  "scrcpy");
+    assert(r == ADB_CLIENT_SUCCESS);
+    r = adb_client_forward_remove("0123456789", 27183);
+    assert(r == ADB_CLIENT_SUCCESS);
+    r = adb_client_forward(NULL, 27184, "scrcpy");
+    assert(r == ADB_CLIENT_SUCCESS);
+
+    fake_adb_join(&adb);
+    assert(!strcmp(adb.requests,
+                   "host-serial:0123456789:forward:tcp:27183;"
+                       "localabstract:scrcpy\n"
+                   "host-serial:0123456789:killforward:tcp:27183\n"
+                   "host:forward:tcp:27184;localabstract:scrcpy\n"));
+}
+
+static void test_failure(void) {
+    struct fake_adb adb;
+    fake_adb_start(&adb, 1);
+    adb.fail_prefix = "reverse:";
+
+    enum adb_client_result r = adb_client_reverse(NULL, "scrcpy", 27183);
+    assert(r == ADB_CLIENT_ERROR);
+
+    fake_adb_join(&adb);
+    assert(!strcmp(adb.requests,
+                   "host:transport-any\n"
+                   "reverse:forward:localabstract:scrcpy;tcp:27183\n"));
+}
+
+static void test_serial_from_env(void) {
+    struct fake_adb adb;
+    fake_adb_start(&adb, 3);
+
+    SDL_setenv("ANDROID_SERIAL", "emulator-5554", 1);
+    enum adb_client_result r = adb_client_reverse(NULL, "scrcpy", 27183);
+    assert(r == ADB_CLIENT_SUCCESS);
+    r = adb_client_forward(NULL, 27183, "scrcpy");
+    assert(r == ADB_CLIENT_SUCCESS);
+    // an explicit serial takes precedence
+    r = adb_client_forward_remove("0123456789", 27183);
+    assert(r == ADB_CLIENT_SUCCESS);
+    SDL_setenv("ANDROID_SERIAL", "", 1);
+
+    fake_adb_join(&adb);
+    assert(!strcmp(adb.requests,
+                   "host:transport:emulator-5554\n"
+                   "reverse:forward:localabstract:scrcpy;tcp:27183\n"
+                   "host-serial:emulator-5554:forward:tcp:27183;"
+                       "localabstract:scrcpy\n"
+                   "host-serial:0123456789:killforward:tcp:27183\n"));
+}
+
+static void test_shell(void) {
+    struct fake_adb adb;
+    fake_adb_start(&adb, 1);
+
+    const char *const cmd[] = {"echo", "hello"};
+    socket_t socket;
+    enum adb_client_result r = adb_client_shell("0123456789", cmd, 2, &socket);
+    assert(r == ADB_CLIENT_SUCCESS);
+
+    char output[6];
+    ssize_t rr = net_recv_all(socket, output, sizeof(output));
+    assert(rr == sizeof(output));
+    assert(!memcmp(output, "hello\n", 6));
+    net_close(socket);
+
+    fake_adb_join(&adb);
+    assert(!strcmp(adb.requests,
+                   "host:transport:0123456789\n"
+                   "shell:echo hello\n"));
+}
+
+static void test_push(void) {
+    char local[] = "test_adb_client_push.tmp";
+    FILE *file = fopen(local, "wb");
+    assert(file);
+    const char content[] = "scrcpy-server content";
+    size_t w = fwrite(content, 1, sizeof(content), file);
+    assert(w == sizeof(content));
+    fclose(file);
+
+    struct fake_adb adb;
+    fake_adb_start(&adb, 1);
+
+    enum adb_client_result r =
+        adb_client_push("0123456789", local, "/data/local/tmp/server.jar");
+    assert(r == ADB_CLIENT_SUCCESS);
+
+    fake_adb_join(&adb);
+    remove(local);
+
+    assert(!strcmp(adb.requests,
+                   "host:transport:0123456789\n"
+                   "sync:\n"));
+    // 0100644 in decimal
+    assert(!strcmp(adb.pushed_path, "/data/local/tmp/server.jar,33188"));
+    assert(adb.pushed_len == sizeof(content));
+    assert(!memcmp(adb.pushed_data, content, sizeof(content)));
+    assert(adb.quit_received);
+}
+
+static void test_stat(void) {
+    struct fake_adb adb;
+    fake_adb_start(&adb, 2);
+
+    bool exists;
+    uint32_t size;
+    enum adb_client_result r =
+        adb_client_stat("0123456789", "/existing", &exists, &size);
+    assert(r == ADB_CLIENT_SUCCESS);
+    assert(exists);
+    assert(size == 1234);
+
+    r = adb_client_stat("0123456789", "/missing", &exists, &size);
+    assert(r == ADB_CLIENT_SUCCESS);
+    assert(!exists);
+
+    fake_adb_join(&adb);
+    assert(adb.quit_received);
+}
+
+static void test_unavailable(void) {
+    struct fake_adb adb;
+    fake_adb_start(&adb, 0);
+    fake_adb_join(&adb);
+    // nobody listens anymore on the configured port
+
+    enum adb_client_result r = adb_client_forward(NULL, 27183, "scrcpy");
+    assert(r == ADB_CLIENT_ERROR_UNAVAILABLE);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    bool ok = net_init();
+    assert(ok);
+
+    // the tests without serial must not depend on the environment
+    SDL_setenv("ANDROID_SERIAL", "", 1);
+
+    test_server_port();
+    test_reverse();
+    test_forward();
+    test_failure();
+    test_serial_from_env();
+    test_shell();
+    test_push();
+    test_stat();
+    test_unavailable();
+
+    net_cleanup();
+    return 0;
+}
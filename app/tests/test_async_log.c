@@ -0,0 +1,157 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL_log.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_timer.h>
+
+#include "async_log.h"
+#include "util/log.h"
+
+// the messages received by the initial output function, separated by '\n'
+static char output[64 * 1024];
+static size_t output_len;
+
+static void
+capture_output(void *userdata, int category, SDL_LogPriority priority,
+               const char *message) {
+    (void) userdata;
+    (void) category;
+    (void) priority;
+    size_t len = strlen(message);
+    assert(output_len + len + 1 < sizeof(output));
+    memcpy(&output[output_len], message, len);
+    output_len += len;
+    output[output_len++] = '\n';
+    output[output_len] = '\0';
+}
+
+static void
+start(void) {
+    output_len = 0;
+    output[0] = '\0';
+    SDL_LogSetOutputFunction(capture_output, NULL);
+    bool ok = async_log_init();
+    assert(ok);
+}
+
+static void
+stop(void) {
+    async_log_destroy();
+    // the initial output function is restored
+    SDL_LogOutputFunction fn;
+    SDL_LogGetOutputFunction(&fn, NULL);
+    assert(fn == capture_output);
+}
+
+static void test_order(void) {
+    start();
+    LOGI("first");
+    LOGW("second %d", 2);
+    LOGE("third");
+    stop();
+
+    assert(!strcmp(output, "first\nsecond 2\nthird\n"));
+}
+
+static void test_repeats(void) {
+    start();
+    LOGE("Could not decode");
+    LOGE("Could not decode");
+    LOGE("Could not decode");
+    LOGI("other");
+    LOGI("other");
+    stop();
+
+    assert(!strcmp(output, "Could not decode\n"
+                           "Last message repeated 2 times\n"
+                           "other\n"
+                           "Last message repeated 1 times\n"));
+}
+
+static void test_truncated(void) {
+    static char big[ASYNC_LOG_MESSAGE_SIZE * 2];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+
+    start();
+    LOGI("%s", big);
+    stop();
+
+    assert(output_len == ASYNC_LOG_MESSAGE_SIZE); // including '\n'
+}
+
+static void test_rate_limit(void) {
+    start();
+    for (int i = 0; i < ASYNC_LOG_RATE_LIMIT + 20; ++i) {
+        LOGI("message %d", i);
+        if (i % 32 == 31) {
+            // let the writer drain the queue, so that no message is dropped
+            SDL_Delay(20);
+        }
+    }
+    stop();
+
+    char expected[64];
+    sprintf(expected, "message %d\n", ASYNC_LOG_RATE_LIMIT - 1);
+    assert(strstr(output, expected));
+    sprintf(expected, "message %d\n", ASYNC_LOG_RATE_LIMIT);
+    assert(!strstr(output, expected));
+    sprintf(expected, "20 log messages suppressed (more than %d per second)\n",
+            ASYNC_LOG_RATE_LIMIT);
+    assert(strstr(output, expected));
+}
+
+static int
+run_producer(void *data) {
+    int id = *(int *) data;
+    for (int i = 0; i < 1000; ++i) {
+        LOGI("producer %d message %d", id, i);
+    }
+    return 0;
+}
+
+static void test_concurrent(void) {
+    start();
+    int ids[4] = {0, 1, 2, 3};
+    SDL_Thread *threads[4];
+    for (int i = 0; i < 4; ++i) {
+        threads[i] = SDL_CreateThread(run_producer, "producer", &ids[i]);
+        assert(threads[i]);
+    }
+    for (int i = 0; i < 4; ++i) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    stop();
+
+    // whatever the number of messages written, suppressed or dropped, the
+    // messages are never corrupted
+    const char *line = output;
+    unsigned count = 0;
+    while (*line) {
+        const char *end = strchr(line, '\n');
+        assert(end);
+        int id, i;
+        if (sscanf(line, "producer %d message %d", &id, &i) == 2) {
+            assert(id >= 0 && id < 4);
+            assert(i >= 0 && i < 1000);
+            ++count;
+        } else {
+            assert(strstr(line, "log messages"));
+        }
+        line = end + 1;
+    }
+    assert(count > 0);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    test_order();
+    test_repeats();
+    test_truncated();
+    test_rate_limit();
+    test_concurrent();
+    return 0;
+}
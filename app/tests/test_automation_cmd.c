@@ -0,0 +1,171 @@
+#include <assert.h>
+#include <string.h>
+#include <SDL2/SDL_stdinc.h>
+
+#include "automation_cmd.h"
+
+static const struct size frame_size = {
+    .width = 1080,
+    .height = 1920,
+};
+
+static bool
+parse(const char *line, struct automation_cmd *cmd, const char **error) {
+    char buf[256];
+    assert(strlen(line) < sizeof(buf));
+    strcpy(buf, line);
+    return automation_cmd_parse(buf, frame_size, cmd, error);
+}
+
+static void test_key(void) {
+    struct automation_cmd cmd;
+    const char *error;
+    bool ok = parse("key down 66 1", &cmd, &error);
+    assert(ok);
+    assert(cmd.type == AUTOMATION_CMD_INPUT);
+    assert(cmd.msg_count == 1);
+    assert(cmd.msgs[0].type == CONTROL_MSG_TYPE_INJECT_KEYCODE);
+    assert(cmd.msgs[0].inject_keycode.action == AKEY_EVENT_ACTION_DOWN);
+    assert(cmd.msgs[0].inject_keycode.keycode == AKEYCODE_ENTER);
+    assert(cmd.msgs[0].inject_keycode.metastate == AMETA_SHIFT_ON);
+
+    ok = parse("key press 4", &cmd, &error);
+    assert(ok);
+    assert(cmd.msg_count == 2);
+    assert(cmd.msgs[0].inject_keycode.action == AKEY_EVENT_ACTION_DOWN);
+    assert(cmd.msgs[1].inject_keycode.action == AKEY_EVENT_ACTION_UP);
+    assert(cmd.msgs[1].inject_keycode.keycode == AKEYCODE_BACK);
+    assert(cmd.msgs[1].inject_keycode.metastate == 0);
+
+    ok = parse("key hold 4", &cmd, &error);
+    assert(!ok);
+    assert(!strcmp(error, "invalid key action"));
+
+    ok = parse("key up abc", &cmd, &error);
+    assert(!ok);
+    assert(!strcmp(error, "invalid keycode"));
+}
+
+static void test_text(void) {
+    struct automation_cmd cmd;
+    const char *error;
+    bool ok = parse("text hello  world", &cmd, &error);
+    assert(ok);
+    assert(cmd.msg_count == 1);
+    assert(cmd.msgs[0].type == CONTROL_MSG_TYPE_INJECT_TEXT);
+    // spaces are preserved
+    assert(!strcmp(cmd.msgs[0].inject_text.text, "hello  world"));
+    SDL_free(cmd.msgs[0].inject_text.text);
+
+    ok = parse("text", &cmd, &error);
+    assert(!ok);
+    assert(!strcmp(error, "empty text"));
+}
+
+static void test_touch(void) {
+    struct automation_cmd cmd;
+    const char *error;
+    bool ok = parse("touch move 2 100 200", &cmd, &error);
+    assert(ok);
+    assert(cmd.msg_count == 1);
+    assert(cmd.msgs[0].type == CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT);
+    assert(cmd.msgs[0].inject_touch_event.action == AMOTION_EVENT_ACTION_MOVE);
+    assert(cmd.msgs[0].inject_touch_event.pointer_id == 2);
+    assert(cmd.msgs[0].inject_touch_event.position.point.x == 100);
+    assert(cmd.msgs[0].inject_touch_event.position.point.y == 200);
+    assert(cmd.msgs[0].inject_touch_event.position.screen_size.width == 1080);
+    assert(cmd.msgs[0].inject_touch_event.position.screen_size.height == 1920);
+    assert(cmd.msgs[0].inject_touch_event.pressure == 1.f);
+
+    // out of the frame
+    ok = parse("touch down 0 1080 0", &cmd, &error);
+    assert(!ok);
+    assert(!strcmp(error, "invalid position"));
+
+    ok = parse("touch down 0 10 10 1", &cmd, &error);
+    assert(!ok);
+    assert(!strcmp(error, "too many arguments"));
+}
+
+static void test_tap(void) {
+    struct automation_cmd cmd;
+    const char *error;
+    bool ok = parse("tap 540 960", &cmd, &error);
+    assert(ok);
+    assert(cmd.msg_count == 2);
+    assert(cmd.msgs[0].inject_touch_event.action == AMOTION_EVENT_ACTION_DOWN);
+    assert(cmd.msgs[1].inject_touch_event.action == AMOTION_EVENT_ACTION_UP);
+    assert(cmd.msgs[1].inject_touch_event.position.point.x == 540);
+    assert(cmd.msgs[1].inject_touch_event.position.point.y == 960);
+    assert(cmd.msgs[1].inject_touch_event.pressure == 0.f);
+
+    // no frame received yet
+    char line[] = "tap 0 0";
+    struct size no_size = {0, 0};
+    ok = automation_cmd_parse(line, no_size, &cmd, &error);
+    assert(!ok);
+    assert(!strcmp(error, "no frame received yet"));
+}
+
+static void test_scroll(void) {
+    struct automation_cmd cmd;
+    const char *error;
+    bool ok = parse("scroll 10 20 0 -3", &cmd, &error);
+    assert(ok);
+    assert(cmd.msg_count == 1);
+    assert(cmd.msgs[0].type == CONTROL_MSG_TYPE_INJECT_SCROLL_EVENT);
+    assert(cmd.msgs[0].inject_scroll_event.hscroll == 0);
+    assert(cmd.msgs[0].inject_scroll_event.vscroll == -3);
+}
+
+static void test_queries(void) {
+    struct automation_cmd cmd;
+    const char *error;
+    bool ok = parse("back", &cmd, &error);
+    assert(ok);
+    assert(cmd.type == AUTOMATION_CMD_INPUT);
+    assert(cmd.msg_count == 1);
+    assert(cmd.msgs[0].type == CONTROL_MSG_TYPE_BACK_OR_SCREEN_ON);
+
+    ok = parse("get size", &cmd, &error);
+    assert(ok);
+    assert(cmd.type == AUTOMATION_CMD_GET_SIZE);
+    assert(cmd.msg_count == 0);
+
+    ok = parse("  get   frame  ", &cmd, &error);
+    assert(ok);
+    assert(cmd.type == AUTOMATION_CMD_GET_FRAME);
+
+    ok = parse("get stats", &cmd, &error);
+    assert(ok);
+    assert(cmd.type == AUTOMATION_CMD_GET_STATS);
+
+    ok = parse("sync", &cmd, &error);
+    assert(ok);
+    assert(cmd.type == AUTOMATION_CMD_SYNC);
+
+    ok = parse("get battery", &cmd, &error);
+    assert(!ok);
+    assert(!strcmp(error, "invalid query"));
+
+    ok = parse("", &cmd, &error);
+    assert(!ok);
+    assert(!strcmp(error, "empty command"));
+
+    ok = parse("swipe 0 0 1 1", &cmd, &error);
+    assert(!ok);
+    assert(!strcmp(error, "unknown command"));
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    test_key();
+    test_text();
+    test_touch();
+    test_tap();
+    test_scroll();
+    test_queries();
+    return 0;
+}
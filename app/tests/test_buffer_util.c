@@ -40,6 +40,18 @@ static void test_buffer_write64be(void) {
     assert(buf[7] == 0xEF);
 }
 
+static void test_buffer_write32le(void) {
+    uint32_t val = 0xABCD1234;
+    uint8_t buf[4];
+
+    buffer_write32le(buf, val);
+
+    assert(buf[0] == 0x34);
+    assert(buf[1] == 0x12);
+    assert(buf[2] == 0xCD);
+    assert(buf[3] == 0xAB);
+}
+
 static void test_buffer_read16be(void) {
     uint8_t buf[2] = {0xAB, 0xCD};
 
@@ -65,6 +77,52 @@ static void test_buffer_read64be(void) {
     assert(val == 0xABCD1234567890EF);
 }
 
+static void test_buffer_read32le(void) {
+    uint8_t buf[4] = {0x34, 0x12, 0xCD, 0xAB};
+
+    uint32_t val = buffer_read32le(buf);
+
+    assert(val == 0xABCD1234);
+}
+
+static void test_buffer_write_varint(void) {
+    uint8_t buf[BUFFER_VARINT_MAX_SIZE];
+
+    size_t len = buffer_write_varint(buf, 0x7f);
+    assert(len == 1);
+    assert(buf[0] == 0x7f);
+
+    len = buffer_write_varint(buf, 300);
+    assert(len == 2);
+    assert(buf[0] == 0xac);
+    assert(buf[1] == 0x02);
+
+    len = buffer_write_varint(buf, UINT64_MAX);
+    assert(len == BUFFER_VARINT_MAX_SIZE);
+    assert(buf[8] == 0xff);
+    assert(buf[9] == 0x01);
+}
+
+static void test_buffer_write_svarint(void) {
+    uint8_t buf[BUFFER_VARINT_MAX_SIZE];
+
+    size_t len = buffer_write_svarint(buf, -1);
+    assert(len == 1);
+    assert(buf[0] == 0x01);
+
+    len = buffer_write_svarint(buf, 1);
+    assert(len == 1);
+    assert(buf[0] == 0x02);
+
+    len = buffer_write_svarint(buf, -65);
+    assert(len == 2);
+    assert(buf[0] == 0x81);
+    assert(buf[1] == 0x01);
+
+    len = buffer_write_svarint(buf, INT64_MIN);
+    assert(len == BUFFER_VARINT_MAX_SIZE);
+}
+
 int main(int argc, char *argv[]) {
     (void) argc;
     (void) argv;
@@ -72,8 +130,12 @@ int main(int argc, char *argv[]) {
     test_buffer_write16be();
     test_buffer_write32be();
     test_buffer_write64be();
+    test_buffer_write32le();
     test_buffer_read16be();
     test_buffer_read32be();
     test_buffer_read64be();
+    test_buffer_read32le();
+    test_buffer_write_varint();
+    test_buffer_write_svarint();
     return 0;
 }
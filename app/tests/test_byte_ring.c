@@ -0,0 +1,96 @@
+#include <assert.h>
+#include <string.h>
+
+#include "util/byte_ring.h"
+
+static void
+write_bytes(struct byte_ring *ring, const char *s) {
+    size_t len = strlen(s);
+    while (len) {
+        size_t available;
+        unsigned char *p = byte_ring_write_ptr(ring, &available);
+        assert(available);
+        size_t w = len < available ? len : available;
+        memcpy(p, s, w);
+        byte_ring_commit(ring, w);
+        s += w;
+        len -= w;
+    }
+}
+
+static void test_byte_ring_empty(void) {
+    unsigned char data[8];
+    struct byte_ring ring;
+    byte_ring_init(&ring, data, sizeof(data));
+
+    assert(!byte_ring_len(&ring));
+
+    size_t len;
+    byte_ring_read_ptr(&ring, &len);
+    assert(!len);
+
+    // the whole capacity is writable
+    byte_ring_write_ptr(&ring, &len);
+    assert(len == 8);
+}
+
+static void test_byte_ring_full(void) {
+    unsigned char data[8];
+    struct byte_ring ring;
+    byte_ring_init(&ring, data, sizeof(data));
+
+    write_bytes(&ring, "abcdefgh");
+    assert(byte_ring_len(&ring) == 8);
+
+    size_t len;
+    byte_ring_write_ptr(&ring, &len);
+    assert(!len);
+
+    const unsigned char *p = byte_ring_read_ptr(&ring, &len);
+    assert(len == 8);
+    assert(!memcmp(p, "abcdefgh", 8));
+}
+
+static void test_byte_ring_wrap(void) {
+    unsigned char data[8];
+    struct byte_ring ring;
+    byte_ring_init(&ring, data, sizeof(data));
+
+    write_bytes(&ring, "abcdef");
+    byte_ring_consume(&ring, 5);
+    assert(byte_ring_len(&ring) == 1);
+
+    // only the space until the end is contiguous
+    size_t len;
+    byte_ring_write_ptr(&ring, &len);
+    assert(len == 2);
+
+    write_bytes(&ring, "ghijk");
+    assert(byte_ring_len(&ring) == 6);
+
+    // the readable bytes wrap around
+    const unsigned char *p = byte_ring_read_ptr(&ring, &len);
+    assert(len == 3);
+    assert(!memcmp(p, "fgh", 3));
+
+    char buf[6];
+    byte_ring_peek(&ring, buf, 6);
+    assert(!memcmp(buf, "fghijk", 6));
+    // not consumed
+    assert(byte_ring_len(&ring) == 6);
+
+    byte_ring_consume(&ring, 3);
+    p = byte_ring_read_ptr(&ring, &len);
+    assert(len == 3);
+    assert(!memcmp(p, "ijk", 3));
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    test_byte_ring_empty();
+    test_byte_ring_full();
+    test_byte_ring_wrap();
+    return 0;
+}
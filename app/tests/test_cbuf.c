@@ -65,6 +65,33 @@ static void test_cbuf_push_take(void) {
     assert(item == 35);
 }
 
+static void test_cbuf_first_last(void) {
+    struct int_queue queue;
+    cbuf_init(&queue);
+
+    // make the head wrap around
+    for (int i = 0; i < 40; ++i) {
+        bool ok = cbuf_push(&queue, i);
+        assert(ok);
+        assert(*cbuf_last(&queue) == i);
+
+        int item;
+        ok = cbuf_take(&queue, &item);
+        assert(ok);
+    }
+
+    cbuf_push(&queue, 1);
+    cbuf_push(&queue, 2);
+    assert(*cbuf_first(&queue) == 1);
+    *cbuf_last(&queue) = 3;
+
+    int item;
+    cbuf_take(&queue, &item);
+    assert(item == 1);
+    cbuf_take(&queue, &item);
+    assert(item == 3);
+}
+
 int main(int argc, char *argv[]) {
     (void) argc;
     (void) argv;
@@ -72,5 +99,6 @@ int main(int argc, char *argv[]) {
     test_cbuf_empty();
     test_cbuf_full();
     test_cbuf_push_take();
+    test_cbuf_first_last();
     return 0;
 }
@@ -45,21 +45,31 @@ static void test_options(void) {
     char *argv[] = {
         "scrcpy",
         "--always-on-top",
+        "--automation-socket", "/tmp/scrcpy.sock",
         "--bit-rate", "5M",
         "--crop", "100:200:300:400",
         "--fullscreen",
+        "--legacy-control",
         "--max-fps", "30",
         "--max-size", "1024",
+        "--metrics-all-interfaces",
+        "--metrics-port", "9100",
         "--lock-video-orientation", "2",
         // "--no-control" is not compatible with "--turn-screen-off"
         // "--no-display" is not compatible with "--fulscreen"
+        "--persistent-server", "600",
         "--port", "1234:1236",
         "--push-target", "/sdcard/Movies",
+        "--push-workers", "4",
+        "--reconnect", "5",
         "--record", "file",
         "--record-format", "mkv",
         "--render-expired-frames",
+        "--rtt-warning", "50",
         "--serial", "0123456789abcdef",
         "--show-touches",
+        "--startup-timeline", "timeline.json",
+        "--trace", "trace.json",
         "--turn-screen-off",
         "--prefer-text",
         "--window-title", "my device",
@@ -75,20 +85,30 @@ static void test_options(void) {
 
     const struct scrcpy_options *opts = &args.opts;
     assert(opts->always_on_top);
+    assert(!strcmp(opts->automation_socket, "/tmp/scrcpy.sock"));
     assert(opts->bit_rate == 5000000);
     assert(!strcmp(opts->crop, "100:200:300:400"));
     assert(opts->fullscreen);
+    assert(opts->legacy_control);
     assert(opts->max_fps == 30);
     assert(opts->max_size == 1024);
+    assert(opts->metrics_port == 9100);
+    assert(opts->metrics_all_interfaces);
     assert(opts->lock_video_orientation == 2);
+    assert(opts->persistent_server_timeout == 600);
     assert(opts->port_range.first == 1234);
     assert(opts->port_range.last == 1236);
     assert(!strcmp(opts->push_target, "/sdcard/Movies"));
+    assert(opts->push_workers == 4);
+    assert(opts->reconnect_retries == 5);
     assert(!strcmp(opts->record_filename, "file"));
     assert(opts->record_format == SC_RECORD_FORMAT_MKV);
     assert(opts->render_expired_frames);
+    assert(opts->rtt_warning == 50);
     assert(!strcmp(opts->serial, "0123456789abcdef"));
     assert(opts->show_touches);
+    assert(!strcmp(opts->startup_timeline_filename, "timeline.json"));
+    assert(!strcmp(opts->trace_filename, "trace.json"));
     assert(opts->turn_screen_off);
     assert(opts->prefer_text);
     assert(!strcmp(opts->window_title, "my device"));
@@ -123,6 +143,63 @@ static void test_options2(void) {
     assert(opts->record_format == SC_RECORD_FORMAT_MP4);
 }
 
+static void test_options_direct_tcp(void) {
+    struct scrcpy_cli_args args = {
+        .opts = SCRCPY_OPTIONS_DEFAULT,
+        .help = false,
+        .version = false,
+    };
+
+    char *argv[] = {
+        "scrcpy",
+        "--direct-tcp", "192.168.1.42:5555",
+        "--direct-tcp-all-interfaces",
+        "--busy-poll", "50",
+    };
+
+    bool ok = scrcpy_parse_args(&args, ARRAY_LEN(argv), argv);
+    assert(ok);
+
+    const struct scrcpy_options *opts = &args.opts;
+    assert(opts->direct_tcp);
+    assert(opts->direct_tcp_addr == 0xC0A8012A);
+    assert(opts->direct_tcp_port == 5555);
+    assert(opts->direct_tcp_all_interfaces);
+    assert(opts->busy_poll_us == 50);
+
+    struct scrcpy_cli_args args2 = {
+        .opts = SCRCPY_OPTIONS_DEFAULT,
+        .help = false,
+        .version = false,
+    };
+
+    char *argv2[] = {
+        "scrcpy",
+        "--direct-tcp", "127.0.0.1",
+    };
+
+    ok = scrcpy_parse_args(&args2, ARRAY_LEN(argv2), argv2);
+    assert(ok);
+    assert(args2.opts.direct_tcp_addr == 0x7F000001);
+    assert(args2.opts.direct_tcp_port == DEFAULT_LOCAL_PORT_RANGE_FIRST);
+    assert(!args2.opts.direct_tcp_all_interfaces);
+
+    struct scrcpy_cli_args args3 = {
+        .opts = SCRCPY_OPTIONS_DEFAULT,
+        .help = false,
+        .version = false,
+    };
+
+    // the device listens on loopback only unless explicitly requested
+    char *argv3[] = {
+        "scrcpy",
+        "--direct-tcp", "10.0.0.1",
+    };
+
+    ok = scrcpy_parse_args(&args3, ARRAY_LEN(argv3), argv3);
+    assert(!ok);
+}
+
 static void test_parse_shortcut_mods(void) {
     struct sc_shortcut_mods mods;
     bool ok;
@@ -168,6 +245,7 @@ int main(int argc, char *argv[]) {
     test_flag_help();
     test_options();
     test_options2();
+    test_options_direct_tcp();
     test_parse_shortcut_mods();
     return 0;
 };
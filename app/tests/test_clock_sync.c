@@ -0,0 +1,100 @@
+#include <assert.h>
+
+#include "clock_sync.h"
+
+// the device clock is ahead of the client clock by 1 second
+#define OFFSET 1000000
+
+// simulate an exchange, with the given network delays and processing time
+static void
+exchange(struct clock_sync *sync, uint64_t t0, int64_t offset,
+         uint64_t outbound, uint64_t processing, uint64_t inbound) {
+    uint64_t t1 = t0 + outbound + offset;
+    uint64_t t2 = t1 + processing;
+    uint64_t t3 = t2 - offset + inbound;
+    clock_sync_add_exchange(sync, t0, t1, t2, t3);
+}
+
+static void test_not_synchronized(void) {
+    struct clock_sync sync;
+    bool ok = clock_sync_init(&sync);
+    assert(ok);
+
+    uint64_t client_time;
+    ok = clock_sync_to_client_time(&sync, 1234, &client_time);
+    assert(!ok);
+
+    clock_sync_destroy(&sync);
+}
+
+static void test_symmetric_delays(void) {
+    struct clock_sync sync;
+    bool ok = clock_sync_init(&sync);
+    assert(ok);
+
+    exchange(&sync, 5000, OFFSET, 1000, 200, 1000);
+    assert(sync.best.offset == OFFSET);
+    // the processing time on the device is not part of the delay
+    assert(sync.best.delay == 2000);
+
+    uint64_t client_time;
+    ok = clock_sync_to_client_time(&sync, OFFSET + 20000, &client_time);
+    assert(ok);
+    assert(client_time == 20000);
+
+    clock_sync_destroy(&sync);
+}
+
+static void test_min_delay_selected(void) {
+    struct clock_sync sync;
+    bool ok = clock_sync_init(&sync);
+    assert(ok);
+
+    exchange(&sync, 5000, OFFSET, 1000, 200, 1000);
+    // asymmetric delays give a wrong offset, with a larger delay
+    exchange(&sync, 10000, OFFSET, 5000, 0, 1000);
+    assert(sync.best.offset == OFFSET);
+    assert(sync.best.delay == 2000);
+
+    clock_sync_destroy(&sync);
+}
+
+static void test_drift(void) {
+    struct clock_sync sync;
+    bool ok = clock_sync_init(&sync);
+    assert(ok);
+
+    exchange(&sync, 5000, OFFSET, 1000, 0, 1000);
+    // the device clock drifts, the first exchange is out of the window
+    for (int i = 0; i < CLOCK_SYNC_WINDOW; ++i) {
+        exchange(&sync, 10000 + i * 500000, OFFSET + 500, 1500, 0, 1500);
+    }
+    assert(sync.best.offset == OFFSET + 500);
+    assert(sync.best.delay == 3000);
+
+    clock_sync_destroy(&sync);
+}
+
+static void test_invalid_exchange(void) {
+    struct clock_sync sync;
+    bool ok = clock_sync_init(&sync);
+    assert(ok);
+
+    // received before sent
+    clock_sync_add_exchange(&sync, 5000, OFFSET, OFFSET + 10, 4000);
+    assert(!sync.count);
+
+    clock_sync_destroy(&sync);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    test_not_synchronized();
+    test_symmetric_delays();
+    test_min_delay_selected();
+    test_drift();
+    test_invalid_exchange();
+    return 0;
+}
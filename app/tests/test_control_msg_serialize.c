@@ -257,6 +257,266 @@ static void test_serialize_rotate_device(void) {
     assert(!memcmp(buf, expected, sizeof(expected)));
 }
 
+static void test_serialize_set_video_size(void) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_SET_VIDEO_SIZE,
+        .set_video_size = {
+            .max_size = 1024,
+            .set_crop = true,
+            .crop = {
+                .size = {
+                    .width = 1080,
+                    .height = 1200,
+                },
+                .x = 0,
+                .y = 400,
+            },
+        },
+    };
+
+    unsigned char buf[CONTROL_MSG_MAX_SIZE];
+    int size = control_msg_serialize(&msg, buf);
+    assert(size == 12);
+
+    const unsigned char expected[] = {
+        CONTROL_MSG_TYPE_SET_VIDEO_SIZE,
+        0x04, 0x00, // 1024
+        0x01, // set crop
+        0x04, 0x38, 0x04, 0xb0, // 1080 1200
+        0x00, 0x00, 0x01, 0x90, // 0 400
+    };
+    assert(!memcmp(buf, expected, sizeof(expected)));
+}
+
+static void test_serialize_set_video_paused(void) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_SET_VIDEO_PAUSED,
+        .set_video_paused = {
+            .paused = true,
+        },
+    };
+
+    unsigned char buf[CONTROL_MSG_MAX_SIZE];
+    int size = control_msg_serialize(&msg, buf);
+    assert(size == 2);
+
+    const unsigned char expected[] = {
+        CONTROL_MSG_TYPE_SET_VIDEO_PAUSED,
+        0x01, // paused
+    };
+    assert(!memcmp(buf, expected, sizeof(expected)));
+}
+
+static void test_serialize_ack_frame(void) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_ACK_FRAME,
+        .ack_frame = {
+            .pts = 0x0102030405060708,
+            .skipped_frames = 3,
+        },
+    };
+
+    unsigned char buf[CONTROL_MSG_MAX_SIZE];
+    int size = control_msg_serialize(&msg, buf);
+    assert(size == 11);
+
+    const unsigned char expected[] = {
+        CONTROL_MSG_TYPE_ACK_FRAME,
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, // pts
+        0x00, 0x03, // skipped frames
+    };
+    assert(!memcmp(buf, expected, sizeof(expected)));
+}
+
+static void test_serialize_ping(void) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_PING,
+        .ping = {
+            .timestamp = 0x0102030405060708,
+        },
+    };
+
+    unsigned char buf[CONTROL_MSG_MAX_SIZE];
+    int size = control_msg_serialize(&msg, buf);
+    assert(size == 9);
+
+    const unsigned char expected[] = {
+        CONTROL_MSG_TYPE_PING,
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, // timestamp
+    };
+    assert(!memcmp(buf, expected, sizeof(expected)));
+}
+
+static void test_encode_compact_inject_keycode(void) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_INJECT_KEYCODE,
+        .inject_keycode = {
+            .action = AKEY_EVENT_ACTION_UP,
+            .keycode = AKEYCODE_ENTER,
+            .repeat = 5,
+            .metastate = AMETA_SHIFT_ON | AMETA_SHIFT_LEFT_ON,
+        },
+    };
+
+    struct control_msg_encoder encoder;
+    control_msg_encoder_init(&encoder, CONTROL_MSG_ENCODING_COMPACT);
+
+    unsigned char buf[CONTROL_MSG_MAX_SIZE];
+    int size = control_msg_encode(&encoder, &msg, buf);
+    assert(size == 5);
+
+    const unsigned char expected[] = {
+        CONTROL_MSG_TYPE_INJECT_KEYCODE,
+        0x01, // AKEY_EVENT_ACTION_UP
+        0x42, // AKEYCODE_ENTER
+        0x05, // repeat
+        0x41, // AMETA_SHIFT_ON | AMETA_SHIFT_LEFT_ON
+    };
+    assert(!memcmp(buf, expected, sizeof(expected)));
+}
+
+static void test_encode_compact_inject_touch_events(void) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT,
+        .inject_touch_event = {
+            .action = AMOTION_EVENT_ACTION_DOWN,
+            .pointer_id = 0,
+            .position = {
+                .point = {
+                    .x = 100,
+                    .y = 200,
+                },
+                .screen_size = {
+                    .width = 1080,
+                    .height = 1920,
+                },
+            },
+            .pressure = 1.0f,
+            .buttons = 0,
+        },
+    };
+
+    struct control_msg_encoder encoder;
+    control_msg_encoder_init(&encoder, CONTROL_MSG_ENCODING_COMPACT);
+
+    unsigned char buf[CONTROL_MSG_MAX_SIZE];
+    int size = control_msg_encode(&encoder, &msg, buf);
+    assert(size == 12);
+
+    const unsigned char expected_down[] = {
+        CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT,
+        0x80, // screen size follows | AMOTION_EVENT_ACTION_DOWN
+        0x00, // pointer id
+        0xb8, 0x08, 0x80, 0x0f, // 1080x1920
+        0xc8, 0x01, 0x90, 0x03, // +100 +200
+        0x00, // buttons
+    };
+    assert(!memcmp(buf, expected_down, sizeof(expected_down)));
+
+    // the screen size is not repeated, the position is relative
+    msg.inject_touch_event.action = AMOTION_EVENT_ACTION_MOVE;
+    msg.inject_touch_event.position.point.x = 103;
+    msg.inject_touch_event.position.point.y = 198;
+    msg.inject_touch_event.pressure = 0.5f;
+    size = control_msg_encode(&encoder, &msg, buf);
+    assert(size == 8);
+
+    const unsigned char expected_move[] = {
+        CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT,
+        0x42, // pressure follows | AMOTION_EVENT_ACTION_MOVE
+        0x00, // pointer id
+        0x06, 0x03, // +3 -2
+        0x80, 0x00, // pressure 0.5
+        0x00, // buttons
+    };
+    assert(!memcmp(buf, expected_move, sizeof(expected_move)));
+
+    msg.inject_touch_event.action = AMOTION_EVENT_ACTION_UP;
+    msg.inject_touch_event.pointer_id = POINTER_ID_MOUSE;
+    msg.inject_touch_event.pressure = 0.f;
+    msg.inject_touch_event.buttons = AMOTION_EVENT_BUTTON_PRIMARY;
+    size = control_msg_encode(&encoder, &msg, buf);
+    assert(size == 6);
+
+    const unsigned char expected_up[] = {
+        CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT,
+        0x21, // no pressure | AMOTION_EVENT_ACTION_UP
+        0x01, // POINTER_ID_MOUSE (-1)
+        0x00, 0x00, // same position
+        0x01, // AMOTION_EVENT_BUTTON_PRIMARY
+    };
+    assert(!memcmp(buf, expected_up, sizeof(expected_up)));
+}
+
+static void test_encode_compact_inject_scroll_event(void) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_INJECT_SCROLL_EVENT,
+        .inject_scroll_event = {
+            .position = {
+                .point = {
+                    .x = 10,
+                    .y = 20,
+                },
+                .screen_size = {
+                    .width = 1080,
+                    .height = 1920,
+                },
+            },
+            .hscroll = 1,
+            .vscroll = -1,
+        },
+    };
+
+    struct control_msg_encoder encoder;
+    control_msg_encoder_init(&encoder, CONTROL_MSG_ENCODING_COMPACT);
+
+    unsigned char buf[CONTROL_MSG_MAX_SIZE];
+    int size = control_msg_encode(&encoder, &msg, buf);
+    assert(size == 10);
+
+    const unsigned char expected[] = {
+        CONTROL_MSG_TYPE_INJECT_SCROLL_EVENT,
+        0x80, // screen size follows
+        0xb8, 0x08, 0x80, 0x0f, // 1080x1920
+        0x14, 0x28, // +10 +20
+        0x02, // hscroll
+        0x01, // vscroll
+    };
+    assert(!memcmp(buf, expected, sizeof(expected)));
+}
+
+static void test_encode_legacy_and_fallback(void) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_PING,
+        .ping = {
+            .timestamp = 0x0102030405060708,
+        },
+    };
+
+    unsigned char legacy[CONTROL_MSG_MAX_SIZE];
+    int legacy_size = control_msg_serialize(&msg, legacy);
+
+    // the messages which are not input events are encoded as before
+    struct control_msg_encoder encoder;
+    control_msg_encoder_init(&encoder, CONTROL_MSG_ENCODING_COMPACT);
+    unsigned char buf[CONTROL_MSG_MAX_SIZE];
+    int size = control_msg_encode(&encoder, &msg, buf);
+    assert(size == legacy_size);
+    assert(!memcmp(buf, legacy, size));
+
+    msg.type = CONTROL_MSG_TYPE_INJECT_KEYCODE;
+    msg.inject_keycode.action = AKEY_EVENT_ACTION_DOWN;
+    msg.inject_keycode.keycode = AKEYCODE_BACK;
+    msg.inject_keycode.repeat = 0;
+    msg.inject_keycode.metastate = 0;
+    legacy_size = control_msg_serialize(&msg, legacy);
+
+    control_msg_encoder_init(&encoder, CONTROL_MSG_ENCODING_LEGACY);
+    size = control_msg_encode(&encoder, &msg, buf);
+    assert(size == legacy_size);
+    assert(!memcmp(buf, legacy, size));
+}
+
 int main(int argc, char *argv[]) {
     (void) argc;
     (void) argv;
@@ -273,5 +533,13 @@ int main(int argc, char *argv[]) {
     test_serialize_set_clipboard();
     test_serialize_set_screen_power_mode();
     test_serialize_rotate_device();
+    test_serialize_set_video_size();
+    test_serialize_set_video_paused();
+    test_serialize_ack_frame();
+    test_serialize_ping();
+    test_encode_compact_inject_keycode();
+    test_encode_compact_inject_touch_events();
+    test_encode_compact_inject_scroll_event();
+    test_encode_legacy_and_fallback();
     return 0;
 }
@@ -0,0 +1,292 @@
+#include <assert.h>
+#include <SDL2/SDL_thread.h>
+
+#include "controller.h"
+#include "util/lock.h"
+
+static struct control_msg
+touch_msg(enum android_motionevent_action action, uint64_t pointer_id,
+          int32_t x) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_INJECT_TOUCH_EVENT,
+        .inject_touch_event = {
+            .action = action,
+            .buttons = 0,
+            .pointer_id = pointer_id,
+            .position = {
+                .screen_size = {
+                    .width = 1080,
+                    .height = 1920,
+                },
+                .point = {
+                    .x = x,
+                    .y = 0,
+                },
+            },
+            .pressure = 1.0f,
+        },
+    };
+    return msg;
+}
+
+static struct control_msg
+key_msg(enum android_keyevent_action action, uint32_t repeat) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_INJECT_KEYCODE,
+        .inject_keycode = {
+            .action = action,
+            .keycode = AKEYCODE_A,
+            .repeat = repeat,
+            .metastate = 0,
+        },
+    };
+    return msg;
+}
+
+static void test_coalesce_moves(void) {
+    struct controller controller;
+    // the controller is not started, the messages stay in the queue
+    bool ok = controller_init(&controller, INVALID_SOCKET,
+                              CONTROL_MSG_ENCODING_LEGACY, NULL, NULL,
+                              NULL);
+    assert(ok);
+
+    struct control_msg msg = touch_msg(AMOTION_EVENT_ACTION_DOWN, 1, 0);
+    controller_push_msg(&controller, &msg);
+    msg = touch_msg(AMOTION_EVENT_ACTION_MOVE, 1, 1);
+    controller_push_msg(&controller, &msg);
+    // replaces the previous move
+    msg = touch_msg(AMOTION_EVENT_ACTION_MOVE, 1, 2);
+    controller_push_msg(&controller, &msg);
+    // another pointer
+    msg = touch_msg(AMOTION_EVENT_ACTION_MOVE, 2, 3);
+    controller_push_msg(&controller, &msg);
+    msg = touch_msg(AMOTION_EVENT_ACTION_UP, 2, 3);
+    controller_push_msg(&controller, &msg);
+    // not merged with the move before the "up" event
+    msg = touch_msg(AMOTION_EVENT_ACTION_MOVE, 2, 4);
+    controller_push_msg(&controller, &msg);
+
+    struct control_msg msgs[8];
+    size_t count = controller_take_msgs(&controller, msgs, 8);
+    assert(count == 5);
+    assert(msgs[0].inject_touch_event.action == AMOTION_EVENT_ACTION_DOWN);
+    assert(msgs[1].inject_touch_event.action == AMOTION_EVENT_ACTION_MOVE);
+    assert(msgs[1].inject_touch_event.position.point.x == 2);
+    assert(msgs[2].inject_touch_event.action == AMOTION_EVENT_ACTION_MOVE);
+    assert(msgs[2].inject_touch_event.pointer_id == 2);
+    assert(msgs[3].inject_touch_event.action == AMOTION_EVENT_ACTION_UP);
+    assert(msgs[4].inject_touch_event.action == AMOTION_EVENT_ACTION_MOVE);
+    assert(msgs[4].inject_touch_event.position.point.x == 4);
+
+    assert(controller.reliable_stats.pushed == 2);
+    assert(controller.lossy_stats.pushed == 3);
+    assert(controller.lossy_stats.merged == 1);
+
+    controller_destroy(&controller);
+}
+
+static void test_lossy_lane_full(void) {
+    struct controller controller;
+    bool ok = controller_init(&controller, INVALID_SOCKET,
+                              CONTROL_MSG_ENCODING_LEGACY, NULL, NULL,
+                              NULL);
+    assert(ok);
+
+    struct control_msg msg;
+    for (int i = 0; i < CONTROL_MSG_LOSSY_QUEUE_SIZE + 10; ++i) {
+        // a different pointer for each move, so that they are not merged
+        msg = touch_msg(AMOTION_EVENT_ACTION_MOVE, i, i);
+        ok = controller_push_msg(&controller, &msg);
+        assert(ok); // a drop is not an error
+    }
+    // the reliable lane is unbounded
+    msg = key_msg(AKEY_EVENT_ACTION_DOWN, 0);
+    ok = controller_push_msg(&controller, &msg);
+    assert(ok);
+
+    assert(controller.lossy_stats.pushed == CONTROL_MSG_LOSSY_QUEUE_SIZE);
+    assert(controller.lossy_stats.dropped == 10);
+
+    struct control_msg msgs[CONTROL_MSG_LOSSY_QUEUE_SIZE + 1];
+    size_t count = controller_take_msgs(&controller, msgs,
+                                        CONTROL_MSG_LOSSY_QUEUE_SIZE + 1);
+    assert(count == CONTROL_MSG_LOSSY_QUEUE_SIZE + 1);
+    assert(msgs[count - 1].type == CONTROL_MSG_TYPE_INJECT_KEYCODE);
+
+    controller_destroy(&controller);
+}
+
+static void test_push_reliable(void) {
+    struct controller controller;
+    bool ok = controller_init(&controller, INVALID_SOCKET,
+                              CONTROL_MSG_ENCODING_LEGACY, NULL, NULL,
+                              NULL);
+    assert(ok);
+
+    // more moves than the capacity of the lossy lane, for the same pointer
+    struct control_msg msg;
+    for (int i = 0; i < CONTROL_MSG_LOSSY_QUEUE_SIZE + 10; ++i) {
+        msg = touch_msg(AMOTION_EVENT_ACTION_MOVE, 1, i);
+        ok = controller_push_msg_reliable(&controller, &msg);
+        assert(ok);
+    }
+
+    // neither merged nor dropped
+    assert(controller.reliable_stats.pushed
+                == CONTROL_MSG_LOSSY_QUEUE_SIZE + 10);
+    assert(controller.lossy_stats.pushed == 0);
+
+    struct control_msg msgs[CONTROL_MSG_LOSSY_QUEUE_SIZE + 10];
+    size_t count = controller_take_msgs(&controller, msgs,
+                                        CONTROL_MSG_LOSSY_QUEUE_SIZE + 10);
+    assert(count == CONTROL_MSG_LOSSY_QUEUE_SIZE + 10);
+    for (size_t i = 0; i < count; ++i) {
+        assert(msgs[i].inject_touch_event.position.point.x == (int32_t) i);
+    }
+
+    controller_destroy(&controller);
+}
+
+static struct control_msg
+ack_msg(uint64_t pts, uint16_t skipped_frames) {
+    struct control_msg msg = {
+        .type = CONTROL_MSG_TYPE_ACK_FRAME,
+        .ack_frame = {
+            .pts = pts,
+            .skipped_frames = skipped_frames,
+        },
+    };
+    return msg;
+}
+
+static void test_merge_acks(void) {
+    struct controller controller;
+    bool ok = controller_init(&controller, INVALID_SOCKET,
+                              CONTROL_MSG_ENCODING_LEGACY, NULL, NULL,
+                              NULL);
+    assert(ok);
+
+    // fill the lossy lane: the acks must not be dropped
+    struct control_msg msg;
+    for (int i = 0; i < CONTROL_MSG_LOSSY_QUEUE_SIZE; ++i) {
+        msg = touch_msg(AMOTION_EVENT_ACTION_MOVE, i, i);
+        controller_push_msg(&controller, &msg);
+    }
+
+    msg = ack_msg(1, 0);
+    controller_push_msg(&controller, &msg);
+    msg = key_msg(AKEY_EVENT_ACTION_DOWN, 0);
+    controller_push_msg(&controller, &msg);
+    // merged into the queued ack
+    msg = ack_msg(3, 1);
+    controller_push_msg(&controller, &msg);
+    msg = ack_msg(5, 1);
+    controller_push_msg(&controller, &msg);
+
+    assert(controller.reliable_stats.pushed == 2);
+    assert(controller.reliable_stats.merged == 2);
+
+    struct control_msg msgs[CONTROL_MSG_LOSSY_QUEUE_SIZE + 2];
+    size_t count = controller_take_msgs(&controller, msgs,
+                                        CONTROL_MSG_LOSSY_QUEUE_SIZE + 2);
+    assert(count == CONTROL_MSG_LOSSY_QUEUE_SIZE + 2);
+    struct control_msg *ack = &msgs[CONTROL_MSG_LOSSY_QUEUE_SIZE];
+    assert(ack->type == CONTROL_MSG_TYPE_ACK_FRAME);
+    assert(ack->ack_frame.pts == 5);
+    assert(ack->ack_frame.skipped_frames == 2);
+
+    // the ack has been taken, the next one is queued again
+    msg = ack_msg(6, 0);
+    controller_push_msg(&controller, &msg);
+    count = controller_take_msgs(&controller, msgs, 1);
+    assert(count == 1);
+    assert(msgs[0].ack_frame.pts == 6);
+    assert(controller.reliable_stats.pushed == 3);
+
+    controller_destroy(&controller);
+}
+
+#define STRESS_KEY_COUNT 10000
+#define STRESS_MOVES_PER_KEY 20
+
+static int
+run_flood(void *data) {
+    struct controller *controller = data;
+    for (uint32_t i = 0; i < STRESS_KEY_COUNT; ++i) {
+        for (int j = 0; j < STRESS_MOVES_PER_KEY; ++j) {
+            struct control_msg msg =
+                touch_msg(AMOTION_EVENT_ACTION_MOVE, j % 2, i);
+            controller_push_msg(controller, &msg);
+        }
+        enum android_keyevent_action action = i % 2 ? AKEY_EVENT_ACTION_UP
+                                                     : AKEY_EVENT_ACTION_DOWN;
+        struct control_msg msg = key_msg(action, i);
+        bool ok = controller_push_msg(controller, &msg);
+        assert(ok);
+        (void) ok;
+    }
+    return 0;
+}
+
+static void test_stress_key_ordering(void) {
+    struct controller controller;
+    bool ok = controller_init(&controller, INVALID_SOCKET,
+                              CONTROL_MSG_ENCODING_LEGACY, NULL, NULL,
+                              NULL);
+    assert(ok);
+
+    SDL_Thread *thread = SDL_CreateThread(run_flood, "flood", &controller);
+    assert(thread);
+
+    // consume like the controller thread, and check that no key is lost or
+    // reordered, and that no move is sent after a later key
+    uint32_t next_key = 0;
+    int32_t last_move_x = 0;
+    while (next_key < STRESS_KEY_COUNT) {
+        struct control_msg msgs[CONTROL_MSG_BATCH_SIZE];
+        mutex_lock(controller.mutex);
+        size_t count = controller_take_msgs(&controller, msgs,
+                                            CONTROL_MSG_BATCH_SIZE);
+        mutex_unlock(controller.mutex);
+
+        for (size_t i = 0; i < count; ++i) {
+            if (msgs[i].type == CONTROL_MSG_TYPE_INJECT_KEYCODE) {
+                assert(msgs[i].inject_keycode.repeat == next_key);
+                enum android_keyevent_action expected_action =
+                    next_key % 2 ? AKEY_EVENT_ACTION_UP
+                                 : AKEY_EVENT_ACTION_DOWN;
+                assert(msgs[i].inject_keycode.action == expected_action);
+                ++next_key;
+            } else {
+                int32_t x = msgs[i].inject_touch_event.position.point.x;
+                // the moves before key i have x == i
+                assert(x == (int32_t) next_key);
+                assert(x >= last_move_x);
+                last_move_x = x;
+            }
+        }
+    }
+
+    SDL_WaitThread(thread, NULL);
+
+    assert(controller.reliable_stats.pushed == STRESS_KEY_COUNT);
+    assert(controller.reliable_stats.dropped == 0);
+    struct control_lane_stats *lossy = &controller.lossy_stats;
+    assert(lossy->pushed + lossy->merged + lossy->dropped
+            == STRESS_KEY_COUNT * STRESS_MOVES_PER_KEY);
+
+    controller_destroy(&controller);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    test_coalesce_moves();
+    test_lossy_lane_full();
+    test_push_reliable();
+    test_merge_acks();
+    test_stress_key_ordering();
+    return 0;
+}
@@ -1,10 +1,93 @@
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "device_msg.h"
 
 #include <stdio.h>
 
+// append len bytes to the ring buffer (they must fit)
+static void
+push_bytes(struct byte_ring *ring, const unsigned char *data, size_t len) {
+    while (len) {
+        size_t available;
+        unsigned char *p = byte_ring_write_ptr(ring, &available);
+        assert(available);
+        size_t w = len < available ? len : available;
+        memcpy(p, data, w);
+        byte_ring_commit(ring, w);
+        data += w;
+        len -= w;
+    }
+}
+
+// read a single message, whose last byte is received separately (so that an
+// incomplete message is also tested)
+static void
+read_msg(const unsigned char *input, size_t len, struct device_msg *msg) {
+    // large enough for the inputs of these tests
+    unsigned char buf[64];
+    struct byte_ring ring;
+    byte_ring_init(&ring, buf, sizeof(buf));
+
+    struct device_msg_reader reader;
+    device_msg_reader_init(&reader);
+
+    push_bytes(&ring, input, len - 1);
+    int r = device_msg_reader_read(&reader, &ring, msg);
+    assert(r == 0);
+
+    push_bytes(&ring, &input[len - 1], 1);
+    r = device_msg_reader_read(&reader, &ring, msg);
+    assert(r == 1);
+    // the whole message is consumed
+    assert(!byte_ring_len(&ring));
+
+    device_msg_reader_destroy(&reader);
+}
+
+// feed the stream to the reader through a small ring buffer, by chunks of
+// chunk_size bytes
+static void
+read_stream(const unsigned char *stream, size_t len, size_t chunk_size,
+            struct device_msg *msgs, int *count) {
+    // large enough for any header
+    unsigned char buf[64];
+    struct byte_ring ring;
+    byte_ring_init(&ring, buf, sizeof(buf));
+
+    struct device_msg_reader reader;
+    device_msg_reader_init(&reader);
+
+    *count = 0;
+    size_t head = 0;
+    while (head < len) {
+        size_t available;
+        unsigned char *p = byte_ring_write_ptr(&ring, &available);
+        assert(available);
+        size_t w = len - head;
+        if (w > available) {
+            w = available;
+        }
+        if (w > chunk_size) {
+            w = chunk_size;
+        }
+        memcpy(p, &stream[head], w);
+        byte_ring_commit(&ring, w);
+        head += w;
+
+        int r;
+        while ((r = device_msg_reader_read(&reader, &ring, &msgs[*count]))) {
+            assert(r == 1);
+            ++*count;
+        }
+        // only an incomplete header may be left
+        assert(byte_ring_len(&ring) < DEVICE_MSG_HEADER_MAX_SIZE);
+    }
+
+    device_msg_reader_destroy(&reader);
+}
+
 static void test_deserialize_clipboard(void) {
     const unsigned char input[] = {
         DEVICE_MSG_TYPE_CLIPBOARD,
@@ -13,8 +96,7 @@ static void test_deserialize_clipboard(void) {
     };
 
     struct device_msg msg;
-    ssize_t r = device_msg_deserialize(input, sizeof(input), &msg);
-    assert(r == 8);
+    read_msg(input, sizeof(input), &msg);
 
     assert(msg.type == DEVICE_MSG_TYPE_CLIPBOARD);
     assert(msg.clipboard.text);
@@ -24,7 +106,9 @@ static void test_deserialize_clipboard(void) {
 }
 
 static void test_deserialize_clipboard_big(void) {
-    unsigned char input[DEVICE_MSG_MAX_SIZE];
+    size_t size = 5 + DEVICE_MSG_TEXT_MAX_LENGTH;
+    unsigned char *input = malloc(size);
+    assert(input);
     input[0] = DEVICE_MSG_TYPE_CLIPBOARD;
     input[1] = (DEVICE_MSG_TEXT_MAX_LENGTH & 0xff000000u) >> 24;
     input[2] = (DEVICE_MSG_TEXT_MAX_LENGTH & 0x00ff0000u) >> 16;
@@ -33,9 +117,11 @@ static void test_deserialize_clipboard_big(void) {
 
     memset(input + 5, 'a', DEVICE_MSG_TEXT_MAX_LENGTH);
 
+    // streamed through the small ring buffer
     struct device_msg msg;
-    ssize_t r = device_msg_deserialize(input, sizeof(input), &msg);
-    assert(r == DEVICE_MSG_MAX_SIZE);
+    int count;
+    read_stream(input, size, size, &msg, &count);
+    assert(count == 1);
 
     assert(msg.type == DEVICE_MSG_TYPE_CLIPBOARD);
     assert(msg.clipboard.text);
@@ -43,6 +129,123 @@ static void test_deserialize_clipboard_big(void) {
     assert(msg.clipboard.text[0] == 'a');
 
     device_msg_destroy(&msg);
+    free(input);
+}
+
+static void test_deserialize_pong(void) {
+    const unsigned char input[] = {
+        DEVICE_MSG_TYPE_PONG,
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, // timestamp
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x42, 0x40, // receive time
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x42, 0x6A, // send time
+    };
+
+    struct device_msg msg;
+    read_msg(input, sizeof(input), &msg);
+
+    assert(msg.type == DEVICE_MSG_TYPE_PONG);
+    assert(msg.pong.timestamp == 0x0102030405060708);
+    assert(msg.pong.receive_time == 1000000);
+    assert(msg.pong.send_time == 1000042);
+
+    device_msg_destroy(&msg);
+}
+
+static void test_deserialize_encoder_stats(void) {
+    const unsigned char input[] = {
+        DEVICE_MSG_TYPE_ENCODER_STATS,
+        0x00, 0x00, 0x01, 0x2C, // frames
+        0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, // bytes
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x42, 0x40, // dequeue wait
+        0x00, 0x00, 0x00, 0x02, // restarts
+        0x00, 0x7A, 0x12, 0x00, // bit rate
+        0x00, 0x00, 0x00, 0x3C, // max fps
+    };
+
+    struct device_msg msg;
+    read_msg(input, sizeof(input), &msg);
+
+    assert(msg.type == DEVICE_MSG_TYPE_ENCODER_STATS);
+    assert(msg.encoder_stats.frames == 300);
+    assert(msg.encoder_stats.bytes == 0x01020304);
+    assert(msg.encoder_stats.dequeue_wait == 1000000);
+    assert(msg.encoder_stats.restarts == 2);
+    assert(msg.encoder_stats.bit_rate == 8000000);
+    assert(msg.encoder_stats.max_fps == 60);
+
+    device_msg_destroy(&msg);
+}
+
+static void test_reader_stream(void) {
+    // a clipboard text much larger than the ring buffer, between two pongs
+    size_t text_len = 100000;
+    size_t len = 25 + 5 + text_len + 25;
+    unsigned char *stream = malloc(len);
+    assert(stream);
+
+    const unsigned char pong[] = {
+        DEVICE_MSG_TYPE_PONG,
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, // timestamp
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x42, 0x40, // receive time
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x42, 0x6A, // send time
+    };
+    memcpy(stream, pong, 25);
+    stream[25] = DEVICE_MSG_TYPE_CLIPBOARD;
+    stream[26] = 0x00;
+    stream[27] = 0x01;
+    stream[28] = 0x86;
+    stream[29] = 0xA0; // 100000
+    for (size_t i = 0; i < text_len; ++i) {
+        stream[30 + i] = 'a' + i % 26;
+    }
+    memcpy(&stream[30 + text_len], pong, 25);
+
+    // 1 byte at a time, and whatever fits in the ring
+    size_t chunk_sizes[] = {1, 7, 1000};
+    for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++i) {
+        struct device_msg msgs[3];
+        int count;
+        read_stream(stream, len, chunk_sizes[i], msgs, &count);
+        assert(count == 3);
+
+        assert(msgs[0].type == DEVICE_MSG_TYPE_PONG);
+        assert(msgs[0].pong.timestamp == 0x0102030405060708);
+        assert(msgs[0].pong.send_time == 1000042);
+
+        assert(msgs[1].type == DEVICE_MSG_TYPE_CLIPBOARD);
+        assert(strlen(msgs[1].clipboard.text) == text_len);
+        assert(!memcmp(msgs[1].clipboard.text, &stream[30], text_len));
+
+        assert(msgs[2].type == DEVICE_MSG_TYPE_PONG);
+        assert(msgs[2].pong.receive_time == 1000000);
+
+        for (int j = 0; j < count; ++j) {
+            device_msg_destroy(&msgs[j]);
+        }
+    }
+
+    free(stream);
+}
+
+static void test_reader_error(void) {
+    unsigned char buf[32];
+    struct byte_ring ring;
+    byte_ring_init(&ring, buf, sizeof(buf));
+
+    struct device_msg_reader reader;
+    device_msg_reader_init(&reader);
+
+    // a clipboard message with an absurd length
+    const unsigned char input[] = {
+        DEVICE_MSG_TYPE_CLIPBOARD, 0x7F, 0xFF, 0xFF, 0xFF,
+    };
+    push_bytes(&ring, input, sizeof(input));
+
+    struct device_msg msg;
+    int r = device_msg_reader_read(&reader, &ring, &msg);
+    assert(r == -1);
+
+    device_msg_reader_destroy(&reader);
 }
 
 int main(int argc, char *argv[]) {
@@ -51,5 +254,9 @@ int main(int argc, char *argv[]) {
 
     test_deserialize_clipboard();
     test_deserialize_clipboard_big();
+    test_deserialize_pong();
+    test_deserialize_encoder_stats();
+    test_reader_stream();
+    test_reader_error();
     return 0;
 }
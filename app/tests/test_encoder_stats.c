@@ -0,0 +1,107 @@
+#include <assert.h>
+
+#include "encoder_stats.h"
+
+static void
+report(struct encoder_stats *stats, uint32_t frames, uint64_t bytes,
+       uint64_t dequeue_wait, uint32_t restarts) {
+    struct device_encoder_stats r = {
+        .frames = frames,
+        .bytes = bytes,
+        .dequeue_wait = dequeue_wait,
+        .restarts = restarts,
+        .bit_rate = 8000000,
+        .max_fps = 60,
+    };
+    encoder_stats_add_report(stats, &r);
+}
+
+static void test_no_report(void) {
+    struct encoder_stats stats;
+    bool ok = encoder_stats_init(&stats);
+    assert(ok);
+
+    struct encoder_stats_summary summary;
+    ok = encoder_stats_take_summary(&stats, &summary);
+    assert(!ok);
+
+    encoder_stats_destroy(&stats);
+}
+
+static void test_interval(void) {
+    struct encoder_stats stats;
+    bool ok = encoder_stats_init(&stats);
+    assert(ok);
+
+    // the first report covers the activity since the start of the encoder
+    report(&stats, 60, 100000, 900000, 0);
+
+    struct encoder_stats_summary summary;
+    ok = encoder_stats_take_summary(&stats, &summary);
+    assert(ok);
+    assert(summary.frames == 60);
+    assert(summary.bytes == 100000);
+    assert(summary.dequeue_wait == 900000);
+    assert(summary.bit_rate == 8000000);
+    assert(summary.max_fps == 60);
+
+    // already taken
+    ok = encoder_stats_take_summary(&stats, &summary);
+    assert(!ok);
+
+    report(&stats, 90, 150000, 1800000, 1);
+    ok = encoder_stats_take_summary(&stats, &summary);
+    assert(ok);
+    assert(summary.frames == 30);
+    assert(summary.bytes == 50000);
+    assert(summary.dequeue_wait == 900000);
+    // not an interval
+    assert(summary.restarts == 1);
+
+    encoder_stats_destroy(&stats);
+}
+
+static void test_new_encoder(void) {
+    struct encoder_stats stats;
+    bool ok = encoder_stats_init(&stats);
+    assert(ok);
+
+    report(&stats, 1000, 2000000, 5000000, 3);
+    // a new session started a new encoder (the counters restarted from 0)
+    encoder_stats_reset(&stats);
+
+    struct encoder_stats_summary summary;
+    ok = encoder_stats_take_summary(&stats, &summary);
+    assert(!ok);
+
+    // not subtracted from the previous report, even if greater
+    report(&stats, 2000, 3000000, 6000000, 0);
+    ok = encoder_stats_take_summary(&stats, &summary);
+    assert(ok);
+    assert(summary.frames == 2000);
+    assert(summary.bytes == 3000000);
+    assert(summary.dequeue_wait == 6000000);
+    assert(summary.restarts == 0);
+
+    encoder_stats_reset(&stats);
+    report(&stats, 20, 30000, 100000, 0);
+
+    ok = encoder_stats_take_summary(&stats, &summary);
+    assert(ok);
+    assert(summary.frames == 20);
+    assert(summary.bytes == 30000);
+    assert(summary.dequeue_wait == 100000);
+    assert(summary.restarts == 0);
+
+    encoder_stats_destroy(&stats);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    test_no_report();
+    test_interval();
+    test_new_encoder();
+    return 0;
+}
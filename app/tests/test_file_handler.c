@@ -0,0 +1,232 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <SDL2/SDL_timer.h>
+
+#include "file_handler.h"
+#include "metrics.h"
+
+// a fake adb, which logs its arguments (one line per execution)
+#define ADB_SCRIPT "./test_file_handler.tmp.sh"
+#define ADB_LOG "test_file_handler.tmp.log"
+
+static void
+write_file(const char *filename, const char *content) {
+    FILE *file = fopen(filename, "w");
+    assert(file);
+    fputs(content, file);
+    fclose(file);
+}
+
+static void
+setup_adb(void) {
+    write_file(ADB_SCRIPT,
+               "#!/bin/sh\n"
+               "echo \"$*\" >> " ADB_LOG "\n"
+               "case \"$*\" in\n"
+               "    *slow*) sleep 10;;\n"
+               "    *fail*) exit 1;;\n"
+               "esac\n");
+    int r = chmod(ADB_SCRIPT, 0755);
+    assert(!r);
+    (void) r;
+    r = setenv("ADB", ADB_SCRIPT, 1);
+    assert(!r);
+}
+
+// read the whole adb log
+static void
+read_log(char *buf, size_t size) {
+    buf[0] = '\0';
+    FILE *file = fopen(ADB_LOG, "r");
+    if (!file) {
+        // adb has not been executed yet
+        return;
+    }
+    size_t len = fread(buf, 1, size - 1, file);
+    assert(len < size - 1);
+    buf[len] = '\0';
+    fclose(file);
+}
+
+static unsigned
+count_occurrences(const char *s, const char *pattern) {
+    unsigned count = 0;
+    while ((s = strstr(s, pattern))) {
+        ++count;
+        s += strlen(pattern);
+    }
+    return count;
+}
+
+static void
+wait_done(struct file_handler *fh, struct file_handler_progress *progress) {
+    for (int i = 0; i < 1000; ++i) {
+        file_handler_get_progress(fh, progress);
+        if (progress->requested && progress->done == progress->requested) {
+            return;
+        }
+        SDL_Delay(10);
+    }
+    assert(!"timeout");
+}
+
+static void test_batch(void) {
+    remove(ADB_LOG);
+
+    struct file_handler fh;
+    bool ok = file_handler_init(&fh, NULL, "/sdcard/", 2);
+    assert(ok);
+
+    char name[64];
+    for (int i = 0; i < 40; ++i) {
+        sprintf(name, "test_file_handler_%02d.tmp", i);
+        write_file(name, "0123456789");
+        ok = file_handler_request(&fh, ACTION_PUSH_FILE, SDL_strdup(name));
+        assert(ok);
+    }
+
+    struct file_handler_progress progress;
+    wait_done(&fh, &progress);
+    assert(progress.requested == 40);
+    assert(progress.failed == 0);
+    assert(progress.bytes == 40 * 10);
+
+    file_handler_stop(&fh);
+    file_handler_join(&fh);
+    file_handler_destroy(&fh);
+
+    static char log[16384];
+    read_log(log, sizeof(log));
+
+    // each file is pushed exactly once, by fewer commands than files
+    for (int i = 0; i < 40; ++i) {
+        sprintf(name, "test_file_handler_%02d.tmp", i);
+        remove(name);
+        char arg[sizeof(name) + 2];
+        sprintf(arg, " %s ", name);
+        assert(count_occurrences(log, arg) == 1);
+    }
+    unsigned commands = count_occurrences(log, "\n");
+    assert(commands == count_occurrences(log, " /sdcard/\n"));
+    assert(commands < 40);
+}
+
+static void test_no_batch(void) {
+    remove(ADB_LOG);
+
+    struct file_handler fh;
+    // the target is not a directory, the files must be pushed one by one
+    bool ok = file_handler_init(&fh, NULL, "/sdcard/file", 1);
+    assert(ok);
+
+    file_handler_request(&fh, ACTION_PUSH_FILE, SDL_strdup("a.tmp"));
+    file_handler_request(&fh, ACTION_PUSH_FILE, SDL_strdup("b.tmp"));
+    file_handler_request(&fh, ACTION_INSTALL_APK, SDL_strdup("c.apk"));
+    file_handler_request(&fh, ACTION_PUSH_FILE, SDL_strdup("fail.tmp"));
+
+    struct file_handler_progress progress;
+    wait_done(&fh, &progress);
+    assert(progress.requested == 4);
+    assert(progress.failed == 1);
+
+    file_handler_stop(&fh);
+    file_handler_join(&fh);
+    file_handler_destroy(&fh);
+
+    static char log[4096];
+    read_log(log, sizeof(log));
+    // a single worker processes the requests in order
+    assert(!strcmp(log, "push a.tmp /sdcard/file\n"
+                        "push b.tmp /sdcard/file\n"
+                        "install -r c.apk\n"
+                        "push fail.tmp /sdcard/file\n"));
+}
+
+static void test_batch_failure(void) {
+    remove(ADB_LOG);
+
+    struct file_handler fh;
+    bool ok = file_handler_init(&fh, NULL, "/sdcard/", 1);
+    assert(ok);
+
+    int64_t errors = metrics_get(METRIC_FILE_ERRORS);
+
+    // the next files are queued (and batched) while the first one is pushed
+    const char *names[] = {"x.tmp", "a.tmp", "fail.tmp", "b.tmp"};
+    for (int i = 0; i < 4; ++i) {
+        write_file(names[i], "0123456789");
+        ok = file_handler_request(&fh, ACTION_PUSH_FILE, SDL_strdup(names[i]));
+        assert(ok);
+    }
+
+    struct file_handler_progress progress;
+    wait_done(&fh, &progress);
+
+    file_handler_stop(&fh);
+    file_handler_join(&fh);
+    file_handler_destroy(&fh);
+
+    for (int i = 0; i < 4; ++i) {
+        remove(names[i]);
+    }
+
+    // whether it was batched or not, only the failed file is accounted as an
+    // error, and the other ones are transferred
+    assert(progress.requested == 4);
+    assert(progress.failed == 1);
+    assert(progress.bytes == 3 * 10);
+    assert(metrics_get(METRIC_FILE_ERRORS) == errors + 1);
+
+    static char log[4096];
+    read_log(log, sizeof(log));
+    assert(count_occurrences(log, "push fail.tmp /sdcard/\n") == 1);
+}
+
+static void test_cancel(void) {
+    remove(ADB_LOG);
+
+    struct file_handler fh;
+    bool ok = file_handler_init(&fh, NULL, "/sdcard/", 1);
+    assert(ok);
+
+    file_handler_request(&fh, ACTION_PUSH_FILE, SDL_strdup("slow.tmp"));
+
+    // wait for the first command to be executed
+    static char log[4096];
+    for (int i = 0; i < 1000 && !log[0]; ++i) {
+        SDL_Delay(10);
+        read_log(log, sizeof(log));
+    }
+    assert(!strcmp(log, "push slow.tmp /sdcard/\n"));
+
+    file_handler_request(&fh, ACTION_PUSH_FILE, SDL_strdup("pending.tmp"));
+
+    uint32_t start = SDL_GetTicks();
+    file_handler_stop(&fh);
+    file_handler_join(&fh);
+    file_handler_destroy(&fh);
+    // the running command is terminated rather than waited
+    assert(SDL_GetTicks() - start < 5000);
+
+    // the pending request is discarded
+    read_log(log, sizeof(log));
+    assert(!strcmp(log, "push slow.tmp /sdcard/\n"));
+    assert(metrics_get(METRIC_FILE_QUEUE) == 0);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    setup_adb();
+    test_batch();
+    test_no_batch();
+    test_batch_failure();
+    test_cancel();
+    remove(ADB_LOG);
+    remove(ADB_SCRIPT);
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <assert.h>
+
+#include "clock_sync.h"
+#include "frame_latency.h"
+#include "util/tick.h"
+
+// both clocks are the same
+static void
+synchronize(struct clock_sync *sync) {
+    clock_sync_add_exchange(sync, 100, 100, 100, 100);
+}
+
+static void test_not_synchronized(void) {
+    struct clock_sync sync;
+    bool ok = clock_sync_init(&sync);
+    assert(ok);
+
+    struct frame_latency fl;
+    ok = frame_latency_init(&fl, &sync);
+    assert(ok);
+
+    frame_latency_on_received(&fl, 0, tick_now_us());
+    frame_latency_on_decoded(&fl, 0);
+    frame_latency_on_presented(&fl, 0);
+
+    struct frame_latency_summary summary;
+    ok = frame_latency_take_summary(&fl, &summary);
+    assert(!ok);
+
+    frame_latency_destroy(&fl);
+    clock_sync_destroy(&sync);
+}
+
+static void test_latencies(void) {
+    struct clock_sync sync;
+    bool ok = clock_sync_init(&sync);
+    assert(ok);
+    synchronize(&sync);
+
+    struct frame_latency fl;
+    ok = frame_latency_init(&fl, &sync);
+    assert(ok);
+
+    // captured 10 ms ago
+    frame_latency_on_received(&fl, 1000, tick_now_us() - 10000);
+    frame_latency_on_decoded(&fl, 1000);
+    frame_latency_on_presented(&fl, 1000);
+    // a frame is presented only once
+    frame_latency_on_presented(&fl, 1000);
+
+    // not decoded
+    frame_latency_on_received(&fl, 2000, tick_now_us() - 10000);
+    frame_latency_on_presented(&fl, 2000);
+
+    struct frame_latency_summary summary;
+    ok = frame_latency_take_summary(&fl, &summary);
+    assert(ok);
+    assert(summary.count == 1);
+    assert(summary.receive.avg >= 10000);
+    assert(summary.decode.avg >= summary.receive.avg);
+    assert(summary.present.avg >= summary.decode.avg);
+    assert(summary.present.max == summary.present.avg);
+
+    // reset
+    ok = frame_latency_take_summary(&fl, &summary);
+    assert(!ok);
+
+    frame_latency_destroy(&fl);
+    clock_sync_destroy(&sync);
+}
+
+static void test_skipped_frames(void) {
+    struct clock_sync sync;
+    bool ok = clock_sync_init(&sync);
+    assert(ok);
+    synchronize(&sync);
+
+    struct frame_latency fl;
+    ok = frame_latency_init(&fl, &sync);
+    assert(ok);
+
+    for (int i = 0; i < FRAME_LATENCY_PENDING + 4; ++i) {
+        frame_latency_on_received(&fl, i, tick_now_us());
+        frame_latency_on_decoded(&fl, i);
+    }
+
+    // the oldest frames are forgotten
+    frame_latency_on_presented(&fl, 0);
+    struct frame_latency_summary summary;
+    ok = frame_latency_take_summary(&fl, &summary);
+    assert(!ok);
+
+    frame_latency_on_presented(&fl, FRAME_LATENCY_PENDING + 3);
+    ok = frame_latency_take_summary(&fl, &summary);
+    assert(ok);
+    assert(summary.count == 1);
+
+    frame_latency_destroy(&fl);
+    clock_sync_destroy(&sync);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    test_not_synchronized();
+    test_latencies();
+    test_skipped_frames();
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <assert.h>
+
+#include "hud_stats.h"
+#include "metrics.h"
+
+static void test_first_sample(void) {
+    struct hud_stats stats;
+    hud_stats_init(&stats);
+
+    // the first sample only records the current values
+    bool updated = hud_stats_update(&stats, 1000);
+    assert(!updated);
+    assert(stats.count == 0);
+
+    // the period has not elapsed
+    updated = hud_stats_update(&stats, 1000 + HUD_STATS_PERIOD_MS - 1);
+    assert(!updated);
+}
+
+static void test_rates(void) {
+    struct hud_stats stats;
+    hud_stats_init(&stats);
+    hud_stats_update(&stats, 1000);
+
+    metrics_add(METRIC_FRAMES_RENDERED, 30);
+    metrics_add(METRIC_DECODER_FRAMES, 32);
+    metrics_add(METRIC_FRAMES_SKIPPED, 2);
+    metrics_add(METRIC_STREAM_BYTES, 500000);
+    metrics_gauge_add(METRIC_RECORDER_QUEUE, 3);
+    metrics_observe(METRIC_FRAME_RECEIVE_LATENCY, 10000);
+    metrics_observe(METRIC_FRAME_RECEIVE_LATENCY, 20000);
+    metrics_observe(METRIC_FRAME_DECODE_LATENCY, 25000);
+    metrics_observe(METRIC_FRAME_DECODE_LATENCY, 35000);
+
+    bool updated = hud_stats_update(&stats, 1500);
+    assert(updated);
+    assert(stats.render_fps == 60);
+    assert(stats.decode_fps == 64);
+    assert(stats.skipped_fps == 4);
+    assert(stats.bit_rate == 8000000);
+    assert(stats.recorder_queue == 3);
+    assert(stats.count == 1);
+    assert(hud_stats_get_latency(&stats, HUD_STAGE_RECEIVE, 0) == 15000);
+    assert(hud_stats_get_latency(&stats, HUD_STAGE_DECODE, 0) == 30000);
+    // no frame presented
+    assert(hud_stats_get_latency(&stats, HUD_STAGE_PRESENT, 0) == 0);
+
+    // nothing happened during the next period
+    updated = hud_stats_update(&stats, 2000);
+    assert(updated);
+    assert(stats.render_fps == 0);
+    assert(stats.bit_rate == 0);
+    assert(stats.count == 2);
+    assert(hud_stats_get_latency(&stats, HUD_STAGE_RECEIVE, 1) == 0);
+
+    metrics_gauge_add(METRIC_RECORDER_QUEUE, -3);
+}
+
+static void test_history(void) {
+    struct hud_stats stats;
+    hud_stats_init(&stats);
+    uint32_t now = 0;
+    hud_stats_update(&stats, now);
+
+    // the first samples are out of the history
+    for (uint32_t i = 1; i <= HUD_STATS_HISTORY + 10; ++i) {
+        metrics_observe(METRIC_FRAME_LATENCY, i * 1000);
+        now += HUD_STATS_PERIOD_MS;
+        bool updated = hud_stats_update(&stats, now);
+        assert(updated);
+    }
+
+    assert(stats.count == HUD_STATS_HISTORY);
+    // from the oldest
+    assert(hud_stats_get_latency(&stats, HUD_STAGE_PRESENT, 0) == 11000);
+    assert(hud_stats_get_latency(&stats, HUD_STAGE_PRESENT,
+                                 HUD_STATS_HISTORY - 1)
+                == (HUD_STATS_HISTORY + 10) * 1000);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    test_first_sample();
+    test_rates();
+    test_history();
+    return 0;
+}
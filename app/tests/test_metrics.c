@@ -0,0 +1,139 @@
+#include <assert.h>
+#include <string.h>
+
+#include "metrics.h"
+#include "metrics_server.h"
+#include "util/net.h"
+
+#define IPV4_LOCALHOST 0x7F000001
+
+static void test_counters_and_gauges(void) {
+    int64_t packets = metrics_get(METRIC_STREAM_PACKETS);
+    metrics_inc(METRIC_STREAM_PACKETS);
+    metrics_add(METRIC_STREAM_PACKETS, 41);
+    assert(metrics_get(METRIC_STREAM_PACKETS) == packets + 42);
+
+    int64_t queue = metrics_get(METRIC_RECORDER_QUEUE);
+    metrics_gauge_add(METRIC_RECORDER_QUEUE, 3);
+    metrics_gauge_add(METRIC_RECORDER_QUEUE, -2);
+    assert(metrics_get(METRIC_RECORDER_QUEUE) == queue + 1);
+}
+
+static void test_histogram(void) {
+    int64_t count = metrics_get(METRIC_CONTROL_RTT);
+    metrics_observe(METRIC_CONTROL_RTT, 500); // 0.5 ms
+    metrics_observe(METRIC_CONTROL_RTT, 3000); // 3 ms
+    metrics_observe(METRIC_CONTROL_RTT, 5000000); // 5 s
+    assert(metrics_get(METRIC_CONTROL_RTT) == count + 3);
+}
+
+static void test_format(void) {
+    metrics_inc(METRIC_DECODER_ERRORS);
+    metrics_observe(METRIC_FRAME_LATENCY, 15000); // 15 ms
+    metrics_observe(METRIC_FRAME_LATENCY, 30000); // 30 ms
+
+    char buf[METRICS_TEXT_MAX_SIZE];
+    size_t len = metrics_format(buf, sizeof(buf));
+    assert(len);
+    assert(len == strlen(buf));
+
+    assert(strstr(buf, "# HELP scrcpy_decoder_errors_total "));
+    assert(strstr(buf, "# TYPE scrcpy_decoder_errors_total counter\n"
+                       "scrcpy_decoder_errors_total 1\n"));
+    assert(strstr(buf, "# TYPE scrcpy_recorder_queue_packets gauge\n"));
+    assert(strstr(buf, "# TYPE scrcpy_frame_latency_seconds histogram\n"));
+
+    // the buckets are cumulative
+    assert(strstr(buf, "scrcpy_frame_latency_seconds_bucket{le=\"0.01\"} 0\n"
+                       "scrcpy_frame_latency_seconds_bucket{le=\"0.02\"} 1\n"
+                       "scrcpy_frame_latency_seconds_bucket{le=\"0.05\"} 2\n"));
+    assert(strstr(buf, "scrcpy_frame_latency_seconds_bucket{le=\"+Inf\"} 2\n"
+                       "scrcpy_frame_latency_seconds_sum 0.045000\n"
+                       "scrcpy_frame_latency_seconds_count 2\n"));
+
+    // truncated
+    len = metrics_format(buf, 100);
+    assert(!len);
+}
+
+// send a request to the metrics server, and read the whole response
+static void
+http_request(uint16_t port, const char *request, char *response,
+             size_t size) {
+    socket_t socket = net_connect(IPV4_LOCALHOST, port);
+    assert(socket != INVALID_SOCKET);
+
+    ssize_t w = net_send_all(socket, request, strlen(request));
+    assert(w == (ssize_t) strlen(request));
+    (void) w;
+
+    size_t len = 0;
+    ssize_t r;
+    while ((r = net_recv(socket, &response[len], size - 1 - len)) > 0) {
+        len += r;
+    }
+    response[len] = '\0';
+    net_close(socket);
+}
+
+static void test_server(void) {
+    struct metrics_server server;
+    uint16_t port;
+    bool ok = false;
+    for (port = 27700; port < 27800; ++port) {
+        ok = metrics_server_init(&server, port, false);
+        if (ok) {
+            break;
+        }
+    }
+    assert(ok);
+
+    ok = metrics_server_start(&server);
+    assert(ok);
+
+    static char response[METRICS_TEXT_MAX_SIZE + 1024];
+    http_request(port, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n",
+                 response, sizeof(response));
+    assert(!strncmp(response, "HTTP/1.1 200 OK\r\n", 17));
+    assert(strstr(response, "Content-Type: text/plain; version=0.0.4"));
+    const char *body = strstr(response, "\r\n\r\n");
+    assert(body);
+    body += 4;
+    assert(!strncmp(body, "# HELP scrcpy_stream_packets_total ", 35));
+
+    http_request(port, "GET /other HTTP/1.1\r\n\r\n", response,
+                 sizeof(response));
+    assert(!strncmp(response, "HTTP/1.1 404 Not Found\r\n", 24));
+
+    http_request(port, "POST /metrics HTTP/1.1\r\n\r\n", response,
+                 sizeof(response));
+    assert(!strncmp(response, "HTTP/1.1 405 Method Not Allowed\r\n", 33));
+
+    // a client which never sends its request does not block the next ones
+    socket_t idle = net_connect(IPV4_LOCALHOST, port);
+    assert(idle != INVALID_SOCKET);
+    http_request(port, "GET /metrics HTTP/1.1\r\n\r\n", response,
+                 sizeof(response));
+    assert(!strncmp(response, "HTTP/1.1 200 OK\r\n", 17));
+    net_close(idle);
+
+    metrics_server_stop(&server);
+    metrics_server_join(&server);
+    metrics_server_destroy(&server);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    bool ok = net_init();
+    assert(ok);
+
+    test_counters_and_gauges();
+    test_histogram();
+    test_format();
+    test_server();
+
+    net_cleanup();
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "util/net.h"
+
+#ifdef __WINDOWS__
+# include <ws2tcpip.h>
+#else
+# include <netinet/in.h>
+# include <netinet/tcp.h>
+#endif
+
+#define IPV4_LOCALHOST 0x7F000001
+
+static void test_parse_ipv4(void) {
+    uint32_t addr;
+    bool ok;
+
+    ok = net_parse_ipv4("127.0.0.1", &addr);
+    assert(ok);
+    assert(addr == 0x7F000001);
+
+    ok = net_parse_ipv4("192.168.1.254", &addr);
+    assert(ok);
+    assert(addr == 0xC0A801FE);
+
+    ok = net_parse_ipv4("0.0.0.0", &addr);
+    assert(ok);
+    assert(addr == 0);
+
+    ok = net_parse_ipv4("255.255.255.255", &addr);
+    assert(ok);
+    assert(addr == 0xFFFFFFFF);
+
+    assert(!net_parse_ipv4("", &addr));
+    assert(!net_parse_ipv4("1.2.3", &addr));
+    assert(!net_parse_ipv4("1.2.3.4.5", &addr));
+    assert(!net_parse_ipv4("1.2.3.256", &addr));
+    assert(!net_parse_ipv4("1.2.3.0004", &addr));
+    assert(!net_parse_ipv4("1.2..4", &addr));
+    assert(!net_parse_ipv4("1.2.3.4 ", &addr));
+    assert(!net_parse_ipv4("a.b.c.d", &addr));
+}
+
+// listen on localhost on the first available port of a range
+static socket_t
+listen_on_any_port(uint16_t *port) {
+    for (uint16_t p = 27300; p < 27400; ++p) {
+        socket_t server_socket = net_listen(IPV4_LOCALHOST, p, 2);
+        if (server_socket != INVALID_SOCKET) {
+            *port = p;
+            return server_socket;
+        }
+    }
+    return INVALID_SOCKET;
+}
+
+static void test_connect_localhost(void) {
+    // the server socket stands in for the device server
+    uint16_t port;
+    socket_t server_socket = listen_on_any_port(&port);
+    assert(server_socket != INVALID_SOCKET);
+
+    // video socket, tuned before connecting
+    socket_t video_socket = net_socket();
+    assert(video_socket != INVALID_SOCKET);
+    bool ok = net_set_recv_buffer_size(video_socket, 1 << 20);
+    assert(ok);
+    ok = net_connect_socket(video_socket, IPV4_LOCALHOST, port);
+    assert(ok);
+
+    // control socket, tuned after connecting
+    socket_t control_socket = net_connect(IPV4_LOCALHOST, port);
+    assert(control_socket != INVALID_SOCKET);
+    ok = net_set_tcp_nodelay(control_socket, true);
+    assert(ok);
+
+    int value;
+    socklen_t len = sizeof(value);
+    int r = getsockopt(control_socket, IPPROTO_TCP, TCP_NODELAY,
+                       (void *) &value, &len);
+    assert(!r);
+    assert(value);
+
+    socket_t device_video_socket = net_accept(server_socket);
+    assert(device_video_socket != INVALID_SOCKET);
+    socket_t device_control_socket = net_accept(server_socket);
+    assert(device_control_socket != INVALID_SOCKET);
+
+    // like the device, send one byte on the video socket
+    char byte = 0;
+    ssize_t w = net_send_all(device_video_socket, &byte, 1);
+    assert(w == 1);
+    ssize_t rr = net_recv(video_socket, &byte, 1);
+    assert(rr == 1);
+
+    const char msg[] = "control message";
+    w = net_send_all(control_socket, msg, sizeof(msg));
+    assert(w > 0);
+    char buf[sizeof(msg)];
+    rr = net_recv_all(device_control_socket, buf, sizeof(buf));
+    assert(rr == sizeof(msg));
+    assert(!memcmp(buf, msg, sizeof(msg)));
+
+    net_close(device_control_socket);
+    net_close(device_video_socket);
+    net_close(control_socket);
+    net_close(video_socket);
+    net_close(server_socket);
+}
+
+static void test_connect_refused(void) {
+    uint16_t port;
+    socket_t server_socket = listen_on_any_port(&port);
+    assert(server_socket != INVALID_SOCKET);
+    // nobody listens anymore
+    net_close(server_socket);
+
+    socket_t socket = net_connect(IPV4_LOCALHOST, port);
+    assert(socket == INVALID_SOCKET);
+}
+
+#ifndef __WINDOWS__
+static void test_unix_socket(void) {
+    const char *path = "test_net_unix.sock";
+    socket_t server_socket = net_listen_unix(path, 1);
+    assert(server_socket != INVALID_SOCKET);
+    net_close(server_socket);
+
+    // the socket file left by the previous server is replaced
+    server_socket = net_listen_unix(path, 1);
+    assert(server_socket != INVALID_SOCKET);
+
+    socket_t socket = net_connect_unix(path);
+    assert(socket != INVALID_SOCKET);
+    socket_t server_side = net_accept(server_socket);
+    assert(server_side != INVALID_SOCKET);
+
+    const char msg[] = "get size";
+    ssize_t w = net_send_all(socket, msg, sizeof(msg));
+    assert(w > 0);
+    char buf[sizeof(msg)];
+    ssize_t r = net_recv_all(server_side, buf, sizeof(buf));
+    assert(r == sizeof(msg));
+    assert(!memcmp(buf, msg, sizeof(msg)));
+
+    net_close(server_side);
+    net_close(socket);
+    net_close(server_socket);
+    remove(path);
+
+    // a regular file is never replaced
+    FILE *file = fopen(path, "w");
+    assert(file);
+    fclose(file);
+    server_socket = net_listen_unix(path, 1);
+    assert(server_socket == INVALID_SOCKET);
+    remove(path);
+}
+#endif
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    bool ok = net_init();
+    assert(ok);
+
+    test_parse_ipv4();
+    test_connect_localhost();
+    test_connect_refused();
+#ifndef __WINDOWS__
+    test_unix_socket();
+#endif
+
+    net_cleanup();
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include <assert.h>
+#include <string.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_timer.h>
+
+#include "controller.h"
+#include "device_msg.h"
+#include "rtt_stats.h"
+#include "util/lock.h"
+#include "util/net.h"
+#include "util/tick.h"
+
+#define IPV4_LOCALHOST 0x7F000001
+
+// a mock device, replying to each ping by a pong after a delay
+struct mock_device {
+    socket_t server_socket;
+    uint16_t port;
+    SDL_Thread *thread;
+    uint32_t delay_ms;
+    unsigned pings;
+};
+
+static int
+run_mock_device(void *data) {
+    struct mock_device *device = data;
+    socket_t socket = net_accept(device->server_socket);
+    assert(socket != INVALID_SOCKET);
+
+    unsigned char ping[9];
+    while (net_recv_all(socket, ping, sizeof(ping)) == sizeof(ping)) {
+        // only pings are sent in these tests
+        assert(ping[0] == CONTROL_MSG_TYPE_PING);
+        ++device->pings;
+
+        SDL_Delay(device->delay_ms);
+
+        unsigned char pong[25];
+        pong[0] = DEVICE_MSG_TYPE_PONG;
+        // echo the timestamp
+        memcpy(&pong[1], &ping[1], 8);
+        // receive and send times, on the device clock (ignored here)
+        memset(&pong[9], 0, 16);
+        ssize_t w = net_send_all(socket, pong, sizeof(pong));
+        assert(w == sizeof(pong));
+        (void) w;
+    }
+
+    net_close(socket);
+    return 0;
+}
+
+static void
+mock_device_start(struct mock_device *device, uint32_t delay_ms) {
+    device->server_socket = INVALID_SOCKET;
+    for (uint16_t p = 27600; p < 27700; ++p) {
+        device->server_socket = net_listen(IPV4_LOCALHOST, p, 1);
+        if (device->server_socket != INVALID_SOCKET) {
+            device->port = p;
+            break;
+        }
+    }
+    assert(device->server_socket != INVALID_SOCKET);
+
+    device->delay_ms = delay_ms;
+    device->pings = 0;
+    device->thread = SDL_CreateThread(run_mock_device, "mock-device", device);
+    assert(device->thread);
+}
+
+static void
+mock_device_join(struct mock_device *device) {
+    SDL_WaitThread(device->thread, NULL);
+    net_close(device->server_socket);
+}
+
+static uint64_t
+get_total(struct rtt_stats *stats) {
+    mutex_lock(stats->mutex);
+    uint64_t total = stats->total;
+    mutex_unlock(stats->mutex);
+    return total;
+}
+
+static void test_no_samples(void) {
+    struct rtt_stats stats;
+    bool ok = rtt_stats_init(&stats, 0);
+    assert(ok);
+
+    struct rtt_percentiles percentiles;
+    ok = rtt_stats_get_percentiles(&stats, &percentiles);
+    assert(!ok);
+
+    rtt_stats_destroy(&stats);
+}
+
+static void test_percentiles(void) {
+    struct rtt_stats stats;
+    bool ok = rtt_stats_init(&stats, 0);
+    assert(ok);
+
+    // in any order
+    for (uint32_t i = 0; i < 100; ++i) {
+        rtt_stats_add(&stats, (i * 37) % 100 + 1);
+    }
+
+    struct rtt_percentiles percentiles;
+    ok = rtt_stats_get_percentiles(&stats, &percentiles);
+    assert(ok);
+    assert(percentiles.count == 100);
+    assert(percentiles.p50 == 50);
+    assert(percentiles.p90 == 90);
+    assert(percentiles.p99 == 99);
+    assert(percentiles.max == 100);
+
+    rtt_stats_destroy(&stats);
+}
+
+static void test_window(void) {
+    struct rtt_stats stats;
+    bool ok = rtt_stats_init(&stats, 0);
+    assert(ok);
+
+    // the first samples are out of the window
+    for (uint32_t i = 1; i <= RTT_STATS_WINDOW + 72; ++i) {
+        rtt_stats_add(&stats, i);
+    }
+    assert(stats.total == RTT_STATS_WINDOW + 72);
+
+    struct rtt_percentiles percentiles;
+    ok = rtt_stats_get_percentiles(&stats, &percentiles);
+    assert(ok);
+    assert(percentiles.count == RTT_STATS_WINDOW);
+    assert(percentiles.p50 == 72 + RTT_STATS_WINDOW / 2);
+    assert(percentiles.max == RTT_STATS_WINDOW + 72);
+
+    rtt_stats_destroy(&stats);
+}
+
+static void test_warning_threshold(void) {
+    struct rtt_stats stats;
+    bool ok = rtt_stats_init(&stats, 10); // 10 ms
+    assert(ok);
+
+    rtt_stats_add(&stats, 5000);
+    assert(!stats.above_threshold);
+    rtt_stats_add(&stats, 15000);
+    assert(stats.above_threshold);
+    rtt_stats_add(&stats, 8000);
+    assert(!stats.above_threshold);
+
+    rtt_stats_destroy(&stats);
+}
+
+static void test_ping_mock_device(void) {
+    struct mock_device device;
+    mock_device_start(&device, 10);
+
+    socket_t control_socket = net_connect(IPV4_LOCALHOST, device.port);
+    assert(control_socket != INVALID_SOCKET);
+
+    struct rtt_stats stats;
+    bool ok = rtt_stats_init(&stats, 5);
+    assert(ok);
+
+    struct controller controller;
+    ok = controller_init(&controller, control_socket,
+                         CONTROL_MSG_ENCODING_LEGACY, &stats, NULL,
+                         NULL);
+    assert(ok);
+    ok = controller_start(&controller);
+    assert(ok);
+
+    // in addition to the periodic pings
+    for (int i = 0; i < 5; ++i) {
+        struct control_msg msg = {
+            .type = CONTROL_MSG_TYPE_PING,
+            .ping = {
+                .timestamp = tick_now_us(),
+            },
+        };
+        ok = controller_push_msg(&controller, &msg);
+        assert(ok);
+    }
+
+    uint32_t deadline = SDL_GetTicks() + 5000;
+    while (get_total(&stats) < 5) {
+        assert(SDL_GetTicks() < deadline);
+        SDL_Delay(5);
+    }
+
+    controller_stop(&controller);
+    // wake up the receiver
+    net_shutdown(control_socket, SHUT_RDWR);
+    controller_join(&controller);
+    controller_destroy(&controller);
+    net_close(control_socket);
+    mock_device_join(&device);
+
+    assert(device.pings >= 5);
+
+    struct rtt_percentiles percentiles;
+    ok = rtt_stats_get_percentiles(&stats, &percentiles);
+    assert(ok);
+    assert(percentiles.count >= 5);
+    // each pong is delayed by 10 ms
+    assert(percentiles.p50 >= 10000);
+    assert(percentiles.max < 5000000);
+    assert(stats.above_threshold);
+
+    rtt_stats_destroy(&stats);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    bool ok = net_init();
+    assert(ok);
+
+    test_no_samples();
+    test_percentiles();
+    test_window();
+    test_warning_threshold();
+    test_ping_mock_device();
+
+    net_cleanup();
+    return 0;
+}
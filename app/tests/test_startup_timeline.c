@@ -0,0 +1,55 @@
+#include <assert.h>
+#include <string.h>
+
+#include "startup_timeline.h"
+
+static void test_startup_timeline_to_json(void) {
+    struct startup_timeline timeline;
+    bool ok = startup_timeline_init(&timeline, 1000);
+    assert(ok);
+
+    char json[256];
+    ok = startup_timeline_to_json(&timeline, json, sizeof(json));
+    assert(ok);
+    assert(!strcmp(json, "{\"spans\":[]}"));
+
+    startup_timeline_add(&timeline, "push_server", 1002, 1058);
+    startup_timeline_add_attempts(&timeline, "connect_to_server", 1060, 1095,
+                                  3);
+    startup_timeline_add(&timeline, "first_frame", 1000, 1420);
+    // must be ignored
+    startup_timeline_add(NULL, "ignored", 1000, 1001);
+
+    ok = startup_timeline_to_json(&timeline, json, sizeof(json));
+    assert(ok);
+    assert(!strcmp(json, "{\"spans\":["
+        "{\"name\":\"push_server\",\"start_ms\":2,\"end_ms\":58},"
+        "{\"name\":\"connect_to_server\",\"start_ms\":60,\"end_ms\":95,"
+        "\"attempts\":3},"
+        "{\"name\":\"first_frame\",\"start_ms\":0,\"end_ms\":420}]}"));
+
+    startup_timeline_destroy(&timeline);
+}
+
+static void test_startup_timeline_truncated(void) {
+    struct startup_timeline timeline;
+    bool ok = startup_timeline_init(&timeline, 0);
+    assert(ok);
+
+    startup_timeline_add(&timeline, "push_server", 2, 58);
+
+    char json[16];
+    ok = startup_timeline_to_json(&timeline, json, sizeof(json));
+    assert(!ok);
+
+    startup_timeline_destroy(&timeline);
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    test_startup_timeline_to_json();
+    test_startup_timeline_truncated();
+    return 0;
+}
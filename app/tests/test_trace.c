@@ -0,0 +1,102 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL_thread.h>
+
+#include "trace.h"
+
+#define TRACE_FILENAME "test_trace.tmp.json"
+
+// read the whole trace file
+static void
+read_trace(char *buf, size_t size) {
+    FILE *file = fopen(TRACE_FILENAME, "r");
+    assert(file);
+    size_t len = fread(buf, 1, size - 1, file);
+    assert(len < size - 1);
+    buf[len] = '\0';
+    fclose(file);
+}
+
+static unsigned
+count_occurrences(const char *s, const char *pattern) {
+    unsigned count = 0;
+    while ((s = strstr(s, pattern))) {
+        ++count;
+        s += strlen(pattern);
+    }
+    return count;
+}
+
+static int
+run_worker(void *data) {
+    (void) data;
+    trace_set_thread_name("worker");
+    for (int i = 0; i < 3; ++i) {
+        uint64_t start = trace_begin();
+        assert(start);
+        trace_end("work", start);
+    }
+    return 0;
+}
+
+static void test_disabled(void) {
+    // tracing is not initialized yet
+    uint64_t start = trace_begin();
+    assert(!start);
+    // must be ignored
+    trace_end("ignored", start);
+}
+
+static void test_write(void) {
+    bool ok = trace_init();
+    assert(ok);
+    trace_set_thread_name("main");
+
+    uint64_t start = trace_begin();
+    assert(start);
+    trace_end("main_span", start);
+
+    // restarted more times than TRACE_MAX_THREADS: each new thread continues
+    // the buffer released by the previous one
+    for (int i = 0; i < TRACE_MAX_THREADS + 1; ++i) {
+        SDL_Thread *thread = SDL_CreateThread(run_worker, "worker", NULL);
+        assert(thread);
+        SDL_WaitThread(thread, NULL);
+    }
+
+    ok = trace_write(TRACE_FILENAME);
+    assert(ok);
+
+    static char json[16384];
+    read_trace(json, sizeof(json));
+    remove(TRACE_FILENAME);
+
+    assert(!strncmp(json, "{\"traceEvents\":[\n", 17));
+    assert(strstr(json, "\n]}\n"));
+    assert(strstr(json, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                        "\"tid\":1,\"args\":{\"name\":\"main\"}}"));
+    assert(strstr(json, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                        "\"tid\":2,\"args\":{\"name\":\"worker\"}}"));
+    assert(strstr(json, "{\"name\":\"main_span\",\"ph\":\"X\",\"pid\":1,"
+                        "\"tid\":1,\"ts\":"));
+    assert(count_occurrences(json, "{\"name\":\"work\",\"ph\":\"X\","
+                                   "\"pid\":1,\"tid\":2,")
+                == 3 * (TRACE_MAX_THREADS + 1));
+    assert(count_occurrences(json, "\"name\":\"thread_name\"") == 2);
+    assert(!strstr(json, "ignored"));
+
+    trace_destroy();
+
+    // disabled again
+    assert(!trace_begin());
+}
+
+int main(int argc, char *argv[]) {
+    (void) argc;
+    (void) argv;
+
+    test_disabled();
+    test_write();
+    return 0;
+}
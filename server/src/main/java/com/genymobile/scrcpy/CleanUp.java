@@ -3,7 +3,6 @@ package com.genymobile.scrcpy;
 import com.genymobile.scrcpy.wrappers.ContentProvider;
 import com.genymobile.scrcpy.wrappers.ServiceManager;
 
-import java.io.File;
 import java.io.IOException;
 
 /**
@@ -13,7 +12,8 @@ import java.io.IOException;
  */
 public final class CleanUp {
 
-    public static final String SERVER_PATH = "/data/local/tmp/scrcpy-server.jar";
+    // The server jar is kept on the device (its name depends on its content), so that the client may skip pushing it on the next launch
+    private static final String SERVER_PATH = System.getProperty("java.class.path");
 
     private CleanUp() {
         // not instantiable
@@ -23,9 +23,6 @@ public final class CleanUp {
         boolean needProcess = disableShowTouches || restoreStayOn != -1 || restoreNormalPowerMode;
         if (needProcess) {
             startProcess(disableShowTouches, restoreStayOn, restoreNormalPowerMode);
-        } else {
-            // There is no additional clean up to do when scrcpy dies
-            unlinkSelf();
         }
     }
 
@@ -38,17 +35,7 @@ public final class CleanUp {
         builder.start();
     }
 
-    private static void unlinkSelf() {
-        try {
-            new File(SERVER_PATH).delete();
-        } catch (Exception e) {
-            Ln.e("Could not unlink server", e);
-        }
-    }
-
     public static void main(String... args) {
-        unlinkSelf();
-
         try {
             // Wait for the server to die
             System.in.read();
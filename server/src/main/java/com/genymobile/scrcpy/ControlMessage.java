@@ -16,6 +16,10 @@ public final class ControlMessage {
     public static final int TYPE_SET_CLIPBOARD = 8;
     public static final int TYPE_SET_SCREEN_POWER_MODE = 9;
     public static final int TYPE_ROTATE_DEVICE = 10;
+    public static final int TYPE_SET_VIDEO_SIZE = 11;
+    public static final int TYPE_SET_VIDEO_PAUSED = 12;
+    public static final int TYPE_ACK_FRAME = 13;
+    public static final int TYPE_PING = 14;
 
     private int type;
     private String text;
@@ -30,6 +34,16 @@ public final class ControlMessage {
     private int vScroll;
     private boolean paste;
     private int repeat;
+    private int maxSize;
+    private boolean setCrop;
+    private int cropWidth;
+    private int cropHeight;
+    private int cropX;
+    private int cropY;
+    private boolean paused;
+    private long pts;
+    private int skippedFrames;
+    private long timestamp;
 
     private ControlMessage() {
     }
@@ -89,6 +103,45 @@ public final class ControlMessage {
         return msg;
     }
 
+    /**
+     * @param maxSize the new max size (0 for unlimited)
+     * @param setCrop {@code false} to keep the current crop
+     * @param cropWidth the new crop width (0 to disable cropping)
+     */
+    public static ControlMessage createSetVideoSize(int maxSize, boolean setCrop, int cropWidth, int cropHeight, int cropX, int cropY) {
+        ControlMessage msg = new ControlMessage();
+        msg.type = TYPE_SET_VIDEO_SIZE;
+        msg.maxSize = maxSize;
+        msg.setCrop = setCrop;
+        msg.cropWidth = cropWidth;
+        msg.cropHeight = cropHeight;
+        msg.cropX = cropX;
+        msg.cropY = cropY;
+        return msg;
+    }
+
+    public static ControlMessage createSetVideoPaused(boolean paused) {
+        ControlMessage msg = new ControlMessage();
+        msg.type = TYPE_SET_VIDEO_PAUSED;
+        msg.paused = paused;
+        return msg;
+    }
+
+    public static ControlMessage createAckFrame(long pts, int skippedFrames) {
+        ControlMessage msg = new ControlMessage();
+        msg.type = TYPE_ACK_FRAME;
+        msg.pts = pts;
+        msg.skippedFrames = skippedFrames;
+        return msg;
+    }
+
+    public static ControlMessage createPing(long timestamp) {
+        ControlMessage msg = new ControlMessage();
+        msg.type = TYPE_PING;
+        msg.timestamp = timestamp;
+        return msg;
+    }
+
     public static ControlMessage createEmpty(int type) {
         ControlMessage msg = new ControlMessage();
         msg.type = type;
@@ -146,4 +199,44 @@ public final class ControlMessage {
     public int getRepeat() {
         return repeat;
     }
+
+    public int getMaxSize() {
+        return maxSize;
+    }
+
+    public boolean getSetCrop() {
+        return setCrop;
+    }
+
+    public int getCropWidth() {
+        return cropWidth;
+    }
+
+    public int getCropHeight() {
+        return cropHeight;
+    }
+
+    public int getCropX() {
+        return cropX;
+    }
+
+    public int getCropY() {
+        return cropY;
+    }
+
+    public boolean getPaused() {
+        return paused;
+    }
+
+    public long getPts() {
+        return pts;
+    }
+
+    public int getSkippedFrames() {
+        return skippedFrames;
+    }
+
+    public long getTimestamp() {
+        return timestamp;
+    }
 }
@@ -3,6 +3,7 @@ package com.genymobile.scrcpy;
 import java.io.EOFException;
 import java.io.IOException;
 import java.io.InputStream;
+import java.nio.BufferUnderflowException;
 import java.nio.ByteBuffer;
 import java.nio.charset.StandardCharsets;
 
@@ -13,6 +14,16 @@ public class ControlMessageReader {
     static final int INJECT_SCROLL_EVENT_PAYLOAD_LENGTH = 20;
     static final int SET_SCREEN_POWER_MODE_PAYLOAD_LENGTH = 1;
     static final int SET_CLIPBOARD_FIXED_PAYLOAD_LENGTH = 1;
+    static final int SET_VIDEO_SIZE_PAYLOAD_LENGTH = 11;
+    static final int SET_VIDEO_PAUSED_PAYLOAD_LENGTH = 1;
+    static final int ACK_FRAME_PAYLOAD_LENGTH = 10;
+    static final int PING_PAYLOAD_LENGTH = 8;
+
+    // flags of the compact touch and scroll events (see setCompact())
+    static final int COMPACT_FLAG_SIZE = 0x80;
+    static final int COMPACT_FLAG_PRESSURE = 0x40;
+    static final int COMPACT_FLAG_NO_PRESSURE = 0x20;
+    static final int COMPACT_ACTION_MASK = 0x1f;
 
     private static final int MESSAGE_MAX_SIZE = 1 << 18; // 256k
 
@@ -22,11 +33,30 @@ public class ControlMessageReader {
     private final byte[] rawBuffer = new byte[MESSAGE_MAX_SIZE];
     private final ByteBuffer buffer = ByteBuffer.wrap(rawBuffer);
 
+    private boolean compact;
+    // the last position and screen size received, in the compact encoding
+    private int lastX;
+    private int lastY;
+    private int screenWidth;
+    private int screenHeight;
+
     public ControlMessageReader() {
         // invariant: the buffer is always in "get" mode
         buffer.limit(0);
     }
 
+    /**
+     * Read the input events in the compact encoding: varints, positions relative to the previous one, screen size sent only when it changes
+     * (the other messages are the same in both encodings).
+     * <p>
+     * It must be set before the first message is read.
+     *
+     * @param compact true for the compact encoding, false for the legacy fixed-width encoding
+     */
+    public void setCompact(boolean compact) {
+        this.compact = compact;
+    }
+
     public boolean isFull() {
         return buffer.remaining() == rawBuffer.length;
     }
@@ -53,6 +83,15 @@ public class ControlMessageReader {
 
         int type = buffer.get();
         ControlMessage msg;
+        if (compact && isCompactType(type)) {
+            msg = parseCompact(type);
+            if (msg == null) {
+                // incomplete message
+                buffer.position(savedPosition);
+            }
+            return msg;
+        }
+
         switch (type) {
             case ControlMessage.TYPE_INJECT_KEYCODE:
                 msg = parseInjectKeycode();
@@ -72,6 +111,18 @@ public class ControlMessageReader {
             case ControlMessage.TYPE_SET_SCREEN_POWER_MODE:
                 msg = parseSetScreenPowerMode();
                 break;
+            case ControlMessage.TYPE_SET_VIDEO_SIZE:
+                msg = parseSetVideoSize();
+                break;
+            case ControlMessage.TYPE_SET_VIDEO_PAUSED:
+                msg = parseSetVideoPaused();
+                break;
+            case ControlMessage.TYPE_ACK_FRAME:
+                msg = parseAckFrame();
+                break;
+            case ControlMessage.TYPE_PING:
+                msg = parsePing();
+                break;
             case ControlMessage.TYPE_BACK_OR_SCREEN_ON:
             case ControlMessage.TYPE_EXPAND_NOTIFICATION_PANEL:
             case ControlMessage.TYPE_COLLAPSE_NOTIFICATION_PANEL:
@@ -132,10 +183,7 @@ public class ControlMessageReader {
         int action = toUnsigned(buffer.get());
         long pointerId = buffer.getLong();
         Position position = readPosition(buffer);
-        // 16 bits fixed-point
-        int pressureInt = toUnsigned(buffer.getShort());
-        // convert it to a float between 0 and 1 (0x1p16f is 2^16 as float)
-        float pressure = pressureInt == 0xffff ? 1f : (pressureInt / 0x1p16f);
+        float pressure = readPressure(buffer);
         int buttons = buffer.getInt();
         return ControlMessage.createInjectTouchEvent(action, pointerId, position, pressure, buttons);
     }
@@ -170,6 +218,149 @@ public class ControlMessageReader {
         return ControlMessage.createSetScreenPowerMode(mode);
     }
 
+    private ControlMessage parseSetVideoSize() {
+        if (buffer.remaining() < SET_VIDEO_SIZE_PAYLOAD_LENGTH) {
+            return null;
+        }
+        int maxSize = toUnsigned(buffer.getShort());
+        boolean setCrop = buffer.get() != 0;
+        int cropWidth = toUnsigned(buffer.getShort());
+        int cropHeight = toUnsigned(buffer.getShort());
+        int cropX = toUnsigned(buffer.getShort());
+        int cropY = toUnsigned(buffer.getShort());
+        return ControlMessage.createSetVideoSize(maxSize, setCrop, cropWidth, cropHeight, cropX, cropY);
+    }
+
+    private ControlMessage parseSetVideoPaused() {
+        if (buffer.remaining() < SET_VIDEO_PAUSED_PAYLOAD_LENGTH) {
+            return null;
+        }
+        boolean paused = buffer.get() != 0;
+        return ControlMessage.createSetVideoPaused(paused);
+    }
+
+    private ControlMessage parseAckFrame() {
+        if (buffer.remaining() < ACK_FRAME_PAYLOAD_LENGTH) {
+            return null;
+        }
+        long pts = buffer.getLong();
+        int skippedFrames = toUnsigned(buffer.getShort());
+        return ControlMessage.createAckFrame(pts, skippedFrames);
+    }
+
+    private ControlMessage parsePing() {
+        if (buffer.remaining() < PING_PAYLOAD_LENGTH) {
+            return null;
+        }
+        long timestamp = buffer.getLong();
+        return ControlMessage.createPing(timestamp);
+    }
+
+    private static boolean isCompactType(int type) {
+        return type == ControlMessage.TYPE_INJECT_KEYCODE || type == ControlMessage.TYPE_INJECT_TOUCH_EVENT
+                || type == ControlMessage.TYPE_INJECT_SCROLL_EVENT;
+    }
+
+    private ControlMessage parseCompact(int type) {
+        try {
+            switch (type) {
+                case ControlMessage.TYPE_INJECT_KEYCODE:
+                    return parseCompactInjectKeycode();
+                case ControlMessage.TYPE_INJECT_TOUCH_EVENT:
+                    return parseCompactInjectTouchEvent();
+                case ControlMessage.TYPE_INJECT_SCROLL_EVENT:
+                    return parseCompactInjectScrollEvent();
+                default:
+                    throw new AssertionError("Not a compact type: " + type);
+            }
+        } catch (BufferUnderflowException e) {
+            return null;
+        }
+    }
+
+    private ControlMessage parseCompactInjectKeycode() {
+        int action = toUnsigned(buffer.get());
+        int keycode = (int) readVarint();
+        int repeat = (int) readVarint();
+        int metaState = (int) readVarint();
+        return ControlMessage.createInjectKeycode(action, keycode, repeat, metaState);
+    }
+
+    private ControlMessage parseCompactInjectTouchEvent() {
+        int actionAndFlags = toUnsigned(buffer.get());
+        int action = actionAndFlags & COMPACT_ACTION_MASK;
+        long pointerId = readSignedVarint();
+        Position position = readCompactPosition(actionAndFlags);
+        float pressure;
+        if ((actionAndFlags & COMPACT_FLAG_PRESSURE) != 0) {
+            pressure = readPressure(buffer);
+        } else if ((actionAndFlags & COMPACT_FLAG_NO_PRESSURE) != 0) {
+            pressure = 0f;
+        } else {
+            pressure = 1f;
+        }
+        int buttons = (int) readVarint();
+        // the message is complete
+        commitPosition(position);
+        return ControlMessage.createInjectTouchEvent(action, pointerId, position, pressure, buttons);
+    }
+
+    private ControlMessage parseCompactInjectScrollEvent() {
+        int flags = toUnsigned(buffer.get());
+        Position position = readCompactPosition(flags);
+        int hScroll = (int) readSignedVarint();
+        int vScroll = (int) readSignedVarint();
+        // the message is complete
+        commitPosition(position);
+        return ControlMessage.createInjectScrollEvent(position, hScroll, vScroll);
+    }
+
+    // the state is not updated until the whole message is read (it may be incomplete)
+    private Position readCompactPosition(int flags) {
+        int width = screenWidth;
+        int height = screenHeight;
+        if ((flags & COMPACT_FLAG_SIZE) != 0) {
+            width = (int) readVarint();
+            height = (int) readVarint();
+        }
+        int x = lastX + (int) readSignedVarint();
+        int y = lastY + (int) readSignedVarint();
+        return new Position(x, y, width, height);
+    }
+
+    private void commitPosition(Position position) {
+        lastX = position.getPoint().getX();
+        lastY = position.getPoint().getY();
+        screenWidth = position.getScreenSize().getWidth();
+        screenHeight = position.getScreenSize().getHeight();
+    }
+
+    // unsigned LEB128, throw BufferUnderflowException if incomplete
+    private long readVarint() {
+        long value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            byte b = buffer.get();
+            value |= (long) (b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                break;
+            }
+        }
+        return value;
+    }
+
+    // zigzag-encoded
+    private long readSignedVarint() {
+        long zigzag = readVarint();
+        return (zigzag >>> 1) ^ -(zigzag & 1);
+    }
+
+    private static float readPressure(ByteBuffer buffer) {
+        // 16 bits fixed-point
+        int pressureInt = toUnsigned(buffer.getShort());
+        // convert it to a float between 0 and 1 (0x1p16f is 2^16 as float)
+        return pressureInt == 0xffff ? 1f : (pressureInt / 0x1p16f);
+    }
+
     private static Position readPosition(ByteBuffer buffer) {
         int x = buffer.getInt();
         int y = buffer.getInt();
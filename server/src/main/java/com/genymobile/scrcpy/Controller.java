@@ -1,5 +1,6 @@
 package com.genymobile.scrcpy;
 
+import android.graphics.Rect;
 import android.os.Build;
 import android.os.SystemClock;
 import android.view.InputDevice;
@@ -20,6 +21,7 @@ public class Controller {
 
     private final Device device;
     private final DesktopConnection connection;
+    private final ScreenEncoder screenEncoder;
     private final DeviceMessageSender sender;
 
     private final KeyCharacterMap charMap = KeyCharacterMap.load(KeyCharacterMap.VIRTUAL_KEYBOARD);
@@ -31,9 +33,10 @@ public class Controller {
 
     private boolean keepPowerModeOff;
 
-    public Controller(Device device, DesktopConnection connection) {
+    public Controller(Device device, DesktopConnection connection, ScreenEncoder screenEncoder) {
         this.device = device;
         this.connection = connection;
+        this.screenEncoder = screenEncoder;
         initPointers();
         sender = new DeviceMessageSender(connection);
     }
@@ -132,11 +135,35 @@ public class Controller {
             case ControlMessage.TYPE_ROTATE_DEVICE:
                 device.rotateDevice();
                 break;
+            case ControlMessage.TYPE_SET_VIDEO_SIZE:
+                setVideoSize(msg);
+                break;
+            case ControlMessage.TYPE_SET_VIDEO_PAUSED:
+                screenEncoder.setPaused(msg.getPaused());
+                break;
+            case ControlMessage.TYPE_ACK_FRAME:
+                screenEncoder.onFrameAck(msg.getPts(), msg.getSkippedFrames());
+                break;
+            case ControlMessage.TYPE_PING:
+                sender.pushPong(msg.getTimestamp(), Device.getMonotonicTimeUs());
+                break;
             default:
                 // do nothing
         }
     }
 
+    private void setVideoSize(ControlMessage msg) {
+        Rect crop = null; // keep the current crop
+        if (msg.getSetCrop()) {
+            int x = msg.getCropX();
+            int y = msg.getCropY();
+            crop = new Rect(x, y, x + msg.getCropWidth(), y + msg.getCropHeight());
+        }
+        if (device.setVideoConstraints(msg.getMaxSize(), crop)) {
+            screenEncoder.resetCapture();
+        }
+    }
+
     private boolean injectKeycode(int action, int keycode, int repeat, int metaState) {
         if (keepPowerModeOff && action == KeyEvent.ACTION_UP && (keycode == KeyEvent.KEYCODE_POWER || keycode == KeyEvent.KEYCODE_WAKEUP)) {
             schedulePowerModeOff();
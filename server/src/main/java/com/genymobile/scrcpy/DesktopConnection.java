@@ -3,12 +3,18 @@ package com.genymobile.scrcpy;
 import android.net.LocalServerSocket;
 import android.net.LocalSocket;
 import android.net.LocalSocketAddress;
+import android.os.ParcelFileDescriptor;
 
 import java.io.Closeable;
+import java.io.DataInputStream;
 import java.io.FileDescriptor;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
+import java.net.InetAddress;
+import java.net.InetSocketAddress;
+import java.net.ServerSocket;
+import java.net.Socket;
 import java.nio.charset.StandardCharsets;
 
 public final class DesktopConnection implements Closeable {
@@ -16,11 +22,23 @@ public final class DesktopConnection implements Closeable {
     private static final int DEVICE_NAME_FIELD_LENGTH = 64;
 
     private static final String SOCKET_NAME = "scrcpy";
+    // a persistent server must not prevent a normal session from listening on SOCKET_NAME
+    private static final String PERSISTENT_SOCKET_NAME = "scrcpy-persistent";
 
-    private final LocalSocket videoSocket;
+    private static final int VIDEO_SOCKET_SEND_BUFFER_SIZE = 1 << 20; // 1MB
+
+    // the reply to the session args on a persistent server
+    private static final int SESSION_ACCEPTED = 0;
+    private static final int SESSION_REJECTED = 1;
+
+    // LocalSocket or Socket
+    private final Closeable videoSocket;
     private final FileDescriptor videoFd;
+    // only for a TCP video socket, which does not expose its file descriptor
+    private final ParcelFileDescriptor videoPfd;
 
-    private final LocalSocket controlSocket;
+    // LocalSocket or Socket
+    private final Closeable controlSocket;
     private final InputStream controlInputStream;
     private final OutputStream controlOutputStream;
 
@@ -33,6 +51,16 @@ public final class DesktopConnection implements Closeable {
         controlInputStream = controlSocket.getInputStream();
         controlOutputStream = controlSocket.getOutputStream();
         videoFd = videoSocket.getFileDescriptor();
+        videoPfd = null;
+    }
+
+    private DesktopConnection(Socket videoSocket, Socket controlSocket) throws IOException {
+        this.videoSocket = videoSocket;
+        this.controlSocket = controlSocket;
+        controlInputStream = controlSocket.getInputStream();
+        controlOutputStream = controlSocket.getOutputStream();
+        videoPfd = ParcelFileDescriptor.fromSocket(videoSocket);
+        videoFd = videoPfd.getFileDescriptor();
     }
 
     private static LocalSocket connect(String abstractName) throws IOException {
@@ -41,21 +69,136 @@ public final class DesktopConnection implements Closeable {
         return localSocket;
     }
 
-    public static DesktopConnection open(Device device, boolean tunnelForward) throws IOException {
+    /**
+     * Listen on a TCP port.
+     * <p>
+     * The connections are not authenticated: anyone able to connect could view the screen and inject input events. Therefore, the
+     * other network interfaces than loopback are only used on explicit request.
+     *
+     * @param port          the TCP port
+     * @param allInterfaces {@code true} to listen on all the network interfaces, {@code false} to listen on loopback only
+     * @return the server socket
+     * @throws IOException if the socket could not be bound
+     */
+    private static ServerSocket listenTcp(int port, boolean allInterfaces) throws IOException {
+        ServerSocket serverSocket = new ServerSocket();
+        try {
+            // the port may still be in TIME_WAIT state from a previous session
+            serverSocket.setReuseAddress(true);
+            InetSocketAddress address = allInterfaces ? new InetSocketAddress(port) : new InetSocketAddress(InetAddress.getLoopbackAddress(), port);
+            serverSocket.bind(address);
+        } catch (IOException | RuntimeException e) {
+            serverSocket.close();
+            throw e;
+        }
+        return serverSocket;
+    }
+
+    private static DesktopConnection acceptTcp(ServerSocket serverSocket) throws IOException {
+        Socket videoSocket = serverSocket.accept();
+        Socket controlSocket;
+        try {
+            videoSocket.setSendBufferSize(VIDEO_SOCKET_SEND_BUFFER_SIZE);
+            // send one byte so the client may read() to detect a connection error
+            videoSocket.getOutputStream().write(0);
+            controlSocket = serverSocket.accept();
+            // control and device messages are small and latency-sensitive
+            controlSocket.setTcpNoDelay(true);
+        } catch (IOException | RuntimeException e) {
+            videoSocket.close();
+            throw e;
+        }
+        return new DesktopConnection(videoSocket, controlSocket);
+    }
+
+    private static DesktopConnection acceptLocal(LocalServerSocket localServerSocket) throws IOException {
+        LocalSocket videoSocket = localServerSocket.accept();
+        LocalSocket controlSocket;
+        try {
+            // send one byte so the client may read() to detect a connection error
+            videoSocket.getOutputStream().write(0);
+            controlSocket = localServerSocket.accept();
+        } catch (IOException | RuntimeException e) {
+            videoSocket.close();
+            throw e;
+        }
+        return new DesktopConnection(videoSocket, controlSocket);
+    }
+
+    private static DesktopConnection openTcp(int port, boolean allInterfaces) throws IOException {
+        try (ServerSocket serverSocket = listenTcp(port, allInterfaces)) {
+            return acceptTcp(serverSocket);
+        }
+    }
+
+    public static DesktopConnection open(Device device, boolean tunnelForward, int tcpPort, boolean tcpAllInterfaces) throws IOException {
+        DesktopConnection connection;
+        if (tcpPort != 0) {
+            connection = openTcp(tcpPort, tcpAllInterfaces);
+        } else {
+            connection = openLocal(tunnelForward);
+        }
+
+        connection.sendDeviceInfo(device);
+        return connection;
+    }
+
+    /**
+     * Listen for successive connections, for a persistent server (the client is always "adb forward"-like, it connects to the device).
+     *
+     * @param tcpPort          the TCP port to listen on, or 0 to listen on the local abstract socket "scrcpy-persistent" (through "adb
+     *                         forward")
+     * @param tcpAllInterfaces {@code true} to listen on all the network interfaces rather than loopback only (if tcpPort is not 0)
+     * @return the listener
+     * @throws IOException if the socket could not be bound
+     */
+    public static Listener listen(int tcpPort, boolean tcpAllInterfaces) throws IOException {
+        if (tcpPort != 0) {
+            return new Listener(listenTcp(tcpPort, tcpAllInterfaces), null);
+        }
+        return new Listener(null, new LocalServerSocket(PERSISTENT_SOCKET_NAME));
+    }
+
+    public static final class Listener implements Closeable {
+        // exactly one of them is not null
+        private final ServerSocket serverSocket;
+        private final LocalServerSocket localServerSocket;
+
+        private Listener(ServerSocket serverSocket, LocalServerSocket localServerSocket) {
+            this.serverSocket = serverSocket;
+            this.localServerSocket = localServerSocket;
+        }
+
+        /**
+         * Accept the next client. The device info is not sent, it must be sent once the session options are received.
+         *
+         * @return the connection
+         * @throws IOException on connection error
+         */
+        public DesktopConnection accept() throws IOException {
+            if (serverSocket != null) {
+                return acceptTcp(serverSocket);
+            }
+            return acceptLocal(localServerSocket);
+        }
+
+        @Override
+        public void close() throws IOException {
+            if (serverSocket != null) {
+                serverSocket.close();
+            } else {
+                localServerSocket.close();
+            }
+        }
+    }
+
+    private static DesktopConnection openLocal(boolean tunnelForward) throws IOException {
         LocalSocket videoSocket;
         LocalSocket controlSocket;
         if (tunnelForward) {
             LocalServerSocket localServerSocket = new LocalServerSocket(SOCKET_NAME);
             try {
-                videoSocket = localServerSocket.accept();
-                // send one byte so the client may read() to detect a connection error
-                videoSocket.getOutputStream().write(0);
-                try {
-                    controlSocket = localServerSocket.accept();
-                } catch (IOException | RuntimeException e) {
-                    videoSocket.close();
-                    throw e;
-                }
+                return acceptLocal(localServerSocket);
             } finally {
                 localServerSocket.close();
             }
@@ -69,19 +212,60 @@ public final class DesktopConnection implements Closeable {
             }
         }
 
-        DesktopConnection connection = new DesktopConnection(videoSocket, controlSocket);
-        Size videoSize = device.getScreenInfo().getVideoSize();
-        connection.send(Device.getDeviceName(), videoSize.getWidth(), videoSize.getHeight());
-        return connection;
+        return new DesktopConnection(videoSocket, controlSocket);
     }
 
     public void close() throws IOException {
-        videoSocket.shutdownInput();
-        videoSocket.shutdownOutput();
-        videoSocket.close();
-        controlSocket.shutdownInput();
-        controlSocket.shutdownOutput();
-        controlSocket.close();
+        if (videoPfd != null) {
+            videoPfd.close();
+        }
+        shutdownAndClose(videoSocket);
+        shutdownAndClose(controlSocket);
+    }
+
+    private static void shutdownAndClose(Closeable socket) throws IOException {
+        if (socket instanceof LocalSocket) {
+            LocalSocket localSocket = (LocalSocket) socket;
+            localSocket.shutdownInput();
+            localSocket.shutdownOutput();
+        } else {
+            Socket tcpSocket = (Socket) socket;
+            tcpSocket.shutdownInput();
+            tcpSocket.shutdownOutput();
+        }
+        socket.close();
+    }
+
+    public void sendDeviceInfo(Device device) throws IOException {
+        Size videoSize = device.getScreenInfo().getVideoSize();
+        send(Device.getDeviceName(), videoSize.getWidth(), videoSize.getHeight());
+    }
+
+    /**
+     * Receive the options of a new session on a persistent server: the server arguments, separated by '\n', prefixed by their length (16-bit
+     * big-endian).
+     *
+     * @return the server arguments
+     * @throws IOException on connection error
+     */
+    public String[] receiveSessionArgs() throws IOException {
+        DataInputStream input = new DataInputStream(controlInputStream);
+        int len = input.readUnsignedShort();
+        byte[] buffer = new byte[len];
+        input.readFully(buffer);
+        return new String(buffer, StandardCharsets.UTF_8).split("\n", -1);
+    }
+
+    /**
+     * Reply to the session options received by {@link #receiveSessionArgs()}. The client waits for the reply, so that it may start a new
+     * server if they are rejected.
+     *
+     * @param accepted {@code true} if the session is started with these options
+     * @throws IOException on connection error
+     */
+    public void sendSessionStatus(boolean accepted) throws IOException {
+        controlOutputStream.write(accepted ? SESSION_ACCEPTED : SESSION_REJECTED);
+        controlOutputStream.flush();
     }
 
     private void send(String deviceName, int width, int height) throws IOException {
@@ -103,6 +287,10 @@ public final class DesktopConnection implements Closeable {
         return videoFd;
     }
 
+    public void setCompactControl(boolean compactControl) {
+        reader.setCompact(compactControl);
+    }
+
     public ControlMessage receiveControlMessage() throws IOException {
         ControlMessage msg = reader.next();
         while (msg == null) {
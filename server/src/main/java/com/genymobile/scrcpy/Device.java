@@ -40,6 +40,10 @@ public final class Device {
     private ClipboardListener clipboardListener;
     private final AtomicBoolean isSettingClipboard = new AtomicBoolean();
 
+    // registered to the system services, to be unregistered by release()
+    private final IRotationWatcher rotationWatcher;
+    private IOnPrimaryClipChangedListener primaryClipChangedListener;
+
     /**
      * Logical display identifier
      */
@@ -52,6 +56,13 @@ public final class Device {
 
     private final boolean supportsInputEvents;
 
+    /**
+     * Current video constraints, which may be changed at runtime
+     */
+    private int maxSize;
+    private Rect crop;
+    private final int lockedVideoOrientation;
+
     public Device(Options options) {
         displayId = options.getDisplayId();
         DisplayInfo displayInfo = serviceManager.getDisplayManager().getDisplayInfo(displayId);
@@ -62,10 +73,13 @@ public final class Device {
 
         int displayInfoFlags = displayInfo.getFlags();
 
-        screenInfo = ScreenInfo.computeScreenInfo(displayInfo, options.getCrop(), options.getMaxSize(), options.getLockedVideoOrientation());
+        maxSize = options.getMaxSize();
+        crop = options.getCrop();
+        lockedVideoOrientation = options.getLockedVideoOrientation();
+        screenInfo = ScreenInfo.computeScreenInfo(displayInfo, crop, maxSize, lockedVideoOrientation);
         layerStack = displayInfo.getLayerStack();
 
-        serviceManager.getWindowManager().registerRotationWatcher(new IRotationWatcher.Stub() {
+        rotationWatcher = new IRotationWatcher.Stub() {
             @Override
             public void onRotationChanged(int rotation) {
                 synchronized (Device.this) {
@@ -77,13 +91,14 @@ public final class Device {
                     }
                 }
             }
-        }, displayId);
+        };
+        serviceManager.getWindowManager().registerRotationWatcher(rotationWatcher, displayId);
 
         if (options.getControl()) {
             // If control is enabled, synchronize Android clipboard to the computer automatically
             ClipboardManager clipboardManager = serviceManager.getClipboardManager();
             if (clipboardManager != null) {
-                clipboardManager.addPrimaryClipChangedListener(new IOnPrimaryClipChangedListener.Stub() {
+                primaryClipChangedListener = new IOnPrimaryClipChangedListener.Stub() {
                     @Override
                     public void dispatchPrimaryClipChanged() {
                         if (isSettingClipboard.get()) {
@@ -99,7 +114,8 @@ public final class Device {
                             }
                         }
                     }
-                });
+                };
+                clipboardManager.addPrimaryClipChangedListener(primaryClipChangedListener);
             } else {
                 Ln.w("No clipboard manager, copy-paste between device and computer will not work");
             }
@@ -116,10 +132,62 @@ public final class Device {
         }
     }
 
+    /**
+     * Unregister the callbacks registered to the system services.
+     * <p>
+     * Must be called once the device is not used anymore if the process survives it (typically for a persistent server), otherwise the
+     * callbacks (and the device) would leak.
+     */
+    public void release() {
+        serviceManager.getWindowManager().removeRotationWatcher(rotationWatcher);
+        if (primaryClipChangedListener != null) {
+            ClipboardManager clipboardManager = serviceManager.getClipboardManager();
+            if (clipboardManager != null) {
+                clipboardManager.removePrimaryClipChangedListener(primaryClipChangedListener);
+            }
+        }
+        synchronized (this) {
+            rotationListener = null;
+            clipboardListener = null;
+        }
+    }
+
     public synchronized ScreenInfo getScreenInfo() {
         return screenInfo;
     }
 
+    /**
+     * Change the video size constraints at runtime.
+     *
+     * @param newMaxSize the new max size (0 means unlimited)
+     * @param newCrop the new crop rectangle, {@code null} to keep the current one, or an empty rectangle to disable cropping
+     * @return {@code true} if the screen info changed (the capture must be reset)
+     */
+    public synchronized boolean setVideoConstraints(int newMaxSize, Rect newCrop) {
+        DisplayInfo displayInfo = serviceManager.getDisplayManager().getDisplayInfo(displayId);
+        if (displayInfo == null) {
+            Ln.w("Could not get display info, video constraints not changed");
+            return false;
+        }
+
+        maxSize = newMaxSize & ~7; // multiple of 8
+        if (newCrop != null) {
+            crop = newCrop.isEmpty() ? null : newCrop;
+        }
+
+        ScreenInfo newScreenInfo = ScreenInfo.computeScreenInfo(displayInfo, crop, maxSize, lockedVideoOrientation);
+        boolean unchanged = newScreenInfo.getContentRect().equals(screenInfo.getContentRect())
+                && newScreenInfo.getVideoSize().equals(screenInfo.getVideoSize());
+        if (unchanged) {
+            return false;
+        }
+
+        screenInfo = newScreenInfo;
+        Size videoSize = screenInfo.getVideoSize();
+        Ln.i("Video size changed to " + videoSize.getWidth() + "x" + videoSize.getHeight());
+        return true;
+    }
+
     public int getLayerStack() {
         return layerStack;
     }
@@ -237,6 +305,16 @@ public final class Device {
         return ok;
     }
 
+    /**
+     * Return the monotonic time in microseconds.
+     * <p>
+     * It is the clock of the capture timestamps (the surface timestamps use {@code CLOCK_MONOTONIC}), so it is used for the clock
+     * synchronization with the client.
+     */
+    public static long getMonotonicTimeUs() {
+        return System.nanoTime() / 1000;
+    }
+
     /**
      * @param mode one of the {@code POWER_MODE_*} constants
      */
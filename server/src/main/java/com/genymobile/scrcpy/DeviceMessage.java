@@ -3,9 +3,15 @@ package com.genymobile.scrcpy;
 public final class DeviceMessage {
 
     public static final int TYPE_CLIPBOARD = 0;
+    public static final int TYPE_PONG = 1;
+    public static final int TYPE_ENCODER_STATS = 2;
 
     private int type;
     private String text;
+    private long timestamp;
+    private long receiveTime;
+    private long sendTime;
+    private EncoderStats encoderStats;
 
     private DeviceMessage() {
     }
@@ -17,6 +23,27 @@ public final class DeviceMessage {
         return event;
     }
 
+    /**
+     * @param timestamp   the timestamp of the ping (client clock)
+     * @param receiveTime the time the ping was received (device clock)
+     * @param sendTime    the time the pong is sent (device clock)
+     */
+    public static DeviceMessage createPong(long timestamp, long receiveTime, long sendTime) {
+        DeviceMessage event = new DeviceMessage();
+        event.type = TYPE_PONG;
+        event.timestamp = timestamp;
+        event.receiveTime = receiveTime;
+        event.sendTime = sendTime;
+        return event;
+    }
+
+    public static DeviceMessage createEncoderStats(EncoderStats encoderStats) {
+        DeviceMessage event = new DeviceMessage();
+        event.type = TYPE_ENCODER_STATS;
+        event.encoderStats = encoderStats;
+        return event;
+    }
+
     public int getType() {
         return type;
     }
@@ -24,4 +51,20 @@ public final class DeviceMessage {
     public String getText() {
         return text;
     }
+
+    public long getTimestamp() {
+        return timestamp;
+    }
+
+    public long getReceiveTime() {
+        return receiveTime;
+    }
+
+    public long getSendTime() {
+        return sendTime;
+    }
+
+    public EncoderStats getEncoderStats() {
+        return encoderStats;
+    }
 }
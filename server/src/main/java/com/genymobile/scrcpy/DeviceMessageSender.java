@@ -1,12 +1,27 @@
 package com.genymobile.scrcpy;
 
 import java.io.IOException;
+import java.util.ArrayDeque;
+import java.util.Queue;
 
 public final class DeviceMessageSender {
 
+    private static final class PendingPong {
+        private final long timestamp;
+        private final long receiveTime;
+
+        private PendingPong(long timestamp, long receiveTime) {
+            this.timestamp = timestamp;
+            this.receiveTime = receiveTime;
+        }
+    }
+
     private final DesktopConnection connection;
 
     private String clipboardText;
+    private EncoderStats encoderStats;
+    // the pings to echo, in order
+    private final Queue<PendingPong> pongs = new ArrayDeque<>();
 
     public DeviceMessageSender(DesktopConnection connection) {
         this.connection = connection;
@@ -17,17 +32,42 @@ public final class DeviceMessageSender {
         notify();
     }
 
+    /**
+     * Push the latest encoder statistics (replacing the previous ones if they are not sent yet).
+     */
+    public synchronized void pushEncoderStats(EncoderStats stats) {
+        encoderStats = stats;
+        notify();
+    }
+
+    /**
+     * @param timestamp   the timestamp of the ping
+     * @param receiveTime the time the ping was received, from {@link Device#getMonotonicTimeUs()}
+     */
+    public synchronized void pushPong(long timestamp, long receiveTime) {
+        pongs.add(new PendingPong(timestamp, receiveTime));
+        notify();
+    }
+
     public void loop() throws IOException, InterruptedException {
         while (true) {
-            String text;
+            DeviceMessage event;
             synchronized (this) {
-                while (clipboardText == null) {
+                while (clipboardText == null && encoderStats == null && pongs.isEmpty()) {
                     wait();
                 }
-                text = clipboardText;
-                clipboardText = null;
+                if (!pongs.isEmpty()) {
+                    // pongs first, to not delay them behind a large clipboard
+                    PendingPong pong = pongs.remove();
+                    event = DeviceMessage.createPong(pong.timestamp, pong.receiveTime, Device.getMonotonicTimeUs());
+                } else if (encoderStats != null) {
+                    event = DeviceMessage.createEncoderStats(encoderStats);
+                    encoderStats = null;
+                } else {
+                    event = DeviceMessage.createClipboard(clipboardText);
+                    clipboardText = null;
+                }
             }
-            DeviceMessage event = DeviceMessage.createClipboard(text);
             connection.sendDeviceMessage(event);
         }
     }
@@ -7,22 +7,39 @@ import java.nio.charset.StandardCharsets;
 
 public class DeviceMessageWriter {
 
-    private static final int MESSAGE_MAX_SIZE = 1 << 18; // 256k
-    public static final int CLIPBOARD_TEXT_MAX_LENGTH = MESSAGE_MAX_SIZE - 5; // type: 1 byte; length: 4 bytes
+    // the fixed part of a message (the clipboard text is written directly, the client streams it)
+    private static final int HEADER_MAX_SIZE = 33;
+    public static final int CLIPBOARD_TEXT_MAX_LENGTH = 1 << 24; // 16M, as accepted by the client
 
-    private final byte[] rawBuffer = new byte[MESSAGE_MAX_SIZE];
+    private final byte[] rawBuffer = new byte[HEADER_MAX_SIZE];
     private final ByteBuffer buffer = ByteBuffer.wrap(rawBuffer);
 
     public void writeTo(DeviceMessage msg, OutputStream output) throws IOException {
         buffer.clear();
-        buffer.put((byte) DeviceMessage.TYPE_CLIPBOARD);
+        buffer.put((byte) msg.getType());
         switch (msg.getType()) {
             case DeviceMessage.TYPE_CLIPBOARD:
                 String text = msg.getText();
                 byte[] raw = text.getBytes(StandardCharsets.UTF_8);
                 int len = StringUtils.getUtf8TruncationIndex(raw, CLIPBOARD_TEXT_MAX_LENGTH);
                 buffer.putInt(len);
-                buffer.put(raw, 0, len);
+                output.write(rawBuffer, 0, buffer.position());
+                output.write(raw, 0, len);
+                break;
+            case DeviceMessage.TYPE_PONG:
+                buffer.putLong(msg.getTimestamp());
+                buffer.putLong(msg.getReceiveTime());
+                buffer.putLong(msg.getSendTime());
+                output.write(rawBuffer, 0, buffer.position());
+                break;
+            case DeviceMessage.TYPE_ENCODER_STATS:
+                EncoderStats stats = msg.getEncoderStats();
+                buffer.putInt(stats.getFrames());
+                buffer.putLong(stats.getBytes());
+                buffer.putLong(stats.getDequeueWaitUs());
+                buffer.putInt(stats.getRestarts());
+                buffer.putInt(stats.getBitRate());
+                buffer.putInt(stats.getMaxFps());
                 output.write(rawBuffer, 0, buffer.position());
                 break;
             default:
@@ -0,0 +1,63 @@
+package com.genymobile.scrcpy;
+
+/**
+ * Snapshot of the statistics of the screen encoder, reported periodically to the client.
+ * <p>
+ * The counters are cumulative since the start of the encoder.
+ */
+public final class EncoderStats {
+    private final int frames;
+    private final long bytes;
+    private final long dequeueWaitUs;
+    private final int restarts;
+    private final int bitRate;
+    private final int maxFps;
+
+    public EncoderStats(int frames, long bytes, long dequeueWaitUs, int restarts, int bitRate, int maxFps) {
+        this.frames = frames;
+        this.bytes = bytes;
+        this.dequeueWaitUs = dequeueWaitUs;
+        this.restarts = restarts;
+        this.bitRate = bitRate;
+        this.maxFps = maxFps;
+    }
+
+    /**
+     * @return the number of encoded frames produced
+     */
+    public int getFrames() {
+        return frames;
+    }
+
+    /**
+     * @return the number of encoded bytes produced (including the codec config packets)
+     */
+    public long getBytes() {
+        return bytes;
+    }
+
+    /**
+     * @return the time spent waiting in {@code dequeueOutputBuffer()}, in microseconds (including the idle time when the screen does not change)
+     */
+    public long getDequeueWaitUs() {
+        return dequeueWaitUs;
+    }
+
+    /**
+     * @return the number of codec restarts (on rotation or screen size change)
+     */
+    public int getRestarts() {
+        return restarts;
+    }
+
+    public int getBitRate() {
+        return bitRate;
+    }
+
+    /**
+     * @return the fps cap, 0 if none
+     */
+    public int getMaxFps() {
+        return maxFps;
+    }
+}
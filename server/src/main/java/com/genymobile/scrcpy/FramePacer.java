@@ -0,0 +1,62 @@
+package com.genymobile.scrcpy;
+
+/**
+ * Track the frames sent to the client which have not been acknowledged yet, to detect when the client cannot keep up.
+ * <p>
+ * The client acknowledges each frame it displays (which also acknowledges the older frames it skipped). When too many frames are in
+ * flight, the capture should be throttled until the client has caught up.
+ * <p>
+ * Only the pending count decides: while the capture is throttled, the frames in flight are still acknowledged, so the count always
+ * goes down and the capture is eventually resumed.
+ */
+public class FramePacer {
+
+    private static final int MAX_PENDING_FRAMES = 16;
+    private static final int RESUME_PENDING_FRAMES = 1;
+
+    private final long[] pendingPts = new long[MAX_PENDING_FRAMES * 2];
+    private int head; // index of the oldest pending frame
+    private int count;
+
+    // pacing is enabled only once the client has acknowledged a frame
+    private boolean active;
+    private boolean throttled;
+
+    public synchronized void onFrameSent(long pts) {
+        if (!active) {
+            return;
+        }
+        if (count == pendingPts.length) {
+            // forget the oldest frame
+            head = (head + 1) % pendingPts.length;
+            --count;
+        }
+        pendingPts[(head + count) % pendingPts.length] = pts;
+        ++count;
+    }
+
+    /**
+     * Handle a frame acknowledgement from the client.
+     *
+     * @param pts the PTS of the last frame displayed by the client
+     * @return {@code true} if the capture must be throttled
+     */
+    public synchronized boolean onFrameAck(long pts) {
+        active = true;
+        while (count > 0 && pendingPts[head] <= pts) {
+            head = (head + 1) % pendingPts.length;
+            --count;
+        }
+
+        if (count > MAX_PENDING_FRAMES) {
+            throttled = true;
+        } else if (count <= RESUME_PENDING_FRAMES) {
+            throttled = false;
+        }
+        return throttled;
+    }
+
+    public synchronized int getPendingCount() {
+        return count;
+    }
+}
@@ -16,6 +16,10 @@ public class Options {
     private boolean showTouches;
     private boolean stayAwake;
     private String codecOptions;
+    private int tcpPort; // 0 to use an adb tunnel
+    private boolean tcpAllInterfaces; // listen on all the network interfaces rather than loopback only
+    private int idleTimeout; // in seconds, 0 if the server is not persistent
+    private boolean compactControl;
 
     public Ln.Level getLogLevel() {
         return logLevel;
@@ -120,4 +124,36 @@ public class Options {
     public void setCodecOptions(String codecOptions) {
         this.codecOptions = codecOptions;
     }
+
+    public int getTcpPort() {
+        return tcpPort;
+    }
+
+    public void setTcpPort(int tcpPort) {
+        this.tcpPort = tcpPort;
+    }
+
+    public boolean getTcpAllInterfaces() {
+        return tcpAllInterfaces;
+    }
+
+    public void setTcpAllInterfaces(boolean tcpAllInterfaces) {
+        this.tcpAllInterfaces = tcpAllInterfaces;
+    }
+
+    public int getIdleTimeout() {
+        return idleTimeout;
+    }
+
+    public void setIdleTimeout(int idleTimeout) {
+        this.idleTimeout = idleTimeout;
+    }
+
+    public boolean getCompactControl() {
+        return compactControl;
+    }
+
+    public void setCompactControl(boolean compactControl) {
+        this.compactControl = compactControl;
+    }
 }
@@ -6,6 +6,7 @@ import android.graphics.Rect;
 import android.media.MediaCodec;
 import android.media.MediaCodecInfo;
 import android.media.MediaFormat;
+import android.os.Bundle;
 import android.os.IBinder;
 import android.view.Surface;
 
@@ -23,8 +24,8 @@ public class ScreenEncoder implements Device.RotationListener {
 
     private static final int NO_PTS = -1;
 
-    private final AtomicBoolean rotationChanged = new AtomicBoolean();
-    private final ByteBuffer headerBuffer = ByteBuffer.allocate(12);
+    private final AtomicBoolean resetCapture = new AtomicBoolean();
+    private final ByteBuffer headerBuffer = ByteBuffer.allocate(20);
 
     private List<CodecOption> codecOptions;
     private int bitRate;
@@ -32,6 +33,19 @@ public class ScreenEncoder implements Device.RotationListener {
     private boolean sendFrameMeta;
     private long ptsOrigin;
 
+    // the codec currently encoding, if any (guarded by this)
+    private MediaCodec currentCodec;
+    private boolean paused; // guarded by this
+    private boolean throttled; // guarded by this
+    private boolean stopped; // guarded by this
+    private final FramePacer framePacer = new FramePacer();
+
+    // statistics reported to the client (guarded by this)
+    private int producedFrames;
+    private long producedBytes;
+    private long dequeueWaitUs;
+    private int codecRestarts;
+
     public ScreenEncoder(boolean sendFrameMeta, int bitRate, int maxFps, List<CodecOption> codecOptions) {
         this.sendFrameMeta = sendFrameMeta;
         this.bitRate = bitRate;
@@ -41,11 +55,112 @@ public class ScreenEncoder implements Device.RotationListener {
 
     @Override
     public void onRotationChanged(int rotation) {
-        rotationChanged.set(true);
+        resetCapture();
+    }
+
+    /**
+     * Request to restart the capture, so that the new screen info (size, crop, rotation) is applied.
+     */
+    public void resetCapture() {
+        resetCapture.set(true);
+    }
+
+    public boolean consumeResetCapture() {
+        return resetCapture.getAndSet(false);
+    }
+
+    /**
+     * Suspend or resume the encoding (typically when the client window is hidden or shown).
+     * <p>
+     * On resume, a sync frame is requested so that the client can display the content immediately.
+     */
+    public synchronized void setPaused(boolean paused) {
+        if (this.paused == paused) {
+            return;
+        }
+        this.paused = paused;
+        Ln.d("Video encoding " + (paused ? "paused" : "resumed"));
+        updateSuspended(!paused);
+    }
+
+    /**
+     * Handle a frame acknowledgement from the client, to suspend the capture while the client cannot keep up.
+     *
+     * @param pts           the PTS of the last frame displayed by the client
+     * @param skippedFrames the number of frames skipped by the client since the previous acknowledgement
+     */
+    public void onFrameAck(long pts, int skippedFrames) {
+        if (skippedFrames > 0) {
+            Ln.d("Client skipped " + skippedFrames + " frames");
+        }
+        boolean throttle = framePacer.onFrameAck(pts);
+        setThrottled(throttle);
+    }
+
+    private synchronized void setThrottled(boolean throttled) {
+        if (this.throttled == throttled) {
+            return;
+        }
+        this.throttled = throttled;
+        updateSuspended(false);
+    }
+
+    /**
+     * Stop streaming (typically when the client is disconnected), even if no frames are produced.
+     */
+    public synchronized void stop() {
+        stopped = true;
+        if (currentCodec != null) {
+            currentCodec.signalEndOfInputStream();
+        }
     }
 
-    public boolean consumeRotationChange() {
-        return rotationChanged.getAndSet(false);
+    private synchronized boolean isStopped() {
+        return stopped;
+    }
+
+    public synchronized EncoderStats getStats() {
+        return new EncoderStats(producedFrames, producedBytes, dequeueWaitUs, codecRestarts, bitRate, maxFps);
+    }
+
+    private synchronized void onOutputBuffer(MediaCodec.BufferInfo bufferInfo, int size, long waitUs) {
+        if ((bufferInfo.flags & MediaCodec.BUFFER_FLAG_CODEC_CONFIG) == 0) {
+            ++producedFrames;
+        }
+        producedBytes += size;
+        dequeueWaitUs += waitUs;
+    }
+
+    private synchronized void onCodecRestart() {
+        ++codecRestarts;
+    }
+
+    private synchronized void setCurrentCodec(MediaCodec codec) {
+        currentCodec = codec;
+        if (codec != null) {
+            if (stopped) {
+                codec.signalEndOfInputStream();
+            } else if (paused || throttled) {
+                applySuspended(codec, true, false);
+            }
+        }
+    }
+
+    // must be called with the lock held
+    private void updateSuspended(boolean requestSyncFrame) {
+        if (currentCodec != null) {
+            applySuspended(currentCodec, paused || throttled, requestSyncFrame);
+        }
+    }
+
+    private static void applySuspended(MediaCodec codec, boolean suspended, boolean requestSyncFrame) {
+        // Suspending drops the input frames, so the encoded stream remains valid (skipping encoded frames would break the decoding)
+        Bundle params = new Bundle();
+        params.putInt(MediaCodec.PARAMETER_KEY_SUSPEND, suspended ? 1 : 0);
+        if (!suspended && requestSyncFrame) {
+            params.putInt(MediaCodec.PARAMETER_KEY_REQUEST_SYNC_FRAME, 0);
+        }
+        codec.setParameters(params);
     }
 
     public void streamScreen(Device device, FileDescriptor fd) throws IOException {
@@ -67,8 +182,13 @@ public class ScreenEncoder implements Device.RotationListener {
         MediaFormat format = createFormat(bitRate, maxFps, codecOptions);
         device.setRotationListener(this);
         boolean alive;
+        boolean first = true;
         try {
             do {
+                if (!first) {
+                    onCodecRestart();
+                }
+                first = false;
                 MediaCodec codec = createCodec();
                 IBinder display = createDisplay();
                 ScreenInfo screenInfo = device.getScreenInfo();
@@ -85,16 +205,19 @@ public class ScreenEncoder implements Device.RotationListener {
                 Surface surface = codec.createInputSurface();
                 setDisplaySurface(display, surface, videoRotation, contentRect, unlockedVideoRect, layerStack);
                 codec.start();
+                setCurrentCodec(codec);
                 try {
                     alive = encode(codec, fd);
+                    setCurrentCodec(null);
                     // do not call stop() on exception, it would trigger an IllegalStateException
                     codec.stop();
                 } finally {
+                    setCurrentCodec(null);
                     destroyDisplay(display);
                     codec.release();
                     surface.release();
                 }
-            } while (alive);
+            } while (alive && !isStopped());
         } finally {
             device.setRotationListener(null);
         }
@@ -104,16 +227,19 @@ public class ScreenEncoder implements Device.RotationListener {
         boolean eof = false;
         MediaCodec.BufferInfo bufferInfo = new MediaCodec.BufferInfo();
 
-        while (!consumeRotationChange() && !eof) {
+        while (!consumeResetCapture() && !eof) {
+            long dequeueStart = System.nanoTime();
             int outputBufferId = codec.dequeueOutputBuffer(bufferInfo, -1);
+            long waitUs = (System.nanoTime() - dequeueStart) / 1000;
             eof = (bufferInfo.flags & MediaCodec.BUFFER_FLAG_END_OF_STREAM) != 0;
             try {
-                if (consumeRotationChange()) {
+                if (consumeResetCapture()) {
                     // must restart encoding with new size
                     break;
                 }
                 if (outputBufferId >= 0) {
                     ByteBuffer codecBuffer = codec.getOutputBuffer(outputBufferId);
+                    onOutputBuffer(bufferInfo, codecBuffer.remaining(), waitUs);
 
                     if (sendFrameMeta) {
                         writeFrameMeta(fd, bufferInfo, codecBuffer.remaining());
@@ -135,16 +261,22 @@ public class ScreenEncoder implements Device.RotationListener {
         headerBuffer.clear();
 
         long pts;
+        long captureTime;
         if ((bufferInfo.flags & MediaCodec.BUFFER_FLAG_CODEC_CONFIG) != 0) {
             pts = NO_PTS; // non-media data packet
+            captureTime = 0;
         } else {
+            // absolute, on the clock of Device.getMonotonicTimeUs(), so that the client may compute the latency
+            captureTime = bufferInfo.presentationTimeUs;
             if (ptsOrigin == 0) {
                 ptsOrigin = bufferInfo.presentationTimeUs;
             }
             pts = bufferInfo.presentationTimeUs - ptsOrigin;
+            framePacer.onFrameSent(pts);
         }
 
         headerBuffer.putLong(pts);
+        headerBuffer.putLong(captureTime);
         headerBuffer.putInt(packetSize);
         headerBuffer.flip();
         IO.writeFully(fd, headerBuffer);
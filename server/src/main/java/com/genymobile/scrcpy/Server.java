@@ -10,10 +10,16 @@ import android.os.Build;
 import java.io.IOException;
 import java.util.List;
 import java.util.Locale;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.ScheduledFuture;
+import java.util.concurrent.TimeUnit;
 
 public final class Server {
 
 
+    private static final int ENCODER_STATS_PERIOD_MS = 1000;
+
     private Server() {
         // not instantiable
     }
@@ -21,67 +27,193 @@ public final class Server {
     private static void scrcpy(Options options) throws IOException {
         Ln.i("Device: " + Build.MANUFACTURER + " " + Build.MODEL + " (Android " + Build.VERSION.RELEASE + ")");
         final Device device = new Device(options);
+
+        SettingsRestore restore = applySettings(device, options);
+        CleanUp.configure(restore.disableShowTouches, restore.restoreStayOn, true);
+
+        boolean tunnelForward = options.isTunnelForward();
+        int tcpPort = options.getTcpPort();
+        boolean tcpAllInterfaces = options.getTcpAllInterfaces();
+
+        try (DesktopConnection connection = DesktopConnection.open(device, tunnelForward, tcpPort, tcpAllInterfaces)) {
+            streamSession(options, device, connection);
+        }
+    }
+
+    /**
+     * Run as a daemon accepting successive clients, so that a client may attach without pushing and starting the server again.
+     * <p>
+     * The options of each session are sent by the client on connection. The server exits if no client is connected for the idle timeout.
+     */
+    private static void runPersistent(Options options) throws IOException {
+        Ln.i("Persistent server on device: " + Build.MANUFACTURER + " " + Build.MODEL + " (Android " + Build.VERSION.RELEASE + ")");
+        final int idleTimeout = options.getIdleTimeout();
+        ScheduledExecutorService idleExecutor = Executors.newSingleThreadScheduledExecutor();
+
+        try (DesktopConnection.Listener listener = DesktopConnection.listen(options.getTcpPort(), options.getTcpAllInterfaces())) {
+            while (true) {
+                ScheduledFuture<?> idleExit = idleExecutor.schedule(new Runnable() {
+                    @Override
+                    public void run() {
+                        Ln.i("No client for " + idleTimeout + " seconds, exiting");
+                        System.exit(0);
+                    }
+                }, idleTimeout, TimeUnit.SECONDS);
+
+                DesktopConnection connection = listener.accept();
+                idleExit.cancel(false);
+
+                Options sessionOptions;
+                try {
+                    sessionOptions = createOptions(connection.receiveSessionArgs());
+                } catch (IllegalArgumentException e) {
+                    rejectSession(listener, connection, e);
+                    return;
+                } catch (IOException e) {
+                    Ln.w("Could not receive the session options: " + e.getMessage());
+                    connection.close();
+                    continue;
+                }
+
+                try {
+                    connection.sendSessionStatus(true);
+                    Ln.initLogLevel(sessionOptions.getLogLevel());
+                    runSession(sessionOptions, connection);
+                } catch (IOException e) {
+                    Ln.w("Session failed: " + e.getMessage());
+                } catch (RuntimeException e) {
+                    // a failure of this session (invalid display, encoder error...) must not stop the server for the next clients
+                    Ln.e("Session failed", e);
+                    suggestFix(e);
+                } finally {
+                    connection.close();
+                }
+                Ln.i("Client disconnected, waiting for the next one");
+            }
+        }
+    }
+
+    /**
+     * Reject the session of a client sending incompatible options (typically, the client has been upgraded), and exit so that it may start a
+     * new server.
+     */
+    private static void rejectSession(DesktopConnection.Listener listener, DesktopConnection connection, IllegalArgumentException e)
+            throws IOException {
+        Ln.e("Incompatible client, exiting", e);
+        // release the socket before replying, so that the new server may listen on it as soon as the client receives the reply
+        listener.close();
+        try {
+            connection.sendSessionStatus(false);
+        } finally {
+            connection.close();
+            System.exit(1);
+        }
+    }
+
+    private static void runSession(Options options, DesktopConnection connection) throws IOException {
+        Device device = new Device(options);
+        try {
+            connection.sendDeviceInfo(device);
+
+            SettingsRestore restore = applySettings(device, options);
+            try {
+                streamSession(options, device, connection);
+            } finally {
+                // the process survives the session, so the CleanUp process would never be triggered
+                restore.run(device);
+            }
+        } finally {
+            device.release();
+        }
+    }
+
+    private static void streamSession(Options options, Device device, DesktopConnection connection) throws IOException {
         List<CodecOption> codecOptions = CodecOption.parse(options.getCodecOptions());
+        ScreenEncoder screenEncoder = new ScreenEncoder(options.getSendFrameMeta(), options.getBitRate(), options.getMaxFps(), codecOptions);
+
+        Thread senderThread = null;
+        ScheduledExecutorService statsExecutor = null;
+        if (options.getControl()) {
+            connection.setCompactControl(options.getCompactControl());
+            final Controller controller = new Controller(device, connection, screenEncoder);
+
+            // asynchronous
+            startController(controller, screenEncoder);
+            senderThread = startDeviceMessageSender(controller.getSender());
+            statsExecutor = startEncoderStatsReporter(screenEncoder, controller.getSender());
+
+            device.setClipboardListener(new Device.ClipboardListener() {
+                @Override
+                public void onClipboardTextChanged(String text) {
+                    controller.getSender().pushClipboardText(text);
+                }
+            });
+        }
+
+        try {
+            // synchronous
+            screenEncoder.streamScreen(device, connection.getVideoFd());
+        } catch (IOException e) {
+            // this is expected on close
+            Ln.d("Screen streaming stopped");
+        } finally {
+            if (statsExecutor != null) {
+                statsExecutor.shutdownNow();
+            }
+            if (senderThread != null) {
+                senderThread.interrupt();
+            }
+        }
+    }
+
+    private static final class SettingsRestore {
+        private boolean disableShowTouches;
+        private int restoreStayOn = -1;
+
+        void run(Device device) {
+            if (disableShowTouches || restoreStayOn != -1) {
+                try (ContentProvider settings = device.createSettingsProvider()) {
+                    if (disableShowTouches) {
+                        settings.putValue(ContentProvider.TABLE_SYSTEM, "show_touches", "0");
+                    }
+                    if (restoreStayOn != -1) {
+                        settings.putValue(ContentProvider.TABLE_GLOBAL, "stay_on_while_plugged_in", String.valueOf(restoreStayOn));
+                    }
+                }
+            }
+            Device.setScreenPowerMode(Device.POWER_MODE_NORMAL);
+        }
+    }
 
-        boolean mustDisableShowTouchesOnCleanUp = false;
-        int restoreStayOn = -1;
+    private static SettingsRestore applySettings(Device device, Options options) {
+        SettingsRestore restore = new SettingsRestore();
         if (options.getShowTouches() || options.getStayAwake()) {
             try (ContentProvider settings = device.createSettingsProvider()) {
                 if (options.getShowTouches()) {
                     String oldValue = settings.getAndPutValue(ContentProvider.TABLE_SYSTEM, "show_touches", "1");
                     // If "show touches" was disabled, it must be disabled back on clean up
-                    mustDisableShowTouchesOnCleanUp = !"1".equals(oldValue);
+                    restore.disableShowTouches = !"1".equals(oldValue);
                 }
 
                 if (options.getStayAwake()) {
                     int stayOn = BatteryManager.BATTERY_PLUGGED_AC | BatteryManager.BATTERY_PLUGGED_USB | BatteryManager.BATTERY_PLUGGED_WIRELESS;
                     String oldValue = settings.getAndPutValue(ContentProvider.TABLE_GLOBAL, "stay_on_while_plugged_in", String.valueOf(stayOn));
                     try {
-                        restoreStayOn = Integer.parseInt(oldValue);
-                        if (restoreStayOn == stayOn) {
+                        restore.restoreStayOn = Integer.parseInt(oldValue);
+                        if (restore.restoreStayOn == stayOn) {
                             // No need to restore
-                            restoreStayOn = -1;
+                            restore.restoreStayOn = -1;
                         }
                     } catch (NumberFormatException e) {
-                        restoreStayOn = 0;
+                        restore.restoreStayOn = 0;
                     }
                 }
             }
         }
-
-        CleanUp.configure(mustDisableShowTouchesOnCleanUp, restoreStayOn, true);
-
-        boolean tunnelForward = options.isTunnelForward();
-
-        try (DesktopConnection connection = DesktopConnection.open(device, tunnelForward)) {
-            ScreenEncoder screenEncoder = new ScreenEncoder(options.getSendFrameMeta(), options.getBitRate(), options.getMaxFps(), codecOptions);
-
-            if (options.getControl()) {
-                final Controller controller = new Controller(device, connection);
-
-                // asynchronous
-                startController(controller);
-                startDeviceMessageSender(controller.getSender());
-
-                device.setClipboardListener(new Device.ClipboardListener() {
-                    @Override
-                    public void onClipboardTextChanged(String text) {
-                        controller.getSender().pushClipboardText(text);
-                    }
-                });
-            }
-
-            try {
-                // synchronous
-                screenEncoder.streamScreen(device, connection.getVideoFd());
-            } catch (IOException e) {
-                // this is expected on close
-                Ln.d("Screen streaming stopped");
-            }
-        }
+        return restore;
     }
 
-    private static void startController(final Controller controller) {
+    private static void startController(final Controller controller, final ScreenEncoder screenEncoder) {
         new Thread(new Runnable() {
             @Override
             public void run() {
@@ -90,13 +222,15 @@ public final class Server {
                 } catch (IOException e) {
                     // this is expected on close
                     Ln.d("Controller stopped");
+                    // the client is gone: end the session even if no frames are produced (the video socket error is only detected on write)
+                    screenEncoder.stop();
                 }
             }
         }).start();
     }
 
-    private static void startDeviceMessageSender(final DeviceMessageSender sender) {
-        new Thread(new Runnable() {
+    private static Thread startDeviceMessageSender(final DeviceMessageSender sender) {
+        Thread thread = new Thread(new Runnable() {
             @Override
             public void run() {
                 try {
@@ -106,7 +240,20 @@ public final class Server {
                     Ln.d("Device message sender stopped");
                 }
             }
-        }).start();
+        });
+        thread.start();
+        return thread;
+    }
+
+    private static ScheduledExecutorService startEncoderStatsReporter(final ScreenEncoder screenEncoder, final DeviceMessageSender sender) {
+        ScheduledExecutorService executor = Executors.newSingleThreadScheduledExecutor();
+        executor.scheduleAtFixedRate(new Runnable() {
+            @Override
+            public void run() {
+                sender.pushEncoderStats(screenEncoder.getStats());
+            }
+        }, ENCODER_STATS_PERIOD_MS, ENCODER_STATS_PERIOD_MS, TimeUnit.MILLISECONDS);
+        return executor;
     }
 
     private static Options createOptions(String... args) {
@@ -120,7 +267,7 @@ public final class Server {
                     "The server version (" + BuildConfig.VERSION_NAME + ") does not match the client " + "(" + clientVersion + ")");
         }
 
-        final int expectedParameters = 14;
+        final int expectedParameters = 18;
         if (args.length != expectedParameters) {
             throw new IllegalArgumentException("Expecting " + expectedParameters + " parameters");
         }
@@ -167,6 +314,22 @@ public final class Server {
         String codecOptions = args[13];
         options.setCodecOptions(codecOptions);
 
+        // if not 0, listen on this TCP port instead of using an adb tunnel
+        int tcpPort = Integer.parseInt(args[14]);
+        options.setTcpPort(tcpPort);
+
+        // if not 0, keep the server running between clients, until no client is connected for this delay (in seconds)
+        int idleTimeout = Integer.parseInt(args[15]);
+        options.setIdleTimeout(idleTimeout);
+
+        // the encoding of the control messages (see ControlMessageReader.setCompact())
+        boolean compactControl = Boolean.parseBoolean(args[16]);
+        options.setCompactControl(compactControl);
+
+        // listen on all the network interfaces rather than loopback only (if tcpPort is not 0)
+        boolean tcpAllInterfaces = Boolean.parseBoolean(args[17]);
+        options.setTcpAllInterfaces(tcpAllInterfaces);
+
         return options;
     }
 
@@ -222,6 +385,10 @@ public final class Server {
 
         Ln.initLogLevel(options.getLogLevel());
 
-        scrcpy(options);
+        if (options.getIdleTimeout() != 0) {
+            runPersistent(options);
+        } else {
+            scrcpy(options);
+        }
     }
 }
@@ -15,6 +15,7 @@ public class ClipboardManager {
     private Method getPrimaryClipMethod;
     private Method setPrimaryClipMethod;
     private Method addPrimaryClipChangedListener;
+    private Method removePrimaryClipChangedListener;
 
     public ClipboardManager(IInterface manager) {
         this.manager = manager;
@@ -84,7 +85,8 @@ public class ClipboardManager {
         }
     }
 
-    private static void addPrimaryClipChangedListener(Method method, IInterface manager, IOnPrimaryClipChangedListener listener)
+    // add or remove a listener (both methods have the same parameters)
+    private static void invokeClipChangedListenerMethod(Method method, IInterface manager, IOnPrimaryClipChangedListener listener)
             throws InvocationTargetException, IllegalAccessException {
         if (Build.VERSION.SDK_INT < Build.VERSION_CODES.Q) {
             method.invoke(manager, listener, ServiceManager.PACKAGE_NAME);
@@ -109,7 +111,32 @@ public class ClipboardManager {
     public boolean addPrimaryClipChangedListener(IOnPrimaryClipChangedListener listener) {
         try {
             Method method = getAddPrimaryClipChangedListener();
-            addPrimaryClipChangedListener(method, manager, listener);
+            invokeClipChangedListenerMethod(method, manager, listener);
+            return true;
+        } catch (InvocationTargetException | IllegalAccessException | NoSuchMethodException e) {
+            Ln.e("Could not invoke method", e);
+            return false;
+        }
+    }
+
+    private Method getRemovePrimaryClipChangedListener() throws NoSuchMethodException {
+        if (removePrimaryClipChangedListener == null) {
+            if (Build.VERSION.SDK_INT < Build.VERSION_CODES.Q) {
+                removePrimaryClipChangedListener = manager.getClass()
+                        .getMethod("removePrimaryClipChangedListener", IOnPrimaryClipChangedListener.class, String.class);
+            } else {
+                removePrimaryClipChangedListener = manager.getClass()
+                        .getMethod("removePrimaryClipChangedListener", IOnPrimaryClipChangedListener.class, String.class, int.class);
+            }
+        }
+        return removePrimaryClipChangedListener;
+    }
+
+    public boolean removePrimaryClipChangedListener(IOnPrimaryClipChangedListener listener) {
+        try {
+            Method method = getRemovePrimaryClipChangedListener();
+            // same parameters as addPrimaryClipChangedListener()
+            invokeClipChangedListenerMethod(method, manager, listener);
             return true;
         } catch (InvocationTargetException | IllegalAccessException | NoSuchMethodException e) {
             Ln.e("Could not invoke method", e);
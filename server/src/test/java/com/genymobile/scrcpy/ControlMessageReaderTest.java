@@ -296,6 +296,102 @@ public class ControlMessageReaderTest {
         Assert.assertEquals(ControlMessage.TYPE_ROTATE_DEVICE, event.getType());
     }
 
+    @Test
+    public void testParseSetVideoSize() throws IOException {
+        ControlMessageReader reader = new ControlMessageReader();
+
+        ByteArrayOutputStream bos = new ByteArrayOutputStream();
+        DataOutputStream dos = new DataOutputStream(bos);
+        dos.writeByte(ControlMessage.TYPE_SET_VIDEO_SIZE);
+        dos.writeShort(1024); // max size
+        dos.writeByte(1); // set crop
+        dos.writeShort(1080); // crop width
+        dos.writeShort(1200); // crop height
+        dos.writeShort(0); // crop x
+        dos.writeShort(400); // crop y
+
+        byte[] packet = bos.toByteArray();
+
+        // The message type (1 byte) does not count
+        Assert.assertEquals(ControlMessageReader.SET_VIDEO_SIZE_PAYLOAD_LENGTH, packet.length - 1);
+
+        reader.readFrom(new ByteArrayInputStream(packet));
+        ControlMessage event = reader.next();
+
+        Assert.assertEquals(ControlMessage.TYPE_SET_VIDEO_SIZE, event.getType());
+        Assert.assertEquals(1024, event.getMaxSize());
+        Assert.assertTrue(event.getSetCrop());
+        Assert.assertEquals(1080, event.getCropWidth());
+        Assert.assertEquals(1200, event.getCropHeight());
+        Assert.assertEquals(0, event.getCropX());
+        Assert.assertEquals(400, event.getCropY());
+    }
+
+    @Test
+    public void testParseSetVideoPaused() throws IOException {
+        ControlMessageReader reader = new ControlMessageReader();
+
+        ByteArrayOutputStream bos = new ByteArrayOutputStream();
+        DataOutputStream dos = new DataOutputStream(bos);
+        dos.writeByte(ControlMessage.TYPE_SET_VIDEO_PAUSED);
+        dos.writeByte(1); // paused
+
+        byte[] packet = bos.toByteArray();
+
+        // The message type (1 byte) does not count
+        Assert.assertEquals(ControlMessageReader.SET_VIDEO_PAUSED_PAYLOAD_LENGTH, packet.length - 1);
+
+        reader.readFrom(new ByteArrayInputStream(packet));
+        ControlMessage event = reader.next();
+
+        Assert.assertEquals(ControlMessage.TYPE_SET_VIDEO_PAUSED, event.getType());
+        Assert.assertTrue(event.getPaused());
+    }
+
+    @Test
+    public void testParseAckFrame() throws IOException {
+        ControlMessageReader reader = new ControlMessageReader();
+
+        ByteArrayOutputStream bos = new ByteArrayOutputStream();
+        DataOutputStream dos = new DataOutputStream(bos);
+        dos.writeByte(ControlMessage.TYPE_ACK_FRAME);
+        dos.writeLong(123456789L); // pts
+        dos.writeShort(3); // skipped frames
+
+        byte[] packet = bos.toByteArray();
+
+        // The message type (1 byte) does not count
+        Assert.assertEquals(ControlMessageReader.ACK_FRAME_PAYLOAD_LENGTH, packet.length - 1);
+
+        reader.readFrom(new ByteArrayInputStream(packet));
+        ControlMessage event = reader.next();
+
+        Assert.assertEquals(ControlMessage.TYPE_ACK_FRAME, event.getType());
+        Assert.assertEquals(123456789L, event.getPts());
+        Assert.assertEquals(3, event.getSkippedFrames());
+    }
+
+    @Test
+    public void testParsePing() throws IOException {
+        ControlMessageReader reader = new ControlMessageReader();
+
+        ByteArrayOutputStream bos = new ByteArrayOutputStream();
+        DataOutputStream dos = new DataOutputStream(bos);
+        dos.writeByte(ControlMessage.TYPE_PING);
+        dos.writeLong(0x0123456789ABCDEFL); // timestamp
+
+        byte[] packet = bos.toByteArray();
+
+        // The message type (1 byte) does not count
+        Assert.assertEquals(ControlMessageReader.PING_PAYLOAD_LENGTH, packet.length - 1);
+
+        reader.readFrom(new ByteArrayInputStream(packet));
+        ControlMessage event = reader.next();
+
+        Assert.assertEquals(ControlMessage.TYPE_PING, event.getType());
+        Assert.assertEquals(0x0123456789ABCDEFL, event.getTimestamp());
+    }
+
     @Test
     public void testMultiEvents() throws IOException {
         ControlMessageReader reader = new ControlMessageReader();
@@ -377,4 +473,107 @@ public class ControlMessageReaderTest {
         Assert.assertEquals(5, event.getRepeat());
         Assert.assertEquals(KeyEvent.META_CTRL_ON, event.getMetaState());
     }
+
+    @Test
+    public void testParseCompactEvents() throws IOException {
+        ControlMessageReader reader = new ControlMessageReader();
+        reader.setCompact(true);
+
+        byte[] packet = {
+                ControlMessage.TYPE_INJECT_KEYCODE,
+                KeyEvent.ACTION_UP,
+                0x42, // KEYCODE_ENTER
+                0x05, // repeat
+                0x41, // META_SHIFT_ON | META_SHIFT_LEFT_ON
+
+                ControlMessage.TYPE_INJECT_TOUCH_EVENT,
+                (byte) 0x80, // screen size follows | ACTION_DOWN
+                0x00, // pointer id
+                (byte) 0xb8, 0x08, (byte) 0x80, 0x0f, // 1080x1920
+                (byte) 0xc8, 0x01, (byte) 0x90, 0x03, // +100 +200
+                0x00, // buttons
+
+                ControlMessage.TYPE_INJECT_TOUCH_EVENT,
+                0x42, // pressure follows | ACTION_MOVE
+                0x00, // pointer id
+                0x06, 0x03, // +3 -2
+                (byte) 0x80, 0x00, // pressure 0.5
+                0x00, // buttons
+
+                ControlMessage.TYPE_INJECT_TOUCH_EVENT,
+                0x21, // no pressure | ACTION_UP
+                0x01, // pointer id -1 (mouse)
+                0x00, 0x00, // same position
+                0x01, // BUTTON_PRIMARY
+
+                ControlMessage.TYPE_INJECT_SCROLL_EVENT,
+                0x00, // no flags
+                0x14, 0x28, // +10 +20
+                0x02, // hscroll
+                0x01, // vscroll
+        };
+        reader.readFrom(new ByteArrayInputStream(packet));
+
+        ControlMessage event = reader.next();
+        Assert.assertEquals(ControlMessage.TYPE_INJECT_KEYCODE, event.getType());
+        Assert.assertEquals(KeyEvent.ACTION_UP, event.getAction());
+        Assert.assertEquals(KeyEvent.KEYCODE_ENTER, event.getKeycode());
+        Assert.assertEquals(5, event.getRepeat());
+        Assert.assertEquals(KeyEvent.META_SHIFT_ON | KeyEvent.META_SHIFT_LEFT_ON, event.getMetaState());
+
+        event = reader.next();
+        Assert.assertEquals(ControlMessage.TYPE_INJECT_TOUCH_EVENT, event.getType());
+        Assert.assertEquals(MotionEvent.ACTION_DOWN, event.getAction());
+        Assert.assertEquals(0, event.getPointerId());
+        Assert.assertEquals(new Position(100, 200, 1080, 1920), event.getPosition());
+        Assert.assertEquals(1f, event.getPressure(), 0f);
+        Assert.assertEquals(0, event.getButtons());
+
+        event = reader.next();
+        Assert.assertEquals(MotionEvent.ACTION_MOVE, event.getAction());
+        Assert.assertEquals(new Position(103, 198, 1080, 1920), event.getPosition());
+        Assert.assertEquals(0.5f, event.getPressure(), 0f);
+
+        event = reader.next();
+        Assert.assertEquals(MotionEvent.ACTION_UP, event.getAction());
+        Assert.assertEquals(-1, event.getPointerId());
+        Assert.assertEquals(new Position(103, 198, 1080, 1920), event.getPosition());
+        Assert.assertEquals(0f, event.getPressure(), 0f);
+        Assert.assertEquals(MotionEvent.BUTTON_PRIMARY, event.getButtons());
+
+        event = reader.next();
+        Assert.assertEquals(ControlMessage.TYPE_INJECT_SCROLL_EVENT, event.getType());
+        Assert.assertEquals(new Position(113, 218, 1080, 1920), event.getPosition());
+        Assert.assertEquals(1, event.getHScroll());
+        Assert.assertEquals(-1, event.getVScroll());
+
+        Assert.assertNull(reader.next());
+    }
+
+    @Test
+    public void testParseCompactPartialEvent() throws IOException {
+        ControlMessageReader reader = new ControlMessageReader();
+        reader.setCompact(true);
+
+        byte[] part1 = {
+                ControlMessage.TYPE_INJECT_TOUCH_EVENT,
+                (byte) 0x82, // screen size follows | ACTION_MOVE
+                0x00, // pointer id
+                (byte) 0xb8, 0x08, (byte) 0x80, 0x0f, // 1080x1920
+                (byte) 0xc8, // incomplete varint
+        };
+        reader.readFrom(new ByteArrayInputStream(part1));
+        Assert.assertNull(reader.next());
+
+        byte[] part2 = {
+                0x01, (byte) 0x90, 0x03, // +100 +200
+                0x00, // buttons
+        };
+        reader.readFrom(new ByteArrayInputStream(part2));
+
+        // the position of the incomplete event has not been applied twice
+        ControlMessage event = reader.next();
+        Assert.assertEquals(MotionEvent.ACTION_MOVE, event.getAction());
+        Assert.assertEquals(new Position(100, 200, 1080, 1920), event.getPosition());
+    }
 }
@@ -7,6 +7,7 @@ import java.io.ByteArrayOutputStream;
 import java.io.DataOutputStream;
 import java.io.IOException;
 import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
 
 public class DeviceMessageWriterTest {
 
@@ -32,4 +33,73 @@ public class DeviceMessageWriterTest {
 
         Assert.assertArrayEquals(expected, actual);
     }
+
+    @Test
+    public void testSerializeBigClipboard() throws IOException {
+        DeviceMessageWriter writer = new DeviceMessageWriter();
+
+        // larger than the former 256k limit
+        char[] chars = new char[1 << 20];
+        Arrays.fill(chars, 'a');
+        String text = new String(chars);
+
+        DeviceMessage msg = DeviceMessage.createClipboard(text);
+        ByteArrayOutputStream bos = new ByteArrayOutputStream();
+        writer.writeTo(msg, bos);
+
+        byte[] actual = bos.toByteArray();
+        Assert.assertEquals(5 + (1 << 20), actual.length);
+        Assert.assertEquals(DeviceMessage.TYPE_CLIPBOARD, actual[0]);
+        Assert.assertEquals(0x10, actual[2]); // length 0x00100000
+        Assert.assertEquals('a', actual[actual.length - 1]);
+    }
+
+    @Test
+    public void testSerializeEncoderStats() throws IOException {
+        DeviceMessageWriter writer = new DeviceMessageWriter();
+
+        ByteArrayOutputStream bos = new ByteArrayOutputStream();
+        DataOutputStream dos = new DataOutputStream(bos);
+        dos.writeByte(DeviceMessage.TYPE_ENCODER_STATS);
+        dos.writeInt(300);
+        dos.writeLong(1_000_000_000L);
+        dos.writeLong(2_500_000L);
+        dos.writeInt(2);
+        dos.writeInt(8_000_000);
+        dos.writeInt(60);
+
+        byte[] expected = bos.toByteArray();
+
+        EncoderStats stats = new EncoderStats(300, 1_000_000_000L, 2_500_000L, 2, 8_000_000, 60);
+        DeviceMessage msg = DeviceMessage.createEncoderStats(stats);
+        bos = new ByteArrayOutputStream();
+        writer.writeTo(msg, bos);
+
+        byte[] actual = bos.toByteArray();
+
+        Assert.assertEquals(33, actual.length);
+        Assert.assertArrayEquals(expected, actual);
+    }
+
+    @Test
+    public void testSerializePong() throws IOException {
+        DeviceMessageWriter writer = new DeviceMessageWriter();
+
+        ByteArrayOutputStream bos = new ByteArrayOutputStream();
+        DataOutputStream dos = new DataOutputStream(bos);
+        dos.writeByte(DeviceMessage.TYPE_PONG);
+        dos.writeLong(0x0123456789ABCDEFL); // ping timestamp
+        dos.writeLong(1000000L); // receive time
+        dos.writeLong(1000042L); // send time
+
+        byte[] expected = bos.toByteArray();
+
+        DeviceMessage msg = DeviceMessage.createPong(0x0123456789ABCDEFL, 1000000L, 1000042L);
+        bos = new ByteArrayOutputStream();
+        writer.writeTo(msg, bos);
+
+        byte[] actual = bos.toByteArray();
+
+        Assert.assertArrayEquals(expected, actual);
+    }
 }
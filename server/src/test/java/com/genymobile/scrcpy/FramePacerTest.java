@@ -0,0 +1,98 @@
+package com.genymobile.scrcpy;
+
+import org.junit.Assert;
+import org.junit.Test;
+
+public class FramePacerTest {
+
+    @Test
+    public void testInactiveUntilFirstAck() {
+        FramePacer pacer = new FramePacer();
+
+        pacer.onFrameSent(1000);
+        pacer.onFrameSent(2000);
+        Assert.assertEquals(0, pacer.getPendingCount());
+
+        Assert.assertFalse(pacer.onFrameAck(0));
+
+        pacer.onFrameSent(3000);
+        Assert.assertEquals(1, pacer.getPendingCount());
+    }
+
+    @Test
+    public void testAckRemovesOlderFrames() {
+        FramePacer pacer = new FramePacer();
+        pacer.onFrameAck(0);
+
+        for (int i = 1; i <= 5; ++i) {
+            pacer.onFrameSent(i * 1000);
+        }
+        Assert.assertEquals(5, pacer.getPendingCount());
+
+        Assert.assertFalse(pacer.onFrameAck(3000));
+        Assert.assertEquals(2, pacer.getPendingCount());
+
+        Assert.assertFalse(pacer.onFrameAck(5000));
+        Assert.assertEquals(0, pacer.getPendingCount());
+    }
+
+    @Test
+    public void testNoThrottleWithoutPendingFrames() {
+        FramePacer pacer = new FramePacer();
+        pacer.onFrameAck(0);
+
+        pacer.onFrameSent(1000);
+        pacer.onFrameSent(2000);
+        pacer.onFrameSent(3000);
+        pacer.onFrameSent(4000);
+
+        // the client skipped frames 1000 to 3000, but caught up: throttling now would never be resumed, since no frame would be
+        // produced (so acknowledged) anymore
+        Assert.assertFalse(pacer.onFrameAck(4000));
+        Assert.assertEquals(0, pacer.getPendingCount());
+    }
+
+    @Test
+    public void testResumeOnlyWhenCaughtUp() {
+        FramePacer pacer = new FramePacer();
+        pacer.onFrameAck(0);
+
+        for (int i = 1; i <= 20; ++i) {
+            pacer.onFrameSent(i * 1000);
+        }
+
+        // 18 frames in flight
+        Assert.assertTrue(pacer.onFrameAck(2000));
+        // 5 frames in flight, still throttled
+        Assert.assertTrue(pacer.onFrameAck(15000));
+        // 1 frame in flight
+        Assert.assertFalse(pacer.onFrameAck(19000));
+    }
+
+    @Test
+    public void testThrottleOnTooManyPendingFrames() {
+        FramePacer pacer = new FramePacer();
+        pacer.onFrameAck(0);
+
+        for (int i = 1; i <= 20; ++i) {
+            pacer.onFrameSent(i * 1000);
+        }
+
+        Assert.assertTrue(pacer.onFrameAck(1000));
+        Assert.assertFalse(pacer.onFrameAck(20000));
+    }
+
+    @Test
+    public void testForgetOldestFramesWhenFull() {
+        FramePacer pacer = new FramePacer();
+        pacer.onFrameAck(0);
+
+        for (int i = 1; i <= 100; ++i) {
+            pacer.onFrameSent(i * 1000);
+        }
+        Assert.assertEquals(32, pacer.getPendingCount());
+
+        pacer.onFrameAck(90000);
+        Assert.assertEquals(10, pacer.getPendingCount());
+    }
+}